@@ -22,15 +22,148 @@
 */
 
 #include "csoundCore.h"                         /*      AUXFD.C         */
+#include "memacct.h"
 
 static CS_NOINLINE void auxchprint(CSOUND *, INSDS *);
 static CS_NOINLINE void fdchprint(CSOUND *, INSDS *);
 
+/* AuxAlloc arenas.  Every instrument keeps the most AuxAlloc space any
+   of its instances has asked for during init (the budget), and an
+   instance takes a region of that size with its first AuxAlloc, from
+   the instrument's free regions when there are any.  Init-time
+   requests are then cut from the region, so a new instance of a known
+   instrument costs one allocation at most, and none once regions come
+   back from instances freed by orcompact or were reserved by
+   --instance-prewarm.  Requests that do not fit fall back to Calloc and
+   raise the budget to what the instance then holds, blocks freed or
+   resized by a later note of a reused instance no longer counting;
+   --aux-strict reports each of them. */
+
+#define AUX_ALIGN(n)    (((n) + 15) & ~((size_t) 15))
+#define AUX_REGION_HDR  16      /* free list link and size */
+
+typedef struct aux_pool_t {
+    size_t  budget;             /* bytes of a region */
+    void    *regions;           /* free regions of budget bytes */
+    int     outside;            /* init-time requests not served */
+} AUX_POOL;
+
+#define REGION_SIZE(r)  (((size_t*) (r))[1])
+
+static void *aux_region_new(CSOUND *csound, size_t budget)
+{
+    char *r = csound->Calloc(csound, AUX_REGION_HDR + budget);  /* instr's */
+    if (UNLIKELY(csound->oparms->rtMemory))
+      mem_prefault(csound, r, AUX_REGION_HDR + budget, 0);
+    REGION_SIZE(r) = budget;
+    return r;
+}
+
+/* new budget: the free regions are too small now */
+static void aux_pool_grow(CSOUND *csound, AUX_POOL *pool, size_t budget)
+{
+    int n;
+    while (pool->regions != NULL) {
+      void *nxt = *(void**) pool->regions;
+      csound->Free(csound, pool->regions);
+      pool->regions = nxt;
+    }
+    pool->budget = budget;
+    for (n = 0; n < csound->oparms->instancePrewarm; n++) {
+      void *r = aux_region_new(csound, budget);
+      *(void**) r = pool->regions;
+      pool->regions = r;
+    }
+}
+
+static CS_NOINLINE void aux_outside(CSOUND *csound, INSDS *ip, size_t nbytes)
+{
+    char *name = ip->instr->insname;
+    const char *op = (csound->ids != NULL && csound->ids->optext != NULL) ?
+      csound->ids->optext->t.opcod : "?";
+    if (name)
+      csound->Warning(csound, Str("instr %s: %s allocated %zu bytes "
+                                  "outside the AuxAlloc arena"),
+                      name, op, nbytes);
+    else
+      csound->Warning(csound, Str("instr %d: %s allocated %zu bytes "
+                                  "outside the AuxAlloc arena"),
+                      ip->insno, op, nbytes);
+}
+
+/* zeroed space from the arena of ip, or NULL */
+static void *aux_arena_alloc(CSOUND *csound, INSDS *ip, size_t nbytes)
+{
+    INSTRTXT *tp = ip->instr;
+    INSDS_PRIV *q = INSDS_PRIV(ip);
+    AUX_POOL *pool;
+    size_t   need = AUX_ALIGN(nbytes);
+    char     *p;
+
+    if (UNLIKELY(tp == NULL)) return NULL;
+    if (UNLIKELY(ATOMIC_GET(ip->init_done))) {
+      q->auxreq += need;                /* performance time, keep Calloc */
+      return NULL;
+    }
+    if (UNLIKELY((pool = tp->auxpool) == NULL))
+      pool = tp->auxpool = csound->Calloc(csound, sizeof(AUX_POOL));
+    /* only a first request takes a region: later ones come while the
+       budget may still be growing */
+    if (q->auxarena == NULL && q->auxreq == 0 && pool->budget > 0) {
+      char *r = pool->regions;
+      if (r != NULL) pool->regions = *(void**) r;
+      else {
+        if (UNLIKELY(csound->oparms->auxStrict))
+          aux_outside(csound, ip, pool->budget);
+        r = aux_region_new(csound, pool->budget);
+      }
+      q->auxarena = r;
+      q->auxnext = r + AUX_REGION_HDR;
+      q->auxend = q->auxnext + REGION_SIZE(r);
+    }
+    q->auxreq += need;
+    if (q->auxarena != NULL && q->auxnext + need <= q->auxend) {
+      p = q->auxnext;
+      q->auxnext += need;
+      memset(p, 0, nbytes);
+      return p;
+    }
+    pool->outside++;
+    if (q->auxreq > pool->budget)
+      aux_pool_grow(csound, pool, q->auxreq);
+    if (UNLIKELY(csound->oparms->auxStrict))
+      aux_outside(csound, ip, nbytes);
+    return NULL;
+}
+
+static inline int aux_in_arena(INSDS *ip, void *p)
+{
+    INSDS_PRIV *q = INSDS_PRIV(ip);
+    return (q->auxarena != NULL && (char*) p >= q->auxarena &&
+            (char*) p < q->auxend);
+}
+
+/* give back space from the arena, or free it */
+static void aux_release(CSOUND *csound, INSDS *ip, AUXCH *auxchp)
+{
+    INSDS_PRIV *q = INSDS_PRIV(ip);
+    size_t size = AUX_ALIGN(auxchp->size);
+    q->auxreq = q->auxreq > size ? q->auxreq - size : 0;
+    if (aux_in_arena(ip, auxchp->auxp)) {
+      /* the latest block can be cut again */
+      if ((char*) auxchp->auxp + AUX_ALIGN(auxchp->size) == q->auxnext)
+        q->auxnext = auxchp->auxp;
+    }
+    else
+      csound->Free(csound, auxchp->auxp);
+}
+
 /* allocate an auxds, or expand an old one */
 /*    call only from init (xxxset) modules */
 
 void csoundAuxAlloc(CSOUND *csound, size_t nbytes, AUXCH *auxchp)
 {
+    INSDS *ip = csound->curip;
     if (auxchp->auxp != NULL) {
       /* if allocd with same size, just clear to zero */
       if (nbytes == (size_t)auxchp->size) {
@@ -38,24 +171,49 @@ void csoundAuxAlloc(CSOUND *csound, size_t nbytes, AUXCH *auxchp)
         return;
       }
       else {
-        void  *tmp = auxchp->auxp;
         /* if size change only, free the old space and re-allocate */
+        aux_release(csound, ip, auxchp);
         auxchp->auxp = NULL;
-        csound->Free(csound, tmp);
       }
     }
     else {                                  /* else link in new auxch blk */
-      auxchp->nxtchp = csound->curip->auxchp;
-      csound->curip->auxchp = auxchp;
+      auxchp->nxtchp = ip->auxchp;
+      ip->auxchp = auxchp;
     }
     /* now alloc the space and update the internal data */
     auxchp->size = nbytes;
-    auxchp->auxp = csound->Calloc(csound, nbytes);
+    auxchp->auxp = aux_arena_alloc(csound, ip, nbytes);
+    if (auxchp->auxp == NULL) {
+      /* charged to the statement, while the regions count to the
+         instrument */
+      int mem_saved = csp_mem_enter(csound,
+                                    (csound->ids != NULL &&
+                                     csound->ids->insdshead == ip) ?
+                                    csp_mem_owner_opcode(csound, csound->ids) :
+                                    -1);
+      auxchp->auxp = csound->Calloc(csound, nbytes);
+      csp_mem_leave(csound, mem_saved);
+      if (UNLIKELY(csound->oparms->rtMemory))
+        mem_prefault(csound, auxchp->auxp, nbytes, 0);
+    }
     auxchp->endp = (char*)auxchp->auxp + nbytes;
     if (UNLIKELY(csound->oparms->odebug))
-      auxchprint(csound, csound->curip);
+      auxchprint(csound, ip);
 }
 
+/* free the regions of tp (delete_instr, free_instrtxt) */
+void aux_pool_free(CSOUND *csound, INSTRTXT *tp)
+{
+    AUX_POOL *pool = tp->auxpool;
+    if (pool == NULL) return;
+    while (pool->regions != NULL) {
+      void *nxt = *(void**) pool->regions;
+      csound->Free(csound, pool->regions);
+      pool->regions = nxt;
+    }
+    csound->Free(csound, pool);
+    tp->auxpool = NULL;
+}
 
 static uintptr_t alloc_thread(void *p) {
     AUXASYNC *pp = (AUXASYNC *) p;
@@ -91,6 +249,23 @@ static uintptr_t alloc_thread(void *p) {
 */
 int csoundAuxAllocAsync(CSOUND *csound, size_t nbytes, AUXCH *auxchp,
                         AUXASYNC *as, aux_cb cb, void *userData) {
+    INSDS *ip = csound->curip;
+    /* a new block the arena can serve needs no thread: hand it over now.
+       The arena keeps it for the life of the instance, so what the
+       callback gives back is only freed if it came from elsewhere */
+    if (auxchp->auxp == NULL && ip != NULL) {
+      AUXCH newm, *ret;
+      if ((newm.auxp = aux_arena_alloc(csound, ip, nbytes)) != NULL) {
+        newm.nxtchp = NULL;
+        newm.size = nbytes;
+        newm.endp = (char*) newm.auxp + nbytes;
+        ret = cb(csound, userData, &newm);
+        if (ret != NULL && ret->auxp != NULL && ret->auxp != newm.auxp &&
+            !aux_in_arena(ip, ret->auxp))
+          csound->Free(csound, ret->auxp);
+        return CSOUND_SUCCESS;
+      }
+    }
     as->csound = csound;
     as->nbytes = nbytes;
     as->auxchp = auxchp;
@@ -149,15 +324,28 @@ void fdclose(CSOUND *csound, FDCH *fdchp)
 
 void auxchfree(CSOUND *csound, INSDS *ip)
 {
+    INSDS_PRIV *q = INSDS_PRIV(ip);
     if (UNLIKELY(csound->oparms->odebug))
       auxchprint(csound, ip);
     while (LIKELY(ip->auxchp != NULL)) {        /* for all auxp's in chain: */
       void  *auxp = (void*) ip->auxchp->auxp;
       AUXCH *nxt = ip->auxchp->nxtchp;
       memset((void*) ip->auxchp, 0, sizeof(AUXCH)); /*  delete the pntr     */
-      csound->Free(csound, auxp);                   /*  & free the space    */
+      if (!aux_in_arena(ip, auxp))
+        csound->Free(csound, auxp);                 /*  & free the space    */
       ip->auxchp = nxt;
     }
+    if (q->auxarena != NULL) {                  /* return the region */
+      AUX_POOL *pool = ip->instr->auxpool;
+      if (pool != NULL && REGION_SIZE(q->auxarena) == pool->budget) {
+        *(void**) q->auxarena = pool->regions;
+        pool->regions = q->auxarena;
+      }
+      else
+        csound->Free(csound, q->auxarena);
+      q->auxarena = q->auxnext = q->auxend = NULL;
+    }
+    q->auxreq = 0;
     if (UNLIKELY(csound->oparms->odebug))
       auxchprint(csound, ip);
 }
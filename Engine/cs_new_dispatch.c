@@ -76,12 +76,55 @@
 #define INIT_SIZE (100)
 //static int task_max_size;
 
+static void dag_seed_deques(CSOUND *csound);
+static void dag_accum_resolve(CSOUND *csound);
+static void dag_report_analyse(CSOUND *csound);
+
+/* Dependencies are kept as a bit matrix: row j has bit k set when task j
+   must wait for task k.  Task ids are slots that stay with an instance for
+   as long as it is active, so a voice starting or stopping only touches
+   its own row and column.  Edges always go from the earlier to the later
+   instance in the active chain, which keeps the graph acyclic. */
+#define DEP_ROW(csound, j) (&(csound)->dag_task_dep[(j)*(csound)->dag_dep_words])
+#define DEP_TEST(row, k)   ((row)[(k)>>6] & ((uint64_t)1 << ((k)&63)))
+#define DEP_SET(row, k)    ((row)[(k)>>6] |= ((uint64_t)1 << ((k)&63)))
+#define DEP_CLR(row, k)    ((row)[(k)>>6] &= ~((uint64_t)1 << ((k)&63)))
+
+#if defined(_MSC_VER)
+static inline int dep_ctz(uint64_t x)
+{
+    unsigned long n;
+    _BitScanForward64(&n, x);
+    return (int)n;
+}
+#else
+#define dep_ctz(x) __builtin_ctzll(x)
+#endif
+
+/* Index of the first dependency at or after k in row, or -1 */
+static inline int dep_next(const uint64_t *row, int words, int k)
+{
+    int w = k>>6;
+    uint64_t b;
+    if (w >= words) return -1;
+    b = row[w] & (~(uint64_t)0 << (k&63));
+    while (b == 0) {
+      if (++w == words) return -1;
+      b = row[w];
+    }
+    return (w<<6) + dep_ctz(b);
+}
+
 static void dag_print_state(CSOUND *csound)
 {
-    int i;
+    int i, k;
     watchList *w;
     printf("*** %d tasks\n", csound->dag_num_active);
     for (i=0; i<csound->dag_num_active; i++) {
+      if (csound->dag_task_map[i] == NULL) {
+        printf("%d: empty slot\n", i);
+        continue;
+      }
       printf("%d(%d): ", i, csound->dag_task_map[i]->insno);
       switch (csound->dag_task_status[i].s) {
       case DONE:
@@ -104,10 +147,11 @@ static void dag_print_state(CSOUND *csound)
         break;
       case WAITING:
         {
-          char *tt = csound->dag_task_dep[i];
-          int j;
+          uint64_t *tt = DEP_ROW(csound, i);
           printf("status=WAITING for tasks [");
-          for (j=0; j<i; j++) if (tt[j]) printf("%d ", j);
+          for (k = dep_next(tt, csound->dag_dep_words, 0); k >= 0;
+               k = dep_next(tt, csound->dag_dep_words, k+1))
+            printf("%d ", k);
           printf("]\n");
         }
         break;
@@ -117,22 +161,12 @@ static void dag_print_state(CSOUND *csound)
     }
 }
 
-/* For now allocate a fixed maximum number of tasks; FIXME */
-static void create_dag(CSOUND *csound)
-{
-    /* Allocate the main task status and watchlists */
-    int max = csound->dag_task_max_size;
-    csound->dag_task_status = csound->Calloc(csound, sizeof(stateWithPadding)*max);
-    csound->dag_task_watch  = csound->Calloc(csound, sizeof(watchList*)*max);
-    csound->dag_task_map    = csound->Calloc(csound, sizeof(INSDS*)*max);
-    csound->dag_task_dep    = (char **)csound->Calloc(csound, sizeof(char*)*max);
-    csound->dag_wlmm = (watchList *)csound->Calloc(csound, sizeof(watchList)*max);
-}
-
+/* (Re)allocate everything indexed by task for dag_task_max_size tasks.
+   The dependency matrix is not preserved; callers rebuild it. */
 static void recreate_dag(CSOUND *csound)
 {
-    /* Allocate the main task status and watchlists */
     int max = csound->dag_task_max_size;
+    csound->dag_dep_words = (max+63)>>6;
     csound->dag_task_status =
       csound->ReAlloc(csound, (stateWithPadding *)csound->dag_task_status,
                sizeof(stateWithPadding)*max);
@@ -141,8 +175,18 @@ static void recreate_dag(CSOUND *csound)
                sizeof(watchList*)*max);
     csound->dag_task_map    =
       csound->ReAlloc(csound, (INSDS *)csound->dag_task_map, sizeof(INSDS*)*max);
+    csound->dag_task_sem    =
+      csound->ReAlloc(csound, csound->dag_task_sem,
+                      sizeof(INSTR_SEMANTICS*)*max);
+    csound->dag_task_rank   =
+      csound->ReAlloc(csound, csound->dag_task_rank, sizeof(int)*max);
+    csound->dag_task_epoch  =
+      csound->ReAlloc(csound, csound->dag_task_epoch, sizeof(uint32_t)*max);
+    csound->dag_pending     =
+      csound->ReAlloc(csound, csound->dag_pending, sizeof(INSDS*)*max);
     csound->dag_task_dep    =
-      (char **)csound->ReAlloc(csound, csound->dag_task_dep, sizeof(char*)*max);
+      csound->ReAlloc(csound, csound->dag_task_dep,
+                      sizeof(uint64_t)*max*csound->dag_dep_words);
     csound->dag_wlmm        =
       (watchList *)csound->ReAlloc(csound, csound->dag_wlmm, sizeof(watchList)*max);
 }
@@ -164,118 +208,164 @@ static INSTR_SEMANTICS *dag_get_info(CSOUND* csound, int insno)
     return current_instr;
 }
 
-static int dag_intersect(CSOUND *csound, struct set_t *current,
-                         struct set_t *later, int cnt)
+/* Two instruments must be ordered if either writes what the other reads
+   or writes.  read_write globals are only accumulated into (ga += x,
+   chnmix), which commutes, so they conflict with plain reads and writes
+   but not with each other; see dag_accum_find for how the sums are kept
+   apart. */
+static int dag_intersect(INSTR_SEMANTICS *current, INSTR_SEMANTICS *later)
 {
-    IGN(cnt);
-    struct set_t *ans;
-    int res = 0;
-    struct set_element_t *ele;
-    ans = csp_set_intersection(csound, current, later);
-    res = ans->count;
-    ele = ans->head;
-    while (ele != NULL) {
-      struct set_element_t *next = ele->next;
-      csound->Free(csound, ele);
-      ele = next; res++;
+    CSP_BITSETS *c = CSP_BITSETS_GET(current), *l = CSP_BITSETS_GET(later);
+    int w, n;
+    if (c == NULL || l == NULL) return 0;
+    n = c->nwords < l->nwords ? c->nwords : l->nwords;
+    for (w=0; w<n; w++) {
+      if ((c->write[w] & (l->read[w] | l->write[w] | l->read_write[w])) ||
+          (c->read_write[w] & (l->read[w] | l->write[w]))              ||
+          (c->read[w] & (l->write[w] | l->read_write[w])))
+        return 1;
     }
-    csound->Free(csound, ans);
-    return res;
+    return 0;
 }
 
+/* Add the edges between the task in slot s and every other live task */
+static void dag_connect(CSOUND *csound, int s)
+{
+    int t;
+    INSTR_SEMANTICS *sem = csound->dag_task_sem[s];
+    int rank = csound->dag_task_rank[s];
+    for (t=0; t<csound->dag_num_active; t++) {
+      if (t == s || csound->dag_task_map[t] == NULL) continue;
+      if (dag_intersect(sem, csound->dag_task_sem[t])) {
+        if (csound->dag_task_rank[t] < rank) DEP_SET(DEP_ROW(csound, s), t);
+        else DEP_SET(DEP_ROW(csound, t), s);
+      }
+    }
+}
+
+/* Rebuild the whole DAG from the active chain, with slots in chain order */
 void dag_build(CSOUND *csound, INSDS *chain)
 {
     INSDS *save = chain;
-    INSDS **task_map;
-    int i;
+    int i, n = 0;
 
     //printf("DAG BUILD***************************************\n");
-    csound->dag_num_active = 0;
+    if (csound->dag_accums != NULL) dag_accum_resolve(csound);
     while (chain != NULL) {
-      csound->dag_num_active++;
+      n++;
       chain = chain->nxtact;
     }
-    if (csound->dag_num_active>csound->dag_task_max_size) {
+    if (n > csound->dag_task_max_size || csound->dag_task_status == NULL) {
       //printf("**************need to extend task vector\n");
-      csound->dag_task_max_size = csound->dag_num_active+INIT_SIZE;
+      if (n > csound->dag_task_max_size)
+        csound->dag_task_max_size = n+INIT_SIZE;
       recreate_dag(csound);
     }
-    if (csound->dag_task_status == NULL)
-      create_dag(csound); /* Should move elsewhere */
-    else {
-      memset((void*)csound->dag_task_watch, '\0',
-             sizeof(watchList*)*csound->dag_task_max_size);
-      for (i=0; i<csound->dag_task_max_size; i++) {
-        if (csound->dag_task_dep[i]) {
-          csound->dag_task_dep[i]= NULL;
-        }
-        csound->dag_wlmm[i].id = INVALID;
-      }
-    }
-    task_map = csound->dag_task_map;
-    for (i=0; i<csound->dag_num_active; i++) {
-      csound->dag_task_status[i].s = AVAILABLE;
-      csound->dag_wlmm[i].id=i;
-    }
-    csound->dag_changed = 0;
+    memset(csound->dag_task_dep, '\0',
+           sizeof(uint64_t)*csound->dag_task_max_size*csound->dag_dep_words);
+    memset(csound->dag_task_map, '\0', sizeof(INSDS*)*csound->dag_task_max_size);
+    csound->dag_num_active = csound->dag_num_live = n;
+    csound->dag_epoch++;
     if (UNLIKELY(csound->oparms->odebug))
       printf("dag_num_active = %d\n", csound->dag_num_active);
-    i = 0; chain = save;
-    while (chain != NULL) {     /* for each instance check against later */
-      int j = i+1;              /* count of instance */
+    for (i = 0, chain = save; chain != NULL; i++, chain = chain->nxtact) {
+      INSDS_PRIV(chain)->dag_slot = i;
+      csound->dag_task_map[i] = chain;
+      csound->dag_task_sem[i] = dag_get_info(csound, chain->insno);
+      csound->dag_task_rank[i] = i;
+      csound->dag_task_epoch[i] = csound->dag_epoch;
+    }
+    for (i=1; i<n; i++) {     /* for each instance check against earlier */
+      int j;
+      uint64_t *tt = DEP_ROW(csound, i);
       if (UNLIKELY(csound->oparms->odebug))
-        printf("\nWho depends on %d (instr %d)?\n", i, chain->insno);
-      INSDS *next = chain->nxtact;
-      INSTR_SEMANTICS *current_instr = dag_get_info(csound, chain->insno);
-      //csp_set_print(csound, current_instr->read);
-      //csp_set_print(csound, current_instr->write);
-      while (next) {
-        INSTR_SEMANTICS *later_instr = dag_get_info(csound, next->insno);
-        int cnt = 0;
-        if (UNLIKELY(csound->oparms->odebug)) printf("%d ", j);
-        //csp_set_print(csound, later_instr->read);
-        //csp_set_print(csound, later_instr->write);
-        //csp_set_print(csound, later_instr->read_write);
-        if (dag_intersect(csound, current_instr->write,
-                          later_instr->read, cnt++)       ||
-            dag_intersect(csound, current_instr->read_write,
-                          later_instr->read, cnt++)       ||
-            dag_intersect(csound, current_instr->read,
-                          later_instr->write, cnt++)      ||
-            dag_intersect(csound, current_instr->write,
-                          later_instr->write, cnt++)      ||
-            dag_intersect(csound, current_instr->read_write,
-                          later_instr->write, cnt++)      ||
-            dag_intersect(csound, current_instr->read,
-                          later_instr->read_write, cnt++) ||
-            dag_intersect(csound, current_instr->write,
-                          later_instr->read_write, cnt++)) {
-          char *tt = csound->dag_task_dep[j];
-          if (tt==NULL) {
-            /* get dep vector if missing and set watch first time */
-            tt = csound->dag_task_dep[j] =
-              (char*)csound->Calloc(csound, sizeof(char)*(j+1));
-            csound->dag_task_status[j].s = WAITING;
-            csound->dag_wlmm[j].next = csound->dag_task_watch[i];
-            csound->dag_wlmm[j].id = j;
-            csound->dag_task_watch[i] = &(csound->dag_wlmm[j]);
-            //printf("set watch %d to %d\n", j, i);
-          }
-          tt[i] = 1;
-          //printf("-yes ");
+        printf("\nWhat does %d (instr %d) depend on?\n",
+               i, csound->dag_task_map[i]->insno);
+      for (j=0; j<i; j++)
+        if (dag_intersect(csound->dag_task_sem[j], csound->dag_task_sem[i]))
+          DEP_SET(tt, j);
+    }
+    csound->dag_changed = 0;
+}
+
+/* Bring the DAG in line with the active chain after voices have been
+   inserted or deactivated.  Only the rows and columns of the instances
+   that came or went are touched.  If an instance was reused in a
+   different place in the chain, or the table is full, rebuild instead. */
+void dag_update(CSOUND *csound, INSDS *chain)
+{
+    INSDS *save = chain;
+    int s, i, n = 0, npending = 0, last_rank = -1;
+    int words = csound->dag_dep_words;
+    uint32_t epoch;
+
+    if (csound->dag_task_status == NULL) {
+      dag_build(csound, chain);
+      return;
+    }
+    if (csound->dag_accums != NULL) dag_accum_resolve(csound);
+    epoch = ++csound->dag_epoch;
+    for (; chain != NULL; chain = chain->nxtact, n++) {
+      s = INSDS_PRIV(chain)->dag_slot;
+      if (s >= 0 && s < csound->dag_num_active &&
+          csound->dag_task_map[s] == chain &&
+          csound->dag_task_epoch[s] != epoch) {
+        if (csound->dag_task_rank[s] < last_rank) {
+          dag_build(csound, save);   /* relative order has changed */
+          return;
         }
-        j++; next = next->nxtact;
+        last_rank = csound->dag_task_rank[s];
+        csound->dag_task_epoch[s] = epoch;
+        csound->dag_task_rank[s] = n;
+      }
+      else if (npending < csound->dag_task_max_size) {
+        INSDS_PRIV(chain)->dag_slot = -n-1;  /* remember chain position */
+        csound->dag_pending[npending++] = chain;
       }
-      task_map[i] = chain;
-      i++; chain = chain->nxtact;
     }
-    if (UNLIKELY(csound->oparms->odebug)) dag_print_state(csound);
+    if (n > csound->dag_task_max_size) {
+      dag_build(csound, save);
+      return;
+    }
+    /* drop the instances that are no longer active */
+    for (s=0; s<csound->dag_num_active; s++) {
+      if (csound->dag_task_map[s] == NULL ||
+          csound->dag_task_epoch[s] == epoch) continue;
+      for (i=0; i<csound->dag_num_active; i++)
+        DEP_CLR(DEP_ROW(csound, i), s);
+      memset(DEP_ROW(csound, s), '\0', sizeof(uint64_t)*words);
+      csound->dag_task_map[s] = NULL;
+      csound->dag_num_live--;
+    }
+    /* and give each new one a free slot and its edges */
+    for (i=0, s=0; i<npending; i++) {
+      INSDS *ip = csound->dag_pending[i];
+      while (csound->dag_task_map[s] != NULL) s++;
+      csound->dag_task_rank[s] = -INSDS_PRIV(ip)->dag_slot-1;
+      INSDS_PRIV(ip)->dag_slot = s;
+      csound->dag_task_map[s] = ip;
+      csound->dag_task_sem[s] = dag_get_info(csound, ip->insno);
+      csound->dag_task_epoch[s] = epoch;
+      memset(DEP_ROW(csound, s), '\0', sizeof(uint64_t)*words);
+      if (s >= csound->dag_num_active) csound->dag_num_active = s+1;
+      csound->dag_num_live++;
+      dag_connect(csound, s);
+    }
+    while (csound->dag_num_active > 0 &&
+           csound->dag_task_map[csound->dag_num_active-1] == NULL)
+      csound->dag_num_active--;
+    csound->dag_changed = 0;
+    if (UNLIKELY(csound->oparms->odebug))
+      printf("dag_update: %d live tasks in %d slots\n",
+             csound->dag_num_live, csound->dag_num_active);
 }
 
+/* Set every task to its initial state for a new k-cycle */
 void dag_reinit(CSOUND *csound)
 {
-    int i;
+    int i, k;
     int max = csound->dag_task_max_size;
+    int words = csound->dag_dep_words;
     volatile stateWithPadding *task_status = csound->dag_task_status;
     watchList * volatile *task_watch = csound->dag_task_watch;
     watchList *wlmm = csound->dag_wlmm;
@@ -283,23 +373,39 @@ void dag_reinit(CSOUND *csound)
       printf("DAG REINIT************************\n");
     for (i=csound->dag_num_active; i<max; i++)
       task_status[i].s = DONE;
-    task_status[0].s = AVAILABLE;
-    task_watch[0] = NULL;
-    for (i=1; i<csound->dag_num_active; i++) {
-      int j;
-      task_status[i].s = AVAILABLE;
+    for (i=0; i<csound->dag_num_active; i++) {
       task_watch[i] = NULL;
-      if (csound->dag_task_dep[i]==NULL) continue;
-      for (j=0; j<i; j++)
-        if (csound->dag_task_dep[i][j]) {
-          task_status[i].s = WAITING;
-          wlmm[i].id = i;
-          wlmm[i].next = task_watch[j];
-          task_watch[j] = &wlmm[i];
-          break;
-        }
+      task_status[i].s = csound->dag_task_map[i] == NULL ? DONE : AVAILABLE;
     }
-    //dag_print_state(csound);
+    for (i=0; i<csound->dag_num_active; i++) {
+      uint64_t *tt;
+      if (csound->dag_task_map[i] == NULL) continue;
+      tt = DEP_ROW(csound, i);
+      if ((k = dep_next(tt, words, 0)) >= 0) { /* watch the first prerequisite */
+        task_status[i].s = WAITING;
+        wlmm[i].id = i;
+        wlmm[i].next = task_watch[k];
+        task_watch[k] = &wlmm[i];
+      }
+    }
+    csound->dag_num_ready = 0;
+    for (i=0; i<csound->dag_num_active; i++)
+      if (task_status[i].s == AVAILABLE) csound->dag_num_ready++;
+    csound->dag_cycle_threads = csound->dag_active_threads;
+    csound->dag_timing = (csound->oparms->dagScheduler == DAG_SCHED_COST ||
+                          csound->oparms->dagReport ||
+                          (csound->oparms->msglevel & TIMEMSG));
+    if (csound->dag_timing) {
+      if (csound->dag_thread_stats == NULL)
+        csound->dag_thread_stats =
+          csound->Calloc(csound, 3*sizeof(double)*csound->oparms->numThreads);
+      else
+        memset(csound->dag_thread_stats, '\0',
+               2*sizeof(double)*csound->oparms->numThreads);
+    }
+    if (UNLIKELY(csound->oparms->odebug)) dag_print_state(csound);
+    if (csound->oparms->dagScheduler != DAG_SCHED_SCAN)
+      dag_seed_deques(csound);
 }
 
 //#define ATOMIC_READ(x) __atomic_load(&(x), __ATOMIC_SEQ_CST)
@@ -324,6 +430,169 @@ void dag_reinit(CSOUND *csound)
                               __ATOMIC_SEQ_CST)
 #endif
 
+/* Deque operations for the work-stealing dispatcher.  The loads and
+   stores of top and bottom need real ordering, unlike the status array */
+#if defined(_MSC_VER)
+#define DQ_LOAD(x)          InterlockedExchangeAdd(&(x), 0)
+#define DQ_STORE(x,v)       InterlockedExchange(&(x), v)
+#define DQ_FENCE()          MemoryBarrier()
+#define DQ_CAS(x,current,new) \
+  (current == InterlockedCompareExchange(x, new, current))
+#else
+#define DQ_LOAD(x)          __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define DQ_STORE(x,v)       __atomic_store_n(&(x), v, __ATOMIC_RELEASE)
+#define DQ_FENCE()          __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define DQ_CAS(x,current,new)  \
+  __atomic_compare_exchange_n(x,&(current),new, false, __ATOMIC_SEQ_CST, \
+                              __ATOMIC_SEQ_CST)
+#endif
+
+/* Only the owner pushes, and never more than the task table holds */
+static inline void dq_push(dagDeque *q, taskID t)
+{
+    long b = q->bottom;
+    q->tasks[b] = t;
+    DQ_STORE(q->bottom, b+1);
+}
+
+static inline taskID dq_pop(dagDeque *q)
+{
+    long b = q->bottom - 1;
+    long t;
+    taskID x = INVALID;
+    DQ_STORE(q->bottom, b);
+    DQ_FENCE();
+    t = DQ_LOAD(q->top);
+    if (t <= b) {
+      x = q->tasks[b];
+      if (t == b) {             /* last one; race any thief for it */
+        if (!DQ_CAS(&q->top, t, t+1)) x = INVALID;
+        DQ_STORE(q->bottom, b+1);
+      }
+    }
+    else DQ_STORE(q->bottom, b+1);
+    return x;
+}
+
+static inline taskID dq_steal(dagDeque *q)
+{
+    long t = DQ_LOAD(q->top);
+    long b;
+    DQ_FENCE();
+    b = DQ_LOAD(q->bottom);
+    if (t < b) {
+      taskID x = q->tasks[t];
+      if (DQ_CAS(&q->top, t, t+1)) return x;
+    }
+    return INVALID;
+}
+
+/* orders tasks by decreasing smoothed cost */
+static int dag_cost_cmp(const void *a, const void *b)
+{
+    double x = INSDS_PRIV(*(INSDS * const *)a)->dag_cost;
+    double y = INSDS_PRIV(*(INSDS * const *)b)->dag_cost;
+    return x < y ? 1 : x > y ? -1 : 0;
+}
+
+/* Longest processing time first, with affinity: the ready tasks are
+   taken in order of decreasing cost, and each goes back to the thread
+   that ran it last unless that would load the thread past its share,
+   in which case it goes to the least loaded thread.  Each deque is
+   filled cheapest first, so that its owner pops the longest task first
+   and thieves take the cheap ones from the other end. */
+#define DAG_MIN_COST (1.0e-7)     /* so that untimed tasks still spread */
+
+static void dag_seed_by_cost(CSOUND *csound, int nq)
+{
+    INSDS **ready = csound->dag_ready;
+    int *to = csound->dag_ready_to;
+    double *load = csound->dag_thread_stats + 2*csound->oparms->numThreads;
+    double total = 0.0, share;
+    int i, j, t, nready = 0;
+
+    for (i=0; i<csound->dag_num_active; i++)
+      if (csound->dag_task_status[i].s == AVAILABLE) {
+        ready[nready++] = csound->dag_task_map[i];
+        total += INSDS_PRIV(csound->dag_task_map[i])->dag_cost + DAG_MIN_COST;
+      }
+    qsort(ready, nready, sizeof(INSDS*), dag_cost_cmp);
+    for (t=0; t<nq; t++) load[t] = 0.0;
+    share = total/nq;
+    for (i=0; i<nready; i++) {
+      INSDS_PRIV *q = INSDS_PRIV(ready[i]);
+      double cost = q->dag_cost + DAG_MIN_COST;
+      t = q->dag_thread;
+      if (t >= nq || (load[t] > 0.0 && load[t]+cost > share)) {
+        for (t=0, j=1; j<nq; j++)
+          if (load[j] < load[t]) t = j;
+      }
+      load[t] += cost;
+      to[i] = t;
+    }
+    for (i=nready-1; i>=0; i--)
+      dq_push(&csound->dag_deques[to[i]], INSDS_PRIV(ready[i])->dag_slot);
+}
+
+/* Called from the main thread before the workers are released, so no
+   locking is needed.  Tasks with no dependencies are dealt round robin
+   to the threads taking part; the rest are pushed by whoever finishes
+   their last prerequisite. */
+static void dag_seed_deques(CSOUND *csound)
+{
+    int i, n = csound->oparms->numThreads;
+    int active = csound->dag_num_active;
+    int nq = csound->dag_active_threads;
+    dagDeque *q;
+    if (csound->dag_deques == NULL ||
+        csound->dag_deque_size < csound->dag_task_max_size) {
+      if (csound->dag_deques == NULL)
+        csound->dag_deques = csound->Calloc(csound, sizeof(dagDeque)*n);
+      csound->dag_deque_size = csound->dag_task_max_size;
+      for (i=0; i<n; i++) {
+        q = &csound->dag_deques[i];
+        q->tasks = csound->ReAlloc(csound, q->tasks,
+                                   sizeof(taskID)*csound->dag_deque_size);
+      }
+      csound->dag_ready = csound->ReAlloc(csound, csound->dag_ready,
+                                       sizeof(INSDS*)*csound->dag_deque_size);
+      csound->dag_ready_to = csound->ReAlloc(csound, csound->dag_ready_to,
+                                       sizeof(int)*csound->dag_deque_size);
+    }
+    for (i=0; i<n; i++) {
+      csound->dag_deques[i].top = 0;
+      csound->dag_deques[i].bottom = 0;
+    }
+    csound->dag_num_remaining = csound->dag_num_live;
+    if (csound->oparms->dagScheduler == DAG_SCHED_COST) {
+      dag_seed_by_cost(csound, nq);
+      return;
+    }
+    q = csound->dag_deques;
+    for (i=0; i<active; i++) {
+      if (csound->dag_task_status[i].s == AVAILABLE) {
+        dq_push(q, i);
+        if (++q == csound->dag_deques+nq) q = csound->dag_deques;
+      }
+    }
+}
+
+static taskID dag_steal_task(CSOUND *csound, int index)
+{
+    int n = csound->oparms->numThreads;
+    dagDeque *deques = csound->dag_deques;
+    int i;
+    taskID t = dq_pop(&deques[index]);
+    if (t != INVALID) return t;
+    /* Own deque empty; try to steal starting from the next thread */
+    for (i = (index+1==n ? 0 : index+1); i != index; i = (i+1==n ? 0 : i+1)) {
+      t = dq_steal(&deques[i]);
+      if (t != INVALID) return t;
+    }
+    if (ATOMIC_GET(csound->dag_num_remaining) == 0) return (taskID)INVALID;
+    return (taskID)WAIT;
+}
+
 taskID dag_get_task(CSOUND *csound, int index, int numThreads, taskID next_task)
 {
     int i;
@@ -340,6 +609,12 @@ taskID dag_get_task(CSOUND *csound, int index, int numThreads, taskID next_task)
       return next_task;
     }
 
+    if (csound->oparms->dagScheduler != DAG_SCHED_SCAN) {
+      taskID t = dag_steal_task(csound, index);
+      if (t >= 0) ATOMIC_WRITE(task_status[t].s, INPROGRESS);
+      return t;
+    }
+
     //printf("**GetTask from %d\n", csound->dag_num_active);
     i = start;
     do {
@@ -406,11 +681,13 @@ inline static int moveWatch(CSOUND *csound, watchList * volatile *w,
     return 1;
 }
 
-taskID dag_end_task(CSOUND *csound, taskID i)
+taskID dag_end_task(CSOUND *csound, int index, taskID i)
 {
     watchList *to_notify, *next;
     int canQueue;
     int j, k;
+    int words = csound->dag_dep_words;
+    uint64_t *deps;
     watchList * volatile *task_watch = csound->dag_task_watch;
     enum state current_task_status;
     int wait_on_current_tasks;
@@ -434,9 +711,10 @@ taskID dag_end_task(CSOUND *csound, taskID i)
       //printf("%d notifying task %d it finished\n", i, j);
       canQueue = 1;
       wait_on_current_tasks = 0;
+      deps = DEP_ROW(csound, j);
 
-      for (k=0; k<j; k++) {     /* seek next watch */
-        if (csound->dag_task_dep[j][k]==0) continue;
+      for (k = dep_next(deps, words, 0); k >= 0;
+           k = dep_next(deps, words, k+1)) {     /* seek next watch */
         current_task_status = ATOMIC_READ(csound->dag_task_status[k].s);
         //printf("investigating task %d (%d)\n", k, current_task_status);
 
@@ -465,8 +743,8 @@ taskID dag_end_task(CSOUND *csound, taskID i)
 
       // Try the same thing again but this time waiting on active or available task
       if (wait_on_current_tasks == 1) {
-        for (k=0; k<j; k++) {     /* seek next watch */
-          if (csound->dag_task_dep[j][k]==0) continue;
+        for (k = dep_next(deps, words, 0); k >= 0;
+             k = dep_next(deps, words, k+1)) {     /* seek next watch */
           current_task_status = ATOMIC_READ(csound->dag_task_status[k].s);
           //printf("investigating task %d (%d)\n", k, current_task_status);
 
@@ -494,14 +772,487 @@ taskID dag_end_task(CSOUND *csound, taskID i)
           next_task = j; // Forward directly to the thread to save re-dispatch
         } else {
           ATOMIC_WRITE(csound->dag_task_status[j].s, AVAILABLE);
+          if (csound->oparms->dagScheduler != DAG_SCHED_SCAN)
+            dq_push(&csound->dag_deques[index], j);
         }
       }
       to_notify = next;
     }
+    if (csound->oparms->dagScheduler != DAG_SCHED_SCAN)
+      ATOMIC_DECR(csound->dag_num_remaining);
     //dag_print_state(csound);
     return next_task;
 }
 
+/* Adaptive worker count.  After its share of a k-cycle the main thread
+   estimates the cost of a task and wakes only as many threads for the
+   next cycle as have at least DAG_THREAD_GRAIN seconds of work each and
+   a ready task to start on.  The others sleep on their own condition
+   variable rather than on the barriers. */
+#define DAG_THREAD_GRAIN (2.0e-5)
+
+#define IDLE_MUTEX(csound, i) ((csound)->dag_idle_locks[i])
+#define IDLE_COND(csound, i)  \
+  ((csound)->dag_idle_locks[(csound)->oparms->numThreads + (i)])
+
+/* called after dag_active_threads or multiThreadedComplete changed */
+void dag_wake_workers(CSOUND *csound, int from, int to)
+{
+    int i;
+    if (csound->dag_idle_locks == NULL) return;
+    for (i = from; i < to; i++)
+      if (ATOMIC_GET(csound->dag_idle_parked[i])) {
+        csoundLockMutex(IDLE_MUTEX(csound, i));
+        csoundCondSignal(IDLE_COND(csound, i));
+        csoundUnlockMutex(IDLE_MUTEX(csound, i));
+      }
+}
+
+/* Called by the main thread before barrier2; barrier1 is idle then */
+void dag_set_threads(CSOUND *csound, double elapsed)
+{
+    int i, n = csound->oparms->numThreads;
+    int cur = csound->dag_active_threads, want;
+    double cost;
+
+    if (!csound->oparms->adaptiveThreads) return;
+    if (csound->dag_idle_locks == NULL) {
+      csound->dag_idle_parked = csound->Calloc(csound, sizeof(int)*n);
+      csound->dag_idle_locks = csound->Calloc(csound, 2*sizeof(void*)*n);
+      for (i = 1; i < n; i++) {
+        IDLE_MUTEX(csound, i) = csoundCreateMutex(0);
+        IDLE_COND(csound, i) = csoundCreateCondVar();
+      }
+    }
+    if (csound->dag_num_live > 0) {
+      cost = elapsed*cur/csound->dag_num_live;
+      /* follow a rise at once but decay slowly, so that a quiet cycle
+         does not send threads to sleep only to wake them again */
+      if (cost > csound->dag_task_cost) csound->dag_task_cost = cost;
+      else csound->dag_task_cost += 0.05*(cost - csound->dag_task_cost);
+    }
+    want = 1 + (int)(csound->dag_num_live*csound->dag_task_cost/
+                     DAG_THREAD_GRAIN);
+    if (want > csound->dag_num_ready) want = csound->dag_num_ready;
+    if (want > n) want = n;
+    if (want < 1) want = 1;
+    if (want == cur) return;
+    csp_barrier_set_count(csound->barrier1, want);
+    ATOMIC_SET(csound->dag_active_threads, want);
+    if (want > cur) dag_wake_workers(csound, cur, want);
+}
+
+/* Called by worker index while it is not needed; returns 1 if the
+   performance has ended */
+int dag_worker_idle(CSOUND *csound, int index)
+{
+    volatile int *parked = &csound->dag_idle_parked[index];
+    int done;
+    /* as in csp_barrier_wait: the flag is set before the state is read
+       again, so either we see the change or the waker signals us */
+    csoundLockMutex(IDLE_MUTEX(csound, index));
+    ATOMIC_SET(*parked, 1);
+    while (index >= ATOMIC_GET(csound->dag_active_threads) &&
+           !ATOMIC_GET(csound->multiThreadedComplete))
+      csoundCondWait(IDLE_COND(csound, index), IDLE_MUTEX(csound, index));
+    ATOMIC_SET(*parked, 0);
+    done = index >= ATOMIC_GET(csound->dag_active_threads);
+    csoundUnlockMutex(IDLE_MUTEX(csound, index));
+    return done;
+}
+
+/* Makespan counters, kept while tasks are timed.  The lower bound for
+   a k-cycle is the larger of its longest task and its total work
+   spread evenly over the threads taking part. */
+void dag_cycle_stats(CSOUND *csound, double makespan)
+{
+    double *st = csound->dag_thread_stats;
+    double work = 0.0, longest = 0.0;
+    int i;
+    if (!csound->dag_timing) return;
+    for (i=0; i<csound->oparms->numThreads; i++) {
+      work += st[2*i];
+      if (st[2*i+1] > longest) longest = st[2*i+1];
+    }
+    csound->dag_stat_cycles++;
+    csound->dag_stat_makespan += makespan;
+    csound->dag_stat_work += work;
+    work /= csound->dag_cycle_threads;
+    csound->dag_stat_bound += (work > longest ? work : longest);
+    if (csound->oparms->dagReport) dag_report_analyse(csound);
+}
+
+void dag_report_stats(CSOUND *csound)
+{
+    double n = (double)csound->dag_stat_cycles;
+    if (csound->dag_stat_cycles == 0) return;
+    csound->Message(csound,
+                    Str("DAG: %lld k-cycles, mean makespan %.2f us, "
+                        "lower bound %.2f us (%.0f%%), work %.2f us\n"),
+                    (long long)csound->dag_stat_cycles,
+                    1.0e6*csound->dag_stat_makespan/n,
+                    1.0e6*csound->dag_stat_bound/n,
+                    100.0*csound->dag_stat_bound/csound->dag_stat_makespan,
+                    1.0e6*csound->dag_stat_work/n);
+}
+
+/* --dag-report: the critical path through the DAG, with each task
+   weighted by its measured cost, and the globals that put its edges
+   there.  Worked out by the main thread at the end of a k-cycle after
+   the DAG has changed, and every DAG_REPORT_EVERY k-cycles otherwise,
+   so that it follows the costs.  The longest path seen is printed at
+   the end, with the share of critical-path time owed to each global. */
+#define DAG_REPORT_EVERY (256)
+#define DAG_REPORT_PATH  (24)       /* tasks of the longest path kept */
+
+typedef struct dag_report_t {
+  uint32_t epoch;
+  int      cycles;                  /* since the last analysis */
+  int      size;                    /* slots the arrays below hold */
+  int      *order;                  /* slot of each chain position */
+  int      *pred;                   /* predecessor on the longest path */
+  double   *finish;                 /* longest path ending at the slot */
+  int      nglobals;
+  double   *blame;                  /* critical-path time, by global */
+  int64_t  *edges;                  /* critical-path edges, by global */
+  int64_t  analyses;
+  double   sum_length, sum_work, sum_blamed;
+  double   longest, longest_work;
+  int      longest_tasks;
+  int      path[DAG_REPORT_PATH];   /* insno, in order */
+  int      path_gid[DAG_REPORT_PATH]; /* why each waits, or -1 */
+} DAG_REPORT;
+
+/* The globals behind an edge between two instruments, as in
+   dag_intersect; returns the first or -1 */
+static int dag_conflict(INSTR_SEMANTICS *a, INSTR_SEMANTICS *b,
+                        DAG_REPORT *r, double cost)
+{
+    CSP_BITSETS *ab = CSP_BITSETS_GET(a), *bb = CSP_BITSETS_GET(b);
+    int w, n, first = -1;
+    if (ab == NULL || bb == NULL) return -1;
+    n = ab->nwords < bb->nwords ? ab->nwords : bb->nwords;
+    for (w=0; w<n; w++) {
+      uint64_t x = (ab->write[w] &
+                    (bb->read[w] | bb->write[w] | bb->read_write[w])) |
+                   (ab->read_write[w] & (bb->read[w] | bb->write[w])) |
+                   (ab->read[w] & (bb->write[w] | bb->read_write[w]));
+      while (x) {
+        int g = (w<<6) + dep_ctz(x);
+        x &= x-1;
+        if (first < 0) first = g;
+        if (r != NULL && g < r->nglobals) {
+          r->blame[g] += cost;
+          r->edges[g]++;
+        }
+      }
+    }
+    return first;
+}
+
+static void dag_report_analyse(CSOUND *csound)
+{
+    DAG_REPORT *r = csound->dag_report;
+    int words = csound->dag_dep_words, n = csound->dag_num_active;
+    int i, s, last = -1, tasks = 0, path[DAG_REPORT_PATH];
+    double length = 0.0, work = 0.0;
+
+    if (r == NULL)
+      r = csound->dag_report = csound->Calloc(csound, sizeof(DAG_REPORT));
+    if (r->epoch == csound->dag_epoch && ++r->cycles < DAG_REPORT_EVERY)
+      return;
+    r->epoch = csound->dag_epoch;
+    r->cycles = 0;
+    if (r->size < csound->dag_task_max_size) {
+      r->size = csound->dag_task_max_size;
+      r->order = csound->ReAlloc(csound, r->order, sizeof(int)*r->size);
+      r->pred = csound->ReAlloc(csound, r->pred, sizeof(int)*r->size);
+      r->finish = csound->ReAlloc(csound, r->finish, sizeof(double)*r->size);
+    }
+    if (r->nglobals < csound->dag_num_globals) {
+      int ng = csound->dag_num_globals;
+      r->blame = csound->ReAlloc(csound, r->blame, sizeof(double)*ng);
+      r->edges = csound->ReAlloc(csound, r->edges, sizeof(int64_t)*ng);
+      for (i=r->nglobals; i<ng; i++) r->blame[i] = 0.0, r->edges[i] = 0;
+      r->nglobals = ng;
+    }
+    /* every edge goes from earlier in the chain to later, so the chain
+       order is a topological one */
+    for (i=0; i<n; i++) r->order[i] = -1;
+    for (s=0; s<n; s++)
+      if (csound->dag_task_map[s] != NULL && csound->dag_task_rank[s] < n)
+        r->order[csound->dag_task_rank[s]] = s;
+    for (i=0; i<n; i++) {
+      uint64_t *row;
+      double best = 0.0, cost;
+      int k, p = -1;
+      if ((s = r->order[i]) < 0) continue;
+      row = DEP_ROW(csound, s);
+      for (k = dep_next(row, words, 0); k >= 0; k = dep_next(row, words, k+1))
+        if (r->finish[k] > best) best = r->finish[k], p = k;
+      r->pred[s] = p;
+      cost = INSDS_PRIV(csound->dag_task_map[s])->dag_cost;
+      r->finish[s] = best + cost + DAG_MIN_COST;
+      work += cost;
+      if (r->finish[s] > length) length = r->finish[s], last = s;
+    }
+    if (last < 0) return;
+    /* walk the path back, charging each edge to its globals */
+    for (s = last; s >= 0; s = r->pred[s]) {
+      if (tasks < DAG_REPORT_PATH) path[tasks] = s;
+      tasks++;
+      if (r->pred[s] >= 0) {
+        double cost =
+          INSDS_PRIV(csound->dag_task_map[s])->dag_cost + DAG_MIN_COST;
+        dag_conflict(csound->dag_task_sem[r->pred[s]],
+                     csound->dag_task_sem[s], r, cost);
+        r->sum_blamed += cost;
+      }
+    }
+    r->analyses++;
+    r->sum_length += length;
+    r->sum_work += work;
+    if (length > r->longest) {
+      /* keep the tail of the path if it is too long to keep whole */
+      int m = tasks < DAG_REPORT_PATH ? tasks : DAG_REPORT_PATH;
+      r->longest = length;
+      r->longest_work = work;
+      r->longest_tasks = tasks;
+      for (i=0; i<m; i++) {
+        s = path[m-1-i];
+        r->path[i] = csound->dag_task_map[s]->insno;
+        r->path_gid[i] = r->pred[s] < 0 ? -1 :
+          dag_conflict(csound->dag_task_sem[r->pred[s]],
+                       csound->dag_task_sem[s], NULL, 0.0);
+      }
+    }
+}
+
+void dag_report_critical(CSOUND *csound)
+{
+    DAG_REPORT *r = csound->dag_report;
+    char **names;
+    int *idx, i, n = 0, m;
+    CONS_CELL *keys, *k;
+
+    if (r == NULL || r->analyses == 0) return;
+    csound->Message(csound,
+                    Str("DAG report: %lld analyses, mean critical path "
+                        "%.2f us of %.2f us work (parallelism %.1f)\n"),
+                    (long long)r->analyses,
+                    1.0e6*r->sum_length/r->analyses,
+                    1.0e6*r->sum_work/r->analyses,
+                    r->sum_length > 0.0 ? r->sum_work/r->sum_length : 0.0);
+    csound->Message(csound,
+                    Str("longest critical path %.2f us over %d tasks "
+                        "(work %.2f us):\n  "),
+                    1.0e6*r->longest, r->longest_tasks,
+                    1.0e6*r->longest_work);
+    /* names of the global ids */
+    names = csound->Calloc(csound, sizeof(char*)*(r->nglobals+1));
+    keys = cs_hash_table_keys(csound, csound->dag_global_ids);
+    for (k = keys; k != NULL; k = k->next) {
+      int g = (int)(intptr_t)cs_hash_table_get(csound, csound->dag_global_ids,
+                                               (char*)k->value) - 1;
+      if (g >= 0 && g < r->nglobals) names[g] = (char*)k->value;
+    }
+    m = r->longest_tasks < DAG_REPORT_PATH ? r->longest_tasks : DAG_REPORT_PATH;
+    if (m < r->longest_tasks) csound->Message(csound, "... ");
+    for (i=0; i<m; ) {
+      int g = r->path_gid[i], insno = r->path[i], j = i+1;
+      char *iname = NULL;
+      if (insno <= csound->engineState.maxinsno &&
+          csound->engineState.instrtxtp[insno] != NULL)
+        iname = csound->engineState.instrtxtp[insno]->insname;
+      if (i > 0)
+        csound->Message(csound, " -[%s]-> ",
+                        g >= 0 && names[g] != NULL ? names[g] : "?");
+      if (iname != NULL) csound->Message(csound, "%s", iname);
+      else csound->Message(csound, Str("instr %d"), insno);
+      /* a chain of instances of one instrument is shown once */
+      while (j < m && r->path[j] == insno && r->path_gid[j] == r->path_gid[i+1])
+        j++;
+      if (j > i+1) {
+        g = r->path_gid[i+1];
+        csound->Message(csound, Str(" x%d (chained by %s)"), j-i,
+                        g >= 0 && names[g] != NULL ? names[g] : "?");
+      }
+      i = j;
+    }
+    csound->Message(csound, "\n");
+    /* and the globals most of the time on critical paths waits for */
+    idx = csound->Malloc(csound, sizeof(int)*(r->nglobals+1));
+    for (i=0; i<r->nglobals; i++)
+      if (r->edges[i] > 0) idx[n++] = i;
+    if (n > 0 && r->sum_blamed > 0.0)
+      csound->Message(csound, Str("serialised by (share of critical-path "
+                                  "time, edges):\n"));
+    for (i=0; i<n && i<10 && r->sum_blamed > 0.0; i++) {
+      int j, t;
+      for (j=i+1; j<n; j++)     /* bring the next largest forward */
+        if (r->blame[idx[j]] > r->blame[idx[i]])
+          t = idx[i], idx[i] = idx[j], idx[j] = t;
+      csound->Message(csound, "  %-24s %5.1f%% %10lld\n",
+                      names[idx[i]] != NULL ? names[idx[i]] : "?",
+                      100.0*r->blame[idx[i]]/r->sum_blamed,
+                      (long long)r->edges[idx[i]]);
+    }
+    cs_cons_free(csound, keys);
+    csound->Free(csound, idx);
+    csound->Free(csound, names);
+}
+
+/* Semantics of the instrument of ip, or NULL for a UDO instance as
+   those are not analysed */
+static INSTR_SEMANTICS *dag_accum_sem(CSOUND *csound, INSDS *ip)
+{
+    INSTR_SEMANTICS *sem;
+    char *name;
+    if (ip->opcod_iobufs != NULL) return NULL;
+    sem = csp_orc_sa_instr_get_by_num(csound, ip->insno);
+    name = csound->engineState.instrtxtp[ip->insno]->insname;
+    if (sem == NULL && name != NULL)
+      sem = csp_orc_sa_instr_get_by_name(csound, name);
+    return sem;
+}
+
+/* Semantic id of a global.  A channel the analysis never saw named
+   ("##chn:name") is only touched through "##chn", which stands for all
+   channels. */
+static int dag_accum_gid(CSOUND *csound, const char *name)
+{
+    const char *colon;
+    char base[8];
+    int gid;
+    if (name == NULL || csound->dag_global_ids == NULL) return -1;
+    gid = (int)(intptr_t)cs_hash_table_get(csound, csound->dag_global_ids,
+                                           (char*)name) - 1;
+    colon = strchr(name, ':');
+    if (gid < 0 && colon != NULL && colon-name < 8) {
+      memcpy(base, name, colon-name);
+      base[colon-name] = '\0';
+      gid = (int)(intptr_t)cs_hash_table_get(csound, csound->dag_global_ids,
+                                             base) - 1;
+    }
+    return gid;
+}
+
+/* Accumulate-only buffers.  Called at init time, possibly from the
+   event thread while the performance thread walks the list, so new
+   entries are complete before they are pushed on the front. */
+DAG_ACCUM *dag_accum_find(CSOUND *csound, INSDS *ip, MYFLT *target,
+                          int size, const char *name)
+{
+    DAG_ACCUM *a, *head, *new = NULL;
+    int n = csound->oparms->numThreads, gid;
+
+    if (n < 2 || target == NULL) return NULL;
+    gid = dag_accum_gid(csound, name);
+    if (ip != NULL) {
+      /* an instrument that also reads the target, or overwrites it, is
+         ordered against every one mixing in and must see its own
+         additions, so it mixes into the target itself; so does one the
+         analysis did not see mixing into it */
+      INSTR_SEMANTICS *sem = dag_accum_sem(csound, ip);
+      CSP_BITSETS *b = sem != NULL ? CSP_BITSETS_GET(sem) : NULL;
+      uint64_t bit = (uint64_t)1 << (gid&63);
+      if (b == NULL || gid < 0 || (gid>>6) >= b->nwords ||
+          ((b->read[gid>>6] | b->write[gid>>6]) & bit) ||
+          !(b->read_write[gid>>6] & bit))
+        return NULL;
+    }
+    do {
+      head = csound->dag_accums;
+      for (a = head; a != NULL; a = a->next)
+        if (a->target == target) {
+          if (new != NULL) {
+            csound->Free(csound, new->name);
+            csound->Free(csound, new->scratch);
+            csound->Free(csound, (void*)new->dirty);
+            csound->Free(csound, new);
+          }
+          return a;
+        }
+      if (new == NULL) {
+        new = csound->Calloc(csound, sizeof(DAG_ACCUM));
+        new->target = target;
+        new->size = size;
+        new->stride = (size + 7) & ~7;  /* keep the blocks aligned */
+        new->threads = n;
+        new->scratch = csound->Calloc(csound, sizeof(MYFLT)*new->stride*n);
+        new->dirty = csound->Calloc(csound, sizeof(int)*n);
+        new->gid = gid;
+        new->name = name != NULL ? cs_strdup(csound, (char*)name) : NULL;
+        new->nglobals = csound->dag_num_globals;
+        csoundSpinLockInit(&new->lock);
+      }
+      new->next = head;
+    } while (!ATOMIC_CAS_PTR(&csound->dag_accums, head, new));
+    return new;
+}
+
+/* Add the scratch blocks into the target and clear them.  The inner
+   loop is a plain sum over contiguous arrays, which compilers vectorise. */
+void dag_accum_flush(CSOUND *csound, DAG_ACCUM *a)
+{
+    int t, i, size = a->size;
+    MYFLT *dst = a->target;
+
+    if (!a->pending) return;
+    csoundSpinLock(&a->lock);
+    if (a->pending) {
+      for (t = 1; t < a->threads; t++) {
+        MYFLT *src = a->scratch + t*a->stride;
+        if (!a->dirty[t]) continue;
+        for (i = 0; i < size; i++) dst[i] += src[i];
+        memset(src, 0, sizeof(MYFLT)*size);
+        a->dirty[t] = 0;
+      }
+      a->pending = 0;
+    }
+    csoundSpinUnLock(&a->lock);
+    IGN(csound);
+}
+
+/* Called before a task runs: flush what it reads or overwrites.  Any
+   task mixing into such a buffer is ordered against this one by the
+   DAG, so none is running now. */
+void dag_accum_flush_for(CSOUND *csound, INSTR_SEMANTICS *sem)
+{
+    DAG_ACCUM *a;
+    CSP_BITSETS *b = sem != NULL ? CSP_BITSETS_GET(sem) : NULL;
+    if (b == NULL) return;
+    for (a = csound->dag_accums; a != NULL; a = a->next) {
+      int w = a->gid >> 6;
+      uint64_t bit = (uint64_t)1 << (a->gid & 63);
+      if (!a->pending || a->gid < 0 || w >= b->nwords)
+        continue;
+      if ((b->read[w] | b->write[w]) & bit)
+        dag_accum_flush(csound, a);
+    }
+}
+
+/* A later compilation may name a channel that a buffer was so far only
+   known by as "##chn"; from then on tasks reading it use the new id.
+   Called by the main thread while the DAG is brought up to date. */
+static void dag_accum_resolve(CSOUND *csound)
+{
+    DAG_ACCUM *a;
+    for (a = csound->dag_accums; a != NULL; a = a->next)
+      if (a->nglobals != csound->dag_num_globals) {
+        if (a->name != NULL) a->gid = dag_accum_gid(csound, a->name);
+        a->nglobals = csound->dag_num_globals;
+      }
+}
+
+/* Called by the main thread after the last task of the k-cycle */
+void dag_accum_flush_all(CSOUND *csound)
+{
+    DAG_ACCUM *a;
+    for (a = csound->dag_accums; a != NULL; a = a->next)
+      dag_accum_flush(csound, a);
+}
+
 
 /* INV : Acyclic */
 /* INV : Each entry is read by a single thread,
@@ -23,8 +23,18 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <errno.h>
 
 #include "csoundCore.h"
+#if defined(HAVE_PTHREAD) && !defined(WIN32)
+#include <pthread.h>
+#include <sched.h>
+#endif
+#if defined(LINUX)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 #include "cs_par_base.h"
 static int csp_set_exists(struct set_t *set, void *data);
@@ -144,29 +154,310 @@ int barrier_wait(barrier_t *b)
 /***********************************************************************
  * parallel primitives
  */
+#if defined(_MSC_VER)
+#define BAR_INCR(x)         InterlockedIncrement((volatile long *)&(x))
+#define BAR_ADD64(x,v)      InterlockedExchangeAdd64(&(x), v)
+#else
+#define BAR_INCR(x)         __atomic_add_fetch(&(x), 1, __ATOMIC_SEQ_CST)
+#define BAR_ADD64(x,v)      __atomic_add_fetch(&(x), v, __ATOMIC_RELAXED)
+#endif
+
 void csp_barrier_alloc(CSOUND *csound, void **barrier,
                        int thread_count)
 {
+    CSP_BARRIER *b;
+    int i;
     if (UNLIKELY(barrier == NULL))
       csound->Die(csound, Str("Invalid NULL Parameter barrier"));
     if (UNLIKELY(thread_count < 1))
       csound->Die(csound, Str("Invalid Parameter thread_count must be > 0"));
 
-    *barrier = csound->CreateBarrier(thread_count);
-    if (UNLIKELY(*barrier == NULL)) {
+    b = csound->Calloc(csound, sizeof(CSP_BARRIER));
+    b->size = b->max = thread_count;
+    b->spin = csound->oparms->barrierSpin;
+    b->stats = (csound->oparms->msglevel & TIMEMSG) != 0;
+    b->mutexes = csound->Calloc(csound, 2*sizeof(void*)*thread_count);
+    b->conds = b->mutexes + thread_count;
+    b->parked = csound->Calloc(csound, sizeof(int)*thread_count);
+    for (i=0; i<thread_count; i++) {
+      b->mutexes[i] = csoundCreateMutex(0);
+      b->conds[i] = csoundCreateCondVar();
+      if (UNLIKELY(b->mutexes[i] == NULL || b->conds[i] == NULL))
         csound->Die(csound, Str("Failed to allocate barrier"));
     }
+    *barrier = b;
 }
 
 void csp_barrier_dealloc(CSOUND *csound, void **barrier)
 {
+    CSP_BARRIER *b;
+    int i;
     if (UNLIKELY(barrier == NULL || *barrier == NULL))
       csound->Die(csound, Str("Invalid NULL Parameter barrier"));
+    b = (CSP_BARRIER *)*barrier;
+    for (i=0; i<b->size; i++) {
+      csoundDestroyMutex(b->mutexes[i]);
+      csoundDestroyCondVar(b->conds[i]);
+    }
+    csound->Free(csound, (void*)b->parked);
+    csound->Free(csound, b->mutexes);
+    csound->Free(csound, b);
+    *barrier = NULL;
+}
+
+/* index is the caller's thread index (0 for the main thread).  A
+   negative index parks on the arrival slot instead, which is only safe
+   while every allocated thread takes part.  Returns 1 in the thread
+   that arrived last, 0 in the others. */
+int csp_barrier_wait(CSOUND *csound, void *barrier, int index)
+{
+    CSP_BARRIER *b = (CSP_BARRIER *)barrier;
+    unsigned int gen = ATOMIC_GET(b->generation);
+    int slot, i;
+    int64_t ns;
+    double start = b->stats ? csoundRealTimeSeconds() : 0.0;
+
+    slot = BAR_INCR(b->count);
+    if (slot == b->max) {                /* last one in releases the rest */
+      b->count = 0;
+      BAR_INCR(b->generation);
+      for (i = 0; i < b->size; i++)
+        if (ATOMIC_GET(b->parked[i])) {
+          csoundLockMutex(b->mutexes[i]);
+          csoundCondSignal(b->conds[i]);
+          csoundUnlockMutex(b->mutexes[i]);
+        }
+      if (b->stats) BAR_ADD64(b->waits, 1);
+      return 1;
+    }
+    for (i=0; i<b->spin; i++) {
+      if (ATOMIC_GET(b->generation) != gen) break;
+      CSP_RELAX();
+    }
+    if (ATOMIC_GET(b->generation) == gen) {
+      slot = index < 0 ? slot - 1 : index;
+      /* the flag is set before the generation is read again, and the
+         releaser reads it after changing the generation, so either we
+         see the new generation or it signals us, under our mutex */
+      csoundLockMutex(b->mutexes[slot]);
+      ATOMIC_SET(b->parked[slot], 1);
+      if (ATOMIC_GET(b->generation) == gen) {
+        do {
+          csoundCondWait(b->conds[slot], b->mutexes[slot]);
+        } while (ATOMIC_GET(b->generation) == gen);
+        if (b->stats) BAR_ADD64(b->parks, 1);
+      }
+      ATOMIC_SET(b->parked[slot], 0);
+      csoundUnlockMutex(b->mutexes[slot]);
+    }
+    if (b->stats) {
+      ns = (int64_t)(1.0e9*(csoundRealTimeSeconds() - start));
+      BAR_ADD64(b->waits, 1);
+      BAR_ADD64(b->wait_ns, ns);
+      if (ns > b->max_ns) b->max_ns = ns; /* approximate under contention */
+    }
+    return 0;
+}
+
+/* change the number of threads taking part; only safe while no thread
+   is inside or about to enter this barrier */
+void csp_barrier_set_count(void *barrier, int thread_count)
+{
+    CSP_BARRIER *b = (CSP_BARRIER *)barrier;
+    if (thread_count < 1) thread_count = 1;
+    if (thread_count > b->size) thread_count = b->size;
+    ATOMIC_SET(b->max, thread_count);
+}
+
+void csp_barrier_report(CSOUND *csound, void *barrier, const char *name)
+{
+    CSP_BARRIER *b = (CSP_BARRIER *)barrier;
+    int64_t waits;
+    if (b == NULL || (waits = b->waits) == 0) return;
+    csound->Message(csound,
+                    Str("%s: %lld waits, %.1f%% parked, "
+                        "mean wait %.2f us, max wait %.2f us\n"),
+                    name, (long long)waits, 100.0*b->parks/waits,
+                    1.0e-3*b->wait_ns/waits, 1.0e-3*b->max_ns);
+}
+
+
+
+/***********************************************************************
+ * thread placement
+ */
+#define CSP_MAX_CPUS 1024
 
-    csound->DestroyBarrier(*barrier);
+/* parse a list such as "0-3,8" into cpus[]; returns the count or -1 */
+static int csp_parse_cpu_list(const char *s, int *cpus, int max)
+{
+    int n = 0;
+    while (*s != '\0') {
+      char *end;
+      long lo = strtol(s, &end, 10), hi;
+      if (end == s || lo < 0) return -1;
+      hi = lo;
+      s = end;
+      if (*s == '-') {
+        hi = strtol(s+1, &end, 10);
+        if (end == s+1 || hi < lo) return -1;
+        s = end;
+      }
+      for (; lo <= hi && lo < CSP_MAX_CPUS; lo++) {
+        int i;
+        for (i = 0; i < n && cpus[i] != lo; i++) ;
+        if (i == n && n < max) cpus[n++] = (int)lo;
+      }
+      if (*s == ',') s++;
+      else if (*s != '\0') return -1;
+    }
+    return n;
 }
 
+void csp_thread_placement_init(CSOUND *csound)
+{
+    OPARMS *O = csound->oparms;
+    int *cpus, n = 0;
+
+    csound->thread_ncpus = 0;
+    csound->perf_thread_placed = 0;
+    if (O->threadCpus == NULL && O->threadNuma < 0) return;
+    cpus = csound->Calloc(csound, sizeof(int)*CSP_MAX_CPUS);
+    if (O->threadCpus != NULL &&
+        (n = csp_parse_cpu_list(O->threadCpus, cpus, CSP_MAX_CPUS)) <= 0) {
+      csound->Warning(csound, Str("invalid CPU list '%s' ignored"),
+                      O->threadCpus);
+      n = 0;
+    }
+    if (O->threadNuma >= 0) {
+#if defined(LINUX)
+      char path[64], buf[1024];
+      int node[CSP_MAX_CPUS], nn = -1, i, j, k;
+      FILE *f;
+      snprintf(path, 64, "/sys/devices/system/node/node%d/cpulist",
+               O->threadNuma);
+      if ((f = fopen(path, "r")) != NULL) {
+        if (fgets(buf, 1024, f) != NULL) {
+          buf[strcspn(buf, "\n")] = '\0';
+          nn = csp_parse_cpu_list(buf, node, CSP_MAX_CPUS);
+        }
+        fclose(f);
+      }
+      if (nn <= 0) {
+        csound->Warning(csound, Str("NUMA node %d not found, "
+                                    "--thread-numa ignored"), O->threadNuma);
+        O->threadNuma = -1;
+      }
+      else if (n == 0) {
+        memcpy(cpus, node, sizeof(int)*nn);
+        n = nn;
+      }
+      else {                    /* keep the listed CPUs that are on the node */
+        for (i = k = 0; i < n; i++)
+          for (j = 0; j < nn; j++)
+            if (cpus[i] == node[j]) { cpus[k++] = cpus[i]; break; }
+        if (k == 0) {
+          csound->Warning(csound, Str("no CPU in '%s' is on NUMA node %d, "
+                                      "using the node's CPUs"),
+                          O->threadCpus, O->threadNuma);
+          memcpy(cpus, node, sizeof(int)*nn);
+          k = nn;
+        }
+        n = k;
+      }
+#else
+      csound->Warning(csound, Str("--thread-numa is not supported "
+                                  "on this platform"));
+      O->threadNuma = -1;
+#endif
+    }
+    csound->thread_cpus = cpus;
+    csound->thread_ncpus = n;
+}
 
+/* Each setting is tried on its own, and a refused one leaves the thread
+   as it was; the message says what took effect. */
+void csp_thread_place(CSOUND *csound, int index, const char *name)
+{
+    OPARMS *O = csound->oparms;
+    char msg[256];
+    int len = 0;
+
+    if (csound->thread_ncpus == 0 && O->threadNuma < 0 &&
+        O->threadSched == CSP_SCHED_OTHER)
+      return;
+    msg[0] = '\0';
+#if defined(LINUX)
+    if (csound->thread_ncpus > 0) {
+      cpu_set_t set;
+      int i, err;
+      CPU_ZERO(&set);
+      if (index >= 0)
+        CPU_SET(csound->thread_cpus[index % csound->thread_ncpus], &set);
+      else
+        for (i = 0; i < csound->thread_ncpus; i++)
+          CPU_SET(csound->thread_cpus[i], &set);
+      if ((err = pthread_setaffinity_np(pthread_self(),
+                                        sizeof(cpu_set_t), &set)) == 0) {
+        if (index >= 0)
+          len += snprintf(msg+len, 256-len, Str(" CPU %d;"),
+                          csound->thread_cpus[index % csound->thread_ncpus]);
+        else
+          len += snprintf(msg+len, 256-len, Str(" %d CPUs;"),
+                          csound->thread_ncpus);
+      }
+      else
+        len += snprintf(msg+len, 256-len, Str(" CPU affinity refused (%s);"),
+                        strerror(err));
+    }
+    if (O->threadNuma >= 0 && len < 256) {
+      /* prefer the node for memory this thread touches first */
+      unsigned long mask[CSP_MAX_CPUS/(8*sizeof(unsigned long))];
+      memset(mask, 0, sizeof(mask));
+      if (O->threadNuma < CSP_MAX_CPUS) {
+        mask[O->threadNuma/(8*sizeof(unsigned long))] |=
+          1UL << (O->threadNuma % (8*sizeof(unsigned long)));
+      }
+      if (syscall(SYS_set_mempolicy, 1 /* MPOL_PREFERRED */, mask,
+                  (unsigned long)CSP_MAX_CPUS + 1) == 0)
+        len += snprintf(msg+len, 256-len, Str(" memory on node %d;"),
+                        O->threadNuma);
+      else
+        len += snprintf(msg+len, 256-len, Str(" NUMA memory policy "
+                                              "refused (%s);"),
+                        strerror(errno));
+    }
+#else
+    if (csound->thread_ncpus > 0)
+      len += snprintf(msg+len, 256-len, Str(" CPU affinity not supported;"));
+#endif
+    if (O->threadSched != CSP_SCHED_OTHER && len < 256) {
+#if defined(HAVE_PTHREAD) && !defined(WIN32)
+      struct sched_param p;
+      int policy = (O->threadSched == CSP_SCHED_FIFO ? SCHED_FIFO : SCHED_RR);
+      const char *pname = (policy == SCHED_FIFO ? "SCHED_FIFO" : "SCHED_RR");
+      int err, lo = sched_get_priority_min(policy);
+      int hi = sched_get_priority_max(policy);
+      memset(&p, 0, sizeof(p));
+      p.sched_priority = O->threadPriority < lo ? lo :
+                         O->threadPriority > hi ? hi : O->threadPriority;
+      if ((err = pthread_setschedparam(pthread_self(), policy, &p)) == 0)
+        len += snprintf(msg+len, 256-len, " %s %d;", pname, p.sched_priority);
+      else
+        len += snprintf(msg+len, 256-len,
+                        Str(" %s refused (%s), default scheduling;"),
+                        pname, strerror(err));
+#else
+      len += snprintf(msg+len, 256-len,
+                      Str(" real-time scheduling not supported;"));
+#endif
+    }
+    if (len > 0 && msg[len-1] == ';') msg[len-1] = '\0';
+    if (index >= 0)
+      csound->Message(csound, Str("%s thread %d:%s\n"), name, index, msg);
+    else
+      csound->Message(csound, Str("%s thread:%s\n"), name, msg);
+}
 
 /***********************************************************************
  * set data structure
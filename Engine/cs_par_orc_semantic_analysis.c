@@ -121,6 +121,101 @@ void sanitize(CSOUND*csound)
       }
       p = p->next;
     }
+    csp_orc_sa_bitsets_update(csound);
+}
+
+static int global_id(CSOUND *csound, char *name)
+{
+    void *id = cs_hash_table_get(csound, csound->dag_global_ids, name);
+    if (id == NULL) {
+      id = (void*)(intptr_t)(++csound->dag_num_globals);
+      cs_hash_table_put(csound, csound->dag_global_ids, name, id);
+    }
+    return (int)(intptr_t)id - 1;
+}
+
+/* "##chn" and "##tab" on their own are used when the channel name or
+   table number is not known until performance, so they stand for every
+   channel or table and take in the bits of all the named ones */
+static void set_to_bits(CSOUND *csound, struct set_t *set, uint64_t *bits,
+                        int nwords, uint64_t *chn, uint64_t *tab)
+{
+    struct set_element_t *ele = set->head;
+    int w;
+    while (ele != NULL) {
+      char *name = (char*)ele->data;
+      int id = global_id(csound, name);
+      bits[id>>6] |= (uint64_t)1 << (id&63);
+      if (strcmp(name, "##chn") == 0)
+        for (w = 0; w < nwords; w++) bits[w] |= chn[w];
+      else if (strcmp(name, "##tab") == 0)
+        for (w = 0; w < nwords; w++) bits[w] |= tab[w];
+      ele = ele->next;
+    }
+}
+
+static void family_bits(CSOUND *csound, struct set_t *set,
+                        uint64_t *chn, uint64_t *tab)
+{
+    struct set_element_t *ele;
+    for (ele = set->head; ele != NULL; ele = ele->next) {
+      char *name = (char*)ele->data;
+      int id = global_id(csound, name);
+      if (strncmp(name, "##chn:", 6) == 0)
+        chn[id>>6] |= (uint64_t)1 << (id&63);
+      else if (strncmp(name, "##tab:", 6) == 0)
+        tab[id>>6] |= (uint64_t)1 << (id&63);
+    }
+}
+
+/* The DAG builder intersects these sets for every pair of active
+   instances, so keep a bitset copy of each.  New compilations can add
+   globals, in which case every instrument gets new bitsets, as a
+   channel or table named for the first time widens those using "##chn"
+   or "##tab".  Each instrument's bitsets are built in one block and
+   published with a single store; the old blocks are left for memRESET
+   as the performance thread may be using them. */
+void csp_orc_sa_bitsets_update(CSOUND *csound)
+{
+    INSTR_SEMANTICS *p;
+    uint64_t *chn, *tab;
+    int nwords;
+    if (csound->dag_global_ids == NULL)
+      csound->dag_global_ids = cs_hash_table_create(csound);
+    for (p = csound->instRoot; p != NULL; p = p->next) {
+      struct set_element_t *ele;
+      for (ele = p->read->head; ele != NULL; ele = ele->next)
+        global_id(csound, (char*)ele->data);
+      for (ele = p->write->head; ele != NULL; ele = ele->next)
+        global_id(csound, (char*)ele->data);
+      for (ele = p->read_write->head; ele != NULL; ele = ele->next)
+        global_id(csound, (char*)ele->data);
+    }
+    nwords = (csound->dag_num_globals+63)>>6;
+    chn = csound->Calloc(csound, 2*sizeof(uint64_t)*(nwords+1));
+    tab = chn + nwords + 1;
+    for (p = csound->instRoot; p != NULL; p = p->next) {
+      family_bits(csound, p->read, chn, tab);
+      family_bits(csound, p->write, chn, tab);
+      family_bits(csound, p->read_write, chn, tab);
+    }
+    for (p = csound->instRoot; p != NULL; p = p->next) {
+      CSP_BITSETS *b = p->bits;
+      if (b != NULL && b->nglobals == csound->dag_num_globals)
+        continue;
+      b = csound->Calloc(csound,
+                         sizeof(CSP_BITSETS) + 3*sizeof(uint64_t)*nwords);
+      b->nwords = nwords;
+      b->nglobals = csound->dag_num_globals;
+      b->read = (uint64_t*)(b + 1);
+      b->write = b->read + nwords;
+      b->read_write = b->write + nwords;
+      set_to_bits(csound, p->read, b->read, nwords, chn, tab);
+      set_to_bits(csound, p->write, b->write, nwords, chn, tab);
+      set_to_bits(csound, p->read_write, b->read_write, nwords, chn, tab);
+      CSP_BITSETS_SET(p, b);
+    }
+    csound->Free(csound, chn);
 }
 void csp_orc_sa_print_list(CSOUND *csound)
 {
@@ -238,7 +333,58 @@ void csp_orc_sa_global_read_add_list(CSOUND *csound, struct set_t *set)
     }
 }
 
-void csp_orc_sa_interlocksf(CSOUND *csound, int code)
+/* The global for one table or channel: "##tab:3" or "##chn:level" when
+   arg is a constant number or string, else base on its own, which
+   stands for all of them (see csp_orc_sa_bitsets_update).  Names are
+   kept in the string pool, so each is stored once however many sets
+   hold it and is released with the engine. */
+static char *resource_name(CSOUND *csound, const char *base, TREE *arg)
+{
+    char buf[32], *name, *key, *s;
+    size_t len;
+    if (arg == NULL) return (char*)base;
+    if (base[2] == 'c' && arg->type == STRING_TOKEN) {
+      s = arg->value->lexeme;
+      len = strlen(s);
+      if (len >= 4 && s[0] == '{' && s[1] == '{') s += 2, len -= 4;
+      else if (len >= 2 && s[0] == '"') s++, len -= 2;
+      else return (char*)base;
+    }
+    else if (base[2] == 't' &&
+             (arg->type == INTEGER_TOKEN || arg->type == NUMBER_TOKEN)) {
+      double fno = strtod(arg->value->lexeme, NULL);
+      if (fno != (double)(int)fno) return (char*)base;
+      snprintf(buf, 32, "%d", (int)fno);
+      s = buf;
+      len = strlen(buf);
+    }
+    else return (char*)base;
+    name = csound->Malloc(csound, strlen(base)+len+2);
+    sprintf(name, "%s:%.*s", base, (int)len, s);
+    key = cs_hash_table_put_key(csound, csound->engineState.stringPool, name);
+    csound->Free(csound, name);
+    return key;
+}
+
+/* Add to set the tables or channels named by the input the OENTRY flags
+   point at, or base if they point nowhere */
+static void resource_add(CSOUND *csound, struct set_t *set,
+                         const char *base, int code, TREE *args)
+{
+    int pos = ANPOS(code);
+    if (pos < 0) csp_set_add(csound, set, (char*)base);
+    else if ((code&_AL) == _AL) {
+      if (args == NULL) csp_set_add(csound, set, (char*)base);
+      for (; args != NULL; args = args->next)
+        csp_set_add(csound, set, resource_name(csound, base, args));
+    }
+    else {
+      while (args != NULL && pos-- > 0) args = args->next;
+      csp_set_add(csound, set, resource_name(csound, base, args));
+    }
+}
+
+void csp_orc_sa_interlocksf(CSOUND *csound, int code, TREE *args)
 {
     if (code&0xfff8) {
       /* zak etc */
@@ -248,23 +394,46 @@ void csp_orc_sa_interlocksf(CSOUND *csound, int code)
       rr = csp_set_alloc_string(csound);
       if (code&ZR) csp_set_add(csound, rr, "##zak");
       if (code&ZW) csp_set_add(csound, ww, "##zak");
-      if (code&TR) csp_set_add(csound, rr, "##tab");
-      if (code&TW) csp_set_add(csound, ww, "##tab");
-      if (code&_CR) csp_set_add(csound, rr, "##chn");
-      if (code&_CW) csp_set_add(csound, ww, "##chn");
+      if (code&TR) resource_add(csound, rr, "##tab", code, args);
+      if (code&TW) resource_add(csound, ww, "##tab", code, args);
+      if (code&_CR) resource_add(csound, rr, "##chn", code, args);
+      if (code&_CW) resource_add(csound, ww, "##chn", code, args);
       if (code&WR) csp_set_add(csound, ww, "##wri");
       if (code&IR) csp_set_add(csound, rr, "##int");
       if (code&IW) csp_set_add(csound, ww, "##int");
       csp_orc_sa_global_read_write_add_list(csound, ww, rr);
+      if (code&_CA) {
+        /* accumulate only, so on the read_write list */
+        ww = csp_set_alloc_string(csound);
+        rr = csp_set_alloc_string(csound);
+        resource_add(csound, ww, "##chn", code, args);
+        resource_add(csound, rr, "##chn", code, args);
+        csp_orc_sa_global_read_write_add_list1(csound, ww, rr);
+        csp_set_dealloc(csound, &ww);
+        csp_set_dealloc(csound, &rr);
+      }
       if (UNLIKELY(code&_QQ)) csound->Message(csound, Str("opcode deprecated"));
     }
 }
 
-void csp_orc_sa_interlocks(CSOUND *csound, ORCTOKEN *opcode)
+void csp_orc_sa_interlocks(CSOUND *csound, ORCTOKEN *opcode, TREE *args)
 {
     char *name = opcode->lexeme;
     OENTRY *ep = find_opcode(csound, name);
-    csp_orc_sa_interlocksf(csound, ep->flags);
+    if (ep != NULL) csp_orc_sa_interlocksf(csound, ep->flags, args);
+    csp_orc_sa_interlocks_tree(csound, args);
+}
+
+void csp_orc_sa_interlocks_tree(CSOUND *csound, TREE *node)
+{
+    for (; node != NULL; node = node->next) {
+      if (node->type == T_FUNCTION)
+        csp_orc_sa_interlocks(csound, node->value, node->right);
+      else {
+        csp_orc_sa_interlocks_tree(csound, node->left);
+        csp_orc_sa_interlocks_tree(csound, node->right);
+      }
+    }
 }
 
 //static int inInstr = 0;
@@ -93,172 +93,236 @@ PUBLIC void cs_cons_free_complete(CSOUND* csound, CONS_CELL* head) {
 
 /* FUNCTION FOR HASH SET */
 
-PUBLIC CS_HASH_TABLE* cs_hash_table_create(CSOUND* csound) {
-    return (CS_HASH_TABLE*) csound->Calloc(csound, sizeof(CS_HASH_TABLE));
-}
+/* Open addressing with linear probing: a lookup reads consecutive slots
+   and only calls strcmp when the stored hash matches.  The table doubles
+   when it becomes half full and removal shifts the following entries
+   back, so there are no tombstones.  As channels are looked up without a
+   lock while another thread may create one, a slot array that has been
+   replaced is kept until the table is freed.  Writers publish with
+   release stores and readers load with acquire: a new key is stored
+   into its slot after its hash and value, and a new slot array after
+   the entries copied into it, so a reader that sees either also sees
+   what was written before. */
+
+#define CS_HASH_MIN_SLOTS 16
+
+#if defined(HAVE_ATOMIC_BUILTIN)
+#define CS_HASH_LOAD(var)       __atomic_load_n(&(var), __ATOMIC_ACQUIRE)
+#define CS_HASH_STORE(var, val) __atomic_store_n(&(var), val, __ATOMIC_RELEASE)
+#elif defined(MSVC)
+#define CS_HASH_LOAD(var) \
+    InterlockedCompareExchangePointer((PVOID volatile *) &(var), NULL, NULL)
+#define CS_HASH_STORE(var, val) \
+    InterlockedExchangePointer((PVOID volatile *) &(var), val)
+#else
+#define CS_HASH_LOAD(var)       (var)
+#define CS_HASH_STORE(var, val) ((var) = (val))
+#endif
 
-static unsigned int cs_name_hash(char *s)
+static unsigned int cs_name_hash(const char *s)
 {
-    unsigned int h = 0;
+    unsigned int h = 2166136261u;       /* FNV-1a */
     while (*s != '\0') {
-      h = (h<<4) ^ *s++;
+      h = (h ^ (unsigned char) *s++) * 16777619u;
     }
-    return (h%HASH_SIZE);
+    return h;
 }
 
-PUBLIC void* cs_hash_table_get(CSOUND* csound,
-                               CS_HASH_TABLE* hashTable, char* key) {
-    IGN(csound);
-    unsigned int index;
+static CS_HASH_SLOTS* cs_hash_slots_create(CSOUND* csound, unsigned int n) {
+    CS_HASH_SLOTS* slots =
+      csound->Calloc(csound, sizeof(CS_HASH_SLOTS) +
+                     (n - 1) * sizeof(CS_HASH_TABLE_ITEM));
+    slots->mask = n - 1;
+    return slots;
+}
+
+/* the slot holding key, or the empty slot ending its probe sequence */
+static inline CS_HASH_TABLE_ITEM* cs_hash_probe(CS_HASH_SLOTS* slots,
+                                                const char* key,
+                                                unsigned int hash) {
+    unsigned int i = hash & slots->mask;
     CS_HASH_TABLE_ITEM* item;
 
-    if (key == NULL) {
-      return NULL;
-    }
+    char* k;
 
-    index = cs_name_hash(key);
-    item = hashTable->buckets[index];
+    while ((k = CS_HASH_LOAD((item = &slots->items[i])->key)) != NULL) {
+      if (item->hash == hash && strcmp(key, k) == 0) {
+        break;
+      }
+      i = (i + 1) & slots->mask;
+    }
+    return item;
+}
 
-    while (item != NULL) {
-      if (strcmp(key, item->key) == 0) {
-        return item->value;
+static void cs_hash_table_grow(CSOUND* csound, CS_HASH_TABLE* hashTable) {
+    CS_HASH_SLOTS* old = hashTable->slots;
+    CS_HASH_SLOTS* slots = cs_hash_slots_create(csound, 2 * (old->mask + 1));
+    unsigned int i, j;
+
+    for (i = 0; i <= old->mask; i++) {
+      CS_HASH_TABLE_ITEM* item = &old->items[i];
+      if (item->key == NULL) continue;
+      j = item->hash & slots->mask;
+      while (slots->items[j].key != NULL) {
+        j = (j + 1) & slots->mask;
       }
-      item = item->next;
+      slots->items[j] = *item;
     }
+    slots->retired = old;
+    CS_HASH_STORE(hashTable->slots, slots);
+}
 
-    return NULL;
+static void cs_hash_slots_free(CSOUND* csound, CS_HASH_SLOTS* slots) {
+    while (slots != NULL) {
+      CS_HASH_SLOTS* retired = slots->retired;
+      csound->Free(csound, slots);
+      slots = retired;
+    }
 }
 
-PUBLIC char* cs_hash_table_get_key(CSOUND* csound,
-                                   CS_HASH_TABLE* hashTable, char* key) {
-    unsigned int index;
-    CS_HASH_TABLE_ITEM* item;
+PUBLIC CS_HASH_TABLE* cs_hash_table_create(CSOUND* csound) {
+    CS_HASH_TABLE* hashTable =
+      (CS_HASH_TABLE*) csound->Calloc(csound, sizeof(CS_HASH_TABLE));
+    hashTable->slots = cs_hash_slots_create(csound, CS_HASH_MIN_SLOTS);
+    return hashTable;
+}
+
+PUBLIC void* cs_hash_table_get(CSOUND* csound,
+                               CS_HASH_TABLE* hashTable, char* key) {
     IGN(csound);
 
     if (key == NULL) {
       return NULL;
     }
+    return CS_HASH_LOAD(cs_hash_probe(CS_HASH_LOAD(hashTable->slots), key,
+                                      cs_name_hash(key))->value);
+}
 
-    index = cs_name_hash(key);
-    item = hashTable->buckets[index];
+PUBLIC char* cs_hash_table_get_key(CSOUND* csound,
+                                   CS_HASH_TABLE* hashTable, char* key) {
+    IGN(csound);
 
-    while (item != NULL) {
-      if (strcmp(key, item->key) == 0) {
-        return item->key;
-      }
-      item = item->next;
+    if (key == NULL) {
+      return NULL;
     }
-
-    return NULL;
+    return CS_HASH_LOAD(cs_hash_probe(CS_HASH_LOAD(hashTable->slots), key,
+                                      cs_name_hash(key))->key);
 }
 
 char* cs_hash_table_put_no_key_copy(CSOUND* csound,
-                                   CS_HASH_TABLE* hashTable,
+                                    CS_HASH_TABLE* hashTable,
                                     char* key, void* value) {
+    unsigned int hash;
+    CS_HASH_TABLE_ITEM* item;
+
     if (key == NULL) {
       return NULL;
     }
 
-    unsigned int index = cs_name_hash(key);
-
-    CS_HASH_TABLE_ITEM* item = hashTable->buckets[index];
-
-    if (item == NULL) {
-      CS_HASH_TABLE_ITEM* newItem = csound->Malloc(csound,
-                                                   sizeof(CS_HASH_TABLE_ITEM));
-      newItem->key = key;
-      newItem->value = value;
-      newItem->next = NULL;
-      hashTable->buckets[index] = newItem;
-      return newItem->key;
-    } else {
-      while (item != NULL) {
-        if (strcmp(key, item->key) == 0) {
-          item->value = value;
-          return item->key;
-        } else if (item->next == NULL) {
-          CS_HASH_TABLE_ITEM* newItem = csound->Malloc(csound,
-                                                       sizeof(CS_HASH_TABLE_ITEM));
-          newItem->key = key;
-          newItem->value = value;
-          newItem->next = NULL;
-          item->next = newItem;
-          return newItem->key;
-        }
-        item = item->next;
-      }
+    hash = cs_name_hash(key);
+    item = cs_hash_probe(hashTable->slots, key, hash);
+    if (item->key != NULL) {
+      CS_HASH_STORE(item->value, value);
+      return item->key;
+    }
+    if (2 * (hashTable->count + 1) > hashTable->slots->mask + 1) {
+      cs_hash_table_grow(csound, hashTable);
+      item = cs_hash_probe(hashTable->slots, key, hash);
     }
-    return NULL;
+    item->hash = hash;
+    item->value = value;
+    CS_HASH_STORE(item->key, key);
+    hashTable->count++;
+    return key;
 }
 
 PUBLIC void cs_hash_table_put(CSOUND* csound,
                               CS_HASH_TABLE* hashTable, char* key, void* value) {
+    CS_HASH_TABLE_ITEM* item;
+
+    if (key == NULL) {
+      return;
+    }
+    item = cs_hash_probe(hashTable->slots, key, cs_name_hash(key));
+    if (item->key != NULL) {
+      CS_HASH_STORE(item->value, value);
+      return;
+    }
     cs_hash_table_put_no_key_copy(csound, hashTable,
                                   cs_strdup(csound, key), value);
 }
 
 PUBLIC char* cs_hash_table_put_key(CSOUND* csound,
                                    CS_HASH_TABLE* hashTable, char* key) {
+    CS_HASH_TABLE_ITEM* item;
+
+    if (key == NULL) {
+      return NULL;
+    }
+    item = cs_hash_probe(hashTable->slots, key, cs_name_hash(key));
+    if (item->key != NULL) {
+      CS_HASH_STORE(item->value, NULL);
+      return item->key;
+    }
     return cs_hash_table_put_no_key_copy(csound, hashTable,
                                          cs_strdup(csound, key), NULL);
 }
 
 PUBLIC void cs_hash_table_remove(CSOUND* csound,
                                  CS_HASH_TABLE* hashTable, char* key) {
-    CS_HASH_TABLE_ITEM *previous, *item;
-    unsigned int index;
+    CS_HASH_SLOTS* slots = hashTable->slots;
+    CS_HASH_TABLE_ITEM* item;
+    unsigned int i, j, home;
+    IGN(csound);
 
     if (key == NULL) {
       return;
     }
 
-    index = cs_name_hash(key);
-
-    previous = NULL;
-    item = hashTable->buckets[index];
-
-    while (item != NULL) {
-      if (strcmp(key, item->key) == 0) {
-        if (previous == NULL) {
-          hashTable->buckets[index] = item->next;
-        } else {
-          previous->next = item->next;
-        }
-        csound->Free(csound, item);
-        return;
+    item = cs_hash_probe(slots, key, cs_name_hash(key));
+    if (item->key == NULL) {
+      return;
+    }
+    /* move back any later entry of the run whose probe sequence passes
+       through the hole, then empty the last slot moved from */
+    i = j = (unsigned int) (item - slots->items);
+    for (;;) {
+      j = (j + 1) & slots->mask;
+      if (slots->items[j].key == NULL) {
+        break;
+      }
+      home = slots->items[j].hash & slots->mask;
+      if (((j - home) & slots->mask) >= ((j - i) & slots->mask)) {
+        slots->items[i] = slots->items[j];
+        i = j;
       }
-      previous = item;
-      item = item->next;
     }
+    slots->items[i].key = NULL;
+    slots->items[i].value = NULL;
+    hashTable->count--;
 }
 
 PUBLIC CONS_CELL* cs_hash_table_keys(CSOUND* csound, CS_HASH_TABLE* hashTable) {
+    CS_HASH_SLOTS* slots = hashTable->slots;
     CONS_CELL* head = NULL;
+    unsigned int i;
 
-    int i = 0;
-
-    for (i = 0; i < HASH_SIZE; i++) {
-      CS_HASH_TABLE_ITEM* item = hashTable->buckets[i];
-
-      while (item != NULL) {
-        head = cs_cons(csound, item->key, head);
-        item = item->next;
+    for (i = 0; i <= slots->mask; i++) {
+      if (slots->items[i].key != NULL) {
+        head = cs_cons(csound, slots->items[i].key, head);
       }
     }
     return head;
 }
 
 PUBLIC CONS_CELL* cs_hash_table_values(CSOUND* csound, CS_HASH_TABLE* hashTable) {
+    CS_HASH_SLOTS* slots = hashTable->slots;
     CONS_CELL* head = NULL;
+    unsigned int i;
 
-    int i = 0;
-
-    for (i = 0; i < HASH_SIZE; i++) {
-      CS_HASH_TABLE_ITEM* item = hashTable->buckets[i];
-
-      while (item != NULL) {
-        head = cs_cons(csound, item->value, head);
-        item = item->next;
+    for (i = 0; i <= slots->mask; i++) {
+      if (slots->items[i].key != NULL) {
+        head = cs_cons(csound, slots->items[i].value, head);
       }
     }
     return head;
@@ -266,82 +330,68 @@ PUBLIC CONS_CELL* cs_hash_table_values(CSOUND* csound, CS_HASH_TABLE* hashTable)
 
 PUBLIC void cs_hash_table_merge(CSOUND* csound,
                                 CS_HASH_TABLE* target, CS_HASH_TABLE* source) {
-    // TODO - check if this is the best strategy for merging
-    int i = 0;
+    CS_HASH_SLOTS* slots = source->slots;
+    unsigned int i;
 
-    for (i = 0; i < HASH_SIZE; i++) {
-      CS_HASH_TABLE_ITEM* item = source->buckets[i];
+    for (i = 0; i <= slots->mask; i++) {
+      CS_HASH_TABLE_ITEM* item = &slots->items[i];
 
-      while (item != NULL) {
-        CS_HASH_TABLE_ITEM* next = item->next;
+      if (item->key != NULL) {
         char* new_key =
           cs_hash_table_put_no_key_copy(csound, target, item->key, item->value);
 
         if (new_key != item->key) {
           csound->Free(csound, item->key);
         }
-
-        csound->Free(csound, item);
-        item = next;
+        item->key = NULL;
+        item->value = NULL;
       }
-      source->buckets[i] = NULL;
     }
-
+    source->count = 0;
 }
 
 PUBLIC void cs_hash_table_free(CSOUND* csound, CS_HASH_TABLE* hashTable) {
-    int i;
-
-    for (i = 0; i < HASH_SIZE; i++) {
-      CS_HASH_TABLE_ITEM* item = hashTable->buckets[i];
+    CS_HASH_SLOTS* slots = hashTable->slots;
+    unsigned int i;
 
-      while(item != NULL) {
-        CS_HASH_TABLE_ITEM* next = item->next;
-        csound->Free(csound, item->key);
-        csound->Free(csound, item);
-        item = next;
+    for (i = 0; i <= slots->mask; i++) {
+      if (slots->items[i].key != NULL) {
+        csound->Free(csound, slots->items[i].key);
       }
     }
+    cs_hash_slots_free(csound, slots);
     csound->Free(csound, hashTable);
 }
 
 PUBLIC void cs_hash_table_mfree_complete(CSOUND* csound, CS_HASH_TABLE* hashTable) {
+    CS_HASH_SLOTS* slots = hashTable->slots;
+    unsigned int i;
 
-    int i;
-
-    for (i = 0; i < HASH_SIZE; i++) {
-      CS_HASH_TABLE_ITEM* item = hashTable->buckets[i];
-
-      while(item != NULL) {
-        CS_HASH_TABLE_ITEM* next = item->next;
-        csound->Free(csound, item->key);
-        csound->Free(csound, item->value);
-        csound->Free(csound, item);
-        item = next;
+    for (i = 0; i <= slots->mask; i++) {
+      if (slots->items[i].key != NULL) {
+        csound->Free(csound, slots->items[i].key);
+        csound->Free(csound, slots->items[i].value);
       }
     }
+    cs_hash_slots_free(csound, slots);
     csound->Free(csound, hashTable);
 }
 
 PUBLIC void cs_hash_table_free_complete(CSOUND* csound, CS_HASH_TABLE* hashTable) {
+    CS_HASH_SLOTS* slots = hashTable->slots;
+    unsigned int i;
 
-    int i;
-
-    for (i = 0; i < HASH_SIZE; i++) {
-      CS_HASH_TABLE_ITEM* item = hashTable->buckets[i];
-
-      while(item != NULL) {
-        CS_HASH_TABLE_ITEM* next = item->next;
-        csound->Free(csound, item->key);
+    for (i = 0; i <= slots->mask; i++) {
+      if (slots->items[i].key != NULL) {
+        csound->Free(csound, slots->items[i].key);
 
         /* NOTE: This needs to be free, not csound->Free.
            To use mfree on keys, use cs_hash_table_mfree_complete
            TODO: Check if this is even necessary anymore... */
-        free(item->value);
-        csound->Free(csound, item);
-        item = next;
+        free(slots->items[i].value);
       }
     }
+    cs_hash_slots_free(csound, slots);
     csound->Free(csound, hashTable);
 }
 
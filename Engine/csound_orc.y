@@ -151,7 +151,8 @@
 #define csp_orc_sa_global_read_write_add_list(a,b,c)
 #define csp_orc_sa_globals_find(a,b)
 #define csp_orc_sa_global_read_write_add_list1(a,b,c)
-#define csp_orc_sa_interlocks(a, b)
+#define csp_orc_sa_interlocks(a, b, c)
+#define csp_orc_sa_interlocks_tree(a, b)
 #define csp_orc_sa_global_read_add_list(a,b)
 #define csp_orc_sa_global_write_add_list(a,b);
 #endif
@@ -164,6 +165,7 @@
     extern int csound_orclex(TREE**, CSOUND *, void *);
     extern void print_tree(CSOUND *, char *msg, TREE *);
     extern TREE* constant_fold(CSOUND *, TREE *);
+    extern TREE* accumulate_assign(CSOUND *, TREE *, TREE *);
     extern void csound_orcerror(PARSE_PARM *, void *, CSOUND *,
                                 TREE**, const char*);
     extern int add_udo_definition(CSOUND*, char *, char *, char *);
@@ -327,15 +329,31 @@ topstatement : rident '=' expr NEWLINE
 statement : ans '=' exprlist NEWLINE
                 {
                     //int op = ($1->value->lexeme[0]!='a')?'=':LOCAL_ASSIGN;
-                  TREE *ans = make_leaf(csound,LINE,LOCN, '=', (ORCTOKEN *)$2);
-                  ans->left = (TREE *)$1;
-                  //print_tree(csound, "****assign", ans);
-                  ans->right = (TREE *)$3;
-                  $$ = ans;
-                  if (namedInstrFlag!=2)
-                    csp_orc_sa_global_read_write_add_list(csound,
+                  TREE *ans = accumulate_assign(csound, $1, $3);
+                  if (ans != NULL) {      /* ga = ga + x is ga += x */
+                    if (namedInstrFlag!=2) {
+                      csp_orc_sa_global_read_add_list(csound,
+                                    csp_orc_sa_globals_find(csound, ans->right));
+                      csp_orc_sa_global_read_write_add_list1(csound,
+                                    csp_orc_sa_globals_find(csound, ans->left),
+                                    csp_orc_sa_globals_find(csound, ans->left));
+                      csp_orc_sa_interlocks_tree(csound, ans->right);
+                    }
+                    $$ = ans;
+                  }
+                  else {
+                    ans = make_leaf(csound,LINE,LOCN, '=', (ORCTOKEN *)$2);
+                    ans->left = (TREE *)$1;
+                    //print_tree(csound, "****assign", ans);
+                    ans->right = (TREE *)$3;
+                    $$ = ans;
+                    if (namedInstrFlag!=2) {
+                      csp_orc_sa_global_read_write_add_list(csound,
                                     csp_orc_sa_globals_find(csound, ans->left),
                                     csp_orc_sa_globals_find(csound, ans->right));
+                      csp_orc_sa_interlocks_tree(csound, ans->right);
+                    }
+                  }
                 }
           | ident S_ADDIN expr NEWLINE
                 {
@@ -466,7 +484,7 @@ statement : ans '=' exprlist NEWLINE
                     csp_orc_sa_global_read_write_add_list(csound,
                                     csp_orc_sa_globals_find(csound, $2->left),
                                     csp_orc_sa_globals_find(csound, $2->right));
-                    csp_orc_sa_interlocks(csound, $2->value);
+                    csp_orc_sa_interlocks(csound, $2->value, $2->right);
                   }
                   query_deprecated_opcode(csound, $2->value);
                   //print_tree(csound, "opcode", $$);
@@ -486,7 +504,7 @@ statement : ans '=' exprlist NEWLINE
                       csp_orc_sa_global_write_add_list(csound,
                                    csp_orc_sa_globals_find(csound, $1->right));
                     }
-                    csp_orc_sa_interlocks(csound, $1->value);
+                    csp_orc_sa_interlocks(csound, $1->value, $1->right);
                     query_deprecated_opcode(csound, $1->value);
                   }
                 }
@@ -502,7 +520,7 @@ statement : ans '=' exprlist NEWLINE
                                   csp_orc_sa_globals_find(csound,
                                                           $1->right));
 
-                  csp_orc_sa_interlocks(csound, $1->value);
+                  csp_orc_sa_interlocks(csound, $1->value, $1->right);
                   }
                   query_deprecated_opcode(csound, $1->value);
 
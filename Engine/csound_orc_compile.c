@@ -37,11 +37,14 @@
 //#include "typetabl.h"
 #include "csound_orc_semantics.h"
 #include "csound_standard_types.h"
+#include "interlocks.h"
 
 static const char *INSTR_NAME_FIRST = "::^inm_first^::";
 static ARG *createArg(CSOUND *csound, INSTRTXT *ip, char *s,
                       ENGINE_STATE *engineState);
 static void insprep(CSOUND *, INSTRTXT *, ENGINE_STATE *engineState);
+static void layout_var_pool(CSOUND *, INSTRTXT *, ENGINE_STATE *engineState);
+static void udo_byref_inputs(CSOUND *, INSTRTXT *);
 static void lgbuild(CSOUND *, INSTRTXT *, char *, int inarg,
                     ENGINE_STATE *engineState);
 int pnum(char *s);
@@ -56,6 +59,7 @@ int named_instr_alloc(CSOUND *csound, char *s, INSTRTXT *ip, int32 insno,
                       ENGINE_STATE *engineState, int merge);
 int check_instr_name(char *s);
 void free_instr_var_memory(CSOUND *, INSDS *);
+void instance_pool_free(CSOUND *, INSTRTXT *);
 void mergeState_enqueue(CSOUND *csound, ENGINE_STATE *e, TYPE_TABLE *t,
                         OPDS *ids);
 
@@ -937,14 +941,14 @@ void free_instrtxt(CSOUND *csound, INSTRTXT *instrtxt) {
     INSDS *nxt = active->nxtinstance;
     if (active->fdchp != NULL)
       fdchclose(csound, active);
-    if (active->auxchp != NULL)
+    if (active->auxchp != NULL || INSDS_PRIV(active)->auxarena != NULL)
       auxchfree(csound, active);
     free_instr_var_memory(csound, active);
     if (active->opcod_iobufs != NULL)
       csound->Free(csound, active->opcod_iobufs);
-    csound->Free(csound, active);
     active = nxt;
   }
+  instance_pool_free(csound, ip);
   OPTXT *t = ip->nxtop;
   while (t) {
     OPTXT *s = t->nxtop;
@@ -1476,6 +1480,9 @@ int engineState_merge(CSOUND *csound, ENGINE_STATE *engineState) {
     insprep(csound, current, current_state); /* run insprep() to connect ARGS */
     recalculateVarPoolMemory(csound,
                              current->varPool); /* recalculate var pool */
+    layout_var_pool(csound, current, current_state);
+    if (current->opcode_info != NULL)
+      udo_byref_inputs(csound, current);
   }
   /* now we need to patch up instr order */
   end = current_state->maxinsno;
@@ -1859,6 +1866,9 @@ int csoundCompileTreeInternal(CSOUND *csound, TREE *root, int async) {
     while ((ip = ip->nxtinstxt) != NULL) { /* add all other entries */
       insprep(csound, ip, engineState);    /*   as combined offsets */
       recalculateVarPoolMemory(csound, ip->varPool);
+      layout_var_pool(csound, ip, engineState);
+      if (ip->opcode_info != NULL)
+        udo_byref_inputs(csound, ip);
     }
 
     CS_VARIABLE *var;
@@ -2075,6 +2085,255 @@ static void insprep(CSOUND *csound, INSTRTXT *tp, ENGINE_STATE *engineState) {
   }
 }
 
+/* Lay out the local variables of an instrument or UDO, replacing the
+   one slot per variable of recalculateVarPoolMemory().  The synthetic
+   a- and k-rate temporaries of expressions (#a0, #k1, ...) share slots
+   when their lifetimes do not overlap.  A lifetime runs from the op
+   that first writes the temporary to the op that last reads it, and
+   must end strictly before the next one starts, as an opcode may write
+   its output before it has read all of its input.  A temporary keeps a
+   slot of its own when it is read before it is written, when a label
+   lies inside its lifetime (a jump could reach the read without the
+   write), or when the op writing it has no perf-time part.  The a-rate
+   slots come first, each value aligned to CS_VAR_ALIGN with its type
+   header in the padding before it, so that the audio buffers an
+   instance touches every k-cycle are contiguous. */
+
+typedef struct {
+  CS_VARIABLE *var;
+  int first, last;      /* ops of the first and last reference, -1: none */
+  int labels;           /* labels before the first reference */
+  int share;            /* may share a slot */
+  int slot;
+} VAR_LIFE;
+
+typedef struct {
+  const CS_TYPE *type;
+  int size, last, offset;
+} VAR_SLOT;
+
+static int layout_is_perf(OPTXT *optxt)
+{
+  const OENTRY *ep = optxt->t.oentry;
+  return (ep->thread & 03) == 0 ? optxt->t.pftype != 'b' :
+    (ep->thread & 02) != 0;
+}
+
+static void layout_ref(VAR_LIFE *life, int count, ARG *arg, int n,
+                       int labels, int out, int perf)
+{
+  for (; arg != NULL; arg = arg->next) {
+    VAR_LIFE *l;
+    int i;
+    if (arg->type != ARG_LOCAL) continue;
+    i = ((CS_VARIABLE *) arg->argPtr)->memBlockIndex;
+    if (i < 0 || i >= count || life[i].var != arg->argPtr) continue;
+    l = &life[i];
+    if (l->first < 0) {
+      l->first = n;
+      l->labels = labels;
+      if (!out || !perf) l->share = 0;
+    }
+    else if (l->labels != labels) l->share = 0;
+    l->last = n;
+  }
+}
+
+static int layout_cmp(const void *a, const void *b)
+{
+  return (*(VAR_LIFE **) a)->first - (*(VAR_LIFE **) b)->first;
+}
+
+static void layout_var_pool(CSOUND *csound, INSTRTXT *tp,
+                            ENGINE_STATE *engineState)
+{
+  CS_VAR_POOL *pool = tp->varPool;
+  CS_VARIABLE *var;
+  VAR_LIFE *life, **order;
+  VAR_SLOT *slot;
+  OPTXT *optxt = (OPTXT *) tp;
+  int count = 0, nslots = 0, norder = 0, nshare;
+  int hdr = CS_FLOAT_ALIGN(CS_VAR_TYPE_OFFSET);
+  int i, j, n, labels, offset, unshared = pool->blockSize;
+
+  for (var = pool->head; var != NULL; var = var->next) count++;
+  if (count == 0) return;
+  life = csound->Calloc(csound, count * sizeof(VAR_LIFE));
+  slot = csound->Calloc(csound, count * sizeof(VAR_SLOT));
+  order = csound->Calloc(csound, count * sizeof(VAR_LIFE *));
+  for (i = 0, var = pool->head; var != NULL; var = var->next, i++) {
+    life[i].var = var;
+    life[i].first = life[i].last = -1;
+    life[i].share = var->varName[0] == '#' &&
+      (var->varType == &CS_VAR_TYPE_A || var->varType == &CS_VAR_TYPE_K);
+    var->memBlockIndex = i;             /* until laid out below */
+  }
+
+  for (n = 0, labels = 0; (optxt = optxt->nxtop) != NULL; n++) {
+    TEXT *ttp = &optxt->t;
+    if (strcmp(ttp->oentry->opname, "endin") == 0 ||
+        strcmp(ttp->oentry->opname, "endop") == 0)
+      break;
+    if (strcmp(ttp->oentry->opname, "$label") == 0) {
+      labels++;
+      continue;
+    }
+    /* an op reads its inputs before it writes its outputs */
+    layout_ref(life, count, ttp->inArgs, n, labels, 0, 0);
+    layout_ref(life, count, ttp->outArgs, n, labels, 1,
+               layout_is_perf(optxt));
+  }
+  /* sharing temporaries by first write, then the unused ones (which fit
+     any slot of their type), then the rest */
+  for (i = 0; i < count; i++)
+    if (life[i].share && life[i].first >= 0) order[norder++] = &life[i];
+  qsort(order, norder, sizeof(VAR_LIFE *), layout_cmp);
+  for (i = 0; i < count; i++)
+    if (life[i].share && life[i].first < 0) order[norder++] = &life[i];
+  nshare = norder;
+  for (i = 0; i < count; i++)
+    if (!life[i].share) order[norder++] = &life[i];
+
+  for (j = 0; j < count; j++) {
+    VAR_LIFE *l = order[j];
+    const CS_TYPE *type = l->var->varType;
+    int size = l->var->memBlockSize;
+    for (i = 0; l->share && i < nslots; i++)
+      if (slot[i].type == type && slot[i].size == size &&
+          (l->first < 0 || slot[i].last < l->first))
+        break;
+    if (!l->share || i == nslots) {
+      i = nslots++;
+      slot[i].type = type;
+      slot[i].size = size;
+      slot[i].last = l->share ? -1 : INT_MAX;
+    }
+    if (l->last > slot[i].last) slot[i].last = l->last;
+    l->slot = i;
+  }
+
+  for (i = 0, offset = 0; i < nslots; i++)
+    if (slot[i].type == &CS_VAR_TYPE_A) {
+      offset = (offset + hdr + CS_VAR_ALIGN - 1) & ~(CS_VAR_ALIGN - 1);
+      slot[i].offset = offset;
+      offset += slot[i].size;
+    }
+  for (i = 0; i < nslots; i++)
+    if (slot[i].type != &CS_VAR_TYPE_A) {
+      slot[i].offset = offset + hdr;
+      offset += hdr + slot[i].size;
+    }
+  for (i = 0; i < count; i++)
+    life[i].var->memBlockIndex = slot[life[i].slot].offset / sizeof(MYFLT);
+  pool->blockSize = offset;
+
+  if (tp != csound->instr0 && tp != engineState->instrtxtp[0] &&
+      UNLIKELY(csound->oparms->odebug || csound->oparms->optReport)) {
+    char name[64];
+    if (tp->opcode_info != NULL)
+      snprintf(name, 64, "opcode %s", tp->opcode_info->name);
+    else if (tp->insname != NULL)
+      snprintf(name, 64, "instr %s", tp->insname);
+    else {
+      for (i = engineState->maxinsno; i > 0; i--)
+        if (engineState->instrtxtp[i] == tp) break;
+      snprintf(name, 64, "instr %d", i);
+    }
+    n = tp->pmax > 3 ? (tp->pmax - 3) * (int) sizeof(CS_VAR_MEM) : 0;
+    csound->Message(csound, Str("%s: %d bytes per instance, %d variables "
+                                "in %d bytes (%d before sharing %d "
+                                "temporaries)\n"),
+                    name, (int) (INSDS_PRIV_SIZE + sizeof(INSDS)) + n +
+                    CS_VAR_ALIGN + pool->blockSize + tp->opdstot, count,
+                    pool->blockSize, unshared, nshare);
+  }
+  csound->Free(csound, order);
+  csound->Free(csound, slot);
+  csound->Free(csound, life);
+}
+
+/* whether op may write variable var */
+static int udo_writes(OPTXT *optxt, CS_VARIABLE *var)
+{
+  const OENTRY *ep = optxt->t.oentry;
+  ARG *arg;
+  for (arg = optxt->t.outArgs; arg != NULL; arg = arg->next)
+    if (arg->argPtr == var) return 1;
+  /* opcodes that write into an input, and array element assignment;
+     opcodes such as pvs2tab fill an input array without saying so, so
+     an array given to any opcode that is not internal counts as written */
+  if ((ep->flags & WI) || strncmp(ep->opname, "##array_set", 11) == 0 ||
+      strcmp(ep->opname, "##array_init") == 0 ||
+      (var->varType == &CS_VAR_TYPE_ARRAY &&
+       strncmp(ep->opname, "##", 2) != 0))
+    for (arg = optxt->t.inArgs; arg != NULL; arg = arg->next)
+      if (arg->argPtr == var) return 1;
+  return 0;
+}
+
+/* Find the inputs of a UDO that useropcd2() need not copy: a-rate and
+   perf-time array inputs that nothing in the body writes.  The opcodes
+   of an instance read those from the caller's arguments, patched in by
+   useropcdset() (insert.c); not done when the body has setksmps, as a
+   local ksmps takes the inputs in slices. */
+static void udo_byref_inputs(CSOUND *csound, INSTRTXT *tp)
+{
+  OPCODINFO *inm = tp->opcode_info;
+  CS_VARIABLE **vars, *in;
+  OPTXT *optxt, *xin = NULL;
+  ARG *arg;
+  int i, n = 0;
+
+  if (inm->byref != NULL) csound->Free(csound, inm->byref);
+  inm->byref = NULL;
+  inm->byref_slots = 0;
+  if (inm->inchns == 0) return;
+  for (optxt = tp->nxtop; optxt != NULL; optxt = optxt->nxtop) {
+    const char *name = optxt->t.oentry->opname;
+    if (strcmp(name, "endop") == 0) break;
+    if (strcmp(name, "setksmps") == 0) return;
+    if (strcmp(name, "xin") == 0) {
+      if (xin != NULL) return;
+      xin = optxt;
+    }
+  }
+  if (xin == NULL) return;
+  vars = csound->Calloc(csound, inm->inchns * sizeof(CS_VARIABLE *));
+  for (i = 0, arg = xin->t.outArgs, in = inm->in_arg_pool->head;
+       i < inm->inchns && arg != NULL && in != NULL;
+       i++, arg = arg->next, in = in->next)
+    if (arg->type == ARG_LOCAL &&
+        (in->varType == &CS_VAR_TYPE_A ||
+         (in->varType == &CS_VAR_TYPE_ARRAY &&
+          in->subType != &CS_VAR_TYPE_I)))
+      vars[i] = (CS_VARIABLE *) arg->argPtr;
+  for (optxt = tp->nxtop; optxt != NULL; optxt = optxt->nxtop) {
+    if (strcmp(optxt->t.oentry->opname, "endop") == 0) break;
+    if (optxt == xin) continue;
+    for (i = 0; i < inm->inchns; i++)
+      if (vars[i] != NULL && udo_writes(optxt, vars[i])) vars[i] = NULL;
+  }
+  /* count the arguments instance() will patch */
+  for (optxt = tp->nxtop; optxt != NULL; optxt = optxt->nxtop) {
+    const char *name = optxt->t.oentry->opname;
+    if (strcmp(name, "endop") == 0) break;
+    if (strcmp(name, "pset") == 0 || strcmp(name, "$label") == 0) continue;
+    for (arg = optxt->t.inArgs; arg != NULL; arg = arg->next)
+      if (arg->type == ARG_LOCAL)
+        for (i = 0; i < inm->inchns; i++)
+          if (vars[i] == arg->argPtr) {
+            n++;
+            break;
+          }
+  }
+  if (n == 0) {
+    csound->Free(csound, vars);
+    return;
+  }
+  inm->byref = vars;
+  inm->byref_slots = n;
+}
+
 /* build pool of floating const values  */
 /* build lcl/gbl list of ds names, offsets */
 /* (no need to save the returned values) */
@@ -2299,7 +2558,6 @@ void debugPrintCsound(CSOUND *csound) {
   }
 }
 
-#include "interlocks.h"
 void query_deprecated_opcode(CSOUND *csound, ORCTOKEN *o) {
   char *name = o->lexeme;
   OENTRY *ep = find_opcode(csound, name);
@@ -24,8 +24,14 @@
 
 #include "csoundCore.h"
 #include "csound_orc.h"
+#include "aops.h"
+#include "interlocks.h"
+#include <ctype.h>
 extern void print_tree(CSOUND *csound, char*, TREE *l);
 extern void delete_tree(CSOUND *csound, TREE *l);
+extern OENTRY *find_opcode(CSOUND *, char *);
+extern int pnum(char *);
+extern OPCODINFO *find_opcode_info(CSOUND *, char *, char *, char *);
 
 static TREE * create_fun_token(CSOUND *csound, TREE *right, char *fname)
 {
@@ -418,6 +424,1317 @@ TREE* constant_fold(CSOUND *csound, TREE* root)
 }
 
 
+static int count_ident(TREE *tree, const char *name)
+{
+    int n = 0;
+    for (; tree != NULL; tree = tree->next) {
+      if (tree->type == T_IDENT && !strcmp(tree->value->lexeme, name)) n++;
+      n += count_ident(tree->left, name) + count_ident(tree->right, name);
+    }
+    return n;
+}
+
+/* If tree is a sum with the variable name as one of its terms, return
+   the sum of the other terms */
+static TREE *remove_term(TREE *tree, const char *name)
+{
+    TREE *rest;
+    if (tree == NULL || tree->type != '+') return NULL;
+    if (tree->left->type == T_IDENT && !strcmp(tree->left->value->lexeme, name))
+      return tree->right;
+    if (tree->right->type == T_IDENT &&
+        !strcmp(tree->right->value->lexeme, name))
+      return tree->left;
+    if ((rest = remove_term(tree->left, name)) != NULL) {
+      tree->left = rest;
+      return tree;
+    }
+    if ((rest = remove_term(tree->right, name)) != NULL) {
+      tree->right = rest;
+      return tree;
+    }
+    return NULL;
+}
+
+/* Called directly from the parser for ans = expr.  Under -j, a global
+   audio variable that is only added to, as in ga = ga + x, is rewritten
+   as ga += x; the semantic analysis then knows the instrument only
+   accumulates into it and need not order its instances (see
+   dag_accum_find).  A single thread gains nothing from that, so the
+   tree is left as written.  Returns the ##addin node or NULL. */
+TREE* accumulate_assign(CSOUND *csound, TREE *ans, TREE *expr)
+{
+    extern ORCTOKEN *lookup_token(CSOUND*,char*,void*);
+    CS_VARIABLE *var;
+    TREE *rest, *node;
+    char *name;
+
+    if (csound->oparms->numThreads <= 1 ||
+        ans == NULL || ans->type != T_IDENT || ans->next != NULL ||
+        expr == NULL || expr->next != NULL)
+      return NULL;
+    name = ans->value->lexeme;
+    if (name[0] != 'g' || name[1] != 'a') return NULL;
+    /* not a whole array, where known */
+    var = csoundFindVariableWithName(csound, csound->engineState.varPool, name);
+    if (var != NULL && var->varType != &CS_VAR_TYPE_A) return NULL;
+    if (count_ident(expr, name) != 1 ||
+        (rest = remove_term(expr, name)) == NULL)
+      return NULL;
+    node = make_leaf(csound, ans->line, ans->locn, T_OPCODE,
+                     lookup_token(csound, "##addin", NULL));
+    node->value->optype = NULL;
+    node->left = ans;
+    node->right = rest;
+    return node;
+}
+
+/* Expression fusion (--expr-fusion).  csound_orc_expressions.c expands
+   an a-rate expression such as (a1*kg + a2*kh)*aenv into one AOP per
+   operator, each writing a ksmps temporary.  fuse_list finds the trees
+   of a-rate arithmetic and unary functions whose intermediate #a
+   results are used once, and replaces each by a single ##fuse at the
+   place of its root, running the tree as a postfix program (aops.c).
+   k-rate subexpressions stay separate opcodes and enter the program as
+   operands. */
+
+static const struct {
+    const char  *opname;
+    char        code;
+} fuse_ops[] = {
+    { "##add.aa", '+' }, { "##add.ak", '+' }, { "##add.ka", '+' },
+    { "##sub.aa", '-' }, { "##sub.ak", '-' }, { "##sub.ka", '-' },
+    { "##mul.aa", '*' }, { "##mul.ak", '*' }, { "##mul.ka", '*' },
+    { "##div.aa", '/' }, { "##div.ak", '/' }, { "##div.ka", '/' },
+    { "abs.a",  FUSE_ABS },  { "exp.a", FUSE_EXP }, { "log.a", FUSE_LOG },
+    { "sqrt.a", FUSE_SQRT }, { "sin.a", FUSE_SIN }, { "cos.a", FUSE_COS },
+    { "tanh.a", FUSE_TANH },
+    { NULL, 0 }
+};
+
+#define FUSE_TERMS  32
+
+typedef struct {
+    TREE    *t;
+    char    code;           /* ##fuse operator, 0: cannot be fused */
+    int     parent;         /* node its result is fused into, -1: none */
+    int     root;           /* root of the last tree that took it */
+    int     done;           /* now part of a ##fuse */
+} FUSE_NODE;
+
+typedef struct {
+    FUSE_NODE *nd;
+    int     *producer;      /* node+1 by temporary number */
+    int     reassoc;
+    int     root, size;     /* tree being compiled and its nodes */
+    char    code[FUSE_MAXCODE];
+    int     ncode, depth;
+    int     nins, pushed;   /* instructions of fuse_init, last an operand */
+    TREE    *args[FUSE_MAXARG];
+    int     nargs;
+} FUSE_PROG;
+
+typedef struct {
+    TREE    *arg;
+    int     node;           /* fused node giving the term, -1: operand */
+    char    rate;
+} FUSE_TERM;
+
+static char fuse_code(TREE *t)
+{
+    OENTRY  *ep = (OENTRY*) t->markup;
+    int     i;
+
+    if (t->type != T_OPCODE || ep == NULL ||
+        t->left == NULL || t->left->next != NULL)
+      return 0;
+    for (i = 0; fuse_ops[i].opname != NULL; i++)
+      if (!strcmp(ep->opname, fuse_ops[i].opname))
+        return fuse_ops[i].code;
+    return 0;
+}
+
+/* number of a synthetic #a temporary, or -1 */
+static int fuse_temp(TREE *arg)
+{
+    char    *s;
+
+    if (arg == NULL || arg->type != T_IDENT || arg->value == NULL)
+      return -1;
+    s = arg->value->lexeme;
+    if (s[0] != '#' || s[1] != 'a' || s[2] < '0' || s[2] > '9' ||
+        strchr(s, '[') != NULL)
+      return -1;
+    return atoi(s + 2);
+}
+
+/* whether a tree may move past t to its root: t must be a piece of an
+   expression, writing only temporaries */
+static int fuse_passable(TREE *t)
+{
+    OENTRY  *ep = (OENTRY*) t->markup;
+    TREE    *a;
+    int     i;
+
+    if (t->type != T_OPCODE || ep == NULL || t->left == NULL)
+      return 0;
+    for (a = t->left; a != NULL; a = a->next)
+      if (a->value->lexeme[0] != '#') return 0;
+    if (!strncmp(ep->opname, "##", 2)) return 1;
+    for (i = 0; fuse_ops[i].opname != NULL; i++) {
+      const char *name = fuse_ops[i].opname;
+      size_t  n = strchr(name, '.') - name + 1;
+      if (name[0] != '#' && !strncmp(ep->opname, name, n)) return 1;
+    }
+    return 0;
+}
+
+static int fuse_child(FUSE_PROG *fp, int i, TREE *arg)
+{
+    int     n = fuse_temp(arg), j;
+
+    if (n < 0 || (j = fp->producer[n] - 1) < 0 || fp->nd[j].parent != i)
+      return -1;
+    return j;
+}
+
+static char fuse_rate(FUSE_PROG *fp, int i, int k)
+{
+    OENTRY  *ep = (OENTRY*) fp->nd[i].t->markup;
+    return ep->intypes[k] == 'a' ? 'a' : 'k';
+}
+
+static int fuse_put(FUSE_PROG *fp, char c, int push)
+{
+    if (fp->ncode >= FUSE_MAXCODE - 1) return 0;
+    fp->code[fp->ncode++] = c;
+    fp->depth += push;
+    return fp->depth <= FUSE_STACK;
+}
+
+/* count an instruction as fuse_init() will make it: an operator shares
+   the instruction of an operand pushed just before it */
+static int fuse_ins(FUSE_PROG *fp, int operand)
+{
+    if (!operand && fp->pushed) {
+      fp->pushed = 0;
+      return 1;
+    }
+    fp->pushed = operand;
+    return ++fp->nins < FUSE_MAXINS;
+}
+
+static int fuse_op(FUSE_PROG *fp, char c, int push)
+{
+    return fuse_ins(fp, 0) && fuse_put(fp, c, push);
+}
+
+static int fuse_operand(FUSE_PROG *fp, TREE *arg, char rate)
+{
+    int     i;
+
+    for (i = 0; i < fp->nargs; i++)
+      if (!strcmp(fp->args[i]->value->lexeme, arg->value->lexeme)) break;
+    if (i == fp->nargs) {
+      if (i == FUSE_MAXARG) return 0;
+      fp->args[fp->nargs++] = arg;
+    }
+    return fuse_ins(fp, 1) && fuse_put(fp, rate, 1) &&
+      fuse_put(fp, (char) ('0' + i), 0);
+}
+
+static int fuse_emit(FUSE_PROG *fp, int i);
+
+static int fuse_term(FUSE_PROG *fp, FUSE_TERM *term)
+{
+    return term->node >= 0 ? fuse_emit(fp, term->node) :
+      fuse_operand(fp, term->arg, term->rate);
+}
+
+/* operands of a chain of one associative operator, in order */
+static int fuse_terms(FUSE_PROG *fp, int i, char code, FUSE_TERM *term, int n)
+{
+    TREE    *arg = fp->nd[i].t->right;
+    int     k, c;
+
+    fp->nd[i].root = fp->root;
+    fp->size++;
+    for (k = 0; arg != NULL; arg = arg->next, k++) {
+      c = fuse_child(fp, i, arg);
+      if (c >= 0 && fp->nd[c].code == code) {
+        if ((n = fuse_terms(fp, c, code, term, n)) < 0) return -1;
+        continue;
+      }
+      if (n == FUSE_TERMS) return -1;
+      term[n].arg = arg;
+      term[n].node = c;
+      term[n].rate = c >= 0 ? 'a' : fuse_rate(fp, i, k);
+      n++;
+    }
+    return n;
+}
+
+/* With reassociation a chain of + or * takes its audio terms in order,
+   then combines the k-rate ones once: a1*k1*k2 runs as a1*(k1*k2) */
+static int fuse_regroup(FUSE_PROG *fp, int i, char code)
+{
+    FUSE_TERM term[FUSE_TERMS];
+    int     size = fp->size, n, k, m, pass, nk = 0;
+
+    n = fuse_terms(fp, i, code, term, 0);
+    for (k = 0; k < n; k++)
+      if (term[k].rate != 'a') nk++;
+    if (nk < 2) {
+      fp->size = size;
+      return -1;
+    }
+    for (pass = 0; pass < 2; pass++)
+      for (k = 0, m = 0; k < n; k++) {
+        if ((term[k].rate == 'a') != (pass == 0)) continue;
+        if (!fuse_term(fp, &term[k]) ||
+            (m++ > 0 && !fuse_op(fp, code, -1)))
+          return 0;
+      }
+    return fuse_op(fp, code, -1);
+}
+
+static int fuse_emit(FUSE_PROG *fp, int i)
+{
+    FUSE_NODE *nd = &fp->nd[i];
+    FUSE_TERM term;
+    TREE    *arg;
+    int     k, ret;
+
+    if (fp->reassoc && (nd->code == '*' || nd->code == '+') &&
+        (ret = fuse_regroup(fp, i, nd->code)) >= 0)
+      return ret;
+    nd->root = fp->root;
+    fp->size++;
+    for (arg = nd->t->right, k = 0; arg != NULL; arg = arg->next, k++) {
+      term.arg = arg;
+      term.node = fuse_child(fp, i, arg);
+      term.rate = fuse_rate(fp, i, k);
+      if (!fuse_term(fp, &term)) return 0;
+    }
+    return fuse_op(fp, nd->code, nd->t->right->next != NULL ? -1 : 0);
+}
+
+static TREE *fuse_copy_arg(CSOUND *csound, TREE *a)
+{
+    TREE    *c = make_leaf(csound, a->line, a->locn, a->type,
+                           make_token(csound, a->value->lexeme));
+    c->value->type = a->value->type;
+    c->value->value = a->value->value;
+    c->value->fvalue = a->value->fvalue;
+    c->markup = a->markup;
+    c->rate = a->rate;
+    return c;
+}
+
+/* replace the tree with root i by a ##fuse, or make its branches roots */
+static void fuse_root(CSOUND *csound, FUSE_PROG *fp, OENTRY *fuse, int i,
+                      int n)
+{
+    TREE    *t = fp->nd[i].t, *arg, *last;
+    char    prog[FUSE_MAXCODE + 2];
+    int     j, found = 0, ok;
+
+    fp->root = i;
+    fp->size = fp->ncode = fp->depth = fp->nargs = 0;
+    fp->nins = fp->pushed = 0;
+    ok = fuse_emit(fp, i) && fp->depth == 1;
+    if (ok && fp->size < 2) return;
+    /* the nodes between the first of the tree and its root must be
+       expression pieces, which it can safely move past */
+    for (j = i - 1; ok && found < fp->size - 1 && j >= 0; j--) {
+      if (fp->nd[j].root == i) found++;
+      else if (!fuse_passable(fp->nd[j].t)) ok = 0;
+    }
+    if (!ok) {
+      for (j = 0; j < n; j++)
+        if (fp->nd[j].parent == i) fp->nd[j].parent = -1;
+      return;
+    }
+    for (j = 0; j < i; j++)
+      if (fp->nd[j].root == i) fp->nd[j].done = 1;
+    prog[0] = '"';
+    memcpy(prog + 1, fp->code, fp->ncode);
+    prog[fp->ncode + 1] = '"';
+    prog[fp->ncode + 2] = '\0';
+    last = make_leaf(csound, t->line, t->locn, STRING_TOKEN,
+                     make_token(csound, prog));
+    arg = last;
+    for (j = 0; j < fp->nargs; j++)
+      last = last->next = fuse_copy_arg(csound, fp->args[j]);
+    delete_tree(csound, t->right);
+    t->right = arg;
+    csound->Free(csound, t->value->lexeme);
+    t->value->lexeme = cs_strdup(csound, "##fuse");
+    t->value->optype = NULL;
+    t->markup = fuse;
+}
+
+static TREE *fuse_list(CSOUND *csound, TREE *list)
+{
+    OENTRY  *fuse = find_opcode(csound, "##fuse");
+    FUSE_PROG fp;
+    TREE    *t, *arg, *head = NULL, *last = NULL;
+    int     *count, n = 0, maxtemp = -1, i, k;
+
+    for (t = list; t != NULL; t = t->next) {
+      if (t->type == INSTR_TOKEN || t->type == UDO_TOKEN)
+        t->right = fuse_list(csound, t->right);
+      else {
+        for (arg = t->left; arg != NULL; arg = arg->next)
+          if ((k = fuse_temp(arg)) > maxtemp) maxtemp = k;
+      }
+      n++;
+    }
+    if (fuse == NULL || maxtemp < 0) return list;
+
+    /* one definition and one use make a temporary an edge of a tree */
+    memset(&fp, 0, sizeof(FUSE_PROG));
+    fp.reassoc = (csound->oparms->exprFusion > 1);
+    fp.nd = csound->Calloc(csound, n*sizeof(FUSE_NODE));
+    fp.producer = csound->Calloc(csound, 3*(maxtemp+1)*sizeof(int));
+    count = fp.producer + maxtemp + 1;      /* definitions, then uses */
+    for (t = list, i = 0; t != NULL; t = t->next, i++) {
+      fp.nd[i].t = t;
+      fp.nd[i].code = fuse_code(t);
+      fp.nd[i].parent = fp.nd[i].root = -1;
+      if (t->type == INSTR_TOKEN || t->type == UDO_TOKEN) continue;
+      for (arg = t->left; arg != NULL; arg = arg->next)
+        if ((k = fuse_temp(arg)) >= 0) {
+          fp.producer[k] = i + 1;
+          count[k]++;
+        }
+      for (arg = t->right; arg != NULL; arg = arg->next)
+        if ((k = fuse_temp(arg)) >= 0 && k <= maxtemp)
+          count[maxtemp + 1 + k]++;
+    }
+    for (i = 0; i < n; i++) {
+      if (!fp.nd[i].code) continue;
+      for (arg = fp.nd[i].t->right; arg != NULL; arg = arg->next) {
+        int j;
+        if ((k = fuse_temp(arg)) < 0 || k > maxtemp ||
+            count[k] != 1 || count[maxtemp + 1 + k] != 1) continue;
+        j = fp.producer[k] - 1;
+        if (j < i && fp.nd[j].code) fp.nd[j].parent = i;
+      }
+    }
+    for (i = n - 1; i >= 0; i--)
+      if (fp.nd[i].code && fp.nd[i].parent < 0 && !fp.nd[i].done)
+        fuse_root(csound, &fp, fuse, i, n);
+
+    for (i = 0; i < n; i++) {
+      t = fp.nd[i].t;
+      if (fp.nd[i].done) {
+        t->next = NULL;
+        delete_tree(csound, t);
+        continue;
+      }
+      if (last == NULL) head = t;
+      else last->next = t;
+      last = t;
+    }
+    if (last != NULL) last->next = NULL;
+    csound->Free(csound, fp.nd);
+    csound->Free(csound, fp.producer);
+    return head;
+}
+
+/* Optimisation of instrument code (--tree-opt, --opt-report).  After
+   expansion an instrument or UDO body is a list of opcodes, with each
+   operator of an expression writing a synthetic temporary; opt_body
+   walks it once in order:
+   - an arithmetic operation or function whose arguments are all
+     constants is evaluated now, by the opcode's own code, and its
+     temporary replaced by the result;
+   - within a basic block (no label or jump in between) an operation
+     repeating an earlier one on unchanged arguments reuses its
+     temporary;
+   - a k-rate operation whose arguments cannot change after the init
+     pass (constants, p-fields and i-variables set once, k-variables
+     set once from those) becomes its i-rate version, run once;
+   - an i-variable set once to a constant is replaced by the constant.
+   Then statements of those kinds whose results are never read are
+   removed. */
+
+static const struct {
+    const char  *prefix;
+    int         eval;       /* 1: may be evaluated, shared and hoisted */
+} opt_pure[] = {
+    { "##add.", 1 }, { "##sub.", 1 }, { "##mul.", 1 }, { "##div.", 1 },
+    { "##mod.", 1 }, { "abs.", 1 }, { "exp.", 1 }, { "log.", 1 },
+    { "log10.", 1 }, { "log2.", 1 }, { "sqrt.", 1 }, { "sin.", 1 },
+    { "cos.", 1 }, { "tan.", 1 }, { "sinh.", 1 }, { "cosh.", 1 },
+    { "tanh.", 1 }, { "taninv2.", 1 }, { "int.", 1 }, { "frac.", 1 },
+    { "round.", 1 }, { "floor.", 1 }, { "ceil.", 1 },
+    { "=.i", 0 }, { "=.k", 0 }, { "=.a", 0 }, { "init.i", 0 },
+    { "init.k", 0 },
+    { NULL, 0 }
+};
+
+typedef struct {
+    int     defs, def;      /* statements writing it, and the last */
+    int     reads;
+    TREE    *subst;         /* replaces its reads */
+    TREE    *source;        /* for a k-variable, the fixed value it copies */
+} OPT_VAR;
+
+typedef struct {
+    TREE    *t;
+    char    *key;
+} OPT_EXPR;
+
+typedef struct {
+    CSOUND  *csound;
+    CS_HASH_TABLE *vars;
+    CS_VAR_POOL *pool;
+    TREE    **st;
+    char    *removed;
+    int     n;
+    int     init_jump;      /* first init-time jump, n: none */
+    int     perf_jump;      /* first label or perf-time jump, n: none */
+    int     reinit;
+    OPT_EXPR *avail;        /* available expressions of the block */
+    int     navail;
+    TREE    *leaves;        /* substitutes made here, freed at the end */
+    const char *name;
+    int     folded, shared, hoisted, propagated, removed_n;
+} OPT_STATE;
+
+static int opt_kind(TREE *t)
+{
+    OENTRY  *ep = (OENTRY*) t->markup;
+    int     i;
+
+    if ((t->type != T_OPCODE && t->type != '=') || ep == NULL ||
+        t->left == NULL)
+      return -1;
+    for (i = 0; opt_pure[i].prefix != NULL; i++)
+      if (!strncmp(ep->opname, opt_pure[i].prefix,
+                   strlen(opt_pure[i].prefix)))
+        return opt_pure[i].eval;
+    return -1;
+}
+
+static int opt_is_const(TREE *a)
+{
+    return a->type == INTEGER_TOKEN || a->type == NUMBER_TOKEN;
+}
+
+static MYFLT opt_const_value(TREE *a)
+{
+    return a->type == INTEGER_TOKEN ? (MYFLT) a->value->value :
+      a->value->fvalue;
+}
+
+static int opt_is_ident(TREE *a)
+{
+    return a->type == T_IDENT && a->left == NULL && a->right == NULL &&
+      a->value != NULL;
+}
+
+/* rate letter of a variable name, 0 for a global */
+static char opt_rate(const char *s)
+{
+    if (*s == '#') s++;
+    return *s == 'g' ? 0 : *s;
+}
+
+static OPT_VAR *opt_var(OPT_STATE *p, char *name)
+{
+    OPT_VAR *v = cs_hash_table_get(p->csound, p->vars, name);
+    if (v == NULL) {
+      v = p->csound->Calloc(p->csound, sizeof(OPT_VAR));
+      v->def = -1;
+      cs_hash_table_put(p->csound, p->vars, name, v);
+    }
+    return v;
+}
+
+/* add d to the reads of the variables in an argument tree */
+static void opt_reads(OPT_STATE *p, TREE *t, int d)
+{
+    for (; t != NULL; t = t->next) {
+      if (t->type == T_IDENT && t->value != NULL)
+        opt_var(p, t->value->lexeme)->reads += d;
+      opt_reads(p, t->left, d);
+      opt_reads(p, t->right, d);
+    }
+}
+
+static void opt_stmt_reads(OPT_STATE *p, TREE *t, int d)
+{
+    TREE    *a;
+
+    opt_reads(p, t->right, d);
+    for (a = t->left; a != NULL; a = a->next) {  /* array indexes */
+      opt_reads(p, a->left, d);
+      opt_reads(p, a->right, d);
+    }
+}
+
+static TREE *opt_leaf(OPT_STATE *p, TREE *a)
+{
+    TREE    *c = fuse_copy_arg(p->csound, a);
+    c->next = p->leaves;
+    p->leaves = c;
+    return c;
+}
+
+static TREE *opt_number(OPT_STATE *p, TREE *t, MYFLT val)
+{
+    char    buf[64];
+    TREE    *c;
+
+    snprintf(buf, 64, "%.20g", val);
+    c = make_leaf(p->csound, t->line, t->locn, NUMBER_TOKEN,
+                  make_token(p->csound, buf));
+    c->value->type = NUMBER_TOKEN;
+    c->value->fvalue = val;
+    c->next = p->leaves;
+    p->leaves = c;
+    return c;
+}
+
+static void opt_replace(OPT_STATE *p, TREE *a, TREE *with)
+{
+    if (opt_is_ident(a)) opt_var(p, a->value->lexeme)->reads--;
+    p->csound->Free(p->csound, a->value->lexeme);
+    a->value->lexeme = cs_strdup(p->csound, with->value->lexeme);
+    a->type = with->type;
+    a->value->type = with->value->type;
+    a->value->value = with->value->value;
+    a->value->fvalue = with->value->fvalue;
+    a->rate = with->rate;
+    if (opt_is_ident(a)) opt_var(p, a->value->lexeme)->reads++;
+}
+
+/* whether a value read by statement i is the same at init and at every
+   k-cycle; if so, and it is a k-variable, *src is what it copies */
+static int opt_fixed(OPT_STATE *p, TREE *a, int i, TREE **src)
+{
+    OPT_VAR *v;
+    char    *s, r;
+
+    *src = a;
+    if (opt_is_const(a)) return 1;
+    if (!opt_is_ident(a)) return 0;
+    s = a->value->lexeme;
+    v = opt_var(p, s);
+    if (pnum(s) >= 0) return v->defs == 0;
+    r = opt_rate(s);
+    if (r == 'i') return v->defs == 1 && v->def < i;
+    if (r == 'k' && v->source != NULL && v->def < i) {
+      *src = v->source;
+      return 1;
+    }
+    return 0;
+}
+
+/* whether init-time code at statement i always runs: code after an
+   igoto or cigoto may be skipped, even before the first label */
+static int opt_init_safe(OPT_STATE *p, int i)
+{
+    return i < p->init_jump;
+}
+
+static void opt_note(OPT_STATE *p, TREE *t, const char *what)
+{
+    if (p->csound->oparms->optReport)
+      p->csound->Message(p->csound, Str("%s, line %d: %s %s\n"), p->name,
+                         t->line, what, ((OENTRY*) t->markup)->opname);
+}
+
+/* turn k-rate operation t into its i-rate version, with a new i-rate
+   temporary replacing the k-rate one */
+static int opt_hoist(OPT_STATE *p, TREE *t, int i)
+{
+    OENTRY  *ep = (OENTRY*) t->markup, *iep;
+    TREE    *a, *src, *out;
+    char    name[64], *s;
+    CS_VARIABLE *var;
+
+    if (p->reinit || !opt_init_safe(p, i) || p->pool == NULL ||
+        t->left->value->lexeme[1] != 'k')
+      return 0;
+    for (a = t->right; a != NULL; a = a->next)
+      if (!opt_fixed(p, a, i, &src)) return 0;
+    strncpy(name, ep->opname, 63);
+    name[63] = '\0';
+    if ((s = strchr(name, '.')) == NULL) return 0;
+    for (s++; *s != '\0'; s++)
+      if (*s == 'k') *s = 'i';
+    iep = find_opcode(p->csound, name);
+    if (iep == NULL || iep->thread != 1 || strcmp(iep->outypes, "i"))
+      return 0;
+    for (a = t->right; a != NULL; a = a->next) {
+      opt_fixed(p, a, i, &src);
+      if (src != a) opt_replace(p, a, src);
+    }
+    snprintf(name, 64, "#i%d", p->pool->synthArgCount++);
+    var = csoundCreateVariable(p->csound, p->csound->typePool,
+                               (CS_TYPE*) &CS_VAR_TYPE_I, name, NULL);
+    if (var == NULL) return 0;
+    csoundAddVariable(p->csound, p->pool, var);
+    out = make_leaf(p->csound, t->line, t->locn, T_IDENT,
+                    make_token(p->csound, name));
+    opt_var(p, t->left->value->lexeme)->subst = opt_leaf(p, out);
+    delete_tree(p->csound, out);
+    p->csound->Free(p->csound, t->left->value->lexeme);
+    t->left->value->lexeme = cs_strdup(p->csound, name);
+    opt_var(p, name)->defs = 1;
+    opt_var(p, name)->def = i;
+    t->markup = iep;
+    opt_note(p, t, Str("to i-time:"));
+    p->hoisted++;
+    return 1;
+}
+
+/* evaluate t, all of whose arguments are constants */
+static int opt_fold(OPT_STATE *p, TREE *t)
+{
+    OENTRY  *ep = (OENTRY*) t->markup;
+    SUBR    fn = ep->thread == 1 ? ep->iopadr :
+                 ep->thread == 2 ? ep->kopadr : NULL;
+    struct {
+      OPDS  h;
+      MYFLT *arg[4];
+    } op;
+    MYFLT   in[3], r = FL(0.0);
+    TREE    *a;
+    int     n;
+
+    if (fn == NULL || ep->outypes[1] != '\0' ||
+        (ep->outypes[0] != 'i' && ep->outypes[0] != 'k'))
+      return 0;
+    for (a = t->right, n = 0; a != NULL; a = a->next, n++)
+      if (n == 3 || !opt_is_const(a)) return 0;
+      else in[n] = opt_const_value(a);
+    /* leave division by zero to report itself at run time */
+    if (!strncmp(ep->opname, "##div.", 6) && n == 2 && in[1] == FL(0.0))
+      return 0;
+    memset(&op, 0, sizeof(op));
+    op.arg[0] = &r;
+    while (n--) op.arg[n + 1] = &in[n];
+    if (fn(p->csound, &op) != OK || !isfinite(r)) return 0;
+    opt_var(p, t->left->value->lexeme)->subst = opt_number(p, t, r);
+    opt_note(p, t, Str("folded"));
+    p->folded++;
+    return 1;
+}
+
+static char *opt_key(OPT_STATE *p, TREE *t)
+{
+    TREE    *a;
+    size_t  len = strlen(((OENTRY*) t->markup)->opname) + 1;
+    char    *key;
+
+    for (a = t->right; a != NULL; a = a->next)
+      len += strlen(a->value->lexeme) + 1;
+    key = p->csound->Malloc(p->csound, len);
+    strcpy(key, ((OENTRY*) t->markup)->opname);
+    for (a = t->right; a != NULL; a = a->next) {
+      strcat(key, "\001");
+      strcat(key, a->value->lexeme);
+    }
+    return key;
+}
+
+/* reuse the temporary of an available expression equal to t, or make
+   t available */
+static int opt_share(OPT_STATE *p, TREE *t)
+{
+    char    *key = opt_key(p, t);
+    int     i;
+
+    for (i = 0; i < p->navail; i++)
+      if (!strcmp(p->avail[i].key, key)) {
+        p->csound->Free(p->csound, key);
+        opt_var(p, t->left->value->lexeme)->subst =
+          opt_leaf(p, p->avail[i].t->left);
+        opt_note(p, t, Str("reused earlier"));
+        p->shared++;
+        return 1;
+      }
+    p->avail[p->navail].t = t;
+    p->avail[p->navail++].key = key;
+    return 0;
+}
+
+/* forget the available expressions reading name, or all for NULL */
+static void opt_kill(OPT_STATE *p, const char *name)
+{
+    int     i, j;
+    TREE    *a;
+
+    for (i = j = 0; i < p->navail; i++) {
+      int keep = (name != NULL);
+      for (a = p->avail[i].t->right; keep && a != NULL; a = a->next)
+        if (opt_is_ident(a) && !strcmp(a->value->lexeme, name)) keep = 0;
+      if (keep) p->avail[j++] = p->avail[i];
+      else p->csound->Free(p->csound, p->avail[i].key);
+    }
+    p->navail = j;
+}
+
+static void opt_kill_globals(OPT_STATE *p)
+{
+    int     i, j;
+    TREE    *a;
+
+    for (i = j = 0; i < p->navail; i++) {
+      int keep = 1;
+      for (a = p->avail[i].t->right; keep && a != NULL; a = a->next)
+        if (opt_is_ident(a) && opt_rate(a->value->lexeme) == 0) keep = 0;
+      if (keep) p->avail[j++] = p->avail[i];
+      else p->csound->Free(p->csound, p->avail[i].key);
+    }
+    p->navail = j;
+}
+
+static int opt_has_label(TREE *t)
+{
+    OENTRY  *ep = (OENTRY*) t->markup;
+    return t->type == GOTO_TOKEN || t->type == IGOTO_TOKEN ||
+      t->type == KGOTO_TOKEN || (ep != NULL && strchr(ep->intypes, 'l'));
+}
+
+/* the passes in which jump t may jump: 1 init, 2 performance */
+static int opt_jump_passes(TREE *t)
+{
+    OENTRY  *ep = (OENTRY*) t->markup;
+
+    if (!opt_has_label(t)) return 0;
+    if (t->type == IGOTO_TOKEN) return 1;
+    if (t->type == KGOTO_TOKEN) return 2;
+    if (t->type == GOTO_TOKEN || ep == NULL) return 3;
+    return ep->thread & 3;
+}
+
+static void opt_stmt(OPT_STATE *p, int i)
+{
+    TREE    *t = p->st[i], *a;
+    OPT_VAR *v;
+    int     kind;
+
+    if (t->type == LABEL_TOKEN) {
+      opt_kill(p, NULL);
+      return;
+    }
+    for (a = t->right; a != NULL; a = a->next)
+      if (opt_is_ident(a) &&
+          (v = opt_var(p, a->value->lexeme))->subst != NULL)
+        opt_replace(p, a, v->subst);
+    kind = opt_kind(t);
+    if (kind > 0 && t->left->next == NULL && opt_is_ident(t->left) &&
+        t->left->value->lexeme[0] == '#' &&
+        opt_var(p, t->left->value->lexeme)->defs == 1) {
+      int fixed = 1;
+      for (a = t->right; a != NULL; a = a->next)
+        if (!opt_is_const(a)) fixed = 0;
+      if (!fixed) opt_hoist(p, t, i);
+      if (opt_fold(p, t) || opt_share(p, t)) {
+        p->removed[i] = 1;
+        opt_stmt_reads(p, t, -1);
+        return;
+      }
+    }
+    else if (kind == 0 && t->left->next == NULL && opt_is_ident(t->left) &&
+             t->right != NULL && t->right->next == NULL) {
+      char *s = t->left->value->lexeme;
+      v = opt_var(p, s);
+      if (v->defs == 1 && pnum(s) < 0 &&
+          ((OENTRY*) t->markup)->opname[0] == '=') {
+        TREE *src;
+        /* an i-variable set once to a constant */
+        if (opt_rate(s) == 'i' && opt_is_const(t->right) &&
+            opt_init_safe(p, i)) {
+          v->subst = opt_leaf(p, t->right);
+          opt_note(p, t, Str("propagated"));
+          p->propagated++;
+        }
+        /* a k-variable set once to a fixed value, by code that runs
+           on every k-cycle */
+        else if (opt_rate(s) == 'k' && i < p->perf_jump &&
+                 opt_fixed(p, t->right, i, &src) &&
+                 opt_rate(src->value->lexeme) != 'k')
+          v->source = opt_leaf(p, src);
+      }
+    }
+    if (kind < 0) opt_kill_globals(p);
+    for (a = t->left; a != NULL; a = a->next)
+      if (opt_is_ident(a)) opt_kill(p, a->value->lexeme);
+    if (kind < 0)             /* some opcodes write their inputs */
+      for (a = t->right; a != NULL; a = a->next)
+        if (opt_is_ident(a)) opt_kill(p, a->value->lexeme);
+    if (opt_has_label(t)) opt_kill(p, NULL);
+}
+
+/* whether all the results of statement t are local and never read */
+static int opt_dead(OPT_STATE *p, TREE *t)
+{
+    TREE    *a;
+
+    if (opt_kind(t) < 0) return 0;
+    for (a = t->left; a != NULL; a = a->next) {
+      char *s;
+      if (!opt_is_ident(a)) return 0;
+      s = a->value->lexeme;
+      if (opt_rate(s) == 0 || pnum(s) >= 0 || opt_var(p, s)->reads > 0)
+        return 0;
+    }
+    return 1;
+}
+
+static TREE *opt_body(CSOUND *csound, TREE *list, CS_VAR_POOL *pool,
+                      const char *name)
+{
+    OPT_STATE p;
+    TREE    *t, *a, *head = NULL, *last = NULL;
+    int     i, changed;
+
+    memset(&p, 0, sizeof(OPT_STATE));
+    p.csound = csound;
+    p.pool = pool;
+    p.name = name;
+    for (t = list; t != NULL; t = t->next) p.n++;
+    if (p.n == 0) return list;
+    p.init_jump = p.perf_jump = p.n;
+    p.vars = cs_hash_table_create(csound);
+    p.st = csound->Calloc(csound, p.n * (sizeof(TREE*) + sizeof(OPT_EXPR) + 1));
+    p.avail = (OPT_EXPR*) (p.st + p.n);
+    p.removed = (char*) (p.avail + p.n);
+    for (t = list, i = 0; t != NULL; t = t->next, i++) {
+      OENTRY *ep = (OENTRY*) t->markup;
+      int jump;
+      p.st[i] = t;
+      if (t->type == LABEL_TOKEN) {
+        if (p.perf_jump == p.n) p.perf_jump = i;
+        continue;
+      }
+      jump = opt_jump_passes(t);
+      if ((jump & 1) && p.init_jump == p.n) p.init_jump = i;
+      if ((jump & 2) && p.perf_jump == p.n) p.perf_jump = i;
+      if (ep != NULL && !strcmp(ep->opname, "reinit")) p.reinit = 1;
+      for (a = t->left; a != NULL; a = a->next)
+        if (opt_is_ident(a)) {
+          OPT_VAR *v = opt_var(&p, a->value->lexeme);
+          v->defs++;
+          v->def = i;
+        }
+      opt_stmt_reads(&p, t, 1);
+    }
+
+    for (i = 0; i < p.n; i++)
+      opt_stmt(&p, i);
+    opt_kill(&p, NULL);
+
+    do {
+      changed = 0;
+      for (i = p.n - 1; i >= 0; i--)
+        if (!p.removed[i] && p.st[i]->type != LABEL_TOKEN &&
+            opt_dead(&p, p.st[i])) {
+          opt_note(&p, p.st[i], Str("removed unread"));
+          opt_stmt_reads(&p, p.st[i], -1);
+          p.removed[i] = 1;
+          p.removed_n++;
+          changed = 1;
+        }
+    } while (changed);
+
+    for (i = 0; i < p.n; i++) {
+      t = p.st[i];
+      if (p.removed[i]) {
+        t->next = NULL;
+        delete_tree(csound, t);
+        continue;
+      }
+      if (last == NULL) head = t;
+      else last->next = t;
+      last = t;
+    }
+    if (last != NULL) last->next = NULL;
+    if (csound->oparms->optReport &&
+        (p.folded || p.shared || p.hoisted || p.propagated || p.removed_n))
+      csound->Message(csound, Str("%s: %d folded, %d shared, %d hoisted to "
+                                  "i-time, %d propagated, %d removed\n"),
+                      name, p.folded, p.shared, p.hoisted, p.propagated,
+                      p.removed_n);
+    delete_tree(csound, p.leaves);
+    cs_hash_table_mfree_complete(csound, p.vars);
+    csound->Free(csound, p.st);
+    return head;
+}
+
+static TREE *opt_list(CSOUND *csound, TREE *list)
+{
+    TREE    *t;
+    char    name[80];
+
+    for (t = list; t != NULL; t = t->next) {
+      TREE *id = t->left;
+      if (t->type != INSTR_TOKEN && t->type != UDO_TOKEN) continue;
+      while (id != NULL && id->value == NULL) id = id->left;
+      snprintf(name, 80, "%s %s", t->type == UDO_TOKEN ? "opcode" : "instr",
+               id != NULL ? id->value->lexeme : "?");
+      t->right = opt_body(csound, t->right, (CS_VAR_POOL*) t->markup, name);
+    }
+    return list;
+}
+
+/* Inlining of user-defined opcodes (--udo-inline=N).  A call of a UDO
+   defined in the same orchestra is replaced by a copy of its body when
+   the body has at most N statements between xin and xout, no labels or
+   jumps, and nothing that depends on running in an instance of its own
+   (setksmps, reinit, turnoff).  The locals of the copy are renamed into
+   the caller: name@N, or a new number for a synthetic temporary.  An
+   input the body never writes is read from the caller's argument
+   itself; one it writes is copied in first, and the outputs are copied
+   out after the body, as useropcd2 does.  UDO bodies are done before
+   instruments, so a small UDO calling another is inlined with that call
+   already expanded.  Callers keep the body they were compiled with if
+   the UDO is later redefined. */
+
+static const char *inl_never[] = {
+    "setksmps", "reinit", "rireturn", "rigoto", "timout", "turnoff",
+    "xin", "xout", NULL
+};
+
+typedef struct {
+    OPCODINFO *inm;
+    TREE    *udo;
+} INL_UDO;
+
+typedef struct {
+    CSOUND  *csound;
+    INL_UDO *udos;
+    int     nudos;
+    CS_VAR_POOL *udo_pool, *pool;
+    CS_HASH_TABLE *names;   /* local of the UDO -> leaf in the caller */
+    TREE    *leaves;        /* the leaves in names, freed after a call */
+    const char *name;
+} INL_STATE;
+
+static int inl_is(TREE *t, const char *name)
+{
+    OENTRY  *ep = (OENTRY*) t->markup;
+    size_t  n = strlen(name);
+    return ep != NULL && !strncmp(ep->opname, name, n) &&
+      (ep->opname[n] == '\0' || ep->opname[n] == '.');
+}
+
+/* whether statement t may write variable name; an array given to an
+   opcode that is not internal counts as written (see udo_writes()) */
+static int inl_writes(TREE *t, const char *name, int array)
+{
+    OENTRY  *ep = (OENTRY*) t->markup;
+    TREE    *a;
+
+    for (a = t->left; a != NULL; a = a->next)
+      if (a->value != NULL && !strcmp(a->value->lexeme, name)) return 1;
+    if (ep != NULL && ((ep->flags & WI) ||
+                       !strncmp(ep->opname, "##array_set", 11) ||
+                       !strcmp(ep->opname, "##array_init") ||
+                       (array && strncmp(ep->opname, "##", 2))))
+      for (a = t->right; a != NULL; a = a->next)
+        if (a->value != NULL && !strcmp(a->value->lexeme, name)) return 1;
+    return 0;
+}
+
+static INL_UDO *inl_find(INL_STATE *p, TREE *t)
+{
+    OENTRY  *ep = (OENTRY*) t->markup;
+    int     i;
+
+    if ((t->type != T_OPCODE && t->type != T_OPCODE0) || ep == NULL ||
+        ep->useropinfo == NULL)
+      return NULL;
+    for (i = p->nudos - 1; i >= 0; i--)   /* the last definition counts */
+      if (p->udos[i].inm == ep->useropinfo) return &p->udos[i];
+    return NULL;
+}
+
+static int inl_count(TREE *t)
+{
+    int     n = 0;
+    for (; t != NULL; t = t->next) n++;
+    return n;
+}
+
+/* the first statement after xin and the xout of an inlinable body, with
+   the number of statements between them */
+static int inl_body(INL_STATE *p, INL_UDO *u, TREE **first, TREE **xout)
+{
+    TREE    *t = u->udo->right, *a;
+    int     i, n = 0;
+
+    *xout = NULL;
+    if (t != NULL && inl_is(t, "xin")) {
+      if (inl_count(t->left) != u->inm->inchns) return -1;
+      t = t->next;
+    }
+    else if (u->inm->inchns > 0) return -1;
+    *first = t;
+    for (; t != NULL; t = t->next) {
+      if (t->next == NULL && inl_is(t, "xout")) {
+        if (inl_count(t->right) != u->inm->outchns) return -1;
+        *xout = t;
+        break;
+      }
+      if (t->type == LABEL_TOKEN || t->markup == NULL || opt_has_label(t) ||
+          inl_find(p, t) == u || ++n > p->csound->oparms->udoInline)
+        return -1;
+      for (i = 0; inl_never[i] != NULL; i++)
+        if (inl_is(t, inl_never[i])) return -1;
+      for (a = t->left; a != NULL; a = a->next)
+        if (a->value != NULL && pnum(a->value->lexeme) >= 0) return -1;
+    }
+    if (*xout == NULL && u->inm->outchns > 0) return -1;
+    return n;
+}
+
+/* a new variable in the caller for local var of the UDO */
+static TREE *inl_local(INL_STATE *p, CS_VARIABLE *var, TREE *at)
+{
+    CS_VARIABLE *nv;
+    ARRAY_VAR_INIT init;
+    TREE    *leaf;
+    char    name[128];
+    int     n = (int) strlen(var->varName);
+
+    if (var->varName[0] == '#') {
+      while (n > 2 && isdigit((unsigned char) var->varName[n-1])) n--;
+      snprintf(name, 128, "%.*s%d", n, var->varName,
+               p->pool->synthArgCount++);
+    }
+    else
+      snprintf(name, 128, "%s@%d", var->varName, p->pool->synthArgCount++);
+    init.dimensions = var->dimensions;
+    init.type = var->subType;
+    nv = csoundCreateVariable(p->csound, p->csound->typePool, var->varType,
+                              name, var->varType == &CS_VAR_TYPE_ARRAY ?
+                              &init : NULL);
+    if (nv == NULL) return NULL;
+    csoundAddVariable(p->csound, p->pool, nv);
+    leaf = make_leaf(p->csound, at->line, at->locn, at->type,
+                     make_token(p->csound, name));
+    leaf->value->type = at->value->type;
+    leaf->markup = at->markup;
+    leaf->rate = at->rate;
+    leaf->next = p->leaves;
+    p->leaves = leaf;
+    cs_hash_table_put(p->csound, p->names, var->varName, leaf);
+    return leaf;
+}
+
+static TREE *inl_copy(INL_STATE *p, TREE *a);
+
+/* copy of argument a, with the locals of the UDO renamed */
+static TREE *inl_copy1(INL_STATE *p, TREE *a)
+{
+    TREE    *to = NULL, *c;
+
+    if (a->value != NULL && a->value->lexeme != NULL &&
+        (to = cs_hash_table_get(p->csound, p->names,
+                                a->value->lexeme)) == NULL) {
+      CS_VARIABLE *var = csoundFindVariableWithName(p->csound, p->udo_pool,
+                                                    a->value->lexeme);
+      if (var != NULL) to = inl_local(p, var, a);
+    }
+    if (a->value == NULL)
+      c = make_leaf(p->csound, a->line, a->locn, a->type, NULL);
+    else c = fuse_copy_arg(p->csound, to != NULL ? to : a);
+    if (to == NULL) {
+      c->markup = a->markup;
+      c->rate = a->rate;
+    }
+    c->left = inl_copy(p, a->left);
+    c->right = inl_copy(p, a->right);
+    return c;
+}
+
+static TREE *inl_copy(INL_STATE *p, TREE *a)
+{
+    TREE    *head = NULL, **tail = &head;
+
+    for (; a != NULL; a = a->next) {
+      *tail = inl_copy1(p, a);
+      tail = &(*tail)->next;
+    }
+    return head;
+}
+
+static TREE *inl_stmt(INL_STATE *p, TREE *like, int type, char *op,
+                      char *opcode, TREE *to, TREE *from)
+{
+    TREE    *t = make_leaf(p->csound, like->line, like->locn, type,
+                           make_token(p->csound, op));
+    t->markup = find_opcode(p->csound, opcode);
+    t->left = fuse_copy_arg(p->csound, to);
+    t->right = fuse_copy_arg(p->csound, from);
+    return t;
+}
+
+/* statements copying from into to, of the type of var */
+static TREE *inl_assign(INL_STATE *p, TREE *like, CS_VARIABLE *var,
+                        TREE *to, TREE *from)
+{
+    TREE    *t;
+
+    if (!strcmp(to->value->lexeme, from->value->lexeme)) return NULL;
+    if (var->varType == &CS_VAR_TYPE_I)
+      return inl_stmt(p, like, '=', "=", "=.i", to, from);
+    if (var->varType == &CS_VAR_TYPE_A)
+      return inl_stmt(p, like, '=', "=", p->csound->oparms->sampleAccurate &&
+                      to->value->lexeme[0] == 'a' ? "=.l" : "=.a", to, from);
+    /* a k-rate copy is made at init as well */
+    t = inl_stmt(p, like, T_OPCODE, "init", "init.k", to, from);
+    t->next = inl_stmt(p, like, '=', "=", "=.k", to, from);
+    return t;
+}
+
+static int inl_copyable(CS_VARIABLE *var)
+{
+    return var->varType == &CS_VAR_TYPE_I || var->varType == &CS_VAR_TYPE_A ||
+      var->varType == &CS_VAR_TYPE_K;
+}
+
+static void inl_append(TREE ***tail, TREE *t)
+{
+    for (; t != NULL; t = t->next) {
+      **tail = t;
+      *tail = &t->next;
+    }
+}
+
+/* the statements replacing call, or NULL to keep it */
+static TREE *inl_call(INL_STATE *p, TREE *call, INL_UDO *u)
+{
+    OPCODINFO *inm = u->inm;
+    TREE    *first, *xout, *xin = u->udo->right, *t, *a, *b, *h;
+    TREE    *head = NULL, **tail = &head;
+    CS_VARIABLE *var;
+    char    *s;
+
+    if (inl_body(p, u, &first, &xout) < 0 ||
+        inl_count(call->right) != inm->inchns ||
+        inl_count(call->left) != inm->outchns)
+      return NULL;
+    if (xin == first) xin = NULL;
+    /* check every argument before changing anything */
+    for (a = xin != NULL ? xin->left : NULL, b = call->right,
+           var = inm->in_arg_pool->head; a != NULL;
+         a = a->next, b = b->next, var = var->next) {
+      if (a->value == NULL || b->value == NULL) return NULL;
+      for (t = first; t != xout; t = t->next)
+        if (inl_writes(t, a->value->lexeme,
+                       var->varType == &CS_VAR_TYPE_ARRAY)) break;
+      if ((t != xout || opt_rate(b->value->lexeme) == 0) &&
+          !inl_copyable(var))
+        return NULL;
+    }
+    for (a = call->left, var = inm->out_arg_pool->head; a != NULL;
+         a = a->next, var = var->next)
+      if (!opt_is_ident(a) || !inl_copyable(var)) return NULL;
+
+    p->names = cs_hash_table_create(p->csound);
+    p->udo_pool = (CS_VAR_POOL*) u->udo->markup;
+    for (a = xin != NULL ? xin->left : NULL, b = call->right,
+           var = inm->in_arg_pool->head; a != NULL;
+         a = a->next, b = b->next, var = var->next) {
+      s = a->value->lexeme;
+      for (t = first; t != xout; t = t->next)
+        if (inl_writes(t, s, var->varType == &CS_VAR_TYPE_ARRAY)) break;
+      if (t == xout && opt_rate(b->value->lexeme) != 0) {
+        cs_hash_table_put(p->csound, p->names, s, b);    /* read in place */
+        continue;
+      }
+      h = inl_copy1(p, a);
+      inl_append(&tail, inl_assign(p, call, var, h, b));
+      delete_tree(p->csound, h);
+    }
+    for (t = first; t != xout; t = t->next) {
+      TREE *c = make_leaf(p->csound, t->line, t->locn, t->type,
+                          make_token(p->csound, t->value->lexeme));
+      c->value->type = t->value->type;
+      c->markup = t->markup;
+      c->rate = t->rate;
+      c->left = inl_copy(p, t->left);
+      c->right = inl_copy(p, t->right);
+      inl_append(&tail, c);
+    }
+    for (a = call->left, b = xout != NULL ? xout->right : NULL,
+           var = inm->out_arg_pool->head; a != NULL;
+         a = a->next, b = b->next, var = var->next) {
+      h = inl_copy1(p, b);
+      inl_append(&tail, inl_assign(p, call, var, a, h));
+      delete_tree(p->csound, h);
+    }
+    cs_hash_table_free(p->csound, p->names);
+    delete_tree(p->csound, p->leaves);
+    p->leaves = NULL;
+    if (p->csound->oparms->optReport)
+      p->csound->Message(p->csound, Str("%s, line %d: inlined %s\n"),
+                         p->name, call->line, inm->name);
+    return head;
+}
+
+static TREE *inl_list(CSOUND *csound, TREE *root)
+{
+    INL_STATE p;
+    TREE    *t, *id;
+    char    name[80];
+    int     pass;
+
+    memset(&p, 0, sizeof(INL_STATE));
+    p.csound = csound;
+    for (t = root; t != NULL; t = t->next)
+      if (t->type == UDO_TOKEN) p.nudos++;
+    if (p.nudos == 0) return root;
+    p.udos = csound->Calloc(csound, p.nudos * sizeof(INL_UDO));
+    p.nudos = 0;
+    for (t = root; t != NULL; t = t->next)
+      if (t->type == UDO_TOKEN) {
+        TREE *ident = t->left;
+        p.udos[p.nudos].inm =
+          find_opcode_info(csound, ident->value->lexeme,
+                           ident->left->value->lexeme,
+                           ident->right->value->lexeme);
+        p.udos[p.nudos++].udo = t;
+      }
+    /* UDO bodies first */
+    for (pass = 0; pass < 2; pass++)
+      for (t = root; t != NULL; t = t->next) {
+        TREE **prev, *s;
+        if (t->type != (pass == 0 ? UDO_TOKEN : INSTR_TOKEN)) continue;
+        id = t->left;
+        while (id != NULL && id->value == NULL) id = id->left;
+        snprintf(name, 80, "%s %s", pass == 0 ? "opcode" : "instr",
+                 id != NULL ? id->value->lexeme : "?");
+        p.name = name;
+        p.pool = (CS_VAR_POOL*) t->markup;
+        for (prev = &t->right; (s = *prev) != NULL; ) {
+          INL_UDO *u = inl_find(&p, s);
+          TREE *body = u != NULL ? inl_call(&p, s, u) : NULL;
+          if (body == NULL) {
+            prev = &s->next;
+            continue;
+          }
+          *prev = body;
+          while (body->next != NULL) body = body->next;
+          body->next = s->next;
+          prev = &body->next;
+          s->next = NULL;
+          delete_tree(csound, s);
+        }
+      }
+    csound->Free(csound, p.udos);
+    return root;
+}
+
 /* Optimizes tree (expressions, etc.) */
 TREE * csound_orc_optimize(CSOUND *csound, TREE *root)
 {
@@ -433,7 +1750,14 @@ TREE * csound_orc_optimize(CSOUND *csound, TREE *root)
       root = root->next;
     }
     //#ifdef JPFF
-    return remove_excess_assigns(csound,original);
+    original = remove_excess_assigns(csound,original);
+    if (csound->oparms->udoInline > 0)
+      original = inl_list(csound, original);
+    if (csound->oparms->treeOpt)
+      original = opt_list(csound, original);
+    if (csound->oparms->exprFusion)
+      original = fuse_list(csound, original);
+    return original;
     //#else
     //return original;
     //#endif
@@ -28,6 +28,7 @@
 //#include <stdbool.h>
 #include "csoundCore.h"
 #include "csound_orc.h"
+#include "memacct.h"
 #include "namedins.h"
 #include "parse_param.h"
 #include "csound_type_system.h"
@@ -63,11 +64,14 @@ const char* SYNTHESIZED_ARG = "_synthesized";
 char* cs_strdup(CSOUND* csound, char* str) {
     size_t len;
     char* retVal;
+    int mem_saved;
 
     if (str == NULL) return NULL;
 
     len = strlen(str);
+    mem_saved = csp_mem_enter(csound, CS_MEM_STRINGS);
     retVal = csound->Malloc(csound, len + 1);
+    csp_mem_leave(csound, mem_saved);
 
     if (len > 0) {
       strncpy(retVal, str, len);
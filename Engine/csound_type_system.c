@@ -249,6 +249,8 @@ void recalculateVarPoolMemory(void* csound, CS_VAR_POOL* pool)
       current = current->next;
       varCount++;
     }
+    pool->blockSize = pool->poolSize +
+      (varCount - 1) * CS_FLOAT_ALIGN(CS_VAR_TYPE_OFFSET);
 }
 
 void reallocateVarPoolMemory(void* csound, CS_VAR_POOL* pool) {
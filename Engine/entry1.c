@@ -185,10 +185,11 @@ OENTRY opcodlst_1[] = {
   { "##mul.aa",  S(AOP),0,    2,      "a",    "aa",   NULL,   mulaa   },
   { "##div.aa",  S(AOP),0,    2,      "a",    "aa",   NULL,   divaa   },
   { "##mod.aa",  S(AOP),0,    2,      "a",    "aa",   NULL,   modaa   },
+  { "##fuse",    S(FUSE),0,   3,      "a",    "S*",   fuse_init, fuse_perf },
   { "##addin.i", S(ASSIGN),0, 1,      "i",    "i",    addin,  NULL    },
   { "##addin.k", S(ASSIGN),0, 2,      "k",    "k",    NULL,   addin   },
-  { "##addin.K", S(ASSIGN),0, 2,      "a",    "k",    NULL,   addinak },
-  { "##addin.a", S(ASSIGN),0, 2,      "a",    "a",    NULL,   addina  },
+  { "##addin.K", S(ADDIN),0,  3,      "a",    "k",    addin_set, addinak },
+  { "##addin.a", S(ADDIN),0,  3,      "a",    "a",    addin_set, addina  },
   { "##subin.i", S(ASSIGN),0, 1,      "i",    "i",    subin,  NULL    },
   { "##subin.k", S(ASSIGN),0, 2,      "k",    "k",    NULL,   subin   },
   { "##subin.K", S(ASSIGN),0, 2,      "a",    "k",    NULL,   subinak },
@@ -376,38 +377,38 @@ OENTRY opcodlst_1[] = {
   /* { "table",  0xffff, TR                                                   }, */
   /* { "tablei", 0xffff, TR                                                   }, */
   /* { "table3", 0xffff, TR                                                   }, */
-  { "table.i",  S(TABL),0, 1,      "i",    "iiooo",(SUBR)tabler_init       },
-  { "table.k",  S(TABL),0, 3,      "k",    "xiooo",(SUBR)tabl_setup,
+  { "table.i",  S(TABL),TR|_AN(1), 1,      "i",    "iiooo",(SUBR)tabler_init       },
+  { "table.k",  S(TABL),TR|_AN(1), 3,      "k",    "xiooo",(SUBR)tabl_setup,
     (SUBR)tabler_kontrol        },
-  { "table.a",  S(TABL),0, 3,      "a",    "xiooo",(SUBR)tabl_setup,
+  { "table.a",  S(TABL),TR|_AN(1), 3,      "a",    "xiooo",(SUBR)tabl_setup,
     (SUBR)tabler_audio                                                      },
-  { "tablei.i", S(TABL),0, 1,      "i",    "iiooo",(SUBR)tableir_init       },
-  { "tablei.k", S(TABL),0, 3,      "k",    "xiooo",(SUBR)tabl_setup,
+  { "tablei.i", S(TABL),TR|_AN(1), 1,      "i",    "iiooo",(SUBR)tableir_init       },
+  { "tablei.k", S(TABL),TR|_AN(1), 3,      "k",    "xiooo",(SUBR)tabl_setup,
     (SUBR)tableir_kontrol                                                   },
-  { "tablei.a", S(TABL),0, 3,      "a",    "xiooo",(SUBR)tabl_setup,
+  { "tablei.a", S(TABL),TR|_AN(1), 3,      "a",    "xiooo",(SUBR)tabl_setup,
     (SUBR)tableir_audio                                                     },
-  { "table3.i", S(TABL),0, 1,      "i",    "iiooo",(SUBR)table3r_init       },
-  { "table3.k", S(TABL),0, 3,      "k",    "xiooo",(SUBR)tabl_setup,
+  { "table3.i", S(TABL),TR|_AN(1), 1,      "i",    "iiooo",(SUBR)table3r_init       },
+  { "table3.k", S(TABL),TR|_AN(1), 3,      "k",    "xiooo",(SUBR)tabl_setup,
     (SUBR)table3r_kontrol                                                   },
-  { "table3.a", S(TABL),0, 3,      "a",    "xiooo",(SUBR)tabl_setup,
+  { "table3.a", S(TABL),TR|_AN(1), 3,      "a",    "xiooo",(SUBR)tabl_setup,
     (SUBR)table3r_audio                                                     },
   /* { "ptable",  0xffff, TR                                                  }, */
   /* { "ptablei", 0xffff, TR                                                  }, */
   /* { "ptable3", 0xffff, TR                                                  }, */
-  { "ptable.i",  S(TABLE),0, 1,     "i",    "iiooo",(SUBR)tabler_init       },
-  { "ptable.k",  S(TABLE),0, 3,     "k",    "xiooo",(SUBR)tabl_setup,
+  { "ptable.i",  S(TABLE),TR|_AN(1), 1,     "i",    "iiooo",(SUBR)tabler_init       },
+  { "ptable.k",  S(TABLE),TR|_AN(1), 3,     "k",    "xiooo",(SUBR)tabl_setup,
     (SUBR)tabler_kontrol                                                    },
-  { "ptable.a",  S(TABLE),0, 3,     "a",    "xiooo",(SUBR)tabl_setup,
+  { "ptable.a",  S(TABLE),TR|_AN(1), 3,     "a",    "xiooo",(SUBR)tabl_setup,
     (SUBR)tabler_audio                                                      },
-  { "ptablei.i", S(TABLE),0, 1,     "i",    "iiooo",(SUBR)tableir_init      },
-  { "ptablei.k", S(TABLE),0, 3,     "k",    "xiooo",(SUBR)tabl_setup,
+  { "ptablei.i", S(TABLE),TR|_AN(1), 1,     "i",    "iiooo",(SUBR)tableir_init      },
+  { "ptablei.k", S(TABLE),TR|_AN(1), 3,     "k",    "xiooo",(SUBR)tabl_setup,
     (SUBR)tableir_kontrol                                                   },
-  { "ptablei.a", S(TABLE),0, 3,     "a",    "xiooo",(SUBR)tabl_setup,
+  { "ptablei.a", S(TABLE),TR|_AN(1), 3,     "a",    "xiooo",(SUBR)tabl_setup,
     (SUBR)tableir_audio                                                     },
-  { "ptable3.i", S(TABLE),0, 1,     "i",    "iiooo",(SUBR)table3r_init      },
-  { "ptable3.k", S(TABLE),0, 3,     "k",    "xiooo",(SUBR)tabl_setup,
+  { "ptable3.i", S(TABLE),TR|_AN(1), 1,     "i",    "iiooo",(SUBR)table3r_init      },
+  { "ptable3.k", S(TABLE),TR|_AN(1), 3,     "k",    "xiooo",(SUBR)tabl_setup,
     (SUBR)table3r_kontrol                                                   },
-  { "ptable3.a", S(TABLE),0, 3,     "a",    "xiooo",(SUBR)tabl_setup,
+  { "ptable3.a", S(TABLE),TR|_AN(1), 3,     "a",    "xiooo",(SUBR)tabl_setup,
     (SUBR)table3r_audio         },
   { "oscil1", S(OSCIL1), TR, 3,     "k",    "ikij", ko1set, kosc1          },
   { "oscil1i",S(OSCIL1), TR, 3,     "k",    "ikij", ko1set, kosc1i         },
@@ -678,47 +679,47 @@ OENTRY opcodlst_1[] = {
   { "filepeak.i", S(SNDINFOPEAK),0, 1, "i",   "io",   filepeak, NULL, NULL       },
   { "filevalid.i", S(FILEVALID),0, 1,  "i",   "i",    filevalid, NULL, NULL      },
   /*  { "nlalp", S(NLALP),0,     3,     "a",  "akkoo", nlalp_set, nlalp }, */
-  { "ptableiw",  S(TABLEW),TW|_QQ, 1, "", "iiiooo", (SUBR)tablew_init, NULL, NULL},
-  { "ptablew.kk", S(TABLEW),TB,  3,  "", "kkiooo",(SUBR)tabl_setup,
+  { "ptableiw",  S(TABLEW),TW|_AN(2)|_QQ, 1, "", "iiiooo", (SUBR)tablew_init, NULL, NULL},
+  { "ptablew.kk", S(TABLEW),TB|_AN(2),  3,  "", "kkiooo",(SUBR)tabl_setup,
     (SUBR)tablew_kontrol, NULL          },
-  { "ptablew.aa", S(TABLEW),TB,  3,  "", "aaiooo",(SUBR)tabl_setup,
+  { "ptablew.aa", S(TABLEW),TB|_AN(2),  3,  "", "aaiooo",(SUBR)tabl_setup,
     (SUBR)tablew_audio               },
-  { "tableiw",  S(TABL),TW|_QQ, 1, "",   "iiiooo", (SUBR)tablew_init, NULL, NULL},
-  { "tablew",  S(TABL),TW, 1,    "",   "iiiooo", (SUBR)tablew_init, NULL, NULL},
-  { "tablew.kk", S(TABL),TW,  3,    "", "kkiooo",(SUBR)tabl_setup,
+  { "tableiw",  S(TABL),TW|_AN(2)|_QQ, 1, "",   "iiiooo", (SUBR)tablew_init, NULL, NULL},
+  { "tablew",  S(TABL),TW|_AN(2), 1,    "",   "iiiooo", (SUBR)tablew_init, NULL, NULL},
+  { "tablew.kk", S(TABL),TW|_AN(2),  3,    "", "kkiooo",(SUBR)tabl_setup,
     (SUBR)tablew_kontrol, NULL          },
-  { "tablew.aa", S(TABL),TW,  3,    "", "aaiooo",(SUBR)tabl_setup,
+  { "tablew.aa", S(TABL),TW|_AN(2),  3,    "", "aaiooo",(SUBR)tabl_setup,
     (SUBR)tablew_audio               },
-  { "tablewkt.kk", S(TABL),TW,3, "",  "kkkooo",
+  { "tablewkt.kk", S(TABL),TW|_AN(2),3, "",  "kkkooo",
     (SUBR)tablkt_setup,(SUBR)tablewkt_kontrol,NULL},
-  { "tablewkt.aa", S(TABL),TW,3, "",  "aakooo",
+  { "tablewkt.aa", S(TABL),TW|_AN(2),3, "",  "aakooo",
     (SUBR)tablkt_setup,(SUBR)tablewkt_audio},
-  { "tableng.i", S(TLEN),TR,1,     "i",  "i",    (SUBR)table_length, NULL,  NULL},
-  { "tableng.k",  S(TLEN),TR,2,    "k",  "k",    NULL,  (SUBR)table_length, NULL},
-  { "tableigpw",S(TGP), TB, 1,     "",  "i",    (SUBR)table_gpw, NULL,  NULL},
-  { "tablegpw", S(TGP), TB,2,      "",  "k",    NULL,   (SUBR)table_gpw, NULL},
+  { "tableng.i", S(TLEN),TR|_AN(0),1,     "i",  "i",    (SUBR)table_length, NULL,  NULL},
+  { "tableng.k",  S(TLEN),TR|_AN(0),2,    "k",  "k",    NULL,  (SUBR)table_length, NULL},
+  { "tableigpw",S(TGP),TB|_AN(0), 1,     "",  "i",    (SUBR)table_gpw, NULL,  NULL},
+  { "tablegpw", S(TGP),TB|_AN(0),2,      "",  "k",    NULL,   (SUBR)table_gpw, NULL},
   { "tableimix",S(TABLMIX),TB, 1,  "",  "iiiiiiiii", (SUBR)table_mix, NULL, NULL},
   { "tablemix", S(TABLMIX),TB, 2,  "",  "kkkkkkkkk", NULL, (SUBR)table_mix, NULL},
   { "tableicopy",S(TGP),TB, 1, "", "ii",   (SUBR)table_copy, NULL, NULL},
   { "tablecopy", S(TGP),TB, 2, "", "kk", NULL, (SUBR)table_copy, NULL},
-  { "tablera", S(TABLRA),TR, 3,   "a",  "kkk",
+  { "tablera", S(TABLRA),TR|_AN(0), 3,   "a",  "kkk",
     (SUBR)table_ra_set, (SUBR)table_ra},
-  { "tablewa", S(TABLWA),TW, 3,   "k",  "kakp",
+  { "tablewa", S(TABLWA),TW|_AN(0), 3,   "k",  "kakp",
     (SUBR)table_wa_set, (SUBR)table_wa},
-  { "tablekt",  S(TABL),TR, 3,   "k",  "xkooo",  (SUBR)tablkt_setup,
+  { "tablekt",  S(TABL),TR|_AN(1), 3,   "k",  "xkooo",  (SUBR)tablkt_setup,
     (SUBR)tablerkt_kontrol,
     NULL         },
-  { "tablekt.a",  S(TABL),TR, 3,   "a",  "xkooo",  (SUBR)tablkt_setup,
+  { "tablekt.a",  S(TABL),TR|_AN(1), 3,   "a",  "xkooo",  (SUBR)tablkt_setup,
     (SUBR)tablerkt_audio           },
-  { "tableikt", S(TABL),TR, 3,    "k",  "xkooo", (SUBR)tablkt_setup,
+  { "tableikt", S(TABL),TR|_AN(1), 3,    "k",  "xkooo", (SUBR)tablkt_setup,
     (SUBR)tableirkt_kontrol,
     NULL          },
-  { "tableikt.a", S(TABL),TR, 3,    "a",  "xkooo", (SUBR)tablkt_setup,
+  { "tableikt.a", S(TABL),TR|_AN(1), 3,    "a",  "xkooo", (SUBR)tablkt_setup,
     (SUBR)tableirkt_audio          },
-  { "table3kt", S(TABL),TR, 3,  "k",  "xkooo", (SUBR)tablkt_setup,
+  { "table3kt", S(TABL),TR|_AN(1), 3,  "k",  "xkooo", (SUBR)tablkt_setup,
     (SUBR)table3rkt_kontrol,
     NULL         },
-  { "table3kt.a", S(TABL),TR, 3,  "a",  "xkooo", (SUBR)tablkt_setup,
+  { "table3kt.a", S(TABL),TR|_AN(1), 3,  "a",  "xkooo", (SUBR)tablkt_setup,
     (SUBR)table3rkt_audio          },
   { "inz",    S(IOZ),    ZW, 2,   "",   "k",  NULL,   (SUBR)inz  },
   { "outz",   S(IOZ),ZR|IR,  2,   "",   "k",    NULL,   (SUBR)outz },
@@ -1056,7 +1057,7 @@ OENTRY opcodlst_1[] = {
   { "loop_le.k", S(LOOP_OPS),0,  2,  "", "kkkl", NULL, (SUBR) loop_le_p, NULL  },
   { "loop_gt.k", S(LOOP_OPS),0,  2,  "", "kkkl", NULL, (SUBR) loop_g_p, NULL   },
   { "loop_ge.k", S(LOOP_OPS),0,  2,  "", "kkkl", NULL, (SUBR) loop_ge_p, NULL  },
-  { "chnget",      0xFFFF,    _CR                                             },
+  { "chnget",      0xFFFF,    _CR|_AN(0)                                           },
   { "chnget.i",    S(CHNGET),0,           1,      "i",            "S",
     (SUBR) chnget_opcode_init_i, NULL, NULL               },
   { "chnget.k",    S(CHNGET),0,           3,      "k",            "S",
@@ -1067,30 +1068,30 @@ OENTRY opcodlst_1[] = {
     (SUBR) chnget_opcode_init_S, (SUBR) chnget_opcode_perf_S, NULL},
   { "chngetks",    S(CHNGET),0,           2,      "S",            "S",
     NULL, (SUBR) chnget_opcode_perf_S, NULL},
-  { "chnset",      0xFFFB,              _CW                               },
-  { "chnset.i",    S(CHNGET),_CW,          1,      "",             "iS",
+  { "chnset",      0xFFFB,              _CW|_AN(1)                             },
+  { "chnset.i",    S(CHNGET),_CW|_AN(1),          1,      "",             "iS",
     (SUBR) chnset_opcode_init_i, NULL, NULL               },
   //  { "chnset.r",    S(CHNGET),0,           1,      "",             "iS",
   //    (SUBR) chnset_opcode_init_i, NULL, NULL               },
   //  { "chnset.c",    S(CHNGET),0,           1,      "",             "iS",
   //    (SUBR) chnset_opcode_init_i, NULL, NULL               },
-  { "chnset.k",    S(CHNGET),_CW,           3,      "",             "kS",
+  { "chnset.k",    S(CHNGET),_CW|_AN(1),           3,      "",             "kS",
     (SUBR) chnset_opcode_init_k, (SUBR) notinit_opcode_stub, NULL },
-  { "chnset.a",    S(CHNGET),_CW,           3,      "",             "aS",
+  { "chnset.a",    S(CHNGET),_CW|_AN(1),           3,      "",             "aS",
     (SUBR) chnset_opcode_init_a, (SUBR) notinit_opcode_stub },
-  { "chnset.S",    S(CHNGET),_CW,           3,      "",             "SS",
+  { "chnset.S",    S(CHNGET),_CW|_AN(1),           3,      "",             "SS",
     (SUBR) chnset_opcode_init_S, (SUBR) chnset_opcode_perf_S, NULL },
-  { "chnsetks",    S(CHNGET),_CW,           2,      "",             "SS",
+  { "chnsetks",    S(CHNGET),_CW|_AN(1),           2,      "",             "SS",
     NULL, (SUBR) chnset_opcode_perf_S, NULL },
-  { "chnmix",      S(CHNGET),           _CB, 3,      "",             "aS",
+  { "chnmix",      S(CHNGET),           _CA|_AN(1), 3,      "",             "aS",
     (SUBR) chnmix_opcode_init, (SUBR) notinit_opcode_stub  },
-  { "chnclear",    S(CHNCLEAR),        _CW, 3,      "",             "W",
+  { "chnclear",    S(CHNCLEAR),        _CW|_AL, 3,      "",             "W",
     (SUBR) chnclear_opcode_init, (SUBR) notinit_opcode_stub },
-  { "chn_k",       S(CHN_OPCODE_K),    _CW, 1,      "",             "SiooooooooN",
+  { "chn_k",       S(CHN_OPCODE_K),    _CW|_AN(0), 1,      "",             "SiooooooooN",
     (SUBR) chn_k_opcode_init, NULL, NULL                  },
-  { "chn_a",       S(CHN_OPCODE),      _CW, 1,      "",             "Si",
+  { "chn_a",       S(CHN_OPCODE),      _CW|_AN(0), 1,      "",             "Si",
     (SUBR) chn_a_opcode_init, NULL, NULL                  },
-  { "chn_S",       S(CHN_OPCODE),      _CW, 1,      "",             "Si",
+  { "chn_S",       S(CHN_OPCODE),      _CW|_AN(0), 1,      "",             "Si",
     (SUBR) chn_S_opcode_init, NULL, NULL                  },
   { "chnexport",   0xFFFF,  0,    0,   NULL,   NULL, NULL, NULL },
   { "chnexport.i", S(CHNEXPORT_OPCODE),0, 1,      "i",            "Sioooo",
@@ -1101,7 +1102,7 @@ OENTRY opcodlst_1[] = {
     (SUBR) chnexport_opcode_init, NULL, NULL              },
   { "chnexport.S", S(CHNEXPORT_OPCODE),0, 1,      "S",            "Si",
     (SUBR) chnexport_opcode_init, NULL, NULL              },
-  { "chnparams",   S(CHNPARAMS_OPCODE),_CR, 1,      "iiiiii",       "S",
+  { "chnparams",   S(CHNPARAMS_OPCODE),_CR|_AN(0), 1,      "iiiiii",       "S",
     (SUBR) chnparams_opcode_init, NULL, NULL              },
   /*  these opcodes have never been fully implemented
       { "chnrecv",     S(CHNSEND),       _CR, 3,      "",             "So",
@@ -38,6 +38,7 @@
 
 
 #include "namedins.h"
+#include "rtcheck.h"
 
 /* list of environment variables used by Csound */
 
@@ -1013,6 +1014,7 @@ void *csoundFileOpenWithType(CSOUND *csound, void *fd, int type,
     SF_INFO sfinfo;
     int     tmp_fd = -1, nbytes = (int) sizeof(CSFILE);
 
+    CSP_RT_CHECK("file open");
 
     /* check file type */
     if (UNLIKELY((unsigned int) (type - 1) >= (unsigned int) CSFILE_SND_W)) {
@@ -1516,11 +1518,14 @@ static int read_files(CSOUND *csound){
 
 
 
+void csp_thread_place(CSOUND *csound, int index, const char *name);
+
 void *file_iothread(void *p){
     int res = 1;
     CSOUND *csound = p;
     int wakeup = (int) (1000*csound->ksmps/csound->esr);
     _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
+    csp_thread_place(csound, -1, Str("file io"));
     if (wakeup == 0) wakeup = 1;
     while (res){
       csoundSleep(wakeup);
@@ -32,6 +32,7 @@
 #include "fgens.h"
 #include "pstream.h"
 #include "pvfileio.h"
+#include "memacct.h"
 #include <stdlib.h>
 /* #undef ISSTRCOD */
 
@@ -131,7 +132,19 @@ static inline unsigned int isPowerOfTwo (unsigned int x) {
  * Returns zero on success.
  */
 
+static int hfgens_(CSOUND *, FUNC **, const EVTBLK *, int);
+
 int hfgens(CSOUND *csound, FUNC **ftpp, const EVTBLK *evtblkp, int mode)
+{
+    /* the table, and whatever its GEN allocates, count as ftables */
+    int mem_saved = csp_mem_enter(csound, CS_MEM_FTABLES);
+    int ret = hfgens_(csound, ftpp, evtblkp, mode);
+    csp_mem_leave(csound, mem_saved);
+    return ret;
+}
+
+static int hfgens_(CSOUND *csound, FUNC **ftpp, const EVTBLK *evtblkp,
+                   int mode)
 {
     int32    genum, ltest;
     int     lobits, msg_enabled, i;
@@ -2377,6 +2390,8 @@ static CS_NOINLINE FUNC *ftalloc(const FGDATA *ff)
     if (ftp == NULL) {                      /*   alloc space as reqd */
       csound->flist[ff->fno] = ftp = (FUNC*) csound->Calloc(csound, sizeof(FUNC));
       ftp->ftable = (MYFLT*) csound->Calloc(csound, (1+ff->flen) * sizeof(MYFLT));
+      if (UNLIKELY(csound->oparms->rtMemory))
+        mem_prefault(csound, ftp->ftable, (1+ff->flen) * sizeof(MYFLT), 1);
     }
     ftp->fno = (int32) ff->fno;
     ftp->flen = ff->flen;
@@ -33,6 +33,7 @@
 #include "interlocks.h"
 #include "csound_type_system.h"
 #include "csound_standard_types.h"
+#include "memacct.h"
 #include <inttypes.h>
 
 static  void    showallocs(CSOUND *);
@@ -41,6 +42,9 @@ static  void    schedofftim(CSOUND *, INSDS *);
 void    beatexpire(CSOUND *, double);
 void    timexpire(CSOUND *, double);
 static  void    instance(CSOUND *, int);
+static  void    instance_prewarm(CSOUND *);
+void    instance_block_free(CSOUND *, INSTRTXT *, INSDS *);
+void    instance_pool_free(CSOUND *, INSTRTXT *);
 extern int argsRequired(char* argString);
 static int insert_midi(CSOUND *csound, int insno, MCHNBLK *chn,
                        MEVENT *mep);
@@ -104,17 +108,21 @@ static void no_op(CSOUND *csound, int attr,
 
  /* do init pass for this instr */
 static int init_pass(CSOUND *csound, INSDS *ip) {
-  int error = 0;
+  int error = 0, mem_saved;
   if(csound->oparms->realtime)
     csoundLockMutex(csound->init_pass_threadlock);
+  mem_saved = csp_mem_enter(csound,
+                            csp_mem_owner_instr(csound, ip->instr, ip->insno));
   csound->curip = ip;
   csound->ids = (OPDS *)ip;
+  INSDS_PRIV(ip)->disp_ready = 0;       /* opcodes may set new opadr */
   while (error == 0 && (csound->ids = csound->ids->nxti) != NULL){
     if (UNLIKELY(csound->oparms->odebug))
       csound->Message(csound, "init %s:\n",
                       csound->ids->optext->t.oentry->opname);
     error = (*csound->ids->iopadr)(csound, csound->ids);
   }
+  csp_mem_leave(csound, mem_saved);
   if(csound->oparms->realtime)
     csoundUnlockMutex(csound->init_pass_threadlock);
   return error;
@@ -123,12 +131,15 @@ static int init_pass(CSOUND *csound, INSDS *ip) {
 int rireturn(CSOUND *csound, void *p);
 /* do reinit pass */
 static int reinit_pass(CSOUND *csound, INSDS *ip, OPDS *ids) {
-  int error = 0;
+  int error = 0, mem_saved;
   if(csound->oparms->realtime) {
     csoundLockMutex(csound->init_pass_threadlock);
   }
+  mem_saved = csp_mem_enter(csound,
+                            csp_mem_owner_instr(csound, ip->instr, ip->insno));
   csound->curip = ip;
   csound->ids = ids;
+  INSDS_PRIV(ip)->disp_ready = 0;
   while (error == 0 && (csound->ids = csound->ids->nxti) != NULL &&
          (csound->ids->iopadr != (SUBR) rireturn)){
    if (UNLIKELY(csound->oparms->odebug))
@@ -137,6 +148,7 @@ static int reinit_pass(CSOUND *csound, INSDS *ip, OPDS *ids) {
     error = (*csound->ids->iopadr)(csound, csound->ids);
   }
 
+  csp_mem_leave(csound, mem_saved);
   ATOMIC_SET8(ip->actflg, 1);
   csound->reinitflag = ip->reinitflag = 0;
   if(csound->oparms->realtime)
@@ -145,6 +157,8 @@ static int reinit_pass(CSOUND *csound, INSDS *ip, OPDS *ids) {
 }
 
 
+void csp_thread_place(CSOUND *csound, int index, const char *name);
+
 /*
  * creates a thread to process instance allocations
  */
@@ -174,6 +188,7 @@ uintptr_t event_insert_thread(void *p) {
  } else {
   csoundSetMessageCallback(csound, no_op);
  }
+  csp_thread_place(csound, -1, Str("event insert"));
 
   while(csound->event_insert_loop) {
     // get the value of items_to_alloc
@@ -248,6 +263,8 @@ int init0(CSOUND *csound)
   while ((csound->ids = csound->ids->nxti) != NULL) {
     (*csound->ids->iopadr)(csound, csound->ids);  /*   run all i-code     */
   }
+  if (csound->oparms->instancePrewarm > 0)
+    instance_prewarm(csound);
   return csound->inerrcnt;                        /*   return errcnt      */
 }
 
@@ -1040,13 +1057,13 @@ void orcompact(CSOUND *csound)          /* free all inactive instr spaces */
             csound->Free(csound, ip->opcod_iobufs);   /* IV - Nov 10 2002 */
           if (ip->fdchp != NULL)
             fdchclose(csound, ip);
-          if (ip->auxchp != NULL)
+          if (ip->auxchp != NULL || INSDS_PRIV(ip)->auxarena != NULL)
             auxchfree(csound, ip);
           free_instr_var_memory(csound, ip);
           if ((nxtip = ip->nxtinstance) != NULL)
             nxtip->prvinstance = prvip;
           *prvnxtloc = nxtip;
-          csound->Free(csound, (char *)ip);
+          instance_block_free(csound, txtp, ip);
         }
         else {
           prvip = ip;
@@ -1364,6 +1381,30 @@ int subinstrset(CSOUND *csound, SUBINST *p){
 */
 int useropcd1(CSOUND *, UOPCODE*), useropcd2(CSOUND *, UOPCODE*);
 
+/* Point the body's reads of the inputs in inm->byref at the caller's
+   arguments, or back at the UDO's own copies when the inputs have to be
+   copied: a local ksmps takes them in slices, and a global argument may
+   be written by the body while it still reads the input. */
+static void udo_bind_inputs(UOPCODE *p, int byref)
+{
+    OPCOD_IOBUFS *buf = p->buf;
+    OPCODINFO *inm = buf->opcode_info;
+    MYFLT   **args = p->ar + inm->outchns;
+    ARG     *arg = p->h.optext->t.inArgs;
+    int     i;
+
+    buf->byref = 0;
+    if (inm->byref == NULL) byref = 0;
+    for (i = 0; i < inm->inchns; i++, arg = arg != NULL ? arg->next : NULL) {
+      buf->refin[i] = byref && inm->byref[i] != NULL &&
+        arg != NULL && arg->type != ARG_GLOBAL;
+      buf->byref |= buf->refin[i];
+    }
+    for (i = 0; i < buf->nrefs; i++)
+      *buf->refs[i].slot = buf->refin[buf->refs[i].arg] ?
+        args[buf->refs[i].arg] : buf->refs[i].local;
+}
+
 int useropcdset(CSOUND *csound, UOPCODE *p)
 {
     OPDS         *saved_ids = csound->ids;
@@ -1460,6 +1501,7 @@ int useropcdset(CSOUND *csound, UOPCODE *p)
       lcurip->onedksmps = CS_ONEDKSMPS;
       lcurip->kicvt = CS_KICVT;
     }
+    udo_bind_inputs(p, local_ksmps == CS_KSMPS);
 
     /* VL 13-12-13 */
     /* this sets ksmps and kr local variables */
@@ -1577,7 +1619,8 @@ int xinset(CSOUND *csound, XIN *p)
     void* in = (void*)bufs[i];
     void* out = (void*)p->args[i];
     tmp[i + inm->outchns] = out;
-    current->varType->copyValue(csound, out, in);
+    if (!buf->byref || !buf->refin[i])
+      current->varType->copyValue(csound, out, in);
     current = current->next;
   }
 
@@ -1790,7 +1833,10 @@ int subinstr(CSOUND *csound, SUBINST *p)
   /* copy current spout buffer and clear it */
   ip->spout = (MYFLT*) p->saved_spout.auxp;
   memset(ip->spout, 0, csound->nspout*sizeof(MYFLT));
-  csound->spoutactive = 0;
+  INSDS_PRIV(ip)->dag_thread = INSDS_PRIV(p->parent_ip)->dag_thread;
+  /* under -j spoutactive stays set for the k-cycle, as the other threads
+     are mixing into their own copies of spout */
+  if (csound->dag_spout == NULL) csound->spoutactive = 0;
 
   /* update release flag */
   ip->relesing = p->parent_ip->relesing;   /* IV - Nov 16 2002 */
@@ -1895,6 +1941,7 @@ int useropcd1(CSOUND *csound, UOPCODE *p)
   offset = p->h.insdshead->ksmps_offset;
   p->ip->spin = p->parent_ip->spin;
   p->ip->spout = p->parent_ip->spout;
+  INSDS_PRIV(p->ip)->dag_thread = INSDS_PRIV(p->parent_ip)->dag_thread;
   inm = p->buf->opcode_info;
 
   /* global ksmps is the caller instr ksmps minus sample-accurate end */
@@ -2200,6 +2247,7 @@ int useropcd2(CSOUND *csound, UOPCODE *p)
 
   p->ip->spin = p->parent_ip->spin;
   p->ip->spout = p->parent_ip->spout;
+  INSDS_PRIV(p->ip)->dag_thread = INSDS_PRIV(p->parent_ip)->dag_thread;
 
   if (UNLIKELY(!(CS_PDS = (OPDS*) (p->ip->nxtp))))
     goto endop; /* no perf code */
@@ -2220,7 +2268,8 @@ int useropcd2(CSOUND *csound, UOPCODE *p)
     //change to use generic code...
     if (current->varType != &CS_VAR_TYPE_I &&
         current->varType != &CS_VAR_TYPE_b &&
-        current->subType != &CS_VAR_TYPE_I) {
+        current->subType != &CS_VAR_TYPE_I &&
+        (!p->buf->byref || !p->buf->refin[i])) {
       if (current->varType == &CS_VAR_TYPE_A && CS_KSMPS == 1) {
         *internal_ptrs[i + inm->outchns] = *external_ptrs[i + inm->outchns];
       } else {
@@ -2303,6 +2352,171 @@ int findLabelMemOffset(CSOUND* csound, INSTRTXT* ip, char* labelName) {
   return offset;
 }
 
+/* Instance blocks are cut from slabs kept per instrument, so a burst
+   of notes costs at most one allocation per slab, growing to
+   POOL_SLAB_MAX blocks, and none for instances made ahead by
+   --instance-prewarm or prealloc.  Blocks freed by orcompact go back to
+   the pool of their instrument; the slabs are released with it. */
+
+#define POOL_SLAB_HDR   16      /* slab link, keeps blocks 16-aligned */
+#define POOL_SLAB_MAX   64
+
+typedef struct instr_pool_t {
+  size_t  blksiz;
+  char    *slabs;               /* linked through their first word */
+  char    *next, *end;          /* uncut part of the newest slab, zeroed */
+  void    *recycled;            /* blocks freed by orcompact */
+  int     slab_blocks;          /* size of the newest slab */
+  int     live;                 /* blocks in use */
+  int     highwater;
+  int     slabs_alloc;          /* slabs taken from the system */
+  int     slabs_perf;           /*   of which for a note being started */
+} INSTR_POOL;
+
+/* a zeroed block for an instance of size bytes, returned as the INSDS
+   following its INSDS_PRIV */
+static INSDS *instance_block(CSOUND *csound, INSTRTXT *tp, size_t size)
+{
+  INSTR_POOL *pool = tp->pool;
+  char *blk;
+
+  size = (INSDS_PRIV_SIZE + size + 15) & ~((size_t) 15);
+  if (UNLIKELY(pool == NULL))
+    pool = tp->pool = csound->Calloc(csound, sizeof(INSTR_POOL));
+  if (UNLIKELY(size > pool->blksiz)) {  /* first use, or more MIDI pfields */
+    pool->blksiz = size;
+    pool->next = pool->end = NULL;
+    pool->recycled = NULL;              /* too small now */
+  }
+  size = pool->blksiz;
+  if (pool->recycled != NULL) {
+    blk = pool->recycled;
+    pool->recycled = *(void**) blk;
+    memset(blk, 0, size);
+  }
+  else {
+    if (pool->next == NULL || pool->next + size > pool->end) {
+      int n = pool->slab_blocks*2;
+      char *slab;
+      if (n > POOL_SLAB_MAX) n = POOL_SLAB_MAX;
+      if (n < csound->inst_prewarm) n = csound->inst_prewarm;
+      if (n < 1) n = 1;
+      slab = csound->Calloc(csound, POOL_SLAB_HDR + n*size);
+      if (UNLIKELY(csound->oparms->rtMemory))
+        mem_prefault(csound, slab, POOL_SLAB_HDR + n*size, 0);
+      *(char**) slab = pool->slabs;
+      pool->slabs = slab;
+      pool->next = slab + POOL_SLAB_HDR;
+      pool->end = pool->next + n*size;
+      pool->slab_blocks = n;
+      pool->slabs_alloc++;
+      if (csound->inst_prewarm == 0) pool->slabs_perf++;
+    }
+    blk = pool->next;
+    pool->next += size;
+  }
+  if (++pool->live > pool->highwater) pool->highwater = pool->live;
+  ((INSDS_PRIV*) blk)->blksiz = size;
+  return (INSDS*) (blk + INSDS_PRIV_SIZE);
+}
+
+void instance_block_free(CSOUND *csound, INSTRTXT *tp, INSDS *ip)
+{
+  INSTR_POOL *pool = tp->pool;
+  INSDS_PRIV *blk = INSDS_PRIV(ip);
+  (void) csound;
+  pool->live--;
+  /* cut before the block size grew: left in its slab until the pool
+     is freed, as reusing it would overrun it */
+  if (UNLIKELY(blk->blksiz < pool->blksiz))
+    return;
+  *(void**) blk = pool->recycled;
+  pool->recycled = blk;
+}
+
+/* release the instances of tp, which must all be inactive */
+void instance_pool_free(CSOUND *csound, INSTRTXT *tp)
+{
+  INSTR_POOL *pool = tp->pool;
+  aux_pool_free(csound, tp);
+  if (pool == NULL) return;
+  while (pool->slabs != NULL) {
+    char *nxt = *(char**) pool->slabs;
+    csound->Free(csound, pool->slabs);
+    pool->slabs = nxt;
+  }
+  csound->Free(csound, pool);
+  tp->pool = NULL;
+  tp->instance = tp->lst_instance = tp->act_instance = NULL;
+}
+
+/* make --instance-prewarm free instances of each instrument and UDO */
+static void instance_prewarm(CSOUND *csound)
+{
+  int want = csound->oparms->instancePrewarm, i, n;
+  OPCODINFO *inm;
+  INSDS *ip;
+
+  for (i = 1; i <= csound->engineState.maxinsno; i++) {
+    INSTRTXT *tp = csound->engineState.instrtxtp[i];
+    if (tp == NULL) continue;
+    for (n = 0, ip = tp->act_instance; ip != NULL; ip = ip->nxtact) n++;
+    csound->inst_prewarm = want - n;
+    for ( ; n < want; n++) instance(csound, i);
+    tp->isNew = 0;
+  }
+  for (inm = csound->opcodeInfo; inm != NULL; inm = inm->prv) {
+    INSTRTXT *tp = csound->engineState.instrtxtp[inm->instno];
+    if (tp == NULL) continue;
+    for (n = 0, ip = tp->act_instance; ip != NULL; ip = ip->nxtact) n++;
+    csound->inst_prewarm = want - n;
+    for ( ; n < want; n++) instance(csound, inm->instno);
+    tp->isNew = 0;
+  }
+  csound->inst_prewarm = 0;
+}
+
+/* instruments that needed the system allocator to start a note */
+void instance_pool_report(CSOUND *csound)
+{
+  int i, hdr = 0;
+  for (i = 1; i <= csound->engineState.maxinsno; i++) {
+    INSTRTXT *tp = csound->engineState.instrtxtp[i];
+    INSTR_POOL *pool;
+    if (tp == NULL || (pool = tp->pool) == NULL || pool->slabs_perf == 0)
+      continue;
+    if (!hdr++)
+      csound->Message(csound, Str("instances allocated while performing "
+                                  "(--instance-prewarm=N avoids them):\n"));
+    if (tp->insname != NULL)
+      csound->Message(csound, Str("  instr %s: %d allocations, "
+                                  "%d instances at most\n"),
+                      tp->insname, pool->slabs_perf, pool->highwater);
+    else
+      csound->Message(csound, Str("  instr %d: %d allocations, "
+                                  "%d instances at most\n"),
+                      i, pool->slabs_perf, pool->highwater);
+  }
+}
+
+/* number of opcodes instance() links into the performance chain */
+static int perf_op_count(INSTRTXT *tp)
+{
+  OPTXT *optxt = (OPTXT*) tp;
+  int   n = 0;
+  while ((optxt = optxt->nxtop) != NULL) {
+    const OENTRY *ep = optxt->t.oentry;
+    if (UNLIKELY(strcmp(ep->opname, "endin") == 0 ||
+                 strcmp(ep->opname, "endop") == 0))
+      break;
+    if (strcmp(ep->opname, "pset") == 0 || strcmp(ep->opname, "$label") == 0)
+      continue;
+    if ((ep->thread & 03) == 0 ? optxt->t.pftype != 'b' : (ep->thread & 02))
+      n++;
+  }
+  return n;
+}
+
 /* create instance of an instr template */
 /*   allocates and sets up all pntrs    */
 
@@ -2310,10 +2524,11 @@ static void instance(CSOUND *csound, int insno)
 {
   INSTRTXT  *tp;
   INSDS     *ip;
+  INSDS_PRIV *priv;
   OPTXT     *optxt;
   OPDS      *opds, *prvids, *prvpds;
   const OENTRY  *ep;
-  int       i, n, pextent, pextra, pextrab;
+  int       i, n, pextent, pextra, pextrab, ndisp;
   char      *nxtopds, *opdslim;
   MYFLT     **argpp, *lclbas;
   CS_VAR_MEM *lcloffbas; // start of pfields
@@ -2324,8 +2539,11 @@ static void instance(CSOUND *csound, int insno)
   ARG*      arg;
   int       argStringCount;
   CS_VARIABLE* current;
+  int       mem_saved;
+  OPCOD_IOBUFS *buf = NULL;
 
   tp = csound->engineState.instrtxtp[insno];
+  mem_saved = csp_mem_enter(csound, csp_mem_owner_instr(csound, tp, insno));
   n = 3;
   if (O->midiKey>n) n = O->midiKey;
   if (O->midiKeyCps>n) n = O->midiKeyCps;
@@ -2337,13 +2555,14 @@ static void instance(CSOUND *csound, int insno)
   pextrab = ((i = tp->pmax - 3L) > 0 ? (int) i * sizeof(CS_VAR_MEM) : 0);
   /* alloc new space,  */
   pextent = sizeof(INSDS) + pextrab + pextra*sizeof(CS_VAR_MEM);
-  ip =
-    (INSDS*) csound->Calloc(csound,
-                            (size_t) pextent + tp->varPool->poolSize +
-                            (tp->varPool->varCount *
-                             CS_FLOAT_ALIGN(CS_VAR_TYPE_OFFSET)) +
-                            (tp->varPool->varCount * sizeof(CS_VARIABLE*)) +
-                            tp->opdstot);
+  ndisp = perf_op_count(tp);
+  ip = instance_block(csound, tp,
+                      (size_t) pextent + CS_VAR_ALIGN +
+                      tp->varPool->blockSize +
+                      (tp->varPool->varCount * sizeof(CS_VARIABLE*)) +
+                      tp->opdstot + sizeof(void*) +
+                      ndisp*sizeof(OPDISP));
+  priv = INSDS_PRIV(ip);
   ip->csound = csound;
   ip->m_chnbp = (MCHNBLK*) NULL;
   ip->instr = tp;
@@ -2369,17 +2588,29 @@ static void instance(CSOUND *csound, int insno)
     OPCODINFO* info = tp->opcode_info;
     size_t pcnt = sizeof(OPCOD_IOBUFS) +
       sizeof(MYFLT*) * (info->inchns + info->outchns);
-    ip->opcod_iobufs = (void*) csound->Malloc(csound, pcnt);
+    ip->opcod_iobufs = (void*) csound->Malloc(csound, pcnt +
+                                       info->byref_slots * sizeof(UDO_REF) +
+                                       info->inchns);
+    buf = (OPCOD_IOBUFS*) ip->opcod_iobufs;
+    buf->refs = (UDO_REF*) ((char*) buf + pcnt);
+    buf->refin = (char*) (buf->refs + info->byref_slots);
+    memset(buf->refin, 0, info->inchns);
+    buf->nrefs = buf->byref = 0;
+    if (info->byref_slots == 0) buf = NULL;
   }
 
   /* gbloffbas = csound->globalVarPool; */
   lcloffbas = (CS_VAR_MEM*)&ip->p0;
-  lclbas = (MYFLT*) ((char*) ip + pextent);   /* split local space */
+  /* split local space, aligned for the a-rate variables at its start */
+  lclbas = (MYFLT*) (((uintptr_t) ip + pextent + CS_VAR_ALIGN - 1) &
+                     ~((uintptr_t) CS_VAR_ALIGN - 1));
   initializeVarPool((void *)csound, lclbas, tp->varPool);
 
-  opMemStart = nxtopds = (char*) lclbas + tp->varPool->poolSize +
-    (tp->varPool->varCount * CS_FLOAT_ALIGN(CS_VAR_TYPE_OFFSET));
+  opMemStart = nxtopds = (char*) lclbas + tp->varPool->blockSize;
   opdslim = nxtopds + tp->opdstot;
+  /* filled in as the chain is linked */
+  priv->disp = (OPDISP*) (((uintptr_t) opdslim + sizeof(void*) - 1) &
+                         ~((uintptr_t) sizeof(void*) - 1));
   if (UNLIKELY(odebug))
     csound->Message(csound,
                     Str("instr %d allocated at %p\n\tlclbas %p, opds %p\n"),
@@ -2428,6 +2659,7 @@ static void instance(CSOUND *csound, int insno)
       else {
         prvpds = prvpds->nxtp = opds;
         opds->opadr = ep->kopadr;
+        priv->disp[priv->ndisp++].op = opds;
       }
       goto args;
     }
@@ -2439,6 +2671,7 @@ static void instance(CSOUND *csound, int insno)
     }
     if ((n = ep->thread & 02) != 0) {         /* thread 2     :   */
       prvpds = prvpds->nxtp = opds;           /* link into pchain */
+      priv->disp[priv->ndisp++].op = opds;
       /* if (!(n & 04) || */
       /*     ((ttp->pftype == 'k' || ttp->pftype == 'c') && ep->kopadr != NULL)) */
         opds->opadr = ep->kopadr;             /*      krate or    */
@@ -2502,6 +2735,14 @@ static void instance(CSOUND *csound, int insno)
       }
       else if (arg->type == ARG_LOCAL){
         argpp[n] = lclbas + var->memBlockIndex;
+        if (UNLIKELY(buf != NULL) && buf->nrefs < tp->opcode_info->byref_slots)
+          for (i = 0; i < tp->opcode_info->inchns; i++)
+            if (tp->opcode_info->byref[i] == var) {
+              buf->refs[buf->nrefs].slot = &argpp[n];
+              buf->refs[buf->nrefs].local = argpp[n];
+              buf->refs[buf->nrefs++].arg = i;
+              break;
+            }
       }
       else if (arg->type == ARG_LABEL) {
         argpp[n] = (MYFLT*)(opMemStart +
@@ -2531,9 +2772,11 @@ static void instance(CSOUND *csound, int insno)
     var->memBlock->value = csound->ekr;
   }
 
-  if (UNLIKELY(nxtopds > opdslim))
+  if (buf != NULL && buf->nrefs != tp->opcode_info->byref_slots)
+    buf->nrefs = 0;                     /* copy them all, as before */
+  if (UNLIKELY(nxtopds > opdslim || priv->ndisp != ndisp))
     csoundDie(csound, Str("inconsistent opds total"));
-
+  csp_mem_leave(csound, mem_saved);
 }
 
 int prealloc_(CSOUND *csound, AOP *p, int instname)
@@ -2554,8 +2797,10 @@ int prealloc_(CSOUND *csound, AOP *p, int instname)
     if (csound->oparms->realtime)
       csoundSpinLock(&csound->alloc_spinlock);
     a = (int) *p->a - csound->engineState.instrtxtp[n]->active;
+    csound->inst_prewarm = a;
     for ( ; a > 0; a--)
       instance(csound, n);
+    csound->inst_prewarm = 0;
     if (csound->oparms->realtime)
       csoundSpinUnLock(&csound->alloc_spinlock);
     return OK;
@@ -2604,12 +2849,12 @@ int delete_instr(CSOUND *csound, DELETEIN *p)
 #endif
     if (active->fdchp != NULL)
       fdchclose(csound, active);
-    if (active->auxchp != NULL)
+    if (active->auxchp != NULL || INSDS_PRIV(active)->auxarena != NULL)
       auxchfree(csound, active);
     free_instr_var_memory(csound, active);
-    csound->Free(csound, active);
     active = nxt;
   }
+  instance_pool_free(csound, ip);
   csound->engineState.instrtxtp[n] = NULL;
   /* Now patch it out */
   for (txtp = &(csound->engineState.instxtanchor);
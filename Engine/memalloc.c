@@ -23,6 +23,14 @@
 */
 
 #include "csoundCore.h"                 /*              MEMALLOC.C      */
+#include "memacct.h"
+#include "rtcheck.h"
+#if !defined(WIN32) && !defined(__EMSCRIPTEN__)
+#include <sys/mman.h>
+#include <unistd.h>
+#include <errno.h>
+#define MEM_HAVE_MLOCK
+#endif
 
 /* This code wraps malloc etc with maintaining a list of allocated memory
    so it can be freed on a reset.  It would not be necessary with a zoned
@@ -44,6 +52,8 @@ typedef struct memAllocBlock_s {
 #endif
     struct memAllocBlock_s  *prv;       /* previous structure in chain  */
     struct memAllocBlock_s  *nxt;       /* next structure in chain      */
+    size_t                  size;       /* bytes asked for              */
+    int                     owner;      /* accounting owner, or -1      */
 } memAllocBlock_t;
 
 #define HDR_SIZE    (((int) sizeof(memAllocBlock_t) + 7) & (~7))
@@ -60,10 +70,86 @@ static void memdie(CSOUND *csound, size_t nbytes)
     csound->LongJmp(csound, CSOUND_MEMORY);
 }
 
+/* Memory accounting (--mem-report).  While it is on every block records
+   the owner current when it was allocated (csound->mem_owner) and its
+   size is added to the owner and to the owner's kind; blocks allocated
+   while it was off have owner -1 and are not counted when freed.
+   Owners are made by csp_mem_owner and never move, so the counters can
+   be updated without a lock. */
+
+#define MEM_OWNER_CHUNK     256
+#define MEM_OWNER_MAXCHUNKS 128         /* ids fit an int16 */
+
+#if defined(MSVC)
+#define MEM_ADD64(x,v) (InterlockedExchangeAdd64((volatile LONG64*)&(x), v)+(v))
+#elif defined(HAVE_ATOMIC_BUILTIN)
+#define MEM_ADD64(x,v) __atomic_add_fetch(&(x), v, __ATOMIC_RELAXED)
+#else
+#define MEM_ADD64(x,v) ((x) += (v))
+#endif
+
+typedef struct {
+    volatile int64_t  current;
+    volatile int64_t  peak;
+} MEM_COUNT;
+
+typedef struct {
+    int               kind;             /* CS_MEM_* */
+    int               insno;
+    char              *instr;           /* NULL for a numbered instrument */
+    char              *opname;
+    MEM_COUNT         n;
+} MEM_OWNER;
+
+typedef struct cs_memacct_t {
+    MEM_OWNER         *chunks[MEM_OWNER_MAXCHUNKS];
+    volatile int      count;
+    int               on;
+    spin_lock_t       lock;
+    MEM_COUNT         kinds[CS_MEM_KINDS + 1];  /* last: everything */
+} CS_MEMACCT;
+
+#define MEM_OWNER_AT(a, n) (&(a)->chunks[(n)/MEM_OWNER_CHUNK] \
+                                        [(n)%MEM_OWNER_CHUNK])
+
+static inline void mem_count(MEM_COUNT *c, int64_t delta)
+{
+    int64_t cur = MEM_ADD64(c->current, delta);
+    if (cur > c->peak) c->peak = cur;   /* a racing update may win */
+}
+
+/* owner for a new block */
+static inline int mem_owner_now(CSOUND *csound)
+{
+    CS_MEMACCT *a = csound->memacct;
+    return (LIKELY(a == NULL) || !a->on) ? -1 : csound->mem_owner;
+}
+
+static inline void mem_account(CSOUND *csound, int owner, int64_t delta)
+{
+    CS_MEMACCT *a;
+    MEM_OWNER  *o;
+    if (LIKELY(owner < 0) || (a = csound->memacct) == NULL) return;
+    o = MEM_OWNER_AT(a, owner);
+    mem_count(&o->n, delta);
+    mem_count(&a->kinds[o->kind], delta);
+    mem_count(&a->kinds[CS_MEM_KINDS], delta);
+}
+
+static void mem_acct_free(CSOUND *csound);
+
+/* The arena backend needs atomic exchange and compare-and-swap */
+#if defined(CS_ARENA_ALLOC) && !defined(MSVC) && !defined(HAVE_ATOMIC_BUILTIN)
+#undef CS_ARENA_ALLOC
+#endif
+
+#ifndef CS_ARENA_ALLOC
+
 void *mmalloc(CSOUND *csound, size_t size)
 {
     void  *p;
 
+    CSP_RT_CHECK("malloc");
 #ifdef MEMDEBUG
     if (UNLIKELY(size == (size_t) 0)) {
       csound->DebugMsg(csound,
@@ -80,6 +166,9 @@ void *mmalloc(CSOUND *csound, size_t size)
     ((memAllocBlock_t*) p)->magic = MEMALLOC_MAGIC;
     ((memAllocBlock_t*) p)->ptr = DATA_PTR(p);
 #endif
+    ((memAllocBlock_t*) p)->size = size;
+    ((memAllocBlock_t*) p)->owner = mem_owner_now(csound);
+    mem_account(csound, ((memAllocBlock_t*) p)->owner, (int64_t) size);
     CSOUND_MEM_SPINLOCK
     ((memAllocBlock_t*) p)->prv = (memAllocBlock_t*) NULL;
     ((memAllocBlock_t*) p)->nxt = (memAllocBlock_t*) MEMALLOC_DB;
@@ -91,17 +180,11 @@ void *mmalloc(CSOUND *csound, size_t size)
     return DATA_PTR(p);
 }
 
-void *mmallocDebug(CSOUND *csound, size_t size, char *file, int line)
-{
-    void *ans = mmalloc(csound,size);
-    printf("Alloc %p (%zu) %s:%d\n", ans, size, file, line);
-    return ans;
-}
-
 void *mcalloc(CSOUND *csound, size_t size)
 {
     void  *p;
 
+    CSP_RT_CHECK("calloc");
 #ifdef MEMDEBUG
     if (UNLIKELY(size == (size_t) 0)) {
       csound->DebugMsg(csound,
@@ -118,6 +201,9 @@ void *mcalloc(CSOUND *csound, size_t size)
     ((memAllocBlock_t*) p)->magic = MEMALLOC_MAGIC;
     ((memAllocBlock_t*) p)->ptr = DATA_PTR(p);
 #endif
+    ((memAllocBlock_t*) p)->size = size;
+    ((memAllocBlock_t*) p)->owner = mem_owner_now(csound);
+    mem_account(csound, ((memAllocBlock_t*) p)->owner, (int64_t) size);
     CSOUND_MEM_SPINLOCK
     ((memAllocBlock_t*) p)->prv = (memAllocBlock_t*) NULL;
     ((memAllocBlock_t*) p)->nxt = (memAllocBlock_t*) MEMALLOC_DB;
@@ -129,13 +215,6 @@ void *mcalloc(CSOUND *csound, size_t size)
     return DATA_PTR(p);
 }
 
-void *mcallocDebug(CSOUND *csound, size_t size, char *file, int line)
-{
-    void *ans = mcalloc(csound,size);
-    printf("Alloc %p (%zu) %s:%d\n", ans, size, file, line);
-    return ans;
-}
-
 
 void mfree(CSOUND *csound, void *p)
 {
@@ -143,6 +222,7 @@ void mfree(CSOUND *csound, void *p)
 
     if (UNLIKELY(p == NULL))
       return;
+    CSP_RT_CHECK("free");
     pp = HDR_PTR(p);
  #ifdef MEMDEBUG
     if (UNLIKELY(pp->magic != MEMALLOC_MAGIC || pp->ptr != p)) {
@@ -157,6 +237,7 @@ void mfree(CSOUND *csound, void *p)
     }
     pp->magic = 0;
  #endif
+    mem_account(csound, pp->owner, -(int64_t) pp->size);
     CSOUND_MEM_SPINLOCK
     /* unlink from chain */
     {
@@ -174,17 +255,12 @@ void mfree(CSOUND *csound, void *p)
     CSOUND_MEM_SPINUNLOCK
 }
 
-void mfreeDebug(CSOUND *csound, void *ans, char *file, int line)
-{
-    printf("Free %p %s:%d\n", ans, file, line);
-    mfree(csound,ans);
-}
-
 void *mrealloc(CSOUND *csound, void *oldp, size_t size)
 {
     memAllocBlock_t *pp;
     void            *p;
 
+    CSP_RT_CHECK("realloc");
     if (UNLIKELY(oldp == NULL))
       return mmalloc(csound, size);
     if (UNLIKELY(size == (size_t) 0)) {
@@ -220,6 +296,8 @@ void *mrealloc(CSOUND *csound, void *oldp, size_t size)
     CSOUND_MEM_SPINLOCK
     /* create new header and update chain pointers */
     pp = (memAllocBlock_t*) p;
+    mem_account(csound, pp->owner, (int64_t) size - (int64_t) pp->size);
+    pp->size = size;
 #ifdef MEMDEBUG
     pp->magic = MEMALLOC_MAGIC;
     pp->ptr = DATA_PTR(pp);
@@ -238,17 +316,11 @@ void *mrealloc(CSOUND *csound, void *oldp, size_t size)
     return DATA_PTR(pp);
 }
 
-void *mreallocDebug(CSOUND *csound, void *oldp, size_t size, char *file, int line)
-{
-    void *p = mrealloc(csound, oldp, size);
-    printf("Realloc %p->%p (%zu) %s:%d\n", oldp, p, size, file, line);
-    return p;
-}
-
 void memRESET(CSOUND *csound)
 {
     memAllocBlock_t *pp, *nxtp;
 
+    mem_acct_free(csound);
     pp = (memAllocBlock_t*) MEMALLOC_DB;
     MEMALLOC_DB = NULL;
     while (pp != NULL) {
@@ -260,3 +332,608 @@ void memRESET(CSOUND *csound)
       pp = nxtp;
     }
 }
+
+#else   /* CS_ARENA_ALLOC */
+
+/* Per-thread arenas.  Each thread allocating for a Csound instance gets
+   an arena of its own, found through a thread-local cache, and cuts
+   blocks of 40 size classes up to MEM_MAXSMALL bytes from large chunks.
+   A block freed by its own thread goes on the arena's free list for its
+   class; one freed by another thread is pushed on the arena's remote
+   list with compare-and-swap, and the owner takes the whole list back
+   when a free list runs dry.  Nothing is linked per block, so memRESET
+   releases the chunks wholesale.  Larger blocks come from malloc and
+   are kept on a list under memlock as before.
+
+   The arena of a thread that exits is not freed: other threads may
+   still hold blocks cut from it.  It stays allocated, with its chunks,
+   until memRESET, so a host that keeps starting short-lived threads
+   that allocate should reset the instance now and then. */
+
+#if defined(MSVC)
+#define MEM_TLS __declspec(thread)
+#define MEM_XCHG(p, v)  InterlockedExchangePointer((PVOID volatile*)&(p), v)
+#define MEM_CAS(p, o, v) \
+  (InterlockedCompareExchangePointer((PVOID volatile*)&(p), v, o) == (o))
+#else
+#define MEM_TLS __thread
+#define MEM_XCHG(p, v)  __atomic_exchange_n(&(p), v, __ATOMIC_ACQUIRE)
+#define MEM_CAS(p, o, v) \
+  __atomic_compare_exchange_n(&(p), &(o), v, 1, __ATOMIC_RELEASE, \
+                              __ATOMIC_RELAXED)
+#endif
+
+#define MEM_CLASSES     40
+#define MEM_MAXSMALL    32768
+#define MEM_CHUNK       (256*1024)
+#define MEM_HDR         16      /* arena pointer, magic, owner, class */
+#define MEM_LARGE_HDR   (((int) sizeof(memAllocBlock_t) + 15 + MEM_HDR) & ~15)
+
+#define MEM_CLASS_OF(p) (((int16_t*) (p))[-1])
+#define MEM_OWNER_OF(p) (((int16_t*) (p))[-2])
+#define MEM_MAGIC_OF(p) (((int32_t*) (p))[-2])
+#define MEM_ARENA_OF(p) (*(memArena_t**) ((char*) (p) - MEM_HDR))
+#define MEM_LARGE_OF(p) ((memAllocBlock_t*) ((char*) (p) - MEM_LARGE_HDR))
+
+typedef struct memArena_s {
+    void                *free[MEM_CLASSES];     /* owner only */
+    void * volatile     remote;         /* freed by other threads */
+    char                *next, *end;    /* uncut part of the newest chunk */
+    void                *chunks;        /* linked through their first word */
+    const void          *owner;         /* thread token */
+    struct memArena_s   *nxt;
+} memArena_t;
+
+typedef struct memArenas_s {
+    memArena_t * volatile arenas;
+    unsigned int        gen;
+    memAllocBlock_t     *large;         /* under memlock */
+} memArenas_t;
+
+static volatile unsigned int mem_generation = 0;
+static MEM_TLS char mem_token;          /* its address names the thread */
+static MEM_TLS struct {
+    CSOUND              *csound;
+    unsigned int        gen;
+    memArena_t          *arena;
+} mem_cache;
+
+static inline int mem_class(size_t size)
+{
+    int e = 7;
+    if (size <= 128) return size == 0 ? 0 : (int) ((size+15) >> 4) - 1;
+    size--;
+    while ((size >> (e+1)) != 0) e++;
+    return 8 + (e-7)*4 + (int) ((size >> (e-2)) & 3);
+}
+
+static inline size_t mem_class_size(int c)
+{
+    if (c < 8) return (size_t) (c+1) << 4;
+    c -= 8;
+    return (size_t) (4 + (c&3) + 1) << (c/4 + 5);
+}
+
+static memArena_t *mem_arena(CSOUND *csound)
+{
+    memArenas_t *root = (memArenas_t*) MEMALLOC_DB;
+    memArena_t  *a;
+
+    if (LIKELY(root != NULL && mem_cache.csound == csound &&
+               mem_cache.gen == root->gen))
+      return mem_cache.arena;
+    if (root == NULL) {                 /* first allocation, or after reset */
+      memArenas_t *r = (memArenas_t*) calloc(1, sizeof(memArenas_t));
+      void *none = NULL;
+      if (UNLIKELY(r == NULL)) memdie(csound, sizeof(memArenas_t));
+#if defined(MSVC)
+      r->gen = (unsigned int) InterlockedIncrement((volatile LONG*)
+                                                  &mem_generation);
+#else
+      r->gen = __atomic_add_fetch(&mem_generation, 1, __ATOMIC_RELAXED);
+#endif
+      if (MEM_CAS(MEMALLOC_DB, none, (void*) r)) root = r;
+      else {
+        free(r);
+        root = (memArenas_t*) MEMALLOC_DB;
+      }
+    }
+    for (a = root->arenas; a != NULL; a = a->nxt)
+      if (a->owner == (const void*) &mem_token) break;
+    if (a == NULL) {
+      memArena_t *head;
+      if (UNLIKELY((a = (memArena_t*) calloc(1, sizeof(memArena_t))) == NULL))
+        memdie(csound, sizeof(memArena_t));
+      a->owner = (const void*) &mem_token;
+      do {
+        head = root->arenas;
+        a->nxt = head;
+      } while (!MEM_CAS(root->arenas, head, a));
+    }
+    mem_cache.csound = csound;
+    mem_cache.gen = root->gen;
+    mem_cache.arena = a;
+    return a;
+}
+
+static void *mem_large(CSOUND *csound, size_t size, int zero, int owner)
+{
+    memArenas_t *root;
+    memAllocBlock_t *p;
+    char *data;
+
+    p = (memAllocBlock_t*) (zero ? calloc(MEM_LARGE_HDR + size, 1)
+                                 : malloc(MEM_LARGE_HDR + size));
+    if (UNLIKELY(p == NULL)) memdie(csound, size);
+    mem_arena(csound);                  /* make sure there is a root */
+    root = (memArenas_t*) MEMALLOC_DB;
+    data = (char*) p + MEM_LARGE_HDR;
+    MEM_CLASS_OF(data) = -1;
+    MEM_MAGIC_OF(data) = MEMALLOC_MAGIC;
+    p->size = size;
+    p->owner = owner;
+    mem_account(csound, owner, (int64_t) size);
+    CSOUND_MEM_SPINLOCK
+    p->prv = NULL;
+    p->nxt = root->large;
+    if (root->large != NULL) root->large->prv = p;
+    root->large = p;
+    CSOUND_MEM_SPINUNLOCK
+    return data;
+}
+
+static void mem_large_unlink(CSOUND *csound, memAllocBlock_t *p)
+{
+    memAllocBlock_t *prv = p->prv, *nxt = p->nxt;
+    if (nxt != NULL) nxt->prv = prv;
+    if (prv != NULL) prv->nxt = nxt;
+    else ((memArenas_t*) MEMALLOC_DB)->large = nxt;
+}
+
+static void *mem_small(CSOUND *csound, size_t size, int zero, int owner)
+{
+    memArena_t *a = mem_arena(csound);
+    int         c = mem_class(size);
+    char        *p = a->free[c];
+
+    if (p == NULL && a->remote != NULL) {
+      /* take back what other threads have freed */
+      char *q = MEM_XCHG(a->remote, NULL);
+      while (q != NULL) {
+        char *nxt = *(char**) q;
+        int   qc = MEM_CLASS_OF(q);
+        *(void**) q = a->free[qc];
+        a->free[qc] = q;
+        q = nxt;
+      }
+      p = a->free[c];
+    }
+    if (p != NULL) {
+      a->free[c] = *(void**) p;
+      if (zero) memset(p, 0, mem_class_size(c));
+      else *(void**) p = NULL;
+    }
+    else {                              /* cut from the chunk, already zero */
+      size_t need = MEM_HDR + mem_class_size(c);
+      if (a->next == NULL || a->next + need > a->end) {
+        char *chunk = (char*) calloc(MEM_CHUNK, 1);
+        if (UNLIKELY(chunk == NULL)) memdie(csound, size);
+        *(void**) chunk = a->chunks;
+        a->chunks = chunk;
+        a->next = chunk + MEM_HDR;
+        a->end = chunk + MEM_CHUNK;
+      }
+      p = a->next + MEM_HDR;
+      a->next += need;
+      MEM_ARENA_OF(p) = a;
+      MEM_CLASS_OF(p) = c;
+    }
+    MEM_MAGIC_OF(p) = MEMALLOC_MAGIC;
+    MEM_OWNER_OF(p) = owner;
+    mem_account(csound, owner, (int64_t) mem_class_size(c));
+    return p;
+}
+
+void *mmalloc(CSOUND *csound, size_t size)
+{
+    CSP_RT_CHECK("malloc");
+#ifdef MEMDEBUG
+    if (UNLIKELY(size == (size_t) 0)) {
+      csound->DebugMsg(csound,
+              " *** internal error: mmalloc() called with zero nbytes\n");
+      return NULL;
+    }
+#endif
+    if (UNLIKELY(size > MEM_MAXSMALL))
+      return mem_large(csound, size, 0, mem_owner_now(csound));
+    return mem_small(csound, size, 0, mem_owner_now(csound));
+}
+
+void *mcalloc(CSOUND *csound, size_t size)
+{
+    CSP_RT_CHECK("calloc");
+#ifdef MEMDEBUG
+    if (UNLIKELY(size == (size_t) 0)) {
+      csound->DebugMsg(csound,
+              " *** internal error: csound->Calloc() called with zero nbytes\n");
+      return NULL;
+    }
+#endif
+    if (UNLIKELY(size > MEM_MAXSMALL))
+      return mem_large(csound, size, 1, mem_owner_now(csound));
+    return mem_small(csound, size, 1, mem_owner_now(csound));
+}
+
+void mfree(CSOUND *csound, void *p)
+{
+    memArena_t *a;
+
+    if (UNLIKELY(p == NULL))
+      return;
+    CSP_RT_CHECK("free");
+#ifdef MEMDEBUG
+    if (UNLIKELY(MEM_MAGIC_OF(p) != MEMALLOC_MAGIC)) {
+      csound->Warning(csound, "csound->Free() called with invalid "
+                      "pointer (%p) %x %x", p, MEM_MAGIC_OF(p), MEMALLOC_MAGIC);
+      return;
+    }
+#endif
+    MEM_MAGIC_OF(p) = 0;
+    if (UNLIKELY(MEM_CLASS_OF(p) < 0)) {
+      memAllocBlock_t *pp = MEM_LARGE_OF(p);
+      mem_account(csound, pp->owner, -(int64_t) pp->size);
+      CSOUND_MEM_SPINLOCK
+      mem_large_unlink(csound, pp);
+      CSOUND_MEM_SPINUNLOCK
+      free((void*) pp);
+      return;
+    }
+    mem_account(csound, MEM_OWNER_OF(p),
+                -(int64_t) mem_class_size(MEM_CLASS_OF(p)));
+    a = MEM_ARENA_OF(p);
+    if (a->owner == (const void*) &mem_token) {
+      *(void**) p = a->free[MEM_CLASS_OF(p)];
+      a->free[MEM_CLASS_OF(p)] = p;
+    }
+    else {
+      void *head;
+      do {
+        head = a->remote;
+        *(void**) p = head;
+      } while (!MEM_CAS(a->remote, head, p));
+    }
+}
+
+void *mrealloc(CSOUND *csound, void *oldp, size_t size)
+{
+    void   *p;
+    size_t  old;
+    int     owner;
+
+    CSP_RT_CHECK("realloc");
+    if (UNLIKELY(oldp == NULL))
+      return mmalloc(csound, size);
+    if (UNLIKELY(size == (size_t) 0)) {
+      mfree(csound, oldp);
+      return NULL;
+    }
+#ifdef MEMDEBUG
+    if (UNLIKELY(MEM_MAGIC_OF(oldp) != MEMALLOC_MAGIC)) {
+      csound->DebugMsg(csound, " *** internal error: mrealloc() called with "
+                       "invalid pointer (%p)\n", oldp);
+      exit(-1);
+    }
+#endif
+    if (MEM_CLASS_OF(oldp) >= 0) {
+      old = mem_class_size(MEM_CLASS_OF(oldp));
+      if (size <= old) return oldp;     /* still fits its class */
+      owner = MEM_OWNER_OF(oldp);
+    }
+    else if (size > MEM_MAXSMALL) {     /* large to large: realloc in place */
+      memAllocBlock_t *pp = MEM_LARGE_OF(oldp), *np;
+      mem_account(csound, pp->owner, (int64_t) size - (int64_t) pp->size);
+      CSOUND_MEM_SPINLOCK
+      np = (memAllocBlock_t*) realloc((void*) pp, MEM_LARGE_HDR + size);
+      if (UNLIKELY(np == NULL)) {
+        CSOUND_MEM_SPINUNLOCK
+        memdie(csound, size);
+        return NULL;
+      }
+      np->size = size;
+      if (np->nxt != NULL) np->nxt->prv = np;
+      if (np->prv != NULL) np->prv->nxt = np;
+      else ((memArenas_t*) MEMALLOC_DB)->large = np;
+      CSOUND_MEM_SPINUNLOCK
+      return (char*) np + MEM_LARGE_HDR;
+    }
+    else {
+      /* large block has no class to read its size from, but the new
+         size is small so at most that much is copied */
+      old = size;
+      owner = MEM_LARGE_OF(oldp)->owner;
+    }
+    /* the new block keeps the owner of the old one */
+    p = size > MEM_MAXSMALL ? mem_large(csound, size, 0, owner)
+                            : mem_small(csound, size, 0, owner);
+    memcpy(p, oldp, old < size ? old : size);
+    mfree(csound, oldp);
+    return p;
+}
+
+void memRESET(CSOUND *csound)
+{
+    memArenas_t *root = (memArenas_t*) MEMALLOC_DB;
+    memArena_t  *a, *nxta;
+    memAllocBlock_t *pp, *nxtp;
+
+    mem_acct_free(csound);
+    if (root == NULL) return;
+    MEMALLOC_DB = NULL;
+    for (a = root->arenas; a != NULL; a = nxta) {
+      void *c = a->chunks;
+      nxta = a->nxt;
+      while (c != NULL) {
+        void *nxtc = *(void**) c;
+        free(c);
+        c = nxtc;
+      }
+      free(a);
+    }
+    for (pp = root->large; pp != NULL; pp = nxtp) {
+      nxtp = pp->nxt;
+      free((void*) pp);
+    }
+    free(root);
+}
+
+#endif  /* CS_ARENA_ALLOC */
+
+void *mmallocDebug(CSOUND *csound, size_t size, char *file, int line)
+{
+    void *ans = mmalloc(csound,size);
+    printf("Alloc %p (%zu) %s:%d\n", ans, size, file, line);
+    return ans;
+}
+
+void *mcallocDebug(CSOUND *csound, size_t size, char *file, int line)
+{
+    void *ans = mcalloc(csound,size);
+    printf("Alloc %p (%zu) %s:%d\n", ans, size, file, line);
+    return ans;
+}
+
+void mfreeDebug(CSOUND *csound, void *ans, char *file, int line)
+{
+    printf("Free %p %s:%d\n", ans, file, line);
+    mfree(csound,ans);
+}
+
+void *mreallocDebug(CSOUND *csound, void *oldp, size_t size, char *file, int line)
+{
+    void *p = mrealloc(csound, oldp, size);
+    printf("Realloc %p->%p (%zu) %s:%d\n", oldp, p, size, file, line);
+    return p;
+}
+
+/* Memory accounting: owners, API and report */
+
+static const char *mem_kind_names[CS_MEM_KINDS] = {
+    "other", "instruments", "opcodes", "ftables", "channels", "strings"
+};
+
+static MEM_OWNER *mem_owner_new(CS_MEMACCT *a)
+{
+    int n = a->count;
+    if (n == MEM_OWNER_CHUNK*MEM_OWNER_MAXCHUNKS) return NULL;
+    if (n % MEM_OWNER_CHUNK == 0 &&
+        (a->chunks[n/MEM_OWNER_CHUNK] =
+         (MEM_OWNER*) calloc(MEM_OWNER_CHUNK, sizeof(MEM_OWNER))) == NULL)
+      return NULL;
+    return MEM_OWNER_AT(a, n);
+}
+
+/* the owner for kind, and insno and opname if the kind has them; the
+   table is kept with malloc so that it is not counted itself */
+int csp_mem_owner(CSOUND *csound, int kind, int insno, const char *opname)
+{
+    CS_MEMACCT *a = csound->memacct;
+    char  *instr = NULL;
+    int   i, n;
+
+    if (a == NULL) return -1;
+    if (kind != CS_MEM_INSTRUMENT && kind != CS_MEM_OPCODE)
+      return kind;                      /* the first owners are the kinds */
+    if (opname == NULL || kind == CS_MEM_INSTRUMENT) opname = "";
+    if (insno <= csound->engineState.maxinsno &&
+        csound->engineState.instrtxtp[insno] != NULL)
+      instr = csound->engineState.instrtxtp[insno]->insname;
+    csoundSpinLock(&a->lock);
+    n = a->count;
+    for (i = CS_MEM_KINDS; i < n; i++) {  /* once per statement, so search */
+      MEM_OWNER *o = MEM_OWNER_AT(a, i);
+      if (o->kind == kind && o->insno == insno && !strcmp(o->opname, opname))
+        break;
+    }
+    if (i == n) {
+      MEM_OWNER *o = mem_owner_new(a);
+      if (o == NULL) i = CS_MEM_OTHER;
+      else {
+        o->kind = kind;
+        o->insno = insno;
+        o->opname = strdup(opname);
+        o->instr = instr != NULL ? strdup(instr) : NULL;
+        ATOMIC_SET(a->count, n+1);
+      }
+    }
+    csoundSpinUnLock(&a->lock);
+    return i;
+}
+
+static void mem_acct_free(CSOUND *csound)
+{
+    CS_MEMACCT *a = csound->memacct;
+    int i;
+    if (a == NULL) return;
+    csound->memacct = NULL;
+    for (i = 0; i < a->count; i++) {
+      free(MEM_OWNER_AT(a, i)->opname);
+      free(MEM_OWNER_AT(a, i)->instr);
+    }
+    for (i = 0; i < MEM_OWNER_MAXCHUNKS && a->chunks[i] != NULL; i++)
+      free(a->chunks[i]);
+    free(a);
+}
+
+PUBLIC void csoundSetMemoryAccounting(CSOUND *csound, int on)
+{
+    CS_MEMACCT *a = csound->memacct;
+    int i;
+    if (a == NULL) {
+      if (!on) return;
+      if ((a = (CS_MEMACCT*) calloc(1, sizeof(CS_MEMACCT))) == NULL) return;
+      csoundSpinLockInit(&a->lock);
+      for (i = 0; i < CS_MEM_KINDS; i++) {
+        MEM_OWNER *o = mem_owner_new(a);
+        o->kind = i;
+        o->opname = strdup("");
+        a->count = i+1;
+      }
+      csound->mem_owner = CS_MEM_OTHER;
+      csound->memacct = a;
+    }
+    a->on = on;
+}
+
+PUBLIC int csoundGetMemoryTotal(CSOUND *csound, int kind,
+                                int64_t *current, int64_t *peak)
+{
+    CS_MEMACCT *a = csound->memacct;
+    if (a == NULL || kind < 0 || kind > CS_MEM_KINDS) return CSOUND_ERROR;
+    if (current != NULL) *current = a->kinds[kind].current;
+    if (peak != NULL) *peak = a->kinds[kind].peak;
+    return CSOUND_SUCCESS;
+}
+
+static int mem_usage_cmp(const void *a, const void *b)
+{
+    int64_t pa = ((const CS_MEMORY_USAGE*) a)->peak;
+    int64_t pb = ((const CS_MEMORY_USAGE*) b)->peak;
+    return pa < pb ? 1 : (pa > pb ? -1 : 0);
+}
+
+PUBLIC int csoundGetMemoryUsage(CSOUND *csound, CS_MEMORY_USAGE **lst)
+{
+    CS_MEMACCT *a = csound->memacct;
+    int i, j, n;
+
+    *lst = NULL;
+    if (a == NULL || (n = ATOMIC_GET(a->count)) == 0) return 0;
+    *lst = csound->Malloc(csound, n*sizeof(CS_MEMORY_USAGE));
+    for (i = j = 0; i < n; i++) {
+      MEM_OWNER *o = MEM_OWNER_AT(a, i);
+      if (o->n.peak == 0) continue;
+      (*lst)[j].kind = o->kind;
+      (*lst)[j].instr = o->instr;
+      (*lst)[j].insno = o->insno;
+      (*lst)[j].opname = o->opname[0] != '\0' ? o->opname : NULL;
+      (*lst)[j].current = o->n.current;
+      (*lst)[j].peak = o->n.peak;
+      j++;
+    }
+    qsort(*lst, j, sizeof(CS_MEMORY_USAGE), mem_usage_cmp);
+    return j;
+}
+
+PUBLIC void csoundDeleteMemoryUsage(CSOUND *csound, CS_MEMORY_USAGE *lst)
+{
+    csound->Free(csound, lst);
+}
+
+void csp_mem_report(CSOUND *csound)
+{
+    CS_MEMACCT *a = csound->memacct;
+    CS_MEMORY_USAGE *lst;
+    int i, n;
+
+    if (a == NULL) return;
+    csound->Message(csound, Str("memory use (kbytes, current and peak):\n"));
+    for (i = 0; i <= CS_MEM_KINDS; i++) {
+      if (i < CS_MEM_KINDS && a->kinds[i].peak == 0) continue;
+      csound->Message(csound, "  %-20s %12.1f %12.1f\n",
+                      i < CS_MEM_KINDS ? Str(mem_kind_names[i]) : Str("total"),
+                      a->kinds[i].current/1024.0, a->kinds[i].peak/1024.0);
+    }
+    n = csoundGetMemoryUsage(csound, &lst);
+    if (n <= 0) return;
+    csound->Message(csound, "  %-12s %-16s %-20s %12s %12s\n",
+                    Str("owner"), Str("instr"), Str("opcode"),
+                    Str("current"), Str("peak"));
+    for (i = 0; i < n && i < 40; i++) {
+      char num[32] = "";
+      if (lst[i].instr == NULL && (lst[i].kind == CS_MEM_INSTRUMENT ||
+                                   lst[i].kind == CS_MEM_OPCODE))
+        snprintf(num, 32, "%d", lst[i].insno);
+      csound->Message(csound, "  %-12s %-16s %-20s %12.1f %12.1f\n",
+                      Str(mem_kind_names[lst[i].kind]),
+                      lst[i].instr ? lst[i].instr : num,
+                      lst[i].opname ? lst[i].opname : "",
+                      lst[i].current/1024.0, lst[i].peak/1024.0);
+    }
+    if (n > 40)
+      csound->Message(csound, Str("  ... %d more\n"), n-40);
+    csoundDeleteMemoryUsage(csound, lst);
+}
+
+/* Real-time memory (--rt-memory).  mem_rt_start locks the process in
+   memory when that is permitted; either way the ftables, instance slabs
+   and AuxAlloc blocks are touched a page at a time as they are
+   allocated, so that the first k-cycle using them takes no faults. */
+
+#define MEM_HUGE_PAGE   ((uintptr_t) 2*1024*1024)
+
+void mem_rt_start(CSOUND *csound)
+{
+#ifdef MEM_HAVE_MLOCK
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+      csound->Warning(csound, Str("--rt-memory: could not lock memory (%s), "
+                                  "pre-faulting only"), strerror(errno));
+    else if (csound->oparms->msglevel & TIMEMSG)
+      csound->Message(csound, Str("--rt-memory: memory locked\n"));
+#else
+    csound->Warning(csound, Str("--rt-memory: memory cannot be locked on "
+                                "this platform, pre-faulting only"));
+#endif
+}
+
+/* fault in the pages of a block just allocated; huge asks for
+   transparent huge pages for the aligned part of a large block */
+void mem_prefault(CSOUND *csound, void *p, size_t n, int huge)
+{
+    static size_t page = 0;
+    char  *q = (char*) p, *end = (char*) p + n;
+
+    (void) csound;
+    if (UNLIKELY(p == NULL || n == 0)) return;
+    if (UNLIKELY(page == 0)) {
+#ifdef MEM_HAVE_MLOCK
+      long ps = sysconf(_SC_PAGESIZE);
+      page = ps > 0 ? (size_t) ps : 4096;
+#else
+      page = 4096;
+#endif
+    }
+#if defined(MEM_HAVE_MLOCK) && defined(MADV_HUGEPAGE)
+    if (huge && n >= 2*MEM_HUGE_PAGE) {
+      uintptr_t a = ((uintptr_t) p + MEM_HUGE_PAGE - 1) & ~(MEM_HUGE_PAGE - 1);
+      uintptr_t b = (uintptr_t) end & ~(MEM_HUGE_PAGE - 1);
+      if (b > a) madvise((void*) a, (size_t) (b - a), MADV_HUGEPAGE);
+    }
+#else
+    (void) huge;
+#endif
+    /* a write, as a read would only map the shared zero page */
+    while (q < end) {
+      *(volatile char*) q = *(volatile char*) q;
+      q = (char*) (((uintptr_t) q + page) & ~((uintptr_t) page - 1));
+    }
+}
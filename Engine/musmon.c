@@ -514,6 +514,38 @@ PUBLIC int csoundCleanup(CSOUND *csound)
       csound->Message(csound, Str("\n%d errors in performance\n"),
                       csound->perferrcnt);
       print_benchmark_info(csound, Str("end of performance"));
+      if (csound->oparms->rtMemory) {
+        void csp_fault_report(CSOUND *);
+        csp_fault_report(csound);
+      }
+      if (csound->oparms->numThreads > 1 &&
+          (csound->oparms->msglevel & TIMEMSG)) {
+        void csp_barrier_report(CSOUND *, void *, const char *);
+        void dag_report_stats(CSOUND *);
+        csp_barrier_report(csound, csound->barrier1, "barrier 1");
+        csp_barrier_report(csound, csound->barrier2, "barrier 2");
+        dag_report_stats(csound);
+      }
+      if (csound->oparms->numThreads > 1 && csound->oparms->dagReport) {
+        void dag_report_critical(CSOUND *);
+        dag_report_critical(csound);
+      }
+      if (csound->profile != NULL) {
+        void csp_profile_report(CSOUND *);
+        csp_profile_report(csound);
+      }
+      if (csound->oparms->msglevel & TIMEMSG) {
+        void instance_pool_report(CSOUND *);
+        instance_pool_report(csound);
+      }
+      if (csound->oparms->memReport) {
+        void csp_mem_report(CSOUND *);
+        csp_mem_report(csound);
+      }
+      if (csound->rtcheck != NULL) {
+        void csp_rt_report(CSOUND *);
+        csp_rt_report(csound);
+      }
     }
     /* close line input (-L) */
     RTclose(csound);
@@ -33,6 +33,12 @@ typedef struct {
     MYFLT   *r, *a;
 } ASSIGN;
 
+typedef struct {                /* ga += x */
+    OPDS    h;
+    MYFLT   *r, *a;
+    DAG_ACCUM *acc;             /* per-thread copies under -j */
+} ADDIN;
+
 #define ASSIGNM_MAX (24)
 typedef struct {
     OPDS    h;
@@ -88,6 +94,52 @@ typedef struct {
     MYFLT   *r, *a, *b, *def;
 } DIVZ;
 
+/* ##fuse: a tree of a-rate arithmetic compiled by fuse_list
+   (csound_orc_optimize.c) into a postfix program.  An operand is 'a' or
+   'k' followed by '0' + the index of the argument after the program;
+   'k' operands are taken once per call.  The operators are + - * / and
+   the unary FUSE_ABS etc.  The program runs over blocks of FUSE_BLOCK
+   samples so intermediate results stay in the opcode's stack frame. */
+#define FUSE_MAXARG     24
+#define FUSE_STACK      8
+#define FUSE_BLOCK      32
+#define FUSE_MAXCODE    96      /* characters of a program */
+#define FUSE_MAXINS     64
+
+#define FUSE_ABS        'A'
+#define FUSE_EXP        'E'
+#define FUSE_LOG        'L'
+#define FUSE_SQRT       'Q'
+#define FUSE_SIN        'S'
+#define FUSE_COS        'C'
+#define FUSE_TANH       'T'
+
+/* decoded operations: a binary one is FUSE_ADD etc. + 0 for audio and
+   audio, 1 audio and scalar, 2 scalar and audio, 3 two scalars; a unary
+   one FUSE_UN + 2*function, + 1 on a scalar */
+enum {
+    FUSE_END, FUSE_NOP,
+    FUSE_BIN = 4,
+    FUSE_ADD = FUSE_BIN, FUSE_SUB = FUSE_BIN+4, FUSE_MUL = FUSE_BIN+8,
+    FUSE_DIV = FUSE_BIN+12,
+    FUSE_UN = FUSE_BIN+16
+};
+
+typedef struct {
+    unsigned char op;
+    char    c;                  /* the program character, 0 for FUSE_NOP */
+    char    push;               /* 'a' or 'k' to push arg first, or 0 */
+    unsigned char arg;
+} FUSE_INS;
+
+typedef struct {
+    OPDS    h;
+    MYFLT   *r;
+    STRINGDAT *prog;
+    MYFLT   *arg[FUSE_MAXARG];
+    FUSE_INS ins[FUSE_MAXINS];
+} FUSE;
+
 typedef struct {
     OPDS    h;
     MYFLT   *r, *a;
@@ -61,8 +61,12 @@ typedef struct channelEntry_s {
     controlChannelHints_t hints;
     MYFLT   *data;
     spin_lock_t  lock;               /* Multi-thread protection */
+    volatile uint32_t seq;           /* audio, string: odd while written */
+    volatile int32_t host_locked;    /* its lock was handed to the host */
     int32_t     type;
     int32_t     datasize;  /* size of allocated chn data */
+    volatile int32_t changed;        /* on the changed list (bus.c) */
+    struct channelEntry_s *changed_nxt;
     char    name[1];
 } CHNENTRY;
 
@@ -74,13 +78,202 @@ typedef struct {
     spin_lock_t  *lock;
     int32_t      pos;
     char     chname[MAX_CHAN_NAME+1];
+    DAG_ACCUM   *acc;           /* chnmix: per-thread copies under -j */
+    CHNENTRY    *chn;           /* k-rate chnget/chnset: the channel */
+    int32_t      fixed;         /* its name is a constant */
 } CHNGET;
 
+#ifdef USE_DOUBLE
+#  define MYFLT_INT_TYPE int64_t
+#else
+#  define MYFLT_INT_TYPE int32_t
+#endif
+
+/* the value of a control channel is read and written whole, without
+   the channel lock where the platform has atomic loads and stores */
+static inline MYFLT chn_load_control(MYFLT *fp, spin_lock_t *lock)
+{
+    union {
+      MYFLT d;
+      MYFLT_INT_TYPE i;
+    } x;
+    IGN(lock);
+#if defined(MSVC)
+    x.i = InterlockedExchangeAdd64((MYFLT_INT_TYPE *) fp, 0);
+#elif defined(HAVE_ATOMIC_BUILTIN)
+    x.i = __atomic_load_n((MYFLT_INT_TYPE *) fp, __ATOMIC_ACQUIRE);
+#else
+    csoundSpinLock(lock);
+    x.d = *fp;
+    csoundSpinUnLock(lock);
+#endif
+    return x.d;
+}
+
+static inline void chn_store_control(MYFLT *fp, spin_lock_t *lock, MYFLT val)
+{
+    union {
+      MYFLT d;
+      MYFLT_INT_TYPE i;
+    } x;
+    x.d = val;
+    IGN(lock);
+#if defined(MSVC)
+    InterlockedExchange64((MYFLT_INT_TYPE *) fp, x.i);
+#elif defined(HAVE_ATOMIC_BUILTIN)
+    __atomic_store_n((MYFLT_INT_TYPE *) fp, x.i, __ATOMIC_RELEASE);
+#else
+    csoundSpinLock(lock);
+    *fp = x.d;
+    csoundSpinUnLock(lock);
+#endif
+}
+
+/* Audio and string channels are guarded by a sequence lock.  Writers
+   still exclude each other with the channel lock, and keep seq odd
+   while they write.  Readers take no lock: they copy the data, and copy
+   it again if seq was odd or has changed meanwhile, so a host reading
+   meters never holds up a performance thread.  Without atomic
+   operations readers take the channel lock instead.
+
+   A host given the lock by csoundGetChannelLock() writes through the
+   channel pointer under it without touching seq, and may replace the
+   buffer of a string channel.  From then on readers of that channel
+   take the lock as well: chn_read_begin() returns an odd value to say
+   that it holds it.  A reader that started before the switch sees
+   host_locked set when it checks, and reads again under the lock.
+
+     do {
+       s = chn_read_begin(chn);
+       ... copy from chn->data ...
+     } while (chn_read_retry(chn, s));
+*/
+static inline void chn_write_begin(CHNENTRY *chn)
+{
+    csoundSpinLock(&chn->lock);
+#if defined(HAVE_ATOMIC_BUILTIN)
+    __atomic_store_n(&chn->seq, chn->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+#elif defined(MSVC)
+    InterlockedIncrement((volatile LONG *) &chn->seq);
+#endif
+}
+
+static inline void chn_write_end(CHNENTRY *chn)
+{
+#if defined(HAVE_ATOMIC_BUILTIN)
+    __atomic_store_n(&chn->seq, chn->seq + 1, __ATOMIC_RELEASE);
+#elif defined(MSVC)
+    InterlockedIncrement((volatile LONG *) &chn->seq);
+#endif
+    csoundSpinUnLock(&chn->lock);
+}
+
+static inline uint32_t chn_read_begin(CHNENTRY *chn)
+{
+#if defined(HAVE_ATOMIC_BUILTIN)
+    uint32_t s;
+    if (UNLIKELY(__atomic_load_n(&chn->host_locked, __ATOMIC_ACQUIRE))) {
+      csoundSpinLock(&chn->lock);
+      return 1;
+    }
+    while ((s = __atomic_load_n(&chn->seq, __ATOMIC_ACQUIRE)) & 1)
+      ;
+    return s;
+#elif defined(MSVC)
+    uint32_t s;
+    if (UNLIKELY(InterlockedCompareExchange((volatile LONG *)
+                                            &chn->host_locked, 0, 0))) {
+      csoundSpinLock(&chn->lock);
+      return 1;
+    }
+    while ((s = (uint32_t)
+            InterlockedCompareExchange((volatile LONG *) &chn->seq, 0, 0)) & 1)
+      ;
+    return s;
+#else
+    csoundSpinLock(&chn->lock);
+    return 0;
+#endif
+}
+
+static inline int chn_read_retry(CHNENTRY *chn, uint32_t s)
+{
+#if defined(HAVE_ATOMIC_BUILTIN)
+    if (UNLIKELY(s & 1)) {
+      csoundSpinUnLock(&chn->lock);
+      return 0;
+    }
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&chn->seq, __ATOMIC_RELAXED) != s ||
+      __atomic_load_n(&chn->host_locked, __ATOMIC_RELAXED);
+#elif defined(MSVC)
+    if (UNLIKELY(s & 1)) {
+      csoundSpinUnLock(&chn->lock);
+      return 0;
+    }
+    return (uint32_t)
+      InterlockedCompareExchange((volatile LONG *) &chn->seq, 0, 0) != s ||
+      InterlockedCompareExchange((volatile LONG *) &chn->host_locked, 0, 0);
+#else
+    IGN(s);
+    csoundSpinUnLock(&chn->lock);
+    return 0;
+#endif
+}
+
+/* A writer growing a string channel publishes the new buffer before
+   its size, and a reader loads the size before the buffer, so it never
+   copies more than the buffer it found holds. */
+static inline int32_t chn_string_size(STRINGDAT *sd)
+{
+#if defined(HAVE_ATOMIC_BUILTIN)
+    return __atomic_load_n(&sd->size, __ATOMIC_ACQUIRE);
+#elif defined(MSVC)
+    int32_t n = *(volatile int32_t *) &sd->size;
+    MemoryBarrier();
+    return n;
+#else
+    return sd->size;
+#endif
+}
+
+static inline char *chn_string_data(STRINGDAT *sd)
+{
+#if defined(HAVE_ATOMIC_BUILTIN)
+    return __atomic_load_n(&sd->data, __ATOMIC_ACQUIRE);
+#else
+    return *(char *volatile *) &sd->data;
+#endif
+}
+
+static inline void chn_string_publish(STRINGDAT *sd, char *data, int32_t size)
+{
+#if defined(HAVE_ATOMIC_BUILTIN)
+    __atomic_store_n(&sd->data, data, __ATOMIC_RELEASE);
+    __atomic_store_n(&sd->size, size, __ATOMIC_RELEASE);
+#else
+#if defined(MSVC)
+    MemoryBarrier();
+#endif
+    *(char *volatile *) &sd->data = data;
+#if defined(MSVC)
+    MemoryBarrier();
+#endif
+    *(volatile int32_t *) &sd->size = size;
+#endif
+}
+
+/* string channels (bus.c): set copies s into the channel, get copies
+   the channel into dst, growing it as needed */
+int32_t chn_string_set(CSOUND *csound, CHNENTRY *chn, const char *s);
+void chn_string_get(CSOUND *csound, CHNENTRY *chn, STRINGDAT *dst);
+
 typedef struct {
     OPDS    h;
     STRINGDAT   *iname[MAX_CHAN_NAME+1];
     MYFLT   *fp[MAX_CHAN_NAME+1];
-    spin_lock_t *lock[MAX_CHAN_NAME+1];
+    CHNENTRY *chn[MAX_CHAN_NAME+1];
 } CHNCLEAR;
 
 typedef struct {
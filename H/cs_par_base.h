@@ -83,6 +83,80 @@
 /* return thread index of caller */
 int csp_thread_index_get(CSOUND *csound);
 
+/* pause hint for busy-wait loops */
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#include <xmmintrin.h>
+#define CSP_RELAX() _mm_pause()
+#else
+#define CSP_RELAX()
+#endif
+
+/*
+ * barrier for the performance threads
+ *
+ * an arriving thread spins for up to spin iterations waiting for the
+ * last arrival, then parks on its own condition variable until the
+ * generation changes, so a wake-up meant for a slow thread can never be
+ * taken by another.  The number of threads taking part can be lowered
+ * below the number allocated for between rounds.  Waits are only timed
+ * when the statistics are printed (-m with TIMEMSG).
+ */
+typedef struct csp_barrier_t {
+    volatile int          count;          /* arrivals this generation */
+    volatile unsigned int generation;
+    int                   max;            /* threads taking part */
+    int                   size;           /* threads allocated for */
+    int                   spin;
+    void                  **mutexes;      /* one per thread */
+    void                  **conds;
+    volatile int          *parked;
+    int                   stats;          /* time the waits */
+    /* statistics */
+    volatile int64_t      waits;
+    volatile int64_t      parks;
+    volatile int64_t      wait_ns;        /* total time spent waiting */
+    volatile int64_t      max_ns;         /* longest single wait */
+} CSP_BARRIER;
+
+void csp_barrier_alloc(CSOUND *csound, void **barrier, int thread_count);
+void csp_barrier_dealloc(CSOUND *csound, void **barrier);
+int  csp_barrier_wait(CSOUND *csound, void *barrier, int index);
+void csp_barrier_set_count(void *barrier, int thread_count);
+void csp_barrier_report(CSOUND *csound, void *barrier, const char *name);
+
+/* real time in seconds from an arbitrary origin (csound.c); unlike an
+   RTCLOCK it does not read the CPU time, so it is cheap enough to call
+   around every task */
+double csoundRealTimeSeconds(void);
+
+/* thread placement from --thread-cpus, --thread-numa and --thread-sched;
+   init is called once before any performance thread starts, then each
+   thread places itself (index -1 for helper threads) */
+void csp_thread_placement_init(CSOUND *csound);
+void csp_thread_place(CSOUND *csound, int index, const char *name);
+
+/* accumulate-only buffers (cs_new_dispatch.c).  name is the global the
+   semantic analysis knows the buffer by ("##chn:name" for a channel),
+   and ip the instance that will mix into it (NULL for spout).  find
+   returns NULL when running single-threaded, or when the instrument of
+   ip also reads or sets the global; the caller then mixes into target
+   under its usual lock */
+DAG_ACCUM *dag_accum_find(CSOUND *csound, INSDS *ip, MYFLT *target,
+                          int size, const char *name);
+void dag_accum_flush(CSOUND *csound, DAG_ACCUM *a);
+void dag_accum_flush_all(CSOUND *csound);
+
+/* where thread should mix into a; the main thread uses target itself */
+static inline MYFLT *dag_accum_buffer(DAG_ACCUM *a, int thread)
+{
+    if (thread == 0) return a->target;
+    if (!a->dirty[thread]) {
+      a->dirty[thread] = 1;
+      a->pending = 1;
+    }
+    return a->scratch + thread*a->stride;
+}
+
 /* structure headers */
 #define HDR_LEN                 4
 //#define INSTR_WEIGHT_INFO_HDR   "IWI"
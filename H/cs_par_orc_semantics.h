@@ -39,6 +39,33 @@
  *          called to fetch an instrument later
  */
 
+/* the read, write and read_write sets of an instrument as bitsets over
+   global ids, for the DAG; built whole, then published in one store */
+typedef struct csp_bitsets_t {
+    int                         nwords;
+    int                         nglobals;   /* globals numbered when built */
+    uint64_t                    *read;
+    uint64_t                    *write;
+    uint64_t                    *read_write;
+} CSP_BITSETS;
+
+/* the compiler thread stores a new CSP_BITSETS with release and the
+   performance thread loads it with acquire, so a reader sees the arrays
+   and nwords that belong together */
+#if defined(HAVE_ATOMIC_BUILTIN)
+#define CSP_BITSETS_GET(p)      __atomic_load_n(&(p)->bits, __ATOMIC_ACQUIRE)
+#define CSP_BITSETS_SET(p, b)   __atomic_store_n(&(p)->bits, b, __ATOMIC_RELEASE)
+#elif defined(MSVC)
+#define CSP_BITSETS_GET(p) \
+    ((CSP_BITSETS*) InterlockedCompareExchangePointer( \
+                      (PVOID volatile *) &(p)->bits, NULL, NULL))
+#define CSP_BITSETS_SET(p, b) \
+    InterlockedExchangePointer((PVOID volatile *) &(p)->bits, b)
+#else
+#define CSP_BITSETS_GET(p)      ((p)->bits)
+#define CSP_BITSETS_SET(p, b)   ((p)->bits = (b))
+#endif
+
 /* maintain information about insturments defined */
 typedef struct instr_semantics_t {
     char                        hdr[HDR_LEN];
@@ -48,11 +75,14 @@ typedef struct instr_semantics_t {
     struct set_t                *read;
     struct set_t                *write;
     struct set_t                *read_write;
+    CSP_BITSETS                 *bits;      /* NULL until first built */
     uint32_t                    weight;
     struct instr_semantics_t    *next;
 } INSTR_SEMANTICS;
 
 void csp_orc_sa_cleanup(CSOUND *csound);
+/* number the globals seen so far and (re)build every instrument's bitsets */
+void csp_orc_sa_bitsets_update(CSOUND *csound);
 void csp_orc_sa_print_list(CSOUND *csound);
 
 /* maintain state about the current instrument we are parsing */
@@ -84,9 +114,13 @@ struct instr_semantics_t
 struct instr_semantics_t
     *csp_orc_sa_instr_get_by_num(CSOUND *csound, int16 insno);
 
-/* interlocks */
-void csp_orc_sa_interlocks(CSOUND *, ORCTOKEN *);
-void csp_orc_sa_interlocksf(CSOUND *, int);
+/* interlocks: the side effects an opcode declares in its OENTRY flags.
+ * args are its inputs, from which constant table numbers and channel
+ * names are taken; calls nested in them are looked at as well */
+void csp_orc_sa_interlocks(CSOUND *, ORCTOKEN *, TREE *);
+void csp_orc_sa_interlocksf(CSOUND *, int, TREE *);
+/* the same for every opcode called as a function within node */
+void csp_orc_sa_interlocks_tree(CSOUND *, TREE *);
 
 void csp_orc_analyze_tree(CSOUND *, TREE*);
 
@@ -86,9 +86,11 @@ int32_t modak(CSOUND *, void *);
 int32_t addaa(CSOUND *, void *), subaa(CSOUND *, void *);
 int32_t mulaa(CSOUND *, void *), divaa(CSOUND *, void *);
 int32_t modaa(CSOUND *, void *);
+int32_t fuse_init(CSOUND *, void *), fuse_perf(CSOUND *, void *);
 int32_t addin(CSOUND *, void *), addina(CSOUND *, void *);
 int32_t subin(CSOUND *, void *), subina(CSOUND *, void *);
 int32_t addinak(CSOUND *, void *), subinak(CSOUND *, void *);
+int32_t addin_set(CSOUND *, void *);
 int32_t divzkk(CSOUND *, void *), divzka(CSOUND *, void *);
 int32_t divzak(CSOUND *, void *), divzaa(CSOUND *, void *);
 int32_t int1(CSOUND *, void *), int1a(CSOUND *, void *);
@@ -57,10 +57,21 @@ typedef struct {
 /* the number of optional outputs defined in entry.c */
 #define SUBINSTNUMOUTS  8
 
+/* an argument of an opcode in a UDO body reading an input in place */
+typedef struct {
+    MYFLT   **slot;
+    MYFLT   *local;             /* the UDO's own copy of the input */
+    int     arg;                /* input number */
+} UDO_REF;
+
 typedef struct {
     OPCODINFO *opcode_info;
     void    *uopcode_struct;
     INSDS   *parent_ip;
+    UDO_REF *refs;
+    int     nrefs;
+    int     byref;              /* some refs point at the caller's arguments */
+    char    *refin;             /* per input, 1: read in place, not copied */
     MYFLT   *iobufp_ptrs[12];  /* expandable IV - Oct 26 2002 */ /* was 8 */
 } OPCOD_IOBUFS;
 
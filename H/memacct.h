@@ -0,0 +1,76 @@
+/*
+    memacct.h:
+
+    Copyright (C) 2026 agent
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+#ifndef CSOUND_MEMACCT_H
+#define CSOUND_MEMACCT_H
+
+/* Memory accounting (--mem-report).  New blocks are charged to
+   csound->mem_owner, which code allocating for an instrument, an opcode
+   or a subsystem sets around its allocations:
+
+       int saved = csp_mem_enter(csound, CS_MEM_FTABLES);
+       ...
+       csp_mem_leave(csound, saved);
+
+   The owner is shared by all threads, so an allocation made on a
+   performance thread while another thread has set an owner is charged
+   to that owner.  With accounting off these cost a load and a store. */
+
+int  csp_mem_owner(CSOUND *csound, int kind, int insno, const char *opname);
+void csp_mem_report(CSOUND *csound);
+
+static inline int csp_mem_enter(CSOUND *csound, int owner)
+{
+    int saved = csound->mem_owner;
+    if (UNLIKELY(csound->memacct != NULL) && owner >= 0)
+      csound->mem_owner = owner;
+    return saved;
+}
+
+static inline void csp_mem_leave(CSOUND *csound, int saved)
+{
+    csound->mem_owner = saved;
+}
+
+/* owner of the instances of tp, cached in it */
+static inline int csp_mem_owner_instr(CSOUND *csound, INSTRTXT *tp, int insno)
+{
+    if (LIKELY(csound->memacct == NULL)) return -1;
+    if (tp->memowner == 0)
+      tp->memowner = csp_mem_owner(csound, CS_MEM_INSTRUMENT, insno, NULL)+1;
+    return tp->memowner - 1;
+}
+
+/* owner of the AuxAlloc space of the statement of op */
+static inline int csp_mem_owner_opcode(CSOUND *csound, OPDS *op)
+{
+    OPTXT *t;
+    if (LIKELY(csound->memacct == NULL)) return -1;
+    t = op->optext;
+    if (t->memowner == 0)
+      t->memowner = csp_mem_owner(csound, CS_MEM_OPCODE, op->insdshead->insno,
+                                  t->t.opcod != NULL ? t->t.opcod : "?") + 1;
+    return t->memowner - 1;
+}
+
+#endif
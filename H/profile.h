@@ -0,0 +1,125 @@
+/*
+    profile.h:
+
+    Copyright (C) 2026 agent
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+#ifndef CSOUND_PROFILE_H
+#define CSOUND_PROFILE_H
+
+/* Opcode profiling (--profile).  kperf decides once per k-cycle whether
+   the cycle is timed, and the performance loops then call opcodes
+   through csp_profile_opcode instead of opadr, so with profiling off
+   each opcode call costs one test of a local flag. */
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#elif defined(_M_IX86) || defined(_M_X64)
+#include <intrin.h>
+#endif
+
+double csoundRealTimeSeconds(void);
+
+/* cheap cycle counter; the unit is calibrated against the real time
+   clock when the profile is read */
+static inline uint64_t csp_cycles(void)
+{
+#if defined(__i386__) || defined(__x86_64__) || \
+    defined(_M_IX86) || defined(_M_X64)
+    return (uint64_t) __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t t;
+    __asm__ __volatile__ ("mrs %0, cntvct_el0" : "=r" (t));
+    return t;
+#else
+    return (uint64_t) (csoundRealTimeSeconds() * 1.0e9);
+#endif
+}
+
+void csp_profile_start(CSOUND *csound);
+
+/* whether this k-cycle is timed, 1 in oparms->profileInterval */
+static inline int csp_profile_cycle(CSOUND *csound)
+{
+    int interval = csound->oparms->profileInterval;
+    if (LIKELY(interval <= 0)) return (csound->prof_cycle = 0);
+    if (--csound->prof_countdown > 0) return (csound->prof_cycle = 0);
+    csound->prof_countdown = interval;
+    if (UNLIKELY(csound->profile == NULL)) csp_profile_start(csound);
+    return (csound->prof_cycle = 1);
+}
+
+/* K-cycle timing, always on.  The perform loops mark the start of a
+   k-cycle before sensevents and the end of each phase, and the cycle is
+   added to the histograms after spoutran.  The performing thread is
+   the only writer; readers take the counts as they find them. */
+#define KTIME_BUCKETS   256     /* 8 per octave of ns, up to 8.6 s */
+
+typedef struct cs_ktiming_t {
+    volatile uint64_t hist[CS_KCYCLE_PHASES][KTIME_BUCKETS];
+    volatile uint64_t sum_ns[CS_KCYCLE_PHASES];
+    volatile uint64_t max_ns[CS_KCYCLE_PHASES];
+    volatile uint64_t cycles;
+    volatile uint64_t misses;
+    /* page faults, counted with --rt-memory */
+    volatile uint64_t minflt, majflt;
+    volatile uint64_t fault_cycles;     /* k-cycles that took any */
+    volatile uint64_t max_faults;       /* most in one k-cycle */
+    long              ru_minflt, ru_majflt; /* last getrusage, -1: none */
+    volatile int      reset;            /* set by a reader, done by writer */
+    double            t0;               /* cycle start, 0 between cycles */
+    double            t_sense, t_chain; /* ends of the first two phases */
+} CS_KTIMING;
+
+static inline void csp_ktime_begin(CSOUND *csound)
+{
+    CS_KTIMING *k = csound->ktiming;
+    /* kperf returning 1 sends the loop round sensevents again */
+    if (k->t0 == 0.0) k->t0 = csoundRealTimeSeconds();
+}
+
+static inline void csp_ktime_sensed(CSOUND *csound)
+{
+    csound->ktiming->t_sense = csoundRealTimeSeconds();
+}
+
+static inline void csp_ktime_chained(CSOUND *csound)
+{
+    csound->ktiming->t_chain = csoundRealTimeSeconds();
+}
+
+/* drop the cycle begun, as when the debugger stops in it */
+static inline void csp_ktime_skip(CSOUND *csound)
+{
+    csound->ktiming->t0 = 0.0;
+}
+
+/* after spoutran: add the cycle to the histograms */
+void csp_ktime_end(CSOUND *csound);
+void csp_ktime_alloc(CSOUND *csound);
+/* page faults while performing, with the end-of-performance times */
+void csp_fault_report(CSOUND *csound);
+
+/* run one opcode, adding its time to the profile entry of its line */
+int  csp_profile_opcode(CSOUND *csound, OPDS *p);
+/* print the profile, most expensive first (csoundCleanup) */
+void csp_profile_report(CSOUND *csound);
+
+#endif
@@ -31,6 +31,8 @@ extern "C" {
 
 void    cscore_(CSOUND *);
 void    *mmalloc(CSOUND *, size_t);
+void    mem_rt_start(CSOUND *);
+void    mem_prefault(CSOUND *, void *, size_t, int);
 void    *mcalloc(CSOUND *, size_t);
 void    *mrealloc(CSOUND *, void *, size_t);
 void    mfree(CSOUND *, void *);
@@ -43,6 +45,7 @@ char    *cs_strndup(CSOUND*, char*, size_t);
 void    csoundAuxAlloc(CSOUND *, size_t, AUXCH *), auxchfree(CSOUND *, INSDS *);
 int     csoundAuxAllocAsync(CSOUND *, size_t , AUXCH *,
                             AUXASYNC *, aux_cb , void *);
+void    aux_pool_free(CSOUND *, INSTRTXT *);
 void    fdrecord(CSOUND *, FDCH *), fdclose(CSOUND *, FDCH *);
 void    fdchclose(CSOUND *, INSDS *);
 CS_PRINTF2  void    synterr(CSOUND *, const char *, ...);
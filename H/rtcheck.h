@@ -0,0 +1,65 @@
+/*
+    rtcheck.h:
+
+    Copyright (C) 2026 agent
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+#ifndef CSOUND_RTCHECK_H
+#define CSOUND_RTCHECK_H
+
+/* Real-time safety checker, built with -DUSE_RT_CHECK=ON (CS_RT_CHECK).
+   The performance loops mark the thread with the instance whose
+   opcodes it is running, in kperf and in the nodePerf workers alike,
+   and the calls that may block or allocate check the mark:
+   csound->Malloc and friends, csoundLockMutex, csoundFileOpenWithType
+   and the message functions.  Each distinct violation is logged once
+   with its opcode and instrument, and all of them are counted and
+   listed at the end of the performance.  In a normal build the macros
+   are empty. */
+
+#ifdef CS_RT_CHECK
+
+#if defined(MSVC)
+#define CSP_RT_TLS __declspec(thread)
+#else
+#define CSP_RT_TLS __thread
+#endif
+
+/* the instance being performed by this thread, NULL outside */
+extern CSP_RT_TLS INSDS *csp_rt_insds;
+void csp_rt_violation(const char *what);
+
+#define CSP_RT_ENTER(ip)  (csp_rt_insds = (ip))
+#define CSP_RT_LEAVE()    (csp_rt_insds = NULL)
+#define CSP_RT_CHECK(what) \
+  do { if (UNLIKELY(csp_rt_insds != NULL)) csp_rt_violation(what); } while (0)
+
+#else
+
+#define CSP_RT_ENTER(ip)
+#define CSP_RT_LEAVE()
+#define CSP_RT_CHECK(what)
+
+#endif
+
+/* list the violations seen and free them (csoundCleanup) */
+void csp_rt_report(CSOUND *csound);
+
+#endif
@@ -22,6 +22,7 @@
 
 #include "csoundCore.h" /*                                      AOPS.C  */
 #include "aops.h"
+#include "cs_par_base.h"
 #include <math.h>
 #include <time.h>
 
@@ -505,6 +506,174 @@ int32_t modaa(CSOUND *csound, AOP *p)
     return OK;
 }
 
+/* ##fuse: decode the program once, knowing which stack slots hold audio
+   blocks and which scalars, so each operation runs one plain loop.  An
+   operand is pushed by the operation that follows it where it can be. */
+int32_t fuse_init(CSOUND *csound, FUSE *p)
+{
+    static const char binops[] = "+-*/", unops[] = {
+      FUSE_ABS, FUSE_EXP, FUSE_LOG, FUSE_SQRT, FUSE_SIN, FUSE_COS, FUSE_TANH,
+      '\0' };
+    const char *c = p->prog->data, *f;
+    char    audio[FUSE_STACK];
+    int32_t nargs = (int32_t) p->INOCOUNT - 1, sp = -1, n = 0;
+    FUSE_INS *ins = p->ins, *in;
+
+    for (; *c != '\0'; c++) {
+      if (*c == 'a' || *c == 'k') {
+        if (UNLIKELY(n >= FUSE_MAXINS - 1 || c[1] < '0' ||
+                     c[1] - '0' >= nargs || ++sp >= FUSE_STACK))
+          goto bad;
+        audio[sp] = (*c == 'a');
+        in = &ins[n++];
+        in->op = FUSE_NOP;
+        in->c = '\0';
+        in->push = *c;
+        in->arg = *++c - '0';
+        continue;
+      }
+      if (n > 0 && ins[n-1].op == FUSE_NOP)
+        in = &ins[n-1];
+      else {
+        if (UNLIKELY(n >= FUSE_MAXINS - 1)) goto bad;
+        in = &ins[n++];
+        in->push = '\0';
+        in->arg = 0;
+      }
+      in->c = *c;
+      if ((f = strchr(binops, *c)) != NULL) {
+        if (UNLIKELY(sp < 1)) goto bad;
+        in->op = FUSE_BIN + 4*(f - binops) +
+          (audio[sp-1] ? (audio[sp] ? 0 : 1) : (audio[sp] ? 2 : 3));
+        audio[sp-1] |= audio[sp];
+        sp--;
+      }
+      else if ((f = strchr(unops, *c)) != NULL) {
+        if (UNLIKELY(sp < 0)) goto bad;
+        in->op = FUSE_UN + 2*(f - unops) + (audio[sp] ? 0 : 1);
+      }
+      else goto bad;
+    }
+    if (UNLIKELY(sp != 0 || n == 0 || ins[n-1].op == FUSE_NOP || !audio[0]))
+      goto bad;
+    ins[n].op = FUSE_END;
+    return OK;
+ bad:
+    return csound->InitError(csound, Str("##fuse: bad program"));
+}
+
+#define FUSE_BINOPS(N,OP,CHECK)                                 \
+    case N:                                                     \
+      d = ins[1].op == FUSE_END ? r + n : buf[sp-1];            \
+      x = v[sp-1]; y = v[sp];                                   \
+      for (j = 0; j < len; j++) d[j] = x[j] OP y[j];            \
+      v[--sp] = d;                                              \
+      break;                                                    \
+    case N+1:                                                   \
+      d = ins[1].op == FUSE_END ? r + n : buf[sp-1];            \
+      x = v[sp-1]; b = s[sp];                                   \
+      CHECK;                                                    \
+      for (j = 0; j < len; j++) d[j] = x[j] OP b;               \
+      v[--sp] = d;                                              \
+      break;                                                    \
+    case N+2:                                                   \
+      d = ins[1].op == FUSE_END ? r + n : buf[sp-1];            \
+      a = s[sp-1]; y = v[sp];                                   \
+      for (j = 0; j < len; j++) d[j] = a OP y[j];               \
+      v[--sp] = d;                                              \
+      break;                                                    \
+    case N+3:                                                   \
+      sp--;                                                     \
+      s[sp] = s[sp] OP s[sp+1];                                 \
+      break;
+
+#define FUSE_UNOPS(N,LIBNAME)                                   \
+    case N:                                                     \
+      d = ins[1].op == FUSE_END ? r + n : buf[sp];              \
+      x = v[sp];                                                \
+      for (j = 0; j < len; j++) d[j] = LIBNAME(x[j]);           \
+      v[sp] = d;                                                \
+      break;                                                    \
+    case N+1:                                                   \
+      s[sp] = LIBNAME(s[sp]);                                   \
+      break;
+
+/* as divak, warn of a k-rate divisor of zero once a call */
+#define FUSE_DIVCHECK                                           \
+    if (UNLIKELY(b == FL(0.0) && n == offset))                  \
+      csound->Warning(csound, Str("Division by zero"))
+
+/* Each operation is that of the AOP or function it replaces, so the
+   result is the same as from the separate opcodes.  An audio operand is
+   read in place and intermediate blocks stay in buf.  A single sample,
+   as with ksmps = 1, is evaluated on scalars alone. */
+int32_t fuse_perf(CSOUND *csound, FUSE *p)
+{
+    MYFLT    buf[FUSE_STACK][FUSE_BLOCK];
+    MYFLT    *v[FUSE_STACK];
+    MYFLT    s[FUSE_STACK];
+    MYFLT    *r = p->r, *d, *x, *y, a, b;
+    uint32_t offset = p->h.insdshead->ksmps_offset;
+    uint32_t early  = p->h.insdshead->ksmps_no_end;
+    uint32_t n, j, len, nsmps = CS_KSMPS;
+    const FUSE_INS *ins;
+    int      sp;
+
+    if (UNLIKELY(offset)) memset(r, '\0', offset*sizeof(MYFLT));
+    if (UNLIKELY(early)) {
+      nsmps -= early;
+      memset(&r[nsmps], '\0', early*sizeof(MYFLT));
+    }
+    if (nsmps - offset == 1) {
+      n = offset;
+      for (ins = p->ins, sp = -1; ins->op != FUSE_END; ins++) {
+        if (ins->push == 'a') s[++sp] = p->arg[ins->arg][n];
+        else if (ins->push == 'k') s[++sp] = *p->arg[ins->arg];
+        switch (ins->c) {
+        case '\0': break;
+        case '+': sp--; s[sp] = s[sp] + s[sp+1]; break;
+        case '-': sp--; s[sp] = s[sp] - s[sp+1]; break;
+        case '*': sp--; s[sp] = s[sp] * s[sp+1]; break;
+        case '/':
+          if (UNLIKELY(ins->op == FUSE_DIV + 1 && s[sp] == FL(0.0)))
+            csound->Warning(csound, Str("Division by zero"));
+          sp--; s[sp] = s[sp] / s[sp+1];
+          break;
+        case FUSE_ABS:  s[sp] = FABS(s[sp]); break;
+        case FUSE_EXP:  s[sp] = EXP(s[sp]); break;
+        case FUSE_LOG:  s[sp] = LOG(s[sp]); break;
+        case FUSE_SQRT: s[sp] = SQRT(s[sp]); break;
+        case FUSE_SIN:  s[sp] = SIN(s[sp]); break;
+        case FUSE_COS:  s[sp] = COS(s[sp]); break;
+        default:        s[sp] = TANH(s[sp]); break;
+        }
+      }
+      r[n] = s[0];
+      return OK;
+    }
+    for (n = offset; n < nsmps; n += len) {
+      len = nsmps - n < FUSE_BLOCK ? nsmps - n : FUSE_BLOCK;
+      for (ins = p->ins, sp = -1; ins->op != FUSE_END; ins++) {
+        if (ins->push == 'a') v[++sp] = p->arg[ins->arg] + n;
+        else if (ins->push == 'k') s[++sp] = *p->arg[ins->arg];
+        switch (ins->op) {
+        FUSE_BINOPS(FUSE_ADD, +, )
+        FUSE_BINOPS(FUSE_SUB, -, )
+        FUSE_BINOPS(FUSE_MUL, *, )
+        FUSE_BINOPS(FUSE_DIV, /, FUSE_DIVCHECK)
+        FUSE_UNOPS(FUSE_UN,    FABS)
+        FUSE_UNOPS(FUSE_UN+2,  EXP)
+        FUSE_UNOPS(FUSE_UN+4,  LOG)
+        FUSE_UNOPS(FUSE_UN+6,  SQRT)
+        FUSE_UNOPS(FUSE_UN+8,  SIN)
+        FUSE_UNOPS(FUSE_UN+10, COS)
+        FUSE_UNOPS(FUSE_UN+12, TANH)
+        }
+      }
+    }
+    return OK;
+}
+
 int32_t divzkk(CSOUND *csound, DIVZ *p)
 {
     IGN(csound);
@@ -1759,6 +1928,9 @@ int32_t inall_opcode(CSOUND *csound, INALL *p)
     return OK;
 }
 
+/* Under -j each thread mixes into its own copy of spout (see nodePerf),
+   so the output opcodes need no lock */
+
 int32_t outs1(CSOUND *csound, OUTM *p)
 {
     MYFLT       *sp=  CS_SPOUT /*csound->spraw*/, *ap1= p->asig;
@@ -1766,7 +1938,6 @@ int32_t outs1(CSOUND *csound, OUTM *p)
     uint32_t nsmps =CS_KSMPS,  n;
     uint32_t early  = nsmps-p->h.insdshead->ksmps_no_end;
 
-    CSOUND_SPOUT_SPINLOCK
     if (!csound->spoutactive) {
       if (offset) memset(sp, '\0', offset*sizeof(MYFLT));
       memcpy(&sp[offset], &ap1[offset], (early-offset)*sizeof(MYFLT));
@@ -1783,7 +1954,6 @@ int32_t outs1(CSOUND *csound, OUTM *p)
         if (n>=offset) sp[n]   += ap1[n];
       }
     }
-    CSOUND_SPOUT_SPINUNLOCK
     return OK;
 }
 
@@ -1803,7 +1973,6 @@ int32_t outs2(CSOUND *csound, OUTM *p)
     uint32_t nsmps =CS_KSMPS,  n;
     uint32_t early  = nsmps-p->h.insdshead->ksmps_no_end;
 
-    CSOUND_SPOUT_SPINLOCK
     if (!csound->spoutactive) {
       memset(sp, '\0', nsmps*sizeof(MYFLT));
       sp +=nsmps;
@@ -1820,7 +1989,6 @@ int32_t outs2(CSOUND *csound, OUTM *p)
         sp[n] += ap2[n];
       }
     }
-    CSOUND_SPOUT_SPINUNLOCK
     return OK;
 }
 
@@ -1830,7 +1998,6 @@ int32_t outq3(CSOUND *csound, OUTM *p)
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t nsmps =CS_KSMPS,  n;
     uint32_t early  = nsmps-p->h.insdshead->ksmps_no_end;
-    CSOUND_SPOUT_SPINLOCK
     if (!csound->spoutactive) {
        memset(sp, '\0', 2*nsmps*sizeof(MYFLT));
       sp += 2*nsmps;
@@ -1847,7 +2014,6 @@ int32_t outq3(CSOUND *csound, OUTM *p)
         sp[n]   += ap3[n];
       }
     }
-    CSOUND_SPOUT_SPINUNLOCK
     return OK;
 }
 
@@ -1857,7 +2023,6 @@ int32_t outq4(CSOUND *csound, OUTM *p)
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t nsmps =CS_KSMPS,  n;
     uint32_t early  = nsmps-p->h.insdshead->ksmps_no_end;
-    CSOUND_SPOUT_SPINLOCK
     if (!csound->spoutactive) {
       memset(sp, '\0', 3*nsmps*sizeof(MYFLT));
       sp += 3*nsmps;
@@ -1874,7 +2039,6 @@ int32_t outq4(CSOUND *csound, OUTM *p)
         sp[n]   += ap4[n];
       }
     }
-    CSOUND_SPOUT_SPINUNLOCK
     return OK;
 }
 
@@ -1886,7 +2050,6 @@ inline static int32_t outn(CSOUND *csound, uint32_t n, OUTX *p)
     uint32_t early  = p->h.insdshead->ksmps_no_end;
     //    if (UNLIKELY((offset|early))) {
     early = nsmps - early;
-    CSOUND_SPOUT_SPINLOCK
 
     if (!csound->spoutactive) {
       memset(spout, '\0', csound->nspout*sizeof(MYFLT));
@@ -1904,7 +2067,6 @@ inline static int32_t outn(CSOUND *csound, uint32_t n, OUTX *p)
         k += nsmps;
       }
     }
-    CSOUND_SPOUT_SPINUNLOCK
         //    }
     /* else { */
     /*   CSOUND_SPOUT_SPINLOCK */
@@ -1974,7 +2136,6 @@ int32_t outarr(CSOUND *csound, OUTARRAY *p)
       uint32_t offset = p->h.insdshead->ksmps_offset;
       uint32_t early  = nsmps-p->h.insdshead->ksmps_no_end;
 
-      CSOUND_SPOUT_SPINLOCK
       if (!csound->spoutactive) {
         memset(spout, '\0', csound->nspout*sizeof(MYFLT));
         for (i=0; i<n; i++) {
@@ -1992,10 +2153,8 @@ int32_t outarr(CSOUND *csound, OUTARRAY *p)
           }
         }
       }
-      CSOUND_SPOUT_SPINUNLOCK
     }
     else {
-      CSOUND_SPOUT_SPINLOCK
       if (!csound->spoutactive) {
         memcpy(spout, data, n*ksmps*sizeof(MYFLT));
         if (csound->nchnls>n)
@@ -2007,7 +2166,6 @@ int32_t outarr(CSOUND *csound, OUTARRAY *p)
           spout[i] += data[i];
         }
       }
-      CSOUND_SPOUT_SPINUNLOCK
     }
     return OK;
 }
@@ -2023,7 +2181,6 @@ int32_t outch(CSOUND *csound, OUTCH *p)
     MYFLT       **args = p->args;
     uint32_t    nchnls = csound->nchnls;
     MYFLT *spout = CS_SPOUT;
-    CSOUND_SPOUT_SPINLOCK
     for (j = 0; j < count; j += 2) {
       ch = MYFLT2LRND(*args[j]);
       if (ch < 1) ch = 1;
@@ -2042,12 +2199,18 @@ int32_t outch(CSOUND *csound, OUTCH *p)
         }
       }
     }
-    CSOUND_SPOUT_SPINUNLOCK
     return OK;
 }
 
 /* For parallel mixin template */
-int32_t addina(CSOUND *csound, ASSIGN *p)
+int32_t addin_set(CSOUND *csound, ADDIN *p)
+{
+    p->acc = dag_accum_find(csound, p->h.insdshead, p->r, csound->ksmps,
+                            csound->GetOutputArgName(p, 0));
+    return OK;
+}
+
+int32_t addina(CSOUND *csound, ADDIN *p)
 {
     MYFLT* val = p->a;
     MYFLT* ans = p->r;
@@ -2055,6 +2218,12 @@ int32_t addina(CSOUND *csound, ASSIGN *p)
     uint32_t    nsmps = CS_KSMPS, n;
     uint32_t    early = nsmps-p->h.insdshead->ksmps_no_end;
 
+    if (p->acc != NULL) {       /* this thread's copy; no lock */
+      ans = dag_accum_buffer(p->acc, INSDS_PRIV(p->h.insdshead)->dag_thread);
+      for (n=offset; n<early; n++)
+        ans[n] += val[n];
+      return OK;
+    }
     CSOUND_SPOUT_SPINLOCK
     for (n=offset; n<early; n++)
       ans[n] += val[n];
@@ -2062,7 +2231,7 @@ int32_t addina(CSOUND *csound, ASSIGN *p)
     return OK;
 }
 
-int32_t addinak(CSOUND *csound, ASSIGN *p)
+int32_t addinak(CSOUND *csound, ADDIN *p)
 {
     MYFLT val;
     MYFLT* ans = p->r;
@@ -2070,6 +2239,13 @@ int32_t addinak(CSOUND *csound, ASSIGN *p)
     uint32_t    nsmps = CS_KSMPS, n;
     uint32_t    early = nsmps-p->h.insdshead->ksmps_no_end;
 
+    if (p->acc != NULL) {
+      ans = dag_accum_buffer(p->acc, INSDS_PRIV(p->h.insdshead)->dag_thread);
+      val = *p->a;
+      for (n=offset; n<early; n++)
+        ans[n] += val;
+      return OK;
+    }
     CSOUND_SPOUT_SPINLOCK
     val = *p->a;
     for (n=offset; n<early; n++)
@@ -2187,6 +2363,9 @@ int32_t monitor_opcode_perf(CSOUND *csound, MONITOR_OPCODE *p)
     uint32_t i, j, nsmps = CS_KSMPS, nchnls = csound->GetNchnls(csound);
     MYFLT *spout = csound->spraw;
 
+    /* bring in what the other threads have output so far; the DAG
+       keeps every output opcode off the other threads meanwhile */
+    if (csound->dag_spout != NULL) dag_accum_flush(csound, csound->dag_spout);
     if (csound->spoutactive) {
       for (j = 0; j<nchnls; j++) {
         for (i = 0; i<nsmps; i++) {
@@ -2232,7 +2411,7 @@ int32_t outRange(CSOUND *csound, OUTRANGE *p)
     //int32_t nchnls = csound->GetNchnls(csound);
     MYFLT *ara[VARGMAX];
     int32_t startChan = (int32_t) *p->kstartChan -1;
-    MYFLT *sp = csound->spraw + startChan*nsmps;
+    MYFLT *sp = CS_SPOUT + startChan*nsmps;
     int32_t narg = p->narg;
 
     if (UNLIKELY(startChan < 0))
@@ -2244,7 +2423,7 @@ int32_t outRange(CSOUND *csound, OUTRANGE *p)
       ara[j] = p->argums[j];
 
     if (!csound->spoutactive) {
-      memset(csound->spraw, '\0', csound->nspout * sizeof(MYFLT));
+      memset(CS_SPOUT, '\0', csound->nspout * sizeof(MYFLT));
       /* no need to offset ?? why ?? */
       int32_t i;
       for (i=0; i < narg; i++) {
@@ -34,6 +34,8 @@
 
 #include "bus.h"
 #include "namedins.h"
+#include "cs_par_base.h"
+#include "memacct.h"
 
 /* For sensing opcodes */
 #if defined(__unix) || defined(__unix__) || defined(__MACH__)
@@ -64,12 +66,6 @@
 #  endif
 #endif
 
-#ifdef USE_DOUBLE
-#  define MYFLT_INT_TYPE int64_t
-#else
-#  define MYFLT_INT_TYPE int32_t
-#endif
-
 
 
 int32_t chani_opcode_perf_k(CSOUND *csound, CHNVAL *p)
@@ -333,6 +329,7 @@ static int32_t delete_channel_db(CSOUND *csound, void *p)
 
     cs_hash_table_mfree_complete(csound, csound->chn_db);
     csound->chn_db = NULL;
+    csound->chn_changed = NULL;
     return 0;
 }
 
@@ -392,41 +389,48 @@ static CS_NOINLINE int32_t create_new_channel(CSOUND *csound, const char *name,
                                           int32_t type)
 {
     CHNENTRY      *pp;
+    int           mem_saved;
     /* check for valid parameters and calculate hash value */
     if (UNLIKELY(!(type & 48)))
       return CSOUND_ERROR;
+    mem_saved = csp_mem_enter(csound, CS_MEM_CHANNELS);
 
     /* create new empty database if not allocated */
     if (csound->chn_db == NULL) {
       csound->chn_db = cs_hash_table_create(csound);
       if (UNLIKELY(csound->RegisterResetCallback(csound, NULL,
-                                                 delete_channel_db) != 0))
-          return CSOUND_MEMORY;
-      if (UNLIKELY(csound->chn_db == NULL))
+                                                 delete_channel_db) != 0) ||
+          UNLIKELY(csound->chn_db == NULL)) {
+        csp_mem_leave(csound, mem_saved);
         return CSOUND_MEMORY;
+      }
     }
     /* allocate new entry */
     pp = alloc_channel(csound, name, type);
-    if (UNLIKELY(pp == NULL))
+    if (UNLIKELY(pp == NULL)) {
+      csp_mem_leave(csound, mem_saved);
       return CSOUND_MEMORY;
+    }
     pp->hints.behav = 0;
     pp->type = type;
     strcpy(&(pp->name[0]), name);
 
     cs_hash_table_put(csound, csound->chn_db, (char*)name, pp);
+    csp_mem_leave(csound, mem_saved);
 
     return CSOUND_SUCCESS;
 }
 
 
-PUBLIC int32_t csoundGetChannelPtr(CSOUND *csound,
-                               MYFLT **p, const char *name, int32_t type)
+/* find or create the channel; *err is the csoundGetChannelPtr result */
+static CHNENTRY *get_channel(CSOUND *csound, const char *name,
+                             int32_t type, int32_t *err)
 {
     CHNENTRY  *pp;
 
-    *p = (MYFLT*) NULL;
+    *err = CSOUND_ERROR;
     if (UNLIKELY(name == NULL))
-      return CSOUND_ERROR;
+      return NULL;
     pp = find_channel(csound, name);
     if (!pp) {
         if (create_new_channel(csound, name, type) == CSOUND_SUCCESS) {
@@ -434,13 +438,309 @@ PUBLIC int32_t csoundGetChannelPtr(CSOUND *csound,
         }
     }
     if (pp != NULL) {
-      if ((pp->type ^ type) & CSOUND_CHANNEL_TYPE_MASK)
-        return pp->type;
+      if ((pp->type ^ type) & CSOUND_CHANNEL_TYPE_MASK) {
+        *err = pp->type;
+        return NULL;
+      }
       pp->type |= (type & (CSOUND_INPUT_CHANNEL | CSOUND_OUTPUT_CHANNEL));
+      *err = CSOUND_SUCCESS;
+    }
+    return pp;
+}
+
+PUBLIC int32_t csoundGetChannelPtr(CSOUND *csound,
+                               MYFLT **p, const char *name, int32_t type)
+{
+    CHNENTRY  *pp;
+    int32_t   err;
+
+    *p = (MYFLT*) NULL;
+    pp = get_channel(csound, name, type, &err);
+    if (pp != NULL)
       *p = pp->data;
-      return CSOUND_SUCCESS;
+    return err;
+}
+
+PUBLIC CS_CHANNEL *csoundGetChannelHandle(CSOUND *csound,
+                                          const char *name, int32_t type)
+{
+    int32_t   err;
+    return get_channel(csound, name, type, &err);
+}
+
+#ifdef BETA
+/* debug builds: catch a handle that is not a control channel, which may
+   also be one left over from before csoundReset() */
+static CS_NOINLINE int chn_control_handle(CSOUND *csound, CS_CHANNEL *chn)
+{
+    if (LIKELY(chn != NULL &&
+               (chn->type & CSOUND_CHANNEL_TYPE_MASK) ==
+               CSOUND_CONTROL_CHANNEL))
+      return 1;
+    csound->Warning(csound, Str("channel handle %p is not a control channel"),
+                    (void*) chn);
+    return 0;
+}
+#endif
+
+PUBLIC MYFLT csoundGetControlChannelByHandle(CSOUND *csound, CS_CHANNEL *chn)
+{
+    IGN(csound);
+#ifdef BETA
+    if (UNLIKELY(!chn_control_handle(csound, chn))) return FL(0.0);
+#endif
+    return chn_load_control(chn->data, &chn->lock);
+}
+
+PUBLIC void csoundSetControlChannelByHandle(CSOUND *csound,
+                                            CS_CHANNEL *chn, MYFLT val)
+{
+    IGN(csound);
+#ifdef BETA
+    if (UNLIKELY(!chn_control_handle(csound, chn))) return;
+#endif
+    chn_store_control(chn->data, &chn->lock, val);
+}
+
+PUBLIC void csoundGetControlChannelBatch(CSOUND *csound,
+                                         CS_CHANNEL *const *chn,
+                                         MYFLT *values, int32_t n)
+{
+    int32_t   i;
+    IGN(csound);
+    for (i = 0; i < n; i++) {
+#ifdef BETA
+      if (chn[i] != NULL && UNLIKELY(!chn_control_handle(csound, chn[i]))) {
+        values[i] = FL(0.0);
+        continue;
+      }
+#endif
+      values[i] = chn[i] != NULL ?
+        chn_load_control(chn[i]->data, &chn[i]->lock) : FL(0.0);
+    }
+}
+
+PUBLIC void csoundSetControlChannelBatch(CSOUND *csound,
+                                         CS_CHANNEL *const *chn,
+                                         const MYFLT *values, int32_t n)
+{
+    int32_t   i;
+    IGN(csound);
+    for (i = 0; i < n; i++) {
+#ifdef BETA
+      if (chn[i] != NULL && UNLIKELY(!chn_control_handle(csound, chn[i])))
+        continue;
+#endif
+      if (chn[i] != NULL)
+        chn_store_control(chn[i]->data, &chn[i]->lock, values[i]);
     }
-    return CSOUND_ERROR;
+}
+
+/* String channels.  A reader may be copying from the buffer while a
+   writer replaces it, so a replaced buffer is not freed but left to the
+   memory database until reset; buffers at least double when they grow,
+   which bounds what is kept. */
+
+int32_t chn_string_set(CSOUND *csound, CHNENTRY *chn, const char *s)
+{
+    STRINGDAT *sd = (STRINGDAT *) chn->data;
+    int32_t   n = (int32_t) strlen(s) + 1, size = chn_string_size(sd);
+    int32_t   cap = (n > 2*size ? n : 2*size), changed = 1;
+    char      *buf = NULL;
+
+    /* allocate outside the lock; the size only ever grows */
+    if (n > size)
+      buf = (char *) csound->Malloc(csound, (size_t) cap);
+    chn_write_begin(chn);
+    size = sd->size;
+    if (n > size) {
+      memcpy(buf, s, n);
+      chn_string_publish(sd, buf, cap);
+      buf = NULL;
+    }
+    else if (strcmp(sd->data, s) != 0)
+      memcpy(sd->data, s, n);
+    else changed = 0;
+    chn_write_end(chn);
+    /* another writer grew the channel first */
+    if (buf != NULL)
+      csound->Free(csound, buf);
+    return changed;
+}
+
+void chn_string_get(CSOUND *csound, CHNENTRY *chn, STRINGDAT *dst)
+{
+    STRINGDAT *sd = (STRINGDAT *) chn->data;
+    uint32_t  seq;
+    int32_t   i, n;
+    char      *src;
+
+    do {
+      seq = chn_read_begin(chn);
+      n = chn_string_size(sd);
+      src = chn_string_data(sd);
+      if (dst->size < n) {
+        if (dst->data != NULL) csound->Free(csound, dst->data);
+        dst->data = (char *) csound->Malloc(csound, n);
+        dst->size = n;
+      }
+      for (i = 0; i < n-1 && src[i] != '\0'; i++)
+        dst->data[i] = src[i];
+      dst->data[i] = '\0';
+    } while (chn_read_retry(chn, seq));
+}
+
+/* Channels written by the orchestra since the host last asked.  The
+   first write after a query raises the channel's changed flag and
+   pushes it on csound->chn_changed without a lock; the host takes the
+   whole list at once, so its cost is in the channels that changed, not
+   in the channels there are.  A flag is lowered as its channel is
+   handed to the host, before the host reads the value, so a later
+   write lists the channel again. */
+
+static void chn_changed(CSOUND *csound, CHNENTRY *chn)
+{
+    CHNENTRY  *head;
+
+    if (chn->changed)                   /* listed already */
+      return;
+#if defined(HAVE_ATOMIC_BUILTIN)
+    if (__atomic_exchange_n(&chn->changed, 1, __ATOMIC_ACQ_REL))
+      return;
+    head = __atomic_load_n(&csound->chn_changed, __ATOMIC_RELAXED);
+    do {
+      chn->changed_nxt = head;
+    } while (!__atomic_compare_exchange_n(&csound->chn_changed, &head, chn, 1,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+#elif defined(MSVC)
+    if (InterlockedExchange((volatile LONG *) &chn->changed, 1))
+      return;
+    do {
+      head = csound->chn_changed;
+      chn->changed_nxt = head;
+    } while (InterlockedCompareExchangePointer(
+               (PVOID volatile *) &csound->chn_changed, chn, head) != head);
+#else
+    csoundSpinLock(&csound->chn_changed_lock);
+    if (!chn->changed) {
+      chn->changed = 1;
+      chn->changed_nxt = csound->chn_changed;
+      csound->chn_changed = chn;
+    }
+    csoundSpinUnLock(&csound->chn_changed_lock);
+#endif
+}
+
+/* take the whole list */
+static CHNENTRY *chn_changed_take(CSOUND *csound)
+{
+#if defined(HAVE_ATOMIC_BUILTIN)
+    return __atomic_exchange_n(&csound->chn_changed, NULL, __ATOMIC_ACQUIRE);
+#elif defined(MSVC)
+    return (CHNENTRY *)
+      InterlockedExchangePointer((PVOID volatile *) &csound->chn_changed, NULL);
+#else
+    CHNENTRY  *list;
+    csoundSpinLock(&csound->chn_changed_lock);
+    list = csound->chn_changed;
+    csound->chn_changed = NULL;
+    csoundSpinUnLock(&csound->chn_changed_lock);
+    return list;
+#endif
+}
+
+/* put back what the host had no room for; their flags are still up, so
+   no writer is pushing them meanwhile */
+static void chn_changed_return(CSOUND *csound, CHNENTRY *list)
+{
+    CHNENTRY  *tail = list, *head;
+
+    while (tail->changed_nxt != NULL)
+      tail = tail->changed_nxt;
+#if defined(HAVE_ATOMIC_BUILTIN)
+    head = __atomic_load_n(&csound->chn_changed, __ATOMIC_RELAXED);
+    do {
+      tail->changed_nxt = head;
+    } while (!__atomic_compare_exchange_n(&csound->chn_changed, &head, list, 1,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+#elif defined(MSVC)
+    do {
+      head = csound->chn_changed;
+      tail->changed_nxt = head;
+    } while (InterlockedCompareExchangePointer(
+               (PVOID volatile *) &csound->chn_changed, list, head) != head);
+#else
+    csoundSpinLock(&csound->chn_changed_lock);
+    tail->changed_nxt = csound->chn_changed;
+    csound->chn_changed = list;
+    csoundSpinUnLock(&csound->chn_changed_lock);
+#endif
+}
+
+/* hand chn to the host: read the link before lowering the flag, as a
+   writer may list the channel again at once */
+static inline CHNENTRY *chn_changed_next(CHNENTRY *chn)
+{
+    CHNENTRY  *nxt = chn->changed_nxt;
+#if defined(HAVE_ATOMIC_BUILTIN)
+    __atomic_store_n(&chn->changed, 0, __ATOMIC_RELEASE);
+#elif defined(MSVC)
+    InterlockedExchange((volatile LONG *) &chn->changed, 0);
+#else
+    chn->changed = 0;
+#endif
+    return nxt;
+}
+
+PUBLIC int32_t csoundGetChangedChannels(CSOUND *csound,
+                                        CS_CHANNEL **chn, int32_t max)
+{
+    CHNENTRY  *list;
+    int32_t   n = 0;
+
+    if (max <= 0 || (list = chn_changed_take(csound)) == NULL)
+      return 0;
+    while (list != NULL && n < max) {
+      chn[n++] = list;
+      list = chn_changed_next(list);
+    }
+    if (list != NULL)
+      chn_changed_return(csound, list);
+    return n;
+}
+
+#define CHN_CHANGED_BATCH 64
+
+PUBLIC int32_t csoundDispatchChangedChannels(CSOUND *csound,
+                                             channelChangeCallback_t func,
+                                             void *userData)
+{
+    CS_CHANNEL *batch[CHN_CHANGED_BATCH];
+    CHNENTRY  *list = chn_changed_take(csound);
+    int32_t   n, total = 0;
+
+    while (list != NULL) {
+      for (n = 0; list != NULL && n < CHN_CHANGED_BATCH; n++) {
+        batch[n] = list;
+        list = chn_changed_next(list);
+      }
+      func(csound, batch, n, userData);
+      total += n;
+    }
+    return total;
+}
+
+PUBLIC const char *csoundGetChannelHandleName(CSOUND *csound,
+                                              CS_CHANNEL *chn)
+{
+    IGN(csound);
+    return chn->name;
+}
+
+PUBLIC int32_t csoundGetChannelHandleType(CSOUND *csound, CS_CHANNEL *chn)
+{
+    IGN(csound);
+    return chn->type;
 }
 
 PUBLIC int32_t csoundGetChannelDatasize(CSOUND *csound, const char *name){
@@ -468,6 +768,19 @@ PUBLIC int32_t *csoundGetChannelLock(CSOUND *csound,
       return NULL;
     pp = find_channel(csound, name);
     if (pp) {
+      /* the host will write under the lock without the sequence count
+         (bus.h), so readers of the channel take the lock from now on */
+      if ((pp->type & CSOUND_CHANNEL_TYPE_MASK) == CSOUND_AUDIO_CHANNEL ||
+          (pp->type & CSOUND_CHANNEL_TYPE_MASK) == CSOUND_STRING_CHANNEL) {
+#if defined(HAVE_ATOMIC_BUILTIN)
+        __atomic_store_n(&pp->host_locked, 1, __ATOMIC_SEQ_CST);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+#elif defined(MSVC)
+        InterlockedExchange((volatile LONG *) &pp->host_locked, 1);
+#else
+        pp->host_locked = 1;
+#endif
+      }
       return (int32_t*) &pp->lock;
     }
     else return NULL;
@@ -646,37 +959,34 @@ static CS_NOINLINE int32_t print_chn_err(void *p, int32_t err)
 }
 
 
+/* resolve the channel of k-rate chnget or chnset once; the name is
+   compared again at performance time only if it is a string variable */
+
+static int32_t chn_resolve_k(CSOUND *csound, CHNGET *p, ARG *name,
+                             int32_t type)
+{
+    int32_t   err;
+
+    p->chn = get_channel(csound, (char*) p->iname->data, type, &err);
+    if (UNLIKELY(p->chn == NULL))
+      return err;
+    p->fp = p->chn->data;
+    p->lock = &(p->chn->lock);
+    p->fixed = (name != NULL && name->type == ARG_STRING);
+    strNcpy(p->chname, p->iname->data, MAX_CHAN_NAME);
+    return CSOUND_SUCCESS;
+}
+
 /* receive control value from bus at performance time */
 static int32_t chnget_opcode_perf_k(CSOUND *csound, CHNGET *p)
 {
-  if(strncmp(p->chname, p->iname->data, MAX_CHAN_NAME)){
-    int32_t err = csoundGetChannelPtr(csound, &(p->fp), (char*) p->iname->data,
-                              CSOUND_CONTROL_CHANNEL | CSOUND_INPUT_CHANNEL);
-    if(err == 0) {
-      p->lock = (spin_lock_t *)csoundGetChannelLock(csound, (char*) p->iname->data);
-    strNcpy(p->chname, p->iname->data, MAX_CHAN_NAME);
+    if (!p->fixed && strncmp(p->chname, p->iname->data, MAX_CHAN_NAME)) {
+      int32_t err = chn_resolve_k(csound, p, NULL,
+                                  CSOUND_CONTROL_CHANNEL | CSOUND_INPUT_CHANNEL);
+      if (UNLIKELY(err))
+        print_chn_err_perf(p, err);
     }
-    else
-      print_chn_err_perf(p, err);
-  }
-
-#if defined(MSVC)
-    volatile union {
-    MYFLT d;
-    MYFLT_INT_TYPE i;
-    } x;
-    x.i = InterlockedExchangeAdd64((MYFLT_INT_TYPE *) p->fp, 0);
-    *(p->arg) = x.d;
-#elif defined(HAVE_ATOMIC_BUILTIN)
-    volatile union {
-    MYFLT d;
-    MYFLT_INT_TYPE i;
-    } x;
-    x.i = __atomic_load_n((MYFLT_INT_TYPE *) p->fp, __ATOMIC_SEQ_CST);
-    *(p->arg) = x.d;
-#else
-    *(p->arg) = *(p->fp);
-#endif
+    *(p->arg) = chn_load_control(p->fp, p->lock);
     return OK;
 }
 
@@ -686,37 +996,35 @@ static int32_t chnget_opcode_perf_a(CSOUND *csound, CHNGET *p)
 {
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
+    uint32_t pos, seq;
 
     if(strncmp(p->chname, p->iname->data, MAX_CHAN_NAME)){
-    int32_t err = csoundGetChannelPtr(csound, &(p->fp), (char*) p->iname->data,
-                              CSOUND_AUDIO_CHANNEL | CSOUND_INPUT_CHANNEL);
-    if(err == 0) {
-    p->lock =  (spin_lock_t *) csoundGetChannelLock(csound, (char*) p->iname->data);
-    strNcpy(p->chname, p->iname->data, MAX_CHAN_NAME);
-    }
-    else
-      print_chn_err_perf(p, err);
+      int32_t err;
+      CHNENTRY *chn = get_channel(csound, (char*) p->iname->data,
+                                  CSOUND_AUDIO_CHANNEL | CSOUND_INPUT_CHANNEL,
+                                  &err);
+      if (chn != NULL) {
+        p->chn = chn;
+        p->fp = chn->data;
+        strNcpy(p->chname, p->iname->data, MAX_CHAN_NAME);
       }
+      else
+        print_chn_err_perf(p, err);
+    }
 
-    if(CS_KSMPS == (uint32_t) csound->ksmps) {
-    csoundSpinLock(p->lock);
-    if (UNLIKELY(offset)) memset(p->arg, '\0', offset);
-    memcpy(&p->arg[offset], p->fp, sizeof(MYFLT)*(CS_KSMPS-offset-early));
-    if (UNLIKELY(early))
-      memset(&p->arg[CS_KSMPS-early], '\0', sizeof(MYFLT)*early);
-    csoundSpinUnLock(p->lock);
-    } else {
-    csoundSpinLock(p->lock);
+    pos = (CS_KSMPS == (uint32_t) csound->ksmps) ? 0 : offset+p->pos;
     if (UNLIKELY(offset)) memset(p->arg, '\0', offset);
-    memcpy(&p->arg[offset], &(p->fp[offset+p->pos]),
-           sizeof(MYFLT)*(CS_KSMPS-offset-early));
+    do {
+      seq = chn_read_begin(p->chn);
+      memcpy(&p->arg[offset], &(p->fp[pos]),
+             sizeof(MYFLT)*(CS_KSMPS-offset-early));
+    } while (chn_read_retry(p->chn, seq));
     if (UNLIKELY(early))
       memset(&p->arg[CS_KSMPS-early], '\0', sizeof(MYFLT)*early);
-    p->pos+=CS_KSMPS;
-    p->pos %= (csound->ksmps-offset);
-    csoundSpinUnLock(p->lock);
+    if (CS_KSMPS != (uint32_t) csound->ksmps) {
+      p->pos+=CS_KSMPS;
+      p->pos %= (csound->ksmps-offset);
     }
-
     return OK;
 }
 
@@ -725,32 +1033,11 @@ static int32_t chnget_opcode_perf_a(CSOUND *csound, CHNGET *p)
 int32_t chnget_opcode_init_i(CSOUND *csound, CHNGET *p)
 {
     int32_t   err;
-    err = csoundGetChannelPtr(csound, &(p->fp), p->iname->data,
-                              CSOUND_CONTROL_CHANNEL | CSOUND_INPUT_CHANNEL);
+    err = chn_resolve_k(csound, p, NULL,
+                        CSOUND_CONTROL_CHANNEL | CSOUND_INPUT_CHANNEL);
     if (UNLIKELY(err))
       return print_chn_err(p, err);
-#if defined(MSVC)
-    {
-    union {
-        MYFLT d;
-        MYFLT_INT_TYPE i;
-    } x;
-    x.i = InterlockedExchangeAdd64((MYFLT_INT_TYPE *)p->fp, 0);
-    *(p->arg) = x.d;
-    }
-#elif defined(HAVE_ATOMIC_BUILTIN)
-    {
-    union {
-    MYFLT d;
-    MYFLT_INT_TYPE i;
-    } x;
-    x.i = __atomic_load_n((MYFLT_INT_TYPE *) p->fp, __ATOMIC_SEQ_CST);
-    *(p->arg) =  x.d;
-    }
-#else
-    *(p->arg) = *(p->fp);
-#endif
-
+    *(p->arg) = chn_load_control(p->fp, p->lock);
     return OK;
 }
 
@@ -759,16 +1046,12 @@ int32_t chnget_opcode_init_i(CSOUND *csound, CHNGET *p)
 int32_t chnget_opcode_init_k(CSOUND *csound, CHNGET *p)
 {
     int32_t   err;
-    err = csoundGetChannelPtr(csound, &(p->fp), (char*) p->iname->data,
-                              CSOUND_CONTROL_CHANNEL | CSOUND_INPUT_CHANNEL);
-    p->lock =   (spin_lock_t *)csoundGetChannelLock(csound, (char*) p->iname->data);
+    err = chn_resolve_k(csound, p, p->h.optext->t.inArgs,
+                        CSOUND_CONTROL_CHANNEL | CSOUND_INPUT_CHANNEL);
     if (LIKELY(!err)) {
-      strNcpy(p->chname, p->iname->data, MAX_CHAN_NAME);
       p->h.opadr = (SUBR) chnget_opcode_perf_k;
       return OK;
     }
-
-
     return print_chn_err(p, err);
 }
 
@@ -778,11 +1061,11 @@ int32_t chnget_opcode_init_a(CSOUND *csound, CHNGET *p)
 {
     int32_t   err;
     p->pos = 0;
-    err = csoundGetChannelPtr(csound, &(p->fp), (char*) p->iname->data,
-                              CSOUND_AUDIO_CHANNEL | CSOUND_INPUT_CHANNEL);
-    p->lock = (spin_lock_t *) csoundGetChannelLock(csound, (char*) p->iname->data);
-
-    if (LIKELY(!err)) {
+    p->chn = get_channel(csound, (char*) p->iname->data,
+                         CSOUND_AUDIO_CHANNEL | CSOUND_INPUT_CHANNEL, &err);
+    if (LIKELY(p->chn != NULL)) {
+      p->fp = p->chn->data;
+      p->lock = &(p->chn->lock);
       strNcpy(p->chname, p->iname->data, MAX_CHAN_NAME);
       p->h.opadr = (SUBR) chnget_opcode_perf_a;
       return OK;
@@ -795,52 +1078,26 @@ int32_t chnget_opcode_init_a(CSOUND *csound, CHNGET *p)
 int32_t chnget_opcode_init_S(CSOUND *csound, CHNGET *p)
 {
     int32_t   err;
-    char *s = ((STRINGDAT *) p->arg)->data;
-    err = csoundGetChannelPtr(csound, &(p->fp), (char*) p->iname->data,
-                              CSOUND_STRING_CHANNEL | CSOUND_INPUT_CHANNEL);
-    p->lock =  (spin_lock_t *) csoundGetChannelLock(csound, (char*) p->iname->data);
-
-    if (UNLIKELY(err))
+    p->chn = get_channel(csound, (char*) p->iname->data,
+                         CSOUND_STRING_CHANNEL | CSOUND_INPUT_CHANNEL, &err);
+    if (UNLIKELY(p->chn == NULL))
       return print_chn_err(p, err);
-    csoundSpinLock(p->lock);
-    if(((STRINGDAT *) p->fp)->data != NULL) {
-      if(((STRINGDAT *) p->fp)->size > ((STRINGDAT *) p->arg)->size) {
-     if(s != NULL) csound->Free(csound, s);
-    s = cs_strdup(csound,((STRINGDAT *) p->fp)->data);
-    ((STRINGDAT *) p->arg)->data = s;
-    ((STRINGDAT *) p->arg)->size = strlen(s) + 1;
-      } else strcpy(((STRINGDAT *) p->arg)->data, ((STRINGDAT *) p->fp)->data);
-    }
-    csoundSpinUnLock(p->lock);
+    p->fp = p->chn->data;
+    p->lock = &(p->chn->lock);
+    chn_string_get(csound, p->chn, (STRINGDAT *) p->arg);
     return OK;
 }
 
 int32_t chnget_opcode_perf_S(CSOUND *csound, CHNGET *p)
 {
     int32_t   err;
-    char *s = ((STRINGDAT *) p->arg)->data;
-    err = csoundGetChannelPtr(csound, &(p->fp), (char*) p->iname->data,
-                              CSOUND_STRING_CHANNEL | CSOUND_INPUT_CHANNEL);
-     p->lock = (spin_lock_t *) csoundGetChannelLock(csound, (char*) p->iname->data);
-
-    if (UNLIKELY(err))
+    p->chn = get_channel(csound, (char*) p->iname->data,
+                         CSOUND_STRING_CHANNEL | CSOUND_INPUT_CHANNEL, &err);
+    if (UNLIKELY(p->chn == NULL))
       return print_chn_err(p, err);
-
-    if(s != NULL && ((STRINGDAT *) p->fp)->data != NULL &&
-      strcmp(s, ((STRINGDAT *) p->fp)->data) == 0) return OK;
-
-    csoundSpinLock(p->lock);
-
-    if(((STRINGDAT *) p->fp)->data != NULL){
-    if(((STRINGDAT *) p->arg)->size <= ((STRINGDAT *) p->fp)->size) {
-    if(s != NULL) csound->Free(csound, s);
-    s = cs_strdup(csound,((STRINGDAT *) p->fp)->data);
-    ((STRINGDAT *) p->arg)->data = s;
-    ((STRINGDAT *) p->arg)->size = strlen(s) + 1;
-    }
-    else strcpy (((STRINGDAT *) p->arg)->data, ((STRINGDAT *) p->fp)->data);
-      }
-    csoundSpinUnLock(p->lock);
+    p->fp = p->chn->data;
+    p->lock = &(p->chn->lock);
+    chn_string_get(csound, p->chn, (STRINGDAT *) p->arg);
     return OK;
 }
 
@@ -849,36 +1106,16 @@ int32_t chnget_opcode_perf_S(CSOUND *csound, CHNGET *p)
 
 static int32_t chnset_opcode_perf_k(CSOUND *csound, CHNGET *p)
 {
- if(strncmp(p->chname, p->iname->data, MAX_CHAN_NAME)){
-    int32_t err = csoundGetChannelPtr(csound, &(p->fp), (char*) p->iname->data,
-                              CSOUND_CONTROL_CHANNEL | CSOUND_INPUT_CHANNEL);
-    if(err == 0) {
-    p->lock = (spin_lock_t *) csoundGetChannelLock(csound, (char*) p->iname->data);
-    strNcpy(p->chname, p->iname->data, MAX_CHAN_NAME);
+    if (!p->fixed && strncmp(p->chname, p->iname->data, MAX_CHAN_NAME)) {
+      int32_t err = chn_resolve_k(csound, p, NULL,
+                                  CSOUND_CONTROL_CHANNEL | CSOUND_OUTPUT_CHANNEL);
+      if (UNLIKELY(err))
+        print_chn_err_perf(p, err);
+    }
+    if (chn_load_control(p->fp, p->lock) != *(p->arg)) {
+      chn_store_control(p->fp, p->lock, *(p->arg));
+      chn_changed(csound, p->chn);
     }
-    else
-      print_chn_err_perf(p, err);
-  }
-
-#if defined(MSVC)
-    volatile union {
-      MYFLT d;
-      MYFLT_INT_TYPE i;
-    } x;
-    x.d = *(p->arg);
-    InterlockedExchange64((MYFLT_INT_TYPE *) p->fp, x.i);
-#elif defined(HAVE_ATOMIC_BUILTIN)
-    union {
-      MYFLT d;
-      MYFLT_INT_TYPE i;
-    } x;
-    x.d = *(p->arg);
-    __atomic_store_n((MYFLT_INT_TYPE *)(p->fp),x.i, __ATOMIC_SEQ_CST);
-#else
-    csoundSpinLock(p->lock);
-    *(p->fp) = *(p->arg);
-    csoundSpinUnLock(p->lock);
-#endif
     return OK;
 }
 
@@ -889,17 +1126,15 @@ static int32_t chnset_opcode_perf_a(CSOUND *csound, CHNGET *p)
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
     if(CS_KSMPS == (uint32_t) csound->ksmps){
-      /* Need lock for the channel */
-      csoundSpinLock(p->lock);
+      chn_write_begin(p->chn);
       if (UNLIKELY(offset)) memset(p->fp, '\0', sizeof(MYFLT)*offset);
       memcpy(&p->fp[offset], &p->arg[offset],
              sizeof(MYFLT)*(CS_KSMPS-offset-early));
       if (UNLIKELY(early))
         memset(&p->fp[early], '\0', sizeof(MYFLT)*(CS_KSMPS-early));
-      csoundSpinUnLock(p->lock);
+      chn_write_end(p->chn);
     } else {
-      /* Need lock for the channel */
-      csoundSpinLock(p->lock);
+      chn_write_begin(p->chn);
       if (UNLIKELY(offset)) memset(p->fp, '\0', sizeof(MYFLT)*offset);
       memcpy(&p->fp[offset+p->pos], &p->arg[offset],
              sizeof(MYFLT)*(CS_KSMPS-offset-early));
@@ -907,8 +1142,9 @@ static int32_t chnset_opcode_perf_a(CSOUND *csound, CHNGET *p)
         memset(&p->fp[early], '\0', sizeof(MYFLT)*(CS_KSMPS-early));
       p->pos += CS_KSMPS;
       p->pos %= (csound->ksmps-offset);
-      csoundSpinUnLock(p->lock);
+      chn_write_end(p->chn);
     }
+    chn_changed(csound, p->chn);
     return OK;
 }
 
@@ -917,17 +1153,26 @@ static int32_t chnset_opcode_perf_a(CSOUND *csound, CHNGET *p)
 static int32_t chnmix_opcode_perf(CSOUND *csound, CHNGET *p)
 {
     uint32_t n = 0;
-    IGN(csound);
     uint32_t nsmps = CS_KSMPS;
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
     if (UNLIKELY(early)) nsmps -= early;
-    /* Need lock for the channel */
-    csoundSpinLock(p->lock);
-    for (n=offset; n<nsmps; n++) {
-      p->fp[n] += p->arg[n];
+    if (p->acc != NULL) {
+      /* this thread's copy of the channel, added in before it is read */
+      MYFLT *fp = dag_accum_buffer(p->acc,
+                                   INSDS_PRIV(p->h.insdshead)->dag_thread);
+      for (n=offset; n<nsmps; n++) {
+        fp[n] += p->arg[n];
+      }
+    }
+    else {
+      chn_write_begin(p->chn);
+      for (n=offset; n<nsmps; n++) {
+        p->fp[n] += p->arg[n];
+      }
+      chn_write_end(p->chn);
     }
-    csoundSpinUnLock(p->lock);
+    chn_changed(csound, p->chn);
     return OK;
 }
 
@@ -936,12 +1181,11 @@ static int32_t chnmix_opcode_perf(CSOUND *csound, CHNGET *p)
 static int32_t chnclear_opcode_perf(CSOUND *csound, CHNCLEAR *p)
 {
     int32_t i, n=p->INCOUNT;
-    /* Need lock for the channel */
-    IGN(csound);
     for (i=0; i<n; i++) {
-      csoundSpinLock(p->lock[i]);
+      chn_write_begin(p->chn[i]);
       memset(p->fp[i], 0, CS_KSMPS*sizeof(MYFLT)); /* Should this leave start? */
-      csoundSpinUnLock(p->lock[i]);
+      chn_write_end(p->chn[i]);
+      chn_changed(csound, p->chn[i]);
     }
     return OK;
 }
@@ -952,36 +1196,14 @@ int32_t chnset_opcode_init_i(CSOUND *csound, CHNGET *p)
 {
     int32_t   err;
 
-    err = csoundGetChannelPtr(csound, &(p->fp), (char*) p->iname->data,
-                              CSOUND_CONTROL_CHANNEL | CSOUND_OUTPUT_CHANNEL);
+    err = chn_resolve_k(csound, p, NULL,
+                        CSOUND_CONTROL_CHANNEL | CSOUND_OUTPUT_CHANNEL);
     if (UNLIKELY(err))
       return print_chn_err(p, err);
-
-
-#if defined(MSVC)
-    volatile union {
-      MYFLT d;
-      MYFLT_INT_TYPE i;
-    } x;
-    x.d = *(p->arg);
-    InterlockedExchange64((MYFLT_INT_TYPE *) p->fp, x.i);
-#elif defined(HAVE_ATOMIC_BUILTIN)
-    union {
-      MYFLT d;
-      MYFLT_INT_TYPE i;
-    } x;
-    x.d = *(p->arg);
-    __atomic_store_n((MYFLT_INT_TYPE *)(p->fp),x.i, __ATOMIC_SEQ_CST);
-#else
-    {
-      spin_lock_t *lock;       /* Need lock for the channel */
-      p->lock = lock =  (spin_lock_t *)
-        csoundGetChannelLock(csound, (char*) p->iname->data);
-      csoundSpinLock(lock);
-      *(p->fp) = *(p->arg);
-      csoundSpinUnLock(lock);
+    if (chn_load_control(p->fp, p->lock) != *(p->arg)) {
+      chn_store_control(p->fp, p->lock, *(p->arg));
+      chn_changed(csound, p->chn);
     }
-#endif
     return OK;
 }
 
@@ -991,10 +1213,9 @@ int32_t chnset_opcode_init_k(CSOUND *csound, CHNGET *p)
 {
     int32_t   err;
 
-    err = csoundGetChannelPtr(csound, &(p->fp), (char*) p->iname->data,
-                              CSOUND_CONTROL_CHANNEL | CSOUND_OUTPUT_CHANNEL);
+    err = chn_resolve_k(csound, p, p->h.optext->t.inArgs->next,
+                        CSOUND_CONTROL_CHANNEL | CSOUND_OUTPUT_CHANNEL);
     if (LIKELY(!err)) {
-      p->lock = (spin_lock_t *)csoundGetChannelLock(csound, (char*) p->iname->data);
       p->h.opadr = (SUBR) chnset_opcode_perf_k;
       return OK;
     }
@@ -1007,10 +1228,11 @@ int32_t chnset_opcode_init_a(CSOUND *csound, CHNGET *p)
 {
     int32_t   err;
     p->pos = 0;
-    err = csoundGetChannelPtr(csound, &(p->fp), (char*) p->iname->data,
-                              CSOUND_AUDIO_CHANNEL | CSOUND_OUTPUT_CHANNEL);
-    if (!err) {
-      p->lock = (spin_lock_t *)csoundGetChannelLock(csound, (char*) p->iname->data);
+    p->chn = get_channel(csound, (char*) p->iname->data,
+                         CSOUND_AUDIO_CHANNEL | CSOUND_OUTPUT_CHANNEL, &err);
+    if (p->chn != NULL) {
+      p->fp = p->chn->data;
+      p->lock = &(p->chn->lock);
       p->h.opadr = (SUBR) chnset_opcode_perf_a;
       return OK;
     }
@@ -1023,10 +1245,15 @@ int32_t chnmix_opcode_init(CSOUND *csound, CHNGET *p)
 {
     int32_t   err;
 
-    err = csoundGetChannelPtr(csound, &(p->fp), (char*) p->iname->data,
-                              CSOUND_AUDIO_CHANNEL | CSOUND_OUTPUT_CHANNEL);
-    if (LIKELY(!err)) {
-      p->lock = (spin_lock_t *)csoundGetChannelLock(csound, (char*) p->iname->data);
+    p->chn = get_channel(csound, (char*) p->iname->data,
+                         CSOUND_AUDIO_CHANNEL | CSOUND_OUTPUT_CHANNEL, &err);
+    if (LIKELY(p->chn != NULL)) {
+      char name[256];
+      p->fp = p->chn->data;
+      p->lock = &(p->chn->lock);
+      snprintf(name, 256, "##chn:%s", (char*) p->iname->data);
+      p->acc = dag_accum_find(csound, p->h.insdshead, p->fp, csound->ksmps,
+                              name);
       p->h.opadr = (SUBR) chnmix_opcode_perf;
       return OK;
     }
@@ -1040,12 +1267,10 @@ int32_t chnclear_opcode_init(CSOUND *csound, CHNCLEAR *p)
     int32_t   err;
     int32_t   i, n = (int32_t)p->INCOUNT;
     for (i=0; i<n; i++) {
-      /* NOTE: p->imode is a pointer to the channel data here */
-      err = csoundGetChannelPtr(csound, &(p->fp[i]), (char*) p->iname[i]->data,
-                                CSOUND_AUDIO_CHANNEL | CSOUND_OUTPUT_CHANNEL);
-      if (LIKELY(!err)) {
-        p->lock[i] = (spin_lock_t *)csoundGetChannelLock(csound,
-                                                         (char*) p->iname[i]->data);
+      p->chn[i] = get_channel(csound, (char*) p->iname[i]->data,
+                              CSOUND_AUDIO_CHANNEL | CSOUND_OUTPUT_CHANNEL, &err);
+      if (LIKELY(p->chn[i] != NULL)) {
+        p->fp[i] = p->chn[i]->data;
       }
       else return print_chn_err(p, err);
     }
@@ -1057,67 +1282,36 @@ int32_t chnclear_opcode_init(CSOUND *csound, CHNCLEAR *p)
 
 int32_t chnset_opcode_init_S(CSOUND *csound, CHNGET *p)
 {
-  int32_t   err;
-    spin_lock_t *lock;
+    int32_t   err;
     char *s = ((STRINGDAT *) p->arg)->data;
 
-    err = csoundGetChannelPtr(csound, &(p->fp), (char*) p->iname->data,
-                              CSOUND_STRING_CHANNEL | CSOUND_OUTPUT_CHANNEL);
-    // size = csoundGetChannelDatasize(csound, p->iname->data);
-    if (UNLIKELY(err)) {
+    p->chn = get_channel(csound, (char*) p->iname->data,
+                         CSOUND_STRING_CHANNEL | CSOUND_OUTPUT_CHANNEL, &err);
+    if (UNLIKELY(p->chn == NULL)) {
       return print_chn_err(p, err);
-
     }
-
     if (s==NULL) return NOTOK;
-    p->lock = lock =  (spin_lock_t *)
-      csoundGetChannelLock(csound, (char*) p->iname->data);
-    csoundSpinLock(lock);
-    if (strlen(s) >= (uint32_t) ((STRINGDAT *)p->fp)->size) {
-      if (((STRINGDAT *)p->fp)->data != NULL)
-        csound->Free(csound, ((STRINGDAT *)p->fp)->data);
-      ((STRINGDAT *)p->fp)->data = cs_strdup(csound, s);
-      ((STRINGDAT *)p->fp)->size = strlen(s)+1;
-
-      //set_channel_data_ptr(csound, p->iname->data,p->fp, strlen(s)+1);
-    }
-    else if(((STRINGDAT *)p->fp)->data != NULL)
-            strcpy(((STRINGDAT *)p->fp)->data, s);
-    csoundSpinUnLock(lock);
-
+    p->fp = p->chn->data;
+    p->lock = &(p->chn->lock);
+    if (chn_string_set(csound, p->chn, s))
+      chn_changed(csound, p->chn);
     return OK;
 }
 
 int32_t chnset_opcode_perf_S(CSOUND *csound, CHNGET *p)
 {
     int32_t   err;
-    spin_lock_t * lock;
     char *s = ((STRINGDAT *) p->arg)->data;
 
-    if ((err=csoundGetChannelPtr(csound, &(p->fp), (char*) p->iname->data,
-                                 CSOUND_STRING_CHANNEL | CSOUND_OUTPUT_CHANNEL)))
+    p->chn = get_channel(csound, (char*) p->iname->data,
+                         CSOUND_STRING_CHANNEL | CSOUND_OUTPUT_CHANNEL, &err);
+    if (UNLIKELY(p->chn == NULL))
       return err;
-    // size = csoundGetChannelDatasize(csound, p->iname->data);
-
     if (s==NULL) return NOTOK;
-    if (((STRINGDAT *)p->fp)->data
-        && strcmp(s, ((STRINGDAT *)p->fp)->data) == 0) return OK;
-
-    p->lock = lock =  (spin_lock_t *)
-      csoundGetChannelLock(csound, (char*) p->iname->data);
-    csoundSpinLock(lock);
-    if (strlen(s) >= (uint32_t) ((STRINGDAT *)p->fp)->size) {
-      if (((STRINGDAT *)p->fp)->data != NULL)
-        csound->Free(csound, ((STRINGDAT *)p->fp)->data);
-      ((STRINGDAT *)p->fp)->data = cs_strdup(csound, s);
-      ((STRINGDAT *)p->fp)->size = strlen(s)+1;
-      //set_channel_data_ptr(csound, p->iname->data,p->fp, strlen(s)+1);
-      //printf("p: %s: %s \n", p->iname->data, ((STRINGDAT *)p->fp)->data);
-    }
-    else if(((STRINGDAT *)p->fp)->data != NULL)
-        strcpy(((STRINGDAT *)p->fp)->data, s);
-    csoundSpinUnLock(lock);
-    //printf("%s \n", (char *)p->fp);
+    p->fp = p->chn->data;
+    p->lock = &(p->chn->lock);
+    if (chn_string_set(csound, p->chn, s))
+      chn_changed(csound, p->chn);
     return OK;
 }
 
@@ -972,12 +972,15 @@ int32_t diskin2_perf_asynchronous(CSOUND *csound, DISKIN2 *p)
 }
 
 
+void csp_thread_place(CSOUND *csound, int index, const char *name);
+
 uintptr_t diskin_io_thread(void *p){
     DISKIN_INST *current = (DISKIN_INST *) p;
     int32_t wakeup = 1000*current->csound->ksmps/current->csound->esr;
     int32_t *start =
       current->csound->QueryGlobalVariable(current->csound,"DISKIN_THREAD_START");
     _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
+    csp_thread_place(current->csound, -1, Str("diskin"));
     while(*start){
       current = (DISKIN_INST *) p;
       csoundSleep(wakeup > 0 ? wakeup : 1);
@@ -1543,6 +1546,7 @@ uintptr_t diskin_io_thread_array(void *p){
       current->csound->QueryGlobalVariable(current->csound,
                                            "DISKIN_THREAD_START_ARRAY");
     _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
+    csp_thread_place(current->csound, -1, Str("diskin"));
     while(*start){
       current = (DISKIN_INST *) p;
       csoundSleep(wakeup > 0 ? wakeup : 1);
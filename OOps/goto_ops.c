@@ -123,6 +123,8 @@ int32_t reinit(CSOUND *csound, GOTO *p)
     if (csound->oparms->realtime == 0) {
       csound->curip = p->h.insdshead;
       csound->ids = p->lblblk->prvi;        /* now, despite ANSI C warning:  */
+      /* the rest of this k-cycle follows the chain (see kperf) */
+      INSDS_PRIV(p->h.insdshead)->disp_ready = 0;
       while ((csound->ids = csound->ids->nxti) != NULL &&
              (csound->ids->iopadr != (SUBR) rireturn))
         (*csound->ids->iopadr)(csound, csound->ids);
@@ -2690,7 +2690,7 @@ static int32_t outa(CSOUND *csound, OUTA *p)
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = nsmps - p->h.insdshead->ksmps_no_end;
     MYFLT       *data = p->tabin->data;
-    MYFLT       *sp= csound->spraw;
+    MYFLT       *sp= CS_SPOUT;
     if (!csound->spoutactive) {
       memset(sp, '\0', nsmps*nchns*sizeof(MYFLT));
       for (l=0; l<pl; l++) {
@@ -4004,10 +4004,10 @@ static OENTRY arrayvars_localops[] =
     { "copy2ttab", sizeof(TABCOPY), TR|_QQ, 2, "", "k[]k", NULL, (SUBR) ftab2tab },
     { "copya2ftab.k", sizeof(TABCOPY), TW, 3, "", "k[]k",
       (SUBR) tab2ftabi, (SUBR) tab2ftab },
-    { "copyf2array.k", sizeof(TABCOPY), TR, 3, "", "k[]k",
+    { "copyf2array.k", sizeof(TABCOPY), TR|WI, 3, "", "k[]k",
       (SUBR) ftab2tabi, (SUBR) ftab2tab },
     { "copya2ftab.i", sizeof(TABCOPY), TW, 1, "", "i[]i", (SUBR) tab2ftabi },
-    { "copyf2array.i", sizeof(TABCOPY), TR, 1, "", "i[]i", (SUBR) ftab2tabi },
+    { "copyf2array.i", sizeof(TABCOPY), TR|WI, 1, "", "i[]i", (SUBR) ftab2tabi },
     /* { "lentab", 0xffff}, */
     { "lentab.i", sizeof(TABQUERY1), _QQ, 1, "i", "k[]p", (SUBR) tablength },
     { "lentab.k", sizeof(TABQUERY1), _QQ, 1, "k", "k[]p", NULL, (SUBR) tablength },
@@ -2648,17 +2648,17 @@ static OENTRY localops[] = {
    (SUBR) pvsenvwset, (SUBR) pvsenvw},
   {"pvsgain", sizeof(PVSGAIN), 0,3, "f", "fk",
    (SUBR) pvsgainset, (SUBR) pvsgain, NULL},
-  {"pvs2tab", sizeof(PVS2TAB_T), 0,3, "k", "k[]f",
+  {"pvs2tab", sizeof(PVS2TAB_T), WI,3, "k", "k[]f",
    (SUBR) pvs2tab_init, (SUBR) pvs2tab, NULL},
-  {"pvs2tab", sizeof(PVS2TABSPLIT_T), 0,3, "k", "k[]k[]f",
+  {"pvs2tab", sizeof(PVS2TABSPLIT_T), WI,3, "k", "k[]k[]f",
    (SUBR) pvs2tabsplit_init, (SUBR) pvs2tabsplit, NULL},
   {"tab2pvs", sizeof(TAB2PVS_T), 0, 3, "f", "k[]oop", (SUBR) tab2pvs_init,
    (SUBR) tab2pvs, NULL},
   {"tab2pvs", sizeof(TAB2PVSSPLIT_T), 0, 3, "f", "k[]k[]oop",
    (SUBR) tab2pvssplit_init, (SUBR) tab2pvssplit, NULL},
-  {"pvs2array", sizeof(PVS2TAB_T), 0,3, "k", "k[]f",
+  {"pvs2array", sizeof(PVS2TAB_T), WI,3, "k", "k[]f",
    (SUBR) pvs2tab_init, (SUBR) pvs2tab, NULL},
-  {"pvs2array", sizeof(PVS2TABSPLIT_T), 0,3, "k", "k[]k[]f",
+  {"pvs2array", sizeof(PVS2TABSPLIT_T), WI,3, "k", "k[]k[]f",
    (SUBR) pvs2tabsplit_init, (SUBR) pvs2tabsplit, NULL},
   {"pvsfromarray", sizeof(TAB2PVS_T), 0, 3, "f", "k[]oop",
    (SUBR) tab2pvs_init, (SUBR) tab2pvs, NULL},
@@ -306,6 +306,52 @@ static const char *longUsageList[] = {
                                    "PFFFT = 1, vDSP =2)"),
   Str_noop("--udp-echo              echo UDP commands on terminal"),
   Str_noop("--aft-zero              set aftertouch to zero, not 127 (default)"),
+  Str_noop("--dag-scheduler=NAME    multicore task dispatch: scan (default), "
+                                   "steal"),
+  Str_noop("                          or cost (steal, longest and same-thread "
+                                   "first)"),
+  Str_noop("--barrier-spin=N        spin N times at a multicore barrier "
+                                   "before sleeping (default 0)"),
+  Str_noop("--adaptive-threads=N    1: wake only as many threads "
+                                   "as the load needs"),
+  Str_noop("                          0 (default): use all -j threads every "
+                                   "k-cycle"),
+  Str_noop("--thread-cpus=LIST      pin performance threads to CPUs "
+                                   "(e.g. 0-3,8)"),
+  Str_noop("--thread-numa=N         keep performance threads and their "
+                                   "memory on NUMA node N"),
+  Str_noop("--thread-sched=NAME     scheduling of performance threads: "
+                                   "other (default), fifo or rr"),
+  Str_noop("--thread-priority=N     real-time priority for fifo or rr "
+                                   "(default lowest)"),
+  Str_noop("--dag-report            with -j, print the critical path through "
+                                   "the instruments"),
+  Str_noop("                          and the globals that serialise it"),
+  Str_noop("--profile[=N]           time each opcode, on every Nth k-cycle "
+                                   "(default 1),"),
+  Str_noop("                          and print the most expensive at the end"),
+  Str_noop("--kcycle-deadline=F     count k-cycles taking longer than F times "
+                                   "ksmps/sr (default 1)"),
+  Str_noop("--instance-prewarm=N    make N instances of each instrument "
+                                   "before performing"),
+  Str_noop("--aux-strict            warn of init-time AuxAlloc not served "
+                                   "from the instrument's arena"),
+  Str_noop("--mem-report            print memory use per instrument, opcode "
+                                   "and subsystem at the end"),
+  Str_noop("--rt-memory             lock memory, pre-fault tables and "
+                                   "instances, count page faults"),
+  Str_noop("--expr-fusion=N         a-rate expressions as one opcode: 0 off, "
+                                   "1 exact (default),"),
+  Str_noop("                          2 regrouping k-rate factors"),
+  Str_noop("--tree-opt=N            fold constants, share common "
+                                   "subexpressions, hoist i-time"),
+  Str_noop("                          work and remove dead code: 0 off, "
+                                   "1 on (default)"),
+  Str_noop("--opt-report            print what the optimizer changed and "
+                                   "the size of each instance"),
+  Str_noop("--udo-inline=N          splice UDOs of up to N statements into "
+                                   "their callers,"),
+  Str_noop("                          0 off (default 16)"),
   " ",
   Str_noop("--help                  long help"),
   NULL
@@ -1184,6 +1230,115 @@ static int decode_long(CSOUND *csound, char *s, int argc, char **argv)
       csound->aftouch = 0;
       return 1;
     }
+    else if (!(strncmp(s, "dag-scheduler=", 14))) {
+      s += 14;
+      if (!strcmp(s, "scan")) O->dagScheduler = DAG_SCHED_SCAN;
+      else if (!strcmp(s, "steal")) O->dagScheduler = DAG_SCHED_STEAL;
+      else if (!strcmp(s, "cost")) O->dagScheduler = DAG_SCHED_COST;
+      else {
+        csoundErrorMsg(csound, Str("unknown DAG scheduler '%s'"), s);
+        return 0;
+      }
+      return 1;
+    }
+    else if (!(strncmp(s, "barrier-spin=", 13))) {
+      s += 13;
+      O->barrierSpin = atoi(s);
+      if (O->barrierSpin < 0) O->barrierSpin = 0;
+      return 1;
+    }
+    else if (!(strncmp(s, "adaptive-threads=", 17))) {
+      s += 17;
+      O->adaptiveThreads = (atoi(s) != 0);
+      return 1;
+    }
+    else if (!(strncmp(s, "thread-cpus=", 12))) {
+      s += 12;
+      O->threadCpus = *s ? cs_strdup(csound, s) : NULL;
+      return 1;
+    }
+    else if (!(strncmp(s, "thread-numa=", 12))) {
+      s += 12;
+      O->threadNuma = atoi(s);
+      return 1;
+    }
+    else if (!(strncmp(s, "thread-sched=", 13))) {
+      s += 13;
+      if (!strcmp(s, "other")) O->threadSched = CSP_SCHED_OTHER;
+      else if (!strcmp(s, "fifo")) O->threadSched = CSP_SCHED_FIFO;
+      else if (!strcmp(s, "rr")) O->threadSched = CSP_SCHED_RR;
+      else {
+        csoundErrorMsg(csound, Str("unknown thread scheduling '%s'"), s);
+        return 0;
+      }
+      return 1;
+    }
+    else if (!(strncmp(s, "thread-priority=", 16))) {
+      s += 16;
+      O->threadPriority = atoi(s);
+      return 1;
+    }
+    else if (!(strcmp(s, "dag-report"))) {
+      O->dagReport = 1;
+      return 1;
+    }
+    else if (!(strcmp(s, "aux-strict"))) {
+      O->auxStrict = 1;
+      return 1;
+    }
+    else if (!(strcmp(s, "rt-memory"))) {
+      O->rtMemory = 1;
+      return 1;
+    }
+    else if (!(strcmp(s, "mem-report"))) {
+      O->memReport = 1;
+      csoundSetMemoryAccounting(csound, 1);
+      return 1;
+    }
+    else if (!(strncmp(s, "instance-prewarm=", 17))) {
+      s += 17;
+      O->instancePrewarm = atoi(s);
+      if (O->instancePrewarm < 0) O->instancePrewarm = 0;
+      return 1;
+    }
+    else if (!(strncmp(s, "kcycle-deadline=", 16))) {
+      s += 16;
+      O->kcycleDeadline = atof(s);
+      if (O->kcycleDeadline <= 0.0) O->kcycleDeadline = 1.0;
+      return 1;
+    }
+    else if (!(strncmp(s, "expr-fusion=", 12))) {
+      int n;
+      s += 12;
+      n = atoi(s);
+      if (n < 0 || n > 2) {
+        csoundErrorMsg(csound, Str("--expr-fusion must be 0, 1 or 2, not '%s'"),
+                       s);
+        return 0;
+      }
+      O->exprFusion = n;
+      return 1;
+    }
+    else if (!(strncmp(s, "tree-opt=", 9))) {
+      s += 9;
+      O->treeOpt = (atoi(s) != 0);
+      return 1;
+    }
+    else if (!(strcmp(s, "opt-report"))) {
+      O->optReport = 1;
+      return 1;
+    }
+    else if (!(strncmp(s, "udo-inline=", 11))) {
+      s += 11;
+      O->udoInline = atoi(s);
+      if (O->udoInline < 0) O->udoInline = 0;
+      return 1;
+    }
+    else if (!(strncmp(s, "profile", 7)) && (s[7] == '\0' || s[7] == '=')) {
+      O->profileInterval = s[7] == '=' ? atoi(s+8) : 1;
+      if (O->profileInterval < 0) O->profileInterval = 0;
+      return 1;
+    }
 
     csoundErrorMsg(csound, Str("unknown long option: '--%s'"), s);
     return 0;
@@ -1603,6 +1758,31 @@ PUBLIC void csoundSetParams(CSOUND *csound, CSOUND_PARAMS *p){
     oparms->e0dbfs_override = p->e0dbfs_override;
 
     if (p->ksmps_override > 0) oparms->ksmps_override = p->ksmps_override;
+
+    /* multicore dispatch policy */
+    if (p->dag_scheduler >= 0) oparms->dagScheduler = p->dag_scheduler;
+    if (p->barrier_spin >= 0) oparms->barrierSpin = p->barrier_spin;
+    if (p->adaptive_threads >= 0)
+      oparms->adaptiveThreads = (p->adaptive_threads != 0);
+    if (p->thread_numa >= 0) oparms->threadNuma = p->thread_numa;
+    if (p->thread_sched >= CSP_SCHED_OTHER && p->thread_sched <= CSP_SCHED_RR)
+      oparms->threadSched = p->thread_sched;
+    if (p->thread_priority >= 0) oparms->threadPriority = p->thread_priority;
+    if (p->dag_report >= 0) oparms->dagReport = (p->dag_report != 0);
+    if (p->profile_interval >= 0) oparms->profileInterval = p->profile_interval;
+    if (p->kcycle_deadline > 0) oparms->kcycleDeadline = p->kcycle_deadline;
+    if (p->instance_prewarm >= 0) oparms->instancePrewarm = p->instance_prewarm;
+    if (p->aux_strict >= 0) oparms->auxStrict = (p->aux_strict != 0);
+    if (p->mem_report >= 0) {
+      oparms->memReport = (p->mem_report != 0);
+      if (oparms->memReport) csoundSetMemoryAccounting(csound, 1);
+    }
+    if (p->rt_memory >= 0) oparms->rtMemory = (p->rt_memory != 0);
+    if (p->expr_fusion >= 0 && p->expr_fusion <= 2)
+      oparms->exprFusion = p->expr_fusion;
+    if (p->tree_opt >= 0) oparms->treeOpt = (p->tree_opt != 0);
+    if (p->opt_report >= 0) oparms->optReport = (p->opt_report != 0);
+    if (p->udo_inline >= 0) oparms->udoInline = p->udo_inline;
 }
 
 PUBLIC void csoundGetParams(CSOUND *csound, CSOUND_PARAMS *p){
@@ -1643,6 +1823,23 @@ PUBLIC void csoundGetParams(CSOUND *csound, CSOUND_PARAMS *p){
     p->daemon = oparms->daemon;
     p->ksmps_override = oparms->ksmps_override;
     p->FFT_library = oparms->fft_lib;
+    p->dag_scheduler = oparms->dagScheduler;
+    p->barrier_spin = oparms->barrierSpin;
+    p->adaptive_threads = oparms->adaptiveThreads;
+    p->thread_numa = oparms->threadNuma;
+    p->thread_sched = oparms->threadSched;
+    p->thread_priority = oparms->threadPriority;
+    p->dag_report = oparms->dagReport;
+    p->profile_interval = oparms->profileInterval;
+    p->kcycle_deadline = oparms->kcycleDeadline;
+    p->instance_prewarm = oparms->instancePrewarm;
+    p->aux_strict = oparms->auxStrict;
+    p->mem_report = oparms->memReport;
+    p->rt_memory = oparms->rtMemory;
+    p->expr_fusion = oparms->exprFusion;
+    p->tree_opt = oparms->treeOpt;
+    p->opt_report = oparms->optReport;
+    p->udo_inline = oparms->udoInline;
 }
 
 
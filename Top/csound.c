@@ -59,6 +59,8 @@
 #include "cs_par_orc_semantics.h"
 //#include "cs_par_dispatch.h"
 #include "find_opcode.h"
+#include "profile.h"
+#include "rtcheck.h"
 
 #if defined(linux)||defined(__HAIKU__)|| defined(__EMSCRIPTEN__)||defined(__CYGWIN__)
 #define PTHREAD_SPINLOCK_INITIALIZER 0
@@ -140,19 +142,13 @@ void print_csound_version(CSOUND* csound)
 }
 
 static void free_opcode_table(CSOUND* csound) {
-    int i;
-    CS_HASH_TABLE_ITEM* bucket;
-    CONS_CELL* head;
-
-    for (i = 0; i < HASH_SIZE; i++) {
-      bucket = csound->opcodes->buckets[i];
+    CONS_CELL *head, *item;
 
-      while (bucket != NULL) {
-        head = bucket->value;
-        cs_cons_free_complete(csound, head);
-        bucket = bucket->next;
-      }
+    head = cs_hash_table_values(csound, csound->opcodes);
+    for (item = head; item != NULL; item = item->next) {
+      cs_cons_free_complete(csound, item->value);
     }
+    cs_cons_free(csound, head);
 
     cs_hash_table_free(csound, csound->opcodes);
 }
@@ -907,7 +903,25 @@ static const CSOUND cenviron_ = {
       0.4,          /*    vbr quality  */
       0,            /*    ksmps_override */
       0,             /*    fft_lib */
-      0
+      0,            /*    echo */
+      0,            /*    dagScheduler */
+      0,            /*    barrierSpin */
+      0,            /*    adaptiveThreads */
+      NULL,         /*    threadCpus */
+      -1,           /*    threadNuma */
+      0,            /*    threadSched */
+      0,            /*    threadPriority */
+      0,            /*    dagReport */
+      0,            /*    profileInterval */
+      1.0,          /*    kcycleDeadline */
+      0,            /*    instancePrewarm */
+      0,            /*    auxStrict */
+      0,            /*    memReport */
+      0,            /*    rtMemory */
+      1,            /*    exprFusion */
+      1,            /*    treeOpt */
+      0,            /*    optReport */
+      16            /*    udoInline */
     },
 
     {0, 0, {0}}, /* REMOT_BUF */
@@ -978,7 +992,49 @@ static const CSOUND cenviron_ = {
     NULL,           /* message_string */
     0,              /* message_string_queue_items */
     0,              /* message_string_queue_wp */
-    NULL            /* message_string_queue */
+    NULL,           /* message_string_queue */
+    NULL,           /* dag_deques */
+    0,              /* dag_deque_size */
+    0,              /* dag_num_remaining */
+    0,              /* dag_dep_words */
+    0,              /* dag_num_live */
+    NULL,           /* dag_task_sem */
+    NULL,           /* dag_task_rank */
+    NULL,           /* dag_task_epoch */
+    0,              /* dag_epoch */
+    NULL,           /* dag_pending */
+    NULL,           /* dag_global_ids */
+    0,              /* dag_num_globals */
+    0,              /* dag_active_threads */
+    0,              /* dag_num_ready */
+    0.0,            /* dag_task_cost */
+    NULL,           /* dag_idle_locks */
+    NULL,           /* dag_idle_parked */
+    NULL,           /* dag_ready */
+    NULL,           /* dag_ready_to */
+    NULL,           /* dag_thread_stats */
+    0,              /* dag_timing */
+    0,              /* dag_cycle_threads */
+    0,              /* dag_stat_cycles */
+    0.0,            /* dag_stat_makespan */
+    0.0,            /* dag_stat_bound */
+    0.0,            /* dag_stat_work */
+    NULL,           /* thread_cpus */
+    0,              /* thread_ncpus */
+    0,              /* perf_thread_placed */
+    NULL,           /* dag_accums */
+    NULL,           /* dag_spout */
+    NULL,           /* dag_report */
+    0,              /* prof_cycle */
+    0,              /* prof_countdown */
+    NULL,           /* profile */
+    NULL,           /* ktiming */
+    0,              /* inst_prewarm */
+    NULL,           /* memacct */
+    0,              /* mem_owner */
+    NULL,           /* rtcheck */
+    NULL,           /* chn_changed */
+    SPINLOCK_INIT   /* chn_changed_lock */
     /*, NULL */           /* self-reference */
 };
 
@@ -1482,14 +1538,67 @@ inline void advanceINSDSPointer(INSDS ***start, int num)
 }
 
 int dag_get_task(CSOUND *csound, int index, int numThreads, int next_task);
-int dag_end_task(CSOUND *csound, int task);
-void dag_build(CSOUND *csound, INSDS *chain);
+int dag_end_task(CSOUND *csound, int index, int task);
+void dag_update(CSOUND *csound, INSDS *chain);
+void dag_set_threads(CSOUND *csound, double elapsed);
+int dag_worker_idle(CSOUND *csound, int index);
+void dag_cycle_stats(CSOUND *csound, double makespan);
+void dag_wake_workers(CSOUND *csound, int from, int to);
 void dag_reinit(CSOUND *csound);
+void dag_accum_flush_for(CSOUND *csound, struct instr_semantics_t *sem);
+
+/* copy the functions of the performance chain of ip into its dispatch
+   array, once the init pass that may have changed them is done */
+static CS_NOINLINE void insds_disp_build(INSDS *ip)
+{
+    INSDS_PRIV *q = INSDS_PRIV(ip);
+    OPDISP *d = q->disp;
+    int i;
+    for (i = 0; i < q->ndisp; i++)
+      d[i].opadr = d[i].op->opadr;
+    q->disp_ready = 1;
+}
+
+/* Run the performance chain of ip once.  The common case runs down the
+   dispatch array; after an opcode that jumps (by setting pds) or
+   reinitialises, the rest of the pass follows the linked chain from
+   where it lands.  Profiled k-cycles use the chain throughout. */
+static inline int insds_perf(CSOUND *csound, INSDS *ip, int prof)
+{
+    int   error = 0;
+    OPDS  *opstart = (OPDS*) ip;
+
+    if (UNLIKELY(!ip->actflg))
+      return 0;
+    if (LIKELY(!prof)) {
+      INSDS_PRIV *q = INSDS_PRIV(ip);
+      const OPDISP *d, *end;
+      if (UNLIKELY(!q->disp_ready))
+        insds_disp_build(ip);
+      for (d = q->disp, end = d + q->ndisp; d < end; d++) {
+        ip->pds = d->op;
+        error = (*d->opadr)(csound, d->op);  /* run each opcode */
+        if (UNLIKELY(ip->pds != d->op || error != 0 ||
+                     !ip->actflg || !q->disp_ready))
+          break;
+      }
+      if (LIKELY(d == end) || error != 0 || !ip->actflg)
+        return error;
+      opstart = ip->pds;
+    }
+    while (error == 0 && (opstart = opstart->nxtp) != NULL && ip->actflg) {
+      /* In case of jumping need this repeat of opstart */
+      opstart->insdshead->pds = opstart;
+      error = UNLIKELY(prof) ? csp_profile_opcode(csound, opstart) :
+        (*opstart->opadr)(csound, opstart); /* run each opcode */
+      opstart = opstart->insdshead->pds;
+    }
+    return error;
+}
 
 inline static int nodePerf(CSOUND *csound, int index, int numThreads)
 {
     INSDS *insds = NULL;
-    OPDS  *opstart = NULL;
     int played_count = 0;
     int which_task;
     INSDS **task_map = (INSDS**)csound->dag_task_map;
@@ -1497,14 +1606,22 @@ inline static int nodePerf(CSOUND *csound, int index, int numThreads)
 #define INVALID (-1)
 #define WAIT    (-2)
     int next_task = INVALID;
-    IGN(index);
+    int timing = csound->dag_timing;
+    int prof = csound->prof_cycle;
+    double t0 = 0.0, work = 0.0, longest = 0.0;
 
     while (1) {
       int done;
       which_task = dag_get_task(csound, index, numThreads, next_task);
       //printf("******** Select task %d\n", which_task);
-      if (which_task==WAIT) continue;
-      if (which_task==INVALID) return played_count;
+      if (which_task==WAIT) { CSP_RELAX(); continue; }
+      if (which_task==INVALID) {
+        if (timing) {
+          csound->dag_thread_stats[2*index] = work;
+          csound->dag_thread_stats[2*index+1] = longest;
+        }
+        return played_count;
+      }
          /* VL: the validity of icurTime needs to be checked */
         time_end = (csound->ksmps+csound->icurTime)/csound->esr;
         insds = task_map[which_task];
@@ -1520,26 +1637,25 @@ inline static int nodePerf(CSOUND *csound, int index, int numThreads)
         done = insds->init_done;
 #endif
         if (done) {
-          opstart = (OPDS*)task_map[which_task];
+          MYFLT *spout = dag_accum_buffer(csound->dag_spout, index);
+          if (timing) t0 = csoundRealTimeSeconds();
+          INSDS_PRIV(insds)->dag_thread = index;
+          if (csound->dag_accums != NULL)
+            dag_accum_flush_for(csound, csound->dag_task_sem[which_task]);
+          CSP_RT_ENTER(insds);
           if (insds->ksmps == csound->ksmps) {
             insds->spin = csound->spin;
-            insds->spout = csound->spraw;
+            insds->spout = spout;
             insds->kcounter =  csound->kcounter;
-            while ((opstart = opstart->nxtp) != NULL) {
-              /* In case of jumping need this repeat of opstart */
-              opstart->insdshead->pds = opstart;
-              (*opstart->opadr)(csound, opstart); /* run each opcode */
-              opstart = opstart->insdshead->pds;
-            }
+            insds_perf(csound, insds, prof);
           } else {
             int i, n = csound->nspout, start = 0;
             int lksmps = insds->ksmps;
             int incr = csound->nchnls*lksmps;
             int offset =  insds->ksmps_offset;
             int early = insds->ksmps_no_end;
-            OPDS  *opstart;
             insds->spin = csound->spin;
-            insds->spout = csound->spraw;
+            insds->spout = spout;
             insds->kcounter =  csound->kcounter*csound->ksmps;
 
             /* we have to deal with sample-accurate code
@@ -1557,21 +1673,26 @@ inline static int nodePerf(CSOUND *csound, int index, int numThreads)
             }
 
             for (i=start; i < n; i+=incr, insds->spin+=incr, insds->spout+=incr) {
-              opstart = (OPDS*) insds;
-              while ((opstart = opstart->nxtp) != NULL) {
-                opstart->insdshead->pds = opstart;
-                (*opstart->opadr)(csound, opstart); /* run each opcode */
-                opstart = opstart->insdshead->pds;
-              }
+              insds_perf(csound, insds, prof);
               insds->kcounter++;
             }
           }
           insds->ksmps_offset = 0; /* reset sample-accuracy offset */
           insds->ksmps_no_end = 0;  /* reset end of loop samples */
+          CSP_RT_LEAVE();
           played_count++;
+          if (timing) {
+            double t = csoundRealTimeSeconds() - t0;
+            /* moving average of run time, for the cost-based placement */
+            INSDS_PRIV *q = INSDS_PRIV(insds);
+            q->dag_cost = (q->dag_cost == 0.0 ? t :
+                           q->dag_cost + 0.125*(t - q->dag_cost));
+            work += t;
+            if (t > longest) longest = t;
+          }
         }
         //printf("******** finished task %d\n", which_task);
-        next_task = dag_end_task(csound, which_task);
+        next_task = dag_end_task(csound, index, which_task);
     }
     return played_count;
 }
@@ -1605,7 +1726,7 @@ unsigned long kperfThread(void * cs)
     int numThreads;
     _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
 
-    csound->WaitBarrier(csound->barrier2);
+    csp_barrier_wait(csound, csound->barrier2, -1);
 
     threadId = csound->GetCurrentThreadID();
     index = getThreadIndex(csound, threadId);
@@ -1622,10 +1743,17 @@ unsigned long kperfThread(void * cs)
       return ULONG_MAX;
     }
     index++;
+    csp_thread_place(csound, index, Str("performance"));
 
     while (1) {
 
-      csound->WaitBarrier(csound->barrier1);
+      /* sleep through cycles that need fewer threads */
+      if (index >= ATOMIC_GET(csound->dag_active_threads) &&
+          dag_worker_idle(csound, index)) {
+        free(threadId);
+        return 0UL;
+      }
+      csp_barrier_wait(csound, csound->barrier1, index);
 
       // FIXME:PTHREAD_WORK - need to check if this is necessary and, if so,
       // use some other kind of locking mechanism as it isn't clear why a
@@ -1640,13 +1768,18 @@ unsigned long kperfThread(void * cs)
 
       nodePerf(csound, index, numThreads);
 
-      csound->WaitBarrier(csound->barrier2);
+      csp_barrier_wait(csound, csound->barrier2, index);
     }
 }
 
 int kperf_nodebug(CSOUND *csound)
 {
     INSDS *ip;
+    int prof;
+    if (UNLIKELY(!csound->perf_thread_placed)) {
+      csound->perf_thread_placed = 1;         /* the thread running kperf */
+      csp_thread_place(csound, 0, Str("performance"));
+    }
     /* update orchestra time */
     csound->kcounter = ++(csound->global_kcounter);
     csound->icurTime += csound->ksmps;
@@ -1679,21 +1812,35 @@ int kperf_nodebug(CSOUND *csound)
     memset(csound->spout, 0, csound->nspout*sizeof(MYFLT));
     memset(csound->spraw, 0, csound->nspout*sizeof(MYFLT));
     ip = csound->actanchor.nxtact;
+    prof = csp_profile_cycle(csound);   /* before the threads start */
 
     if (ip != NULL) {
       /* There are 2 partitions of work: 1st by inso,
          2nd by inso count / thread count. */
       if (csound->multiThreadedThreadInfo != NULL) {
-        if (csound->dag_changed) dag_build(csound, ip);
-        else dag_reinit(csound);     /* set to initial state */
+        RTCLOCK clk;
+        if (csound->dag_changed) dag_update(csound, ip);
+        dag_reinit(csound);     /* set to initial state */
+        if (UNLIKELY(csound->dag_spout == NULL))
+          csound->dag_spout = dag_accum_find(csound, NULL, csound->spraw,
+                                             csound->nspout, NULL);
+        /* each thread mixes into its own zeroed copy of spout */
+        csound->spoutactive = 1;
 
         /* process this partition */
-        csound->WaitBarrier(csound->barrier1);
+        csp_barrier_wait(csound, csound->barrier1, 0);
+        csound->InitTimerStruct(&clk);
 
         (void) nodePerf(csound, 0, 1);
+        /* choose the threads for the next cycle */
+        dag_set_threads(csound, csound->GetRealTime(&clk));
 
         /* wait until partition is complete */
-        csound->WaitBarrier(csound->barrier2);
+        csp_barrier_wait(csound, csound->barrier2, 0);
+        csp_barrier_set_count(csound->barrier2,
+                              ATOMIC_GET(csound->dag_active_threads));
+        dag_accum_flush_all(csound);
+        dag_cycle_stats(csound, csound->GetRealTime(&clk));
         csound->multiThreadedDag = NULL;
       }
       else {
@@ -1713,19 +1860,12 @@ int kperf_nodebug(CSOUND *csound)
           }
           done = ATOMIC_GET(ip->init_done);
           if (done == 1) {/* if init-pass has been done */
-            int error = 0;
-            OPDS  *opstart = (OPDS*) ip;
             ip->spin = csound->spin;
             ip->spout = csound->spraw;
             ip->kcounter =  csound->kcounter;
+            CSP_RT_ENTER(ip);
             if (ip->ksmps == csound->ksmps) {
-              while (error == 0 &&
-                     (opstart = opstart->nxtp) != NULL &&
-                     ip->actflg) {
-                opstart->insdshead->pds = opstart;
-                error = (*opstart->opadr)(csound, opstart); /* run each opcode */
-                opstart = opstart->insdshead->pds;
-              }
+              insds_perf(csound, ip, prof);
             } else {
                 int error = 0;
                 int i, n = csound->nspout, start = 0;
@@ -1733,7 +1873,6 @@ int kperf_nodebug(CSOUND *csound)
                 int incr = csound->nchnls*lksmps;
                 int offset =  ip->ksmps_offset;
                 int early = ip->ksmps_no_end;
-                OPDS  *opstart;
                 ip->spin = csound->spin;
                 ip->spout = csound->spraw;
                 ip->kcounter =  csound->kcounter*csound->ksmps/lksmps;
@@ -1753,16 +1892,12 @@ int kperf_nodebug(CSOUND *csound)
                 }
 
                 for (i=start; i < n; i+=incr, ip->spin+=incr, ip->spout+=incr) {
-                  opstart = (OPDS*) ip;
-                  while (error ==  0 && (opstart = opstart->nxtp) != NULL
-                         && ip->actflg) {
-                    opstart->insdshead->pds = opstart;
-                    error = (*opstart->opadr)(csound, opstart); /* run each opcode */
-                    opstart = opstart->insdshead->pds;
-                  }
+                  if (error == 0)
+                    error = insds_perf(csound, ip, prof);
                   ip->kcounter++;
                 }
             }
+            CSP_RT_LEAVE();
           }
           /*else csound->Message(csound, "time %f\n",
                                  csound->kcounter/csound->ekr);*/
@@ -1777,8 +1912,10 @@ int kperf_nodebug(CSOUND *csound)
       memset(csound->spout, 0, csound->nspout * sizeof(MYFLT));
       memset(csound->spraw, 0, csound->nspout * sizeof(MYFLT));
     }
+    csp_ktime_chained(csound);
     make_interleave(csound);
     csound->spoutran(csound); /* send to audio_out */
+    csp_ktime_end(csound);
     //#ifdef ANDROID
     //struct timespec ts;
     //clock_gettime(CLOCK_MONOTONIC, &ts);
@@ -1824,7 +1961,9 @@ static inline void opcode_perf_debug(CSOUND *csound,
           bp_node = bp_node->next;
         }
       opstart->insdshead->pds = opstart;
+      CSP_RT_ENTER(ip);
       (*opstart->opadr)(csound, opstart); /* run each opcode */
+      CSP_RT_LEAVE();
       opstart = opstart->insdshead->pds;
     }
 }
@@ -1870,6 +2009,10 @@ int kperf_debug(CSOUND *csound)
 {
     INSDS *ip;
     csdebug_data_t *data = (csdebug_data_t *) csound->csdebug_data;
+    if (UNLIKELY(!csound->perf_thread_placed)) {
+      csound->perf_thread_placed = 1;         /* the thread running kperf */
+      csp_thread_place(csound, 0, Str("performance"));
+    }
 
     /* call message_dequeue to run API calls */
     message_dequeue(csound);
@@ -1939,16 +2082,29 @@ int kperf_debug(CSOUND *csound)
       /* There are 2 partitions of work: 1st by inso,
          2nd by inso count / thread count. */
       if (csound->multiThreadedThreadInfo != NULL) {
-        if (csound->dag_changed) dag_build(csound, ip);
-        else dag_reinit(csound);     /* set to initial state */
+        RTCLOCK clk;
+        if (csound->dag_changed) dag_update(csound, ip);
+        dag_reinit(csound);     /* set to initial state */
+        if (UNLIKELY(csound->dag_spout == NULL))
+          csound->dag_spout = dag_accum_find(csound, NULL, csound->spraw,
+                                             csound->nspout, NULL);
+        /* each thread mixes into its own zeroed copy of spout */
+        csound->spoutactive = 1;
 
         /* process this partition */
-        csound->WaitBarrier(csound->barrier1);
+        csp_barrier_wait(csound, csound->barrier1, 0);
+        csound->InitTimerStruct(&clk);
 
         (void) nodePerf(csound, 0, 1);
+        /* choose the threads for the next cycle */
+        dag_set_threads(csound, csound->GetRealTime(&clk));
 
         /* wait until partition is complete */
-        csound->WaitBarrier(csound->barrier2);
+        csp_barrier_wait(csound, csound->barrier2, 0);
+        csp_barrier_set_count(csound->barrier2,
+                              ATOMIC_GET(csound->dag_active_threads));
+        dag_accum_flush_all(csound);
+        dag_cycle_stats(csound, csound->GetRealTime(&clk));
         csound->multiThreadedDag = NULL;
       }
       else {
@@ -1976,6 +2132,7 @@ int kperf_debug(CSOUND *csound)
                     data->debug_opcode_ptr = NULL;
                     data->status = CSDEBUG_STATUS_STOPPED;
                     csoundDebuggerBreakpointReached(csound);
+                    csp_ktime_skip(csound);
                     return 0;
                 } else {
                     ip = data->debug_instr_ptr;
@@ -1994,6 +2151,7 @@ int kperf_debug(CSOUND *csound)
                   data->status = CSDEBUG_STATUS_STOPPED;
                   csoundDebuggerBreakpointReached(csound);
                   bp_node->count = bp_node->skip;
+                  csp_ktime_skip(csound);
                   return 0;
                 } else {
                   bp_node->count--;
@@ -2046,6 +2204,7 @@ int kperf_debug(CSOUND *csound)
             if (ip != NULL) { /* must defer break until next kperf */
               data->status = CSDEBUG_STATUS_STOPPED;
               csoundDebuggerBreakpointReached(csound);
+              csp_ktime_skip(csound);
               return 0;
             }
           }
@@ -2059,10 +2218,14 @@ int kperf_debug(CSOUND *csound)
       memset(csound->spout, 0, csound->nspout * sizeof(MYFLT));
       memset(csound->spraw, 0, csound->nspout * sizeof(MYFLT));
     }
-    else
+    csp_ktime_chained(csound);
+    if (csound->spoutactive)
       make_interleave(csound);
     csound->spoutran(csound);               /*      send to audio_out  */
+    csp_ktime_end(csound);
     }
+    else                                    /* stopped: not timed */
+      csp_ktime_skip(csound);
     return 0;
 }
 
@@ -2121,7 +2284,9 @@ PUBLIC int csoundPerformKsmps(CSOUND *csound)
     if(!csound->oparms->realtime) // no API lock in realtime mode
       csoundLockMutex(csound->API_lock);
     do {
+      csp_ktime_begin(csound);
       done = sensevents(csound);
+      csp_ktime_sensed(csound);
       if (UNLIKELY(done)) {
         if(!csound->oparms->realtime) // no API lock in realtime mode
          csoundUnlockMutex(csound->API_lock);
@@ -2156,7 +2321,10 @@ static int csoundPerformKsmpsInternal(CSOUND *csound)
       return ((returnValue - CSOUND_EXITJMP_SUCCESS) | CSOUND_EXITJMP_SUCCESS);
     }
    do {
-     if (UNLIKELY((done = sensevents(csound)))) {
+     csp_ktime_begin(csound);
+     done = sensevents(csound);
+     csp_ktime_sensed(csound);
+     if (UNLIKELY(done)) {
        csoundMessage(csound,
                      Str("Score finished in csoundPerformKsmpsInternal().\n"));
         return done;
@@ -2190,7 +2358,10 @@ PUBLIC int csoundPerformBuffer(CSOUND *csound)
       csoundLockMutex(csound->API_lock);
      }
       do {
-        if (UNLIKELY((done = sensevents(csound)))){
+        csp_ktime_begin(csound);
+        done = sensevents(csound);
+        csp_ktime_sensed(csound);
+        if (UNLIKELY(done)){
           if(!csound->oparms->realtime) // no API lock in realtime mode
             csoundUnlockMutex(csound->API_lock);
           return done;
@@ -2231,13 +2402,17 @@ PUBLIC int csoundPerform(CSOUND *csound)
         if(!csound->oparms->realtime)
            csoundLockMutex(csound->API_lock);
       do {
-        if (UNLIKELY((done = sensevents(csound)))) {
+        csp_ktime_begin(csound);
+        done = sensevents(csound);
+        csp_ktime_sensed(csound);
+        if (UNLIKELY(done)) {
           csoundMessage(csound, Str("Score finished in csoundPerform().\n"));
           if(!csound->oparms->realtime)
           csoundUnlockMutex(csound->API_lock);
           if (csound->oparms->numThreads > 1) {
-            csound->multiThreadedComplete = 1;
-            csound->WaitBarrier(csound->barrier1);
+            ATOMIC_SET(csound->multiThreadedComplete, 1);
+            dag_wake_workers(csound, 1, csound->oparms->numThreads);
+            csp_barrier_wait(csound, csound->barrier1, 0);
           }
           return done;
         }
@@ -2302,6 +2477,12 @@ PUBLIC MYFLT csoundGet0dBFS(CSOUND *csound)
     return csound->e0dbfs;
 }
 
+PUBLIC int csoundGetActiveThreads(CSOUND *csound)
+{
+    if (csound->multiThreadedThreadInfo == NULL) return 1;
+    return ATOMIC_GET(csound->dag_active_threads);
+}
+
 PUBLIC long csoundGetInputBufferSize(CSOUND *csound)
 {
     return csound->oparms_.inbufsamps;
@@ -2533,6 +2714,7 @@ PUBLIC void csoundSetMessageCallback(CSOUND *csound,
 PUBLIC void csoundMessageV(CSOUND *csound,
                            int attr, const char *format, va_list args)
 {
+  CSP_RT_CHECK("message");
   if(csound->csoundMessageCallback_) {
     csound->csoundMessageCallback_(csound, attr, format, args);
   } else {
@@ -2544,6 +2726,7 @@ PUBLIC void csoundMessageV(CSOUND *csound,
 PUBLIC void csoundMessage(CSOUND *csound, const char *format, ...)
 {
     va_list args;
+    CSP_RT_CHECK("message");
     va_start(args, format);
     if(csound->csoundMessageCallback_)
     csound->csoundMessageCallback_(csound, 0, format, args);
@@ -2557,6 +2740,7 @@ PUBLIC void csoundMessage(CSOUND *csound, const char *format, ...)
 PUBLIC void csoundMessageS(CSOUND *csound, int attr, const char *format, ...)
 {
     va_list args;
+    CSP_RT_CHECK("message");
     va_start(args, format);
     if(csound->csoundMessageCallback_)
     csound->csoundMessageCallback_(csound, attr, format, args);
@@ -3895,6 +4079,11 @@ PUBLIC double csoundGetCPUTime(RTCLOCK *p)
             * (1.0 / (double) CLOCKS_PER_SEC));
 }
 
+double csoundRealTimeSeconds(void)
+{
+    return (double) get_real_time() * timeResolutionSeconds;
+}
+
 /* return a 32-bit unsigned integer to be used as seed from current time */
 
 PUBLIC uint32_t csoundGetRandomSeedFromTime(void)
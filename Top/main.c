@@ -463,8 +463,13 @@ PUBLIC int csoundStart(CSOUND *csound) // DEBUG
     O->informat = O->outformat;             /* informat default */
 
 
+    {
+      void csp_thread_placement_init(CSOUND *);
+      csp_thread_placement_init(csound);
+    }
     if (O->numThreads > 1) {
       void csp_barrier_alloc(CSOUND *, void **, int);
+      int csp_barrier_wait(CSOUND *, void *, int);
       int i;
       THREADINFO *current = NULL;
 
@@ -472,6 +477,7 @@ PUBLIC int csoundStart(CSOUND *csound) // DEBUG
       csp_barrier_alloc(csound, &(csound->barrier2), O->numThreads);
 
       csound->multiThreadedComplete = 0;
+      csound->dag_active_threads = O->numThreads;
 
       for (i = 1; i < O->numThreads; i++) {
         THREADINFO *t = csound->Malloc(csound, sizeof(THREADINFO));
@@ -488,8 +494,14 @@ PUBLIC int csoundStart(CSOUND *csound) // DEBUG
         current = t;
       }
 
-      csound->WaitBarrier(csound->barrier2);
+      csp_barrier_wait(csound, csound->barrier2, -1);
+    }
+    {
+      void csp_ktime_alloc(CSOUND *);
+      csp_ktime_alloc(csound);          /* k-cycle timing for the API */
     }
+    if (csound->oparms->rtMemory)
+      mem_rt_start(csound);
     csound->engineStatus |= CS_STATE_COMP;
     if (csound->oparms->daemon > 1)
       csoundUDPServerStart(csound,csound->oparms->daemon);
@@ -0,0 +1,397 @@
+/*
+    profile.c:
+
+    Copyright (C) 2026 agent
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+/* Per-opcode profiling.  Each orchestra statement gets an entry the
+   first time it is timed, numbered in its TEXT so later calls go
+   straight to it.  Entries with the same opcode, instrument and line
+   (an instrument compiled again) share one.  The entries live in fixed
+   chunks that never move, as other performance threads may be adding
+   into them while a new one is made. */
+
+#include "csoundCore.h"
+#include "profile.h"
+#if !defined(WIN32) && !defined(__EMSCRIPTEN__)
+#include <sys/resource.h>
+#define KT_HAVE_RUSAGE
+#endif
+
+#define PROF_CHUNK      256
+#define PROF_MAXCHUNKS  1024
+
+#if defined(MSVC)
+#define PROF_ADD64(x,v) InterlockedExchangeAdd64((volatile LONG64*)&(x), v)
+#elif defined(HAVE_ATOMIC_BUILTIN)
+#define PROF_ADD64(x,v) __atomic_add_fetch(&(x), v, __ATOMIC_RELAXED)
+#else
+#define PROF_ADD64(x,v) ((x) += (v))
+#endif
+
+typedef struct {
+    char              *opname;
+    char              *instr;           /* NULL for a numbered instrument */
+    int               insno;
+    int               line;
+    volatile uint64_t calls;
+    volatile uint64_t ticks;
+} PROF_ENTRY;
+
+typedef struct cs_profile_t {
+    PROF_ENTRY        *chunks[PROF_MAXCHUNKS];
+    volatile int      count;
+    spin_lock_t       lock;
+    uint64_t          tick0;            /* counter and clock at the start */
+    double            time0;
+} CS_PROFILE;
+
+#define PROF_ENTRY_AT(p, n) (&(p)->chunks[(n)/PROF_CHUNK][(n)%PROF_CHUNK])
+
+void csp_profile_start(CSOUND *csound)
+{
+    CS_PROFILE *p = csound->Calloc(csound, sizeof(CS_PROFILE));
+    csoundSpinLockInit(&p->lock);
+    p->time0 = csoundRealTimeSeconds();
+    p->tick0 = csp_cycles();
+    csound->profile = p;
+}
+
+/* counter ticks per second since the profile started */
+static double prof_rate(CS_PROFILE *p)
+{
+    double dt = csoundRealTimeSeconds() - p->time0;
+    uint64_t dk = csp_cycles() - p->tick0;
+    if (dt < 1.0e-3 || dk == 0) return 1.0e9;
+    return (double) dk / dt;
+}
+
+/* entry number + 1 for the statement of op, or -1 if there is no room */
+static int prof_slot(CSOUND *csound, OPDS *op)
+{
+    CS_PROFILE *p = csound->profile;
+    OPTXT *optxt = op->optext;
+    TEXT  *t = &optxt->t;
+    INSDS *ip = op->insdshead;
+    char  *opname = t->opcod != NULL ? t->opcod : "?";
+    char  *instr = NULL;
+    int   i, n;
+
+    if (ip->insno <= csound->engineState.maxinsno &&
+        csound->engineState.instrtxtp[ip->insno] != NULL)
+      instr = csound->engineState.instrtxtp[ip->insno]->insname;
+    csoundSpinLock(&p->lock);
+    if (optxt->prof != 0) {             /* another thread got here first */
+      csoundSpinUnLock(&p->lock);
+      return optxt->prof;
+    }
+    n = p->count;
+    for (i = 0; i < n; i++) {           /* once per statement, so search */
+      PROF_ENTRY *e = PROF_ENTRY_AT(p, i);
+      if (e->insno == ip->insno && e->line == t->linenum &&
+          !strcmp(e->opname, opname))
+        break;
+    }
+    if (i == n) {
+      PROF_ENTRY *e;
+      if (n == PROF_CHUNK*PROF_MAXCHUNKS) {
+        optxt->prof = -1;
+        csoundSpinUnLock(&p->lock);
+        return -1;
+      }
+      if (n % PROF_CHUNK == 0)
+        p->chunks[n/PROF_CHUNK] =
+          csound->Calloc(csound, PROF_CHUNK*sizeof(PROF_ENTRY));
+      e = PROF_ENTRY_AT(p, n);
+      e->opname = cs_strdup(csound, opname);
+      e->instr = instr != NULL ? cs_strdup(csound, instr) : NULL;
+      e->insno = ip->insno;
+      e->line = t->linenum;
+      ATOMIC_SET(p->count, n+1);
+    }
+    optxt->prof = i+1;
+    csoundSpinUnLock(&p->lock);
+    return i+1;
+}
+
+int csp_profile_opcode(CSOUND *csound, OPDS *op)
+{
+    int slot = op->optext->prof, ret;
+    uint64_t t0;
+
+    if (UNLIKELY(slot == 0)) slot = prof_slot(csound, op);
+    t0 = csp_cycles();
+    ret = (*op->opadr)(csound, op);
+    t0 = csp_cycles() - t0;
+    if (LIKELY(slot > 0)) {
+      PROF_ENTRY *e = PROF_ENTRY_AT(csound->profile, slot-1);
+      PROF_ADD64(e->calls, 1);
+      PROF_ADD64(e->ticks, t0);
+    }
+    return ret;
+}
+
+static int prof_cmp(const void *a, const void *b)
+{
+    double x = ((CS_OPCODE_PROFILE*) a)->seconds;
+    double y = ((CS_OPCODE_PROFILE*) b)->seconds;
+    return x < y ? 1 : (x > y ? -1 : 0);
+}
+
+PUBLIC void csoundSetOpcodeProfiling(CSOUND *csound, int interval)
+{
+    csound->oparms->profileInterval = interval > 0 ? interval : 0;
+}
+
+PUBLIC int csoundGetOpcodeProfile(CSOUND *csound, CS_OPCODE_PROFILE **lst)
+{
+    CS_PROFILE *p = csound->profile;
+    double rate;
+    int i, n;
+
+    *lst = NULL;
+    if (p == NULL || (n = ATOMIC_GET(p->count)) == 0) return 0;
+    *lst = (CS_OPCODE_PROFILE*) csound->Malloc(csound,
+                                               n*sizeof(CS_OPCODE_PROFILE));
+    if (UNLIKELY(*lst == NULL)) return CSOUND_MEMORY;
+    rate = prof_rate(p);
+    for (i = 0; i < n; i++) {
+      PROF_ENTRY *e = PROF_ENTRY_AT(p, i);
+      (*lst)[i].opname = e->opname;
+      (*lst)[i].instr = e->instr;
+      (*lst)[i].insno = e->insno;
+      (*lst)[i].line = e->line;
+      (*lst)[i].calls = e->calls;
+      (*lst)[i].seconds = (double) e->ticks / rate;
+    }
+    qsort((void*) *lst, n, sizeof(CS_OPCODE_PROFILE), prof_cmp);
+    return n;
+}
+
+PUBLIC void csoundDeleteOpcodeProfile(CSOUND *csound, CS_OPCODE_PROFILE *lst)
+{
+    if (lst != NULL) csound->Free(csound, lst);
+}
+
+void csp_profile_report(CSOUND *csound)
+{
+    CS_OPCODE_PROFILE *lst;
+    double total = 0.0;
+    int i, n = csoundGetOpcodeProfile(csound, &lst);
+
+    if (n <= 0) return;
+    for (i = 0; i < n; i++) total += lst[i].seconds;
+    csound->Message(csound, Str("opcode profile (1 in %d k-cycles timed, "
+                                "%.3f s in opcodes):\n"),
+                    csound->oparms->profileInterval > 0 ?
+                    csound->oparms->profileInterval : 1, total);
+    csound->Message(csound, "  %-20s %-16s %6s %12s %12s %9s %6s\n",
+                    Str("opcode"), Str("instr"), Str("line"), Str("calls"),
+                    Str("time (ms)"), Str("ns/call"), "%");
+    for (i = 0; i < n && i < 40; i++) {
+      char num[32];
+      if (lst[i].instr == NULL) snprintf(num, 32, "%d", lst[i].insno);
+      csound->Message(csound, "  %-20s %-16s %6d %12llu %12.3f %9.1f %5.1f%%\n",
+                      lst[i].opname, lst[i].instr ? lst[i].instr : num,
+                      lst[i].line, (unsigned long long) lst[i].calls,
+                      1.0e3*lst[i].seconds,
+                      lst[i].calls ? 1.0e9*lst[i].seconds/lst[i].calls : 0.0,
+                      total > 0.0 ? 100.0*lst[i].seconds/total : 0.0);
+    }
+    if (n > 40)
+      csound->Message(csound, Str("  ... %d more\n"), n-40);
+    csoundDeleteOpcodeProfile(csound, lst);
+}
+
+/* K-cycle timing */
+
+#if defined(HAVE_ATOMIC_BUILTIN)
+#define KT_STORE(x,v)   __atomic_store_n(&(x), v, __ATOMIC_RELAXED)
+#define KT_LOAD(x)      __atomic_load_n(&(x), __ATOMIC_RELAXED)
+#else
+#define KT_STORE(x,v)   ((x) = (v))
+#define KT_LOAD(x)      (x)
+#endif
+
+void csp_ktime_alloc(CSOUND *csound)
+{
+    if (csound->ktiming == NULL) {
+      csound->ktiming = csound->Calloc(csound, sizeof(CS_KTIMING));
+      csound->ktiming->ru_minflt = csound->ktiming->ru_majflt = -1;
+    }
+}
+
+/* page faults since the last call.  Only the performing thread is
+   counted when it runs alone; with -j the workers fault too, so the
+   whole process is */
+static void ktime_faults(CSOUND *csound, CS_KTIMING *k)
+{
+#ifdef KT_HAVE_RUSAGE
+    struct rusage ru;
+    uint64_t n;
+# ifdef RUSAGE_THREAD
+    int who = csound->oparms->numThreads > 1 ? RUSAGE_SELF : RUSAGE_THREAD;
+# else
+    int who = RUSAGE_SELF;
+# endif
+    if (getrusage(who, &ru) != 0) return;
+    if (k->ru_minflt >= 0) {
+      uint64_t mn = (uint64_t) (ru.ru_minflt - k->ru_minflt);
+      uint64_t mj = (uint64_t) (ru.ru_majflt - k->ru_majflt);
+      n = mn + mj;
+      if (n > 0) {
+        KT_STORE(k->minflt, k->minflt + mn);
+        KT_STORE(k->majflt, k->majflt + mj);
+        KT_STORE(k->fault_cycles, k->fault_cycles + 1);
+        if (n > k->max_faults) KT_STORE(k->max_faults, n);
+      }
+    }
+    k->ru_minflt = ru.ru_minflt;
+    k->ru_majflt = ru.ru_majflt;
+#else
+    (void) csound; (void) k;
+#endif
+}
+
+/* bucket of a time in ns: exact below 8, then 8 to an octave */
+static int ktime_bucket(uint64_t ns)
+{
+    int e = 3, b;
+    if (ns < 8) return (int) ns;
+    if (ns >> 19) e += 16;
+    if (ns >> (e+8)) e += 8;
+    if (ns >> (e+4)) e += 4;
+    if (ns >> (e+2)) e += 2;
+    if (ns >> (e+1)) e += 1;
+    if (ns >> (e+1)) e += 1;
+    b = (e-2)*8 + (int) ((ns >> (e-3)) & 7);
+    return b < KTIME_BUCKETS ? b : KTIME_BUCKETS-1;
+}
+
+/* upper edge of bucket b in seconds */
+static double ktime_upper(int b)
+{
+    int e;
+    if (b < 8) return 1.0e-9*(b+1);
+    e = b/8 + 2;
+    return 1.0e-9*(double) ((uint64_t) (8 + b%8 + 1) << (e-3));
+}
+
+static void ktime_add(CS_KTIMING *k, int phase, double t)
+{
+    uint64_t ns = t > 0.0 ? (uint64_t) (t*1.0e9) : 0;
+    int b = ktime_bucket(ns);
+    KT_STORE(k->hist[phase][b], k->hist[phase][b]+1);
+    KT_STORE(k->sum_ns[phase], k->sum_ns[phase]+ns);
+    if (ns > k->max_ns[phase]) KT_STORE(k->max_ns[phase], ns);
+}
+
+void csp_ktime_end(CSOUND *csound)
+{
+    CS_KTIMING *k = csound->ktiming;
+    double t = csoundRealTimeSeconds(), total;
+
+    if (UNLIKELY(k->reset)) {
+      memset((void*) k->hist, 0, sizeof(k->hist));
+      memset((void*) k->sum_ns, 0, sizeof(k->sum_ns));
+      memset((void*) k->max_ns, 0, sizeof(k->max_ns));
+      KT_STORE(k->cycles, 0);
+      KT_STORE(k->misses, 0);
+      KT_STORE(k->minflt, 0);
+      KT_STORE(k->majflt, 0);
+      KT_STORE(k->fault_cycles, 0);
+      KT_STORE(k->max_faults, 0);
+      ATOMIC_SET(k->reset, 0);
+    }
+    total = t - k->t0;
+    ktime_add(k, CS_KCYCLE_TOTAL, total);
+    ktime_add(k, CS_KCYCLE_SENSEVENTS, k->t_sense - k->t0);
+    ktime_add(k, CS_KCYCLE_CHAIN, k->t_chain - k->t_sense);
+    ktime_add(k, CS_KCYCLE_SPOUT, t - k->t_chain);
+    if (total > csound->oparms->kcycleDeadline*csound->ksmps/csound->esr)
+      KT_STORE(k->misses, k->misses+1);
+    KT_STORE(k->cycles, k->cycles+1);
+    if (UNLIKELY(csound->oparms->rtMemory)) ktime_faults(csound, k);
+    k->t0 = 0.0;
+}
+
+void csp_fault_report(CSOUND *csound)
+{
+    CS_KTIMING *k = csound->ktiming;
+    if (k == NULL || !csound->oparms->rtMemory) return;
+    csound->Message(csound, Str("page faults while performing: %llu minor, "
+                                "%llu major, in %llu of %llu k-cycles "
+                                "(at most %llu in one)\n"),
+                    (unsigned long long) k->minflt,
+                    (unsigned long long) k->majflt,
+                    (unsigned long long) k->fault_cycles,
+                    (unsigned long long) k->cycles,
+                    (unsigned long long) k->max_faults);
+}
+
+PUBLIC int csoundGetKcycleHistogram(CSOUND *csound, int phase,
+                                    uint64_t *counts, double *upper, int n)
+{
+    CS_KTIMING *k = csound->ktiming;
+    int i;
+    if (k == NULL || phase < 0 || phase >= CS_KCYCLE_PHASES || n < 0)
+      return CSOUND_ERROR;
+    if (n > KTIME_BUCKETS) n = KTIME_BUCKETS;
+    for (i = 0; i < n; i++) {
+      counts[i] = KT_LOAD(k->hist[phase][i]);
+      if (upper != NULL) upper[i] = ktime_upper(i);
+    }
+    return n;
+}
+
+PUBLIC int csoundGetKcycleTiming(CSOUND *csound, int phase,
+                                 CS_KCYCLE_TIMING *t)
+{
+    CS_KTIMING *k = csound->ktiming;
+    uint64_t hist[KTIME_BUCKETS], n = 0, sum = 0;
+    double q[3] = { 0.5, 0.99, 0.999 }, *p[3];
+    int i, j;
+
+    if (csoundGetKcycleHistogram(csound, phase, hist, NULL,
+                                 KTIME_BUCKETS) < 0)
+      return CSOUND_ERROR;
+    for (i = 0; i < KTIME_BUCKETS; i++) n += hist[i];
+    t->cycles = n;
+    t->misses = KT_LOAD(k->misses);
+    t->minor_faults = KT_LOAD(k->minflt);
+    t->major_faults = KT_LOAD(k->majflt);
+    t->fault_cycles = KT_LOAD(k->fault_cycles);
+    t->deadline = csound->oparms->kcycleDeadline*csound->ksmps/csound->esr;
+    t->max = 1.0e-9*(double) KT_LOAD(k->max_ns[phase]);
+    t->mean = n ? 1.0e-9*(double) KT_LOAD(k->sum_ns[phase])/n : 0.0;
+    p[0] = &t->p50; p[1] = &t->p99; p[2] = &t->p999;
+    for (i = j = 0; j < 3; j++) {
+      uint64_t need = (uint64_t) (q[j]*n + 0.999999);
+      while (i < KTIME_BUCKETS-1 && sum + hist[i] < need) sum += hist[i++];
+      *p[j] = n ? ktime_upper(i) : 0.0;
+      if (*p[j] > t->max) *p[j] = t->max;
+    }
+    return CSOUND_SUCCESS;
+}
+
+PUBLIC void csoundResetKcycleTiming(CSOUND *csound)
+{
+    if (csound->ktiming != NULL) ATOMIC_SET(csound->ktiming->reset, 1);
+}
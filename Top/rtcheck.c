@@ -0,0 +1,158 @@
+/*
+    rtcheck.c:
+
+    Copyright (C) 2026 agent
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+#include "csoundCore.h"
+#include "rtcheck.h"
+
+/* Real-time safety checker (rtcheck.h).  The list lives outside
+   csound->Malloc, which is one of the calls being checked. */
+
+typedef struct rt_violation_t {
+    const char  *what;                  /* the call, a literal */
+    char        *opname;
+    int         line;
+    int         insno;
+    char        *insname;
+    uint64_t    count;
+    struct rt_violation_t *nxt;
+} RT_VIOLATION;
+
+typedef struct cs_rtcheck_t {
+    RT_VIOLATION *list;                 /* in order of first occurrence */
+    uint64_t    total;
+} CS_RTCHECK;
+
+#ifdef CS_RT_CHECK
+
+CSP_RT_TLS INSDS *csp_rt_insds = NULL;
+
+/* the list is shared by the performance threads */
+static spin_lock_t rt_lock = SPINLOCK_INIT;
+
+static char *rt_strdup(const char *s)
+{
+    char *p = (char*) malloc(strlen(s) + 1);
+    if (p != NULL) strcpy(p, s);
+    return p;
+}
+
+static RT_VIOLATION *rt_find(CS_RTCHECK *r, const char *what,
+                             const char *opname, int line, int insno)
+{
+    RT_VIOLATION *v;
+    for (v = r->list; v != NULL; v = v->nxt)
+      if (v->what == what && v->line == line && v->insno == insno &&
+          strcmp(v->opname, opname) == 0)
+        return v;
+    return NULL;
+}
+
+void csp_rt_violation(const char *what)
+{
+    INSDS       *ip = csp_rt_insds;
+    CSOUND      *csound = ip->csound;
+    OPDS        *op = ip->pds;
+    const char  *opname = "?", *insname = NULL;
+    int         line = 0, first = 0;
+    CS_RTCHECK  *r;
+    RT_VIOLATION *v;
+
+    /* unmark the thread so that the warning below is not reported too */
+    csp_rt_insds = NULL;
+    if (op != NULL && op->optext != NULL) {
+      opname = op->optext->t.opcod;
+      line = op->optext->t.linenum;
+    }
+    if (ip->instr != NULL)
+      insname = ip->instr->insname;
+    csoundSpinLock(&rt_lock);
+    if ((r = csound->rtcheck) == NULL)
+      r = csound->rtcheck = (CS_RTCHECK*) calloc(1, sizeof(CS_RTCHECK));
+    if (r != NULL) {
+      r->total++;
+      if ((v = rt_find(r, what, opname, line, ip->insno)) == NULL &&
+          (v = (RT_VIOLATION*) calloc(1, sizeof(RT_VIOLATION))) != NULL) {
+        RT_VIOLATION **pp = &r->list;
+        v->what = what;
+        v->opname = rt_strdup(opname);
+        v->line = line;
+        v->insno = ip->insno;
+        v->insname = insname != NULL ? rt_strdup(insname) : NULL;
+        if (v->opname == NULL) {
+          free(v->insname); free(v); v = NULL;
+        }
+        else {
+          while (*pp != NULL) pp = &(*pp)->nxt;
+          *pp = v;
+          first = 1;
+        }
+      }
+      if (v != NULL) v->count++;
+    }
+    csoundSpinUnLock(&rt_lock);
+    if (first) {
+      if (insname != NULL)
+        csound->Warning(csound, Str("real-time violation: %s in opcode %s "
+                                    "(line %d) of instr %s"),
+                        what, opname, line, insname);
+      else
+        csound->Warning(csound, Str("real-time violation: %s in opcode %s "
+                                    "(line %d) of instr %d"),
+                        what, opname, line, (int) ip->insno);
+    }
+    csp_rt_insds = ip;
+}
+
+#endif
+
+void csp_rt_report(CSOUND *csound)
+{
+    CS_RTCHECK   *r = csound->rtcheck;
+    RT_VIOLATION *v, *nxt;
+    int          n = 0;
+
+    if (r == NULL)
+      return;
+    for (v = r->list; v != NULL; v = v->nxt)
+      n++;
+    csound->Message(csound, Str("\nreal-time violations: %llu at %d places\n"),
+                    (unsigned long long) r->total, n);
+    csound->Message(csound, "%12s  %-12s %-16s %6s  %s\n",
+                    "count", "call", "opcode", "line", "instr");
+    for (v = r->list; v != NULL; v = nxt) {
+      nxt = v->nxt;
+      if (v->insname != NULL)
+        csound->Message(csound, "%12llu  %-12s %-16s %6d  %s\n",
+                        (unsigned long long) v->count, v->what, v->opname,
+                        v->line, v->insname);
+      else
+        csound->Message(csound, "%12llu  %-12s %-16s %6d  %d\n",
+                        (unsigned long long) v->count, v->what, v->opname,
+                        v->line, v->insno);
+      free(v->opname);
+      free(v->insname);
+      free(v);
+    }
+    free(r);
+    csound->rtcheck = NULL;
+}
@@ -34,6 +34,7 @@
 #endif
 
 #include "csoundCore.h"
+#include "rtcheck.h"
 
 #if 0
 static CS_NOINLINE void notImplementedWarning_(const char *name)
@@ -495,6 +496,7 @@ PUBLIC void *csoundCreateMutex(int isRecursive)
 
 PUBLIC void csoundLockMutex(void *mutex_)
 {
+    CSP_RT_CHECK("mutex lock");
     pthread_mutex_lock((pthread_mutex_t*) mutex_);
 }
 
@@ -556,6 +558,14 @@ PUBLIC void csoundCondSignal(void* condVar) {
         pthread_cond_signal(condVar);
 }
 
+PUBLIC void csoundDestroyCondVar(void* condVar)
+{
+  if (condVar != NULL) {
+    pthread_cond_destroy((pthread_cond_t*) condVar);
+    free(condVar);
+  }
+}
+
 /* ------------------------------------------------------------------------ */
 
 #elif defined(WIN32)
@@ -684,6 +694,7 @@ PUBLIC void *csoundCreateMutex(int isRecursive)
 
 PUBLIC void csoundLockMutex(void *mutex_)
 {
+  CSP_RT_CHECK("mutex lock");
   EnterCriticalSection((LPCRITICAL_SECTION) mutex_);
 }
 
@@ -781,6 +792,11 @@ PUBLIC void csoundCondSignal(void* condVar) {
     WakeConditionVariable(cv);
 }
 
+PUBLIC void csoundDestroyCondVar(void* condVar)
+{
+    free(condVar);
+}
+
 // REMOVE FOLLOWING BARRIER DEFINITION WINDOWS SUPPORT LIMITED to WIN 8.1+
 typedef struct barrier {
     CRITICAL_SECTION* mut;
@@ -960,6 +976,10 @@ PUBLIC void csoundCondSignal(void* condVar) {
  // notImplementedWarning_("csoundCreateCondSignal");
 }
 
+PUBLIC void csoundDestroyCondVar(void* condVar) {
+ // notImplementedWarning_("csoundDestroyCondVar");
+}
+
 PUBLIC long csoundRunCommand(const char * const *argv, int noWait) {
   //notImplementedWarning_("csoundRunCommand");
     return 0;
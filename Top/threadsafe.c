@@ -21,14 +21,9 @@
 
 #include "csoundCore.h"
 #include "csound_orc.h"
+#include "bus.h"
 #include <stdlib.h>
 
-#ifdef USE_DOUBLE
-#  define MYFLT_INT_TYPE int64_t
-#else
-#  define MYFLT_INT_TYPE int32_t
-#endif
-
 int csoundKillInstanceInternal(CSOUND *csound, MYFLT instr, char *instrName,
                                int mode, int allow_release, int async);
 int csoundCompileTreeInternal(CSOUND *csound, TREE *root, int async);
@@ -505,136 +500,90 @@ int csoundKillInstanceAsync(CSOUND *csound, MYFLT instr, char *instrName,
 MYFLT csoundGetControlChannel(CSOUND *csound, const char *name, int *err)
 {
   MYFLT *pval;
+  MYFLT val = FL(0.0);
   int err_;
-  union {
-    MYFLT d;
-    MYFLT_INT_TYPE i;
-  } x;
-  x.d = FL(0.0);
   if (UNLIKELY(strlen(name) == 0)) return FL(.0);
   if ((err_ = csoundGetChannelPtr(csound, &pval, name,
                                   CSOUND_CONTROL_CHANNEL | CSOUND_OUTPUT_CHANNEL))
       == CSOUND_SUCCESS) {
-#if defined(MSVC)
-    x.i = InterlockedExchangeAdd64((MYFLT_INT_TYPE *)pval, 0);
-#elif defined(HAVE_ATOMIC_BUILTIN)
-    x.i = __atomic_load_n((MYFLT_INT_TYPE *)pval, __ATOMIC_SEQ_CST);
-#else
-    x.d = *pval;
-#endif
+    val = chn_load_control(pval,
+                           (spin_lock_t *) csoundGetChannelLock(csound, name));
   }
   if (err) {
     *err = err_;
   }
-  return x.d;
+  return val;
 }
 
 void csoundSetControlChannel(CSOUND *csound, const char *name, MYFLT val){
   MYFLT *pval;
-  union {
-    MYFLT d;
-    MYFLT_INT_TYPE i;
-  } x;
-  x.d = val;
   if (csoundGetChannelPtr(csound, &pval, name,
                           CSOUND_CONTROL_CHANNEL | CSOUND_INPUT_CHANNEL)
       == CSOUND_SUCCESS)
-
-#if defined(MSVC)
-    InterlockedExchange64((MYFLT_INT_TYPE *)pval, x.i);
-#elif defined(HAVE_ATOMIC_BUILTIN)
-    __atomic_store_n((MYFLT_INT_TYPE *)pval, x.i, __ATOMIC_SEQ_CST);
-#else
-  {
-    spin_lock_t *lock = (spin_lock_t *)
-      csoundGetChannelLock(csound, (char*) name);
-    csoundSpinLock(lock);
-    *pval  = val;
-    csoundSpinUnLock(lock);
-  }
-#endif
+    chn_store_control(pval,
+                      (spin_lock_t *) csoundGetChannelLock(csound, name), val);
 }
 
+/* audio and string channels: see the sequence lock in bus.h; reading
+   never holds up a performance thread writing the channel */
+
 void csoundGetAudioChannel(CSOUND *csound, const char *name, MYFLT *samples)
 {
-
-  MYFLT  *psamples;
+  CHNENTRY *chn;
+  uint32_t seq;
   if (strlen(name) == 0) return;
-  if (csoundGetChannelPtr(csound, &psamples, name,
-                          CSOUND_AUDIO_CHANNEL | CSOUND_OUTPUT_CHANNEL)
-      == CSOUND_SUCCESS) {
-    spin_lock_t *lock = (spin_lock_t *)csoundGetChannelLock(csound, (char*) name);
-    csoundSpinLock(lock);
-    memcpy(samples, psamples, csoundGetKsmps(csound)*sizeof(MYFLT));
-    csoundSpinUnLock(lock);
+  chn = csoundGetChannelHandle(csound, name,
+                               CSOUND_AUDIO_CHANNEL | CSOUND_OUTPUT_CHANNEL);
+  if (chn != NULL) {
+    do {
+      seq = chn_read_begin(chn);
+      memcpy(samples, chn->data, csoundGetKsmps(csound)*sizeof(MYFLT));
+    } while (chn_read_retry(chn, seq));
   }
 }
 
 void csoundSetAudioChannel(CSOUND *csound, const char *name, MYFLT *samples)
 {
-  MYFLT  *psamples;
-  if (csoundGetChannelPtr(csound, &psamples, name,
-                          CSOUND_AUDIO_CHANNEL | CSOUND_INPUT_CHANNEL)
-      == CSOUND_SUCCESS){
-    spin_lock_t *lock = (spin_lock_t *)csoundGetChannelLock(csound, (char*) name);
-    csoundSpinLock(lock);
-    memcpy(psamples, samples, csoundGetKsmps(csound)*sizeof(MYFLT));
-    csoundSpinUnLock(lock);
+  CHNENTRY *chn;
+  chn = csoundGetChannelHandle(csound, name,
+                               CSOUND_AUDIO_CHANNEL | CSOUND_INPUT_CHANNEL);
+  if (chn != NULL) {
+    chn_write_begin(chn);
+    memcpy(chn->data, samples, csoundGetKsmps(csound)*sizeof(MYFLT));
+    chn_write_end(chn);
   }
 }
 
 void csoundSetStringChannel(CSOUND *csound, const char *name, char *string)
 {
-  MYFLT  *pstring;
-
-  if (csoundGetChannelPtr(csound, &pstring, name,
-                          CSOUND_STRING_CHANNEL | CSOUND_INPUT_CHANNEL)
-      == CSOUND_SUCCESS){
-
-    STRINGDAT* stringdat = (STRINGDAT*) pstring;
-    int    size = stringdat->size; //csoundGetChannelDatasize(csound, name);
-    spin_lock_t *lock = (spin_lock_t *) csoundGetChannelLock(csound, (char*) name);
-
-    if (lock != NULL) {
-      csoundSpinLock(lock);
-    }
-
-    if (strlen(string) + 1 > (unsigned int) size) {
-      if (stringdat->data!=NULL) csound->Free(csound,stringdat->data);
-      stringdat->data = cs_strdup(csound, string);
-      stringdat->size = strlen(string) + 1;
-      //set_channel_data_ptr(csound,name,(void*)pstring, strlen(string)+1);
-    } else {
-      strcpy((char *) stringdat->data, string);
-    }
-
-    if (lock != NULL) {
-      csoundSpinUnLock(lock);
-    }
-  }
+  CHNENTRY *chn;
+  chn = csoundGetChannelHandle(csound, name,
+                               CSOUND_STRING_CHANNEL | CSOUND_INPUT_CHANNEL);
+  if (chn != NULL && string != NULL)
+    chn_string_set(csound, chn, string);
 }
 
 void csoundGetStringChannel(CSOUND *csound, const char *name, char *string)
 {
-  MYFLT  *pstring;
+  CHNENTRY *chn;
+  STRINGDAT *sd;
+  uint32_t seq;
+  int i, n;
   char *chstring;
-  int n2;
-  if (strlen(name) == 0) return;
-  if (csoundGetChannelPtr(csound, &pstring, name,
-                          CSOUND_STRING_CHANNEL | CSOUND_OUTPUT_CHANNEL)
-      == CSOUND_SUCCESS){
-    spin_lock_t *lock = (spin_lock_t *) csoundGetChannelLock(csound, (char*) name);
-    chstring = ((STRINGDAT *) pstring)->data;
-    if (lock != NULL)
-      csoundSpinLock(lock);
-    if (string != NULL && chstring != NULL) {
-      n2 = strlen(chstring);
-      strNcpy(string,chstring, n2+1);
-      //string[n2] = '\0';
-    }
-    if (lock != NULL)
-      csoundSpinUnLock(lock);
-  }
+  if (strlen(name) == 0 || string == NULL) return;
+  chn = csoundGetChannelHandle(csound, name,
+                               CSOUND_STRING_CHANNEL | CSOUND_OUTPUT_CHANNEL);
+  if (chn == NULL) return;
+  sd = (STRINGDAT *) chn->data;
+  /* string is as large as csoundGetChannelDatasize said */
+  do {
+    seq = chn_read_begin(chn);
+    n = chn_string_size(sd);
+    chstring = chn_string_data(sd);
+    for (i = 0; i < n-1 && chstring[i] != '\0'; i++)
+      string[i] = chstring[i];
+    string[i] = '\0';
+  } while (chn_read_retry(chn, seq));
 }
 
 PUBLIC int csoundSetPvsChannel(CSOUND *csound, const PVSDATEXT *fin,
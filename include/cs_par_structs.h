@@ -67,4 +67,47 @@ typedef struct _watchList {
                      sizeof(struct _watchList *))) / sizeof(uint8_t)];
 } watchList;
 
+/* Task dispatch policies, selected with --dag-scheduler */
+enum { DAG_SCHED_SCAN = 0,         /* scan the status array for work */
+       DAG_SCHED_STEAL = 1,        /* per-thread deques with stealing */
+       DAG_SCHED_COST = 2 };       /* as STEAL, placed by cost and affinity */
+
+/* scheduling policy for performance threads (--thread-sched) */
+enum { CSP_SCHED_OTHER = 0, CSP_SCHED_FIFO = 1, CSP_SCHED_RR = 2 };
+
+/* Per-thread deque of ready tasks (Chase-Lev).  The owning thread pushes
+ * and pops at the bottom, idle threads steal from the top.  The buffer is
+ * as large as the task table and both ends are reset every k-cycle, so it
+ * never wraps.  top and bottom live on separate cache lines as one is
+ * written by thieves and the other by the owner. */
+typedef struct _dagDeque {
+  volatile long top;
+  uint8_t padding1 [(CONCURRENTPADDING - sizeof(long)) / sizeof(uint8_t)];
+  volatile long bottom;
+  uint8_t padding2 [(CONCURRENTPADDING - sizeof(long)) / sizeof(uint8_t)];
+  taskID *tasks;
+  uint8_t padding3 [(CONCURRENTPADDING - sizeof(taskID *)) / sizeof(uint8_t)];
+} dagDeque;
+
+/* A buffer that tasks only add into (spout, a chnmix channel, a global
+ * audio variable written with +=).  Each thread other than the main one
+ * mixes into its own scratch block, and the blocks are added into the
+ * target before any task that reads or writes the global named by gid
+ * runs, and at the end of the k-cycle.  The DAG keeps such tasks apart
+ * from the ones mixing in, so the target is never written concurrently. */
+typedef struct dag_accum_t {
+  MYFLT   *target;
+  int     size;                 /* MYFLTs in target */
+  int     stride;               /* MYFLTs between scratch blocks */
+  int     threads;
+  int     gid;                  /* semantic global id, or -1 */
+  char    *name;                /* the global, "##chn:name" for a channel */
+  int     nglobals;             /* globals numbered when gid was found */
+  MYFLT   *scratch;             /* threads blocks of stride */
+  volatile int *dirty;          /* scratch block t holds data */
+  volatile int pending;         /* some block holds data */
+  spin_lock_t lock;
+  struct dag_accum_t *next;
+} DAG_ACCUM;
+
 #endif
@@ -510,6 +510,28 @@ extern "C" {
     int     daemon;  /* daemon mode */
     int     ksmps_override; /* ksmps override */
     int     FFT_library;    /* fft_lib */
+    int     dag_scheduler;  /* multicore dispatch, 0: scan, 1: work stealing,
+                               2: stealing placed by cost */
+    int     barrier_spin;   /* barrier spin count before parking */
+    int     adaptive_threads; /* vary worker count with the load (0/1) */
+    int     thread_numa;    /* NUMA node for performance threads,
+                               -1: leave unchanged */
+    int     thread_sched;   /* 0: default, 1: SCHED_FIFO, 2: SCHED_RR */
+    int     thread_priority; /* real-time priority for thread_sched */
+    int     dag_report;     /* report the DAG critical path (0/1) */
+    int     profile_interval; /* time opcodes every Nth k-cycle, 0: off */
+    MYFLT   kcycle_deadline; /* fraction of ksmps/sr counted as a miss */
+    int     instance_prewarm; /* free instances made for each instrument */
+    int     aux_strict;     /* report init-time AuxAlloc outside the arena */
+    int     mem_report;     /* account and report memory per owner (0/1) */
+    int     rt_memory;      /* lock and pre-fault memory, count faults */
+    int     expr_fusion;    /* 0: off, 1: fuse a-rate expressions (default),
+                               2: also reassociate */
+    int     tree_opt;       /* optimize instrument code (0/1) */
+    int     opt_report;     /* print what the optimizer changed and the
+                               size of each instance (0/1) */
+    int     udo_inline;     /* inline UDOs of up to this many statements,
+                               0: off */
   } CSOUND_PARAMS;
 
   /**
@@ -656,6 +678,85 @@ extern "C" {
     controlChannelHints_t    hints;
   } controlChannelInfo_t;
 
+  /**
+   * One line of the opcode profile (see csoundGetOpcodeProfile()).
+   * calls and seconds cover only the timed k-cycles.
+   */
+  typedef struct {
+    const char *opname;
+    const char *instr;          /* instrument or UDO name, NULL if numbered */
+    int     insno;
+    int     line;               /* orchestra line of the statement */
+    uint64_t calls;
+    double  seconds;
+  } CS_OPCODE_PROFILE;
+
+  /**
+   * Phases of a k-cycle timed by csoundGetKcycleTiming()
+   */
+  typedef enum {
+    CS_KCYCLE_TOTAL = 0,        /* the whole k-cycle */
+    CS_KCYCLE_SENSEVENTS = 1,   /* score and real-time events */
+    CS_KCYCLE_CHAIN = 2,        /* the active instruments */
+    CS_KCYCLE_SPOUT = 3,        /* sending the output (spoutran) */
+    CS_KCYCLE_PHASES = 4
+  } csKcyclePhase;
+
+  /**
+   * Summary of the k-cycle time histogram of one phase.  The
+   * percentiles are the upper edges of histogram buckets, which are an
+   * eighth of an octave wide.  All times are in seconds.
+   */
+  typedef struct {
+    uint64_t cycles;            /* k-cycles measured */
+    uint64_t misses;            /* k-cycles longer than deadline */
+    double  deadline;           /* --kcycle-deadline of ksmps/sr */
+    double  mean;
+    double  max;
+    double  p50, p99, p999;
+    /* page faults during k-cycles, counted only with --rt-memory */
+    uint64_t minor_faults;
+    uint64_t major_faults;
+    uint64_t fault_cycles;      /* k-cycles that took any */
+  } CS_KCYCLE_TIMING;
+
+  /**
+   * Owners of memory counted by csoundSetMemoryAccounting()
+   */
+  typedef enum {
+    CS_MEM_OTHER = 0,           /* not attributed */
+    CS_MEM_INSTRUMENT = 1,      /* instances and init-time allocations */
+    CS_MEM_OPCODE = 2,          /* AuxAlloc space, per statement */
+    CS_MEM_FTABLES = 3,
+    CS_MEM_CHANNELS = 4,
+    CS_MEM_STRINGS = 5,         /* names and strings of the compiler */
+    CS_MEM_KINDS = 6
+  } csMemoryOwner;
+
+  /**
+   * Memory held by one owner (see csoundGetMemoryUsage()).  insno and
+   * instr are set for CS_MEM_INSTRUMENT and CS_MEM_OPCODE, opname for
+   * CS_MEM_OPCODE.
+   */
+  typedef struct {
+    int     kind;               /* a csMemoryOwner */
+    const char *instr;          /* instrument or UDO name, NULL if numbered */
+    int     insno;
+    const char *opname;
+    int64_t current;            /* bytes */
+    int64_t peak;
+  } CS_MEMORY_USAGE;
+
+  /**
+   * Opaque handle to a channel, see csoundGetChannelHandle().
+   */
+  typedef struct channelEntry_s CS_CHANNEL;
+
+  /* receives a batch of channels written since the last dispatch */
+  typedef void (*channelChangeCallback_t)(CSOUND *csound,
+                                          CS_CHANNEL *const *chn, int n,
+                                          void *userData);
+
   typedef void (*channelCallback_t)(CSOUND *csound,
                                     const char *channelName,
                                     void *channelValuePtr,
@@ -1015,6 +1116,92 @@ extern "C" {
    */
   PUBLIC int64_t csoundGetCurrentTimeSamples(CSOUND *csound);
 
+  /**
+   * Returns the number of threads taking part in the current k-cycle.
+   * With -j N this is N, or between 1 and N following the orchestra
+   * load when --adaptive-threads=1 is given. It is 1 without -j.
+   */
+  PUBLIC int csoundGetActiveThreads(CSOUND *csound);
+
+  /**
+   * Times every opcode call on one k-cycle in interval, adding the time
+   * to a profile kept per opcode, instrument and orchestra line; 0
+   * turns profiling off.  Same as --profile=N.  Off, it costs one test
+   * per opcode call.
+   */
+  PUBLIC void csoundSetOpcodeProfiling(CSOUND *csound, int interval);
+
+  /**
+   * Returns the opcode profile in *lst, most expensive first, and the
+   * number of entries, which is zero if nothing has been timed.  The
+   * list must be freed with csoundDeleteOpcodeProfile(); the name
+   * pointers become invalid after csoundReset().
+   */
+  PUBLIC int csoundGetOpcodeProfile(CSOUND *csound, CS_OPCODE_PROFILE **lst);
+
+  /**
+   * Releases a list returned by csoundGetOpcodeProfile().
+   */
+  PUBLIC void csoundDeleteOpcodeProfile(CSOUND *csound,
+                                        CS_OPCODE_PROFILE *lst);
+
+  /**
+   * Fills *t with the wall time taken by a phase (a csKcyclePhase) of
+   * each k-cycle since csoundStart() or csoundResetKcycleTiming(), and
+   * the number of cycles that missed the deadline.  Can be called from
+   * any thread while performing without taking a lock.  Returns
+   * CSOUND_SUCCESS, or CSOUND_ERROR before csoundStart() or for an
+   * unknown phase.
+   */
+  PUBLIC int csoundGetKcycleTiming(CSOUND *csound, int phase,
+                                   CS_KCYCLE_TIMING *t);
+
+  /**
+   * Copies up to n buckets of the k-cycle time histogram of a phase into
+   * counts, and the upper edge of each bucket in seconds into upper if
+   * that is not NULL.  Returns the number of buckets copied, or
+   * CSOUND_ERROR.
+   */
+  PUBLIC int csoundGetKcycleHistogram(CSOUND *csound, int phase,
+                                      uint64_t *counts, double *upper, int n);
+
+  /**
+   * Clears the k-cycle timing; the performing thread does this at the
+   * end of its next k-cycle.
+   */
+  PUBLIC void csoundResetKcycleTiming(CSOUND *csound);
+
+  /**
+   * Counts the memory allocated through csound->Malloc and friends per
+   * owner: each instrument, each opcode statement calling AuxAlloc, and
+   * the function tables, channels and strings.  Same as --mem-report,
+   * which also prints the counts at the end.  Blocks allocated while
+   * accounting is off are not counted, so turn it on before compiling.
+   */
+  PUBLIC void csoundSetMemoryAccounting(CSOUND *csound, int on);
+
+  /**
+   * Returns the memory held by each owner in *lst, largest peak first,
+   * and the number of entries.  The list must be freed with
+   * csoundDeleteMemoryUsage(); the name pointers become invalid after
+   * csoundReset().
+   */
+  PUBLIC int csoundGetMemoryUsage(CSOUND *csound, CS_MEMORY_USAGE **lst);
+
+  /**
+   * Releases a list returned by csoundGetMemoryUsage().
+   */
+  PUBLIC void csoundDeleteMemoryUsage(CSOUND *csound, CS_MEMORY_USAGE *lst);
+
+  /**
+   * Sets the current and peak bytes held by all owners of a kind (a
+   * csMemoryOwner), or by all owners if kind is CS_MEM_KINDS.  The peak
+   * of a kind is that of its sum, not the sum of the peaks.  Returns
+   * CSOUND_ERROR if accounting was never turned on.
+   */
+  PUBLIC int csoundGetMemoryTotal(CSOUND *csound, int kind,
+                                  int64_t *current, int64_t *peak);
+
   /**
    * Return the size of MYFLT in bytes.
    */
@@ -1675,10 +1862,16 @@ extern "C" {
    * 2) For string and audio channels (and controls if option 1 is not
    *    available), retrieve the channel lock with csoundGetChannelLock()
    *    and use csoundSpinLock() and csoundSpinUnLock() to protect access
-   *    to **p.
+   *    to **p.  Csound normally reads audio and string channels without
+   *    their lock; once csoundGetChannelLock() has been called for such a
+   *    channel, its readers (chnget and the functions below) take the
+   *    lock too, so a host writing under it, or replacing the buffer of
+   *    a string channel, is never seen half done.  The readers of that
+   *    channel then wait for the host while it holds the lock.
    * See Top/threadsafe.c in the Csound library sources for
    * examples.  Optionally, use the channel get/set functions
-   * provided below, which are threadsafe by default.
+   * provided below, which are threadsafe by default and keep reading
+   * lock-free.
    */
   PUBLIC int csoundGetChannelPtr(CSOUND *,
                                  MYFLT **p, const char *name, int type);
@@ -1730,7 +1923,9 @@ extern "C" {
   /**
    * Recovers a pointer to a lock for the specified channel called 'name'.
    * The returned lock can be locked/unlocked  with the csoundSpinLock()
-   * and csoundSpinUnLock() functions.
+   * and csoundSpinUnLock() functions.  For an audio or string channel
+   * this also makes Csound take the lock when it reads the channel
+   * (see csoundGetChannelPtr()).
    * @returns the address of the lock or NULL if the channel does not exist
    */
   PUBLIC int *csoundGetChannelLock(CSOUND *, const char *name);
@@ -1786,6 +1981,90 @@ extern "C" {
    */
   PUBLIC int csoundGetChannelDatasize(CSOUND *csound, const char *name);
 
+  /**
+   * Returns a handle to the channel called 'name', creating it if it
+   * does not exist, as csoundGetChannelPtr() does for the same type.
+   * Returns NULL if the name is invalid, or the channel exists with a
+   * different type.  Looking the name up once and then reading or
+   * writing through the handle avoids hashing the name on every call.
+   * The handle is valid until csoundReset() or csoundDestroy(), which
+   * free the channels; it must not be used after either, and a new
+   * handle must be taken once the orchestra is compiled again.
+   */
+  PUBLIC CS_CHANNEL *csoundGetChannelHandle(CSOUND *csound,
+                                            const char *name, int type);
+
+  /**
+   * Returns the value of the control channel chn.  The value is read
+   * with an atomic load, without taking the channel lock.  chn must be
+   * a control channel handle; debug builds warn and return zero
+   * for one of another type.
+   */
+  PUBLIC MYFLT csoundGetControlChannelByHandle(CSOUND *csound,
+                                               CS_CHANNEL *chn);
+
+  /**
+   * Sets the control channel chn to val with an atomic store.  chn must
+   * be a control channel handle; debug builds warn and ignore one of
+   * another type.
+   */
+  PUBLIC void csoundSetControlChannelByHandle(CSOUND *csound,
+                                              CS_CHANNEL *chn, MYFLT val);
+
+  /**
+   * Reads the n control channels chn[0..n-1] into values[0..n-1].
+   * A NULL handle reads as zero.  Each value is read atomically, but
+   * the n values are not a snapshot taken at one instant.
+   */
+  PUBLIC void csoundGetControlChannelBatch(CSOUND *csound,
+                                           CS_CHANNEL *const *chn,
+                                           MYFLT *values, int n);
+
+  /**
+   * Sets the n control channels chn[0..n-1] to values[0..n-1].  NULL
+   * handles are skipped.
+   */
+  PUBLIC void csoundSetControlChannelBatch(CSOUND *csound,
+                                           CS_CHANNEL *const *chn,
+                                           const MYFLT *values, int n);
+
+  /**
+   * Stores in chn[0..] up to max channels that the orchestra has written
+   * (chnset, chnmix, chnclear) since they were last returned, and
+   * returns how many were stored.  A control or string channel counts
+   * only if its value changed.  Channels that did not fit are returned
+   * by the next call.  Writes by the host are not reported.  The cost
+   * is in the number of channels that changed, not the number there
+   * are, so a host can call this every k-cycle instead of polling each
+   * output channel.  The list is kept without locks and may be taken
+   * from any one thread while the performance runs; a channel written
+   * again after it was returned is reported again.
+   */
+  PUBLIC int csoundGetChangedChannels(CSOUND *csound,
+                                      CS_CHANNEL **chn, int max);
+
+  /**
+   * As csoundGetChangedChannels(), but hands all the changed channels
+   * to func, in batches of up to 64, in the calling thread.  Called
+   * from a host thread, such as a GUI timer, this delivers changes off
+   * the audio thread.  Returns the number of channels delivered.
+   */
+  PUBLIC int csoundDispatchChangedChannels(CSOUND *csound,
+                                           channelChangeCallback_t func,
+                                           void *userData);
+
+  /**
+   * Returns the name of the channel chn.
+   */
+  PUBLIC const char *csoundGetChannelHandleName(CSOUND *csound,
+                                                CS_CHANNEL *chn);
+
+  /**
+   * Returns the type and direction bits of the channel chn, as
+   * csoundListChannels() reports them.
+   */
+  PUBLIC int csoundGetChannelHandleType(CSOUND *csound, CS_CHANNEL *chn);
+
   /** Sets the function which will be called whenever the invalue opcode
    * is used. */
   PUBLIC void
@@ -2243,6 +2522,9 @@ extern "C" {
   /** Signals a conditional variable */
   PUBLIC void csoundCondSignal(void* condVar);
 
+  /** Destroys a conditional variable made by csoundCreateCondVar() */
+  PUBLIC void csoundDestroyCondVar(void* condVar);
+
   /**
    * Waits for at least the specified number of milliseconds,
    * yielding the CPU to other threads.
@@ -262,6 +262,25 @@ typedef struct CORFIL {
     int     ksmps_override;
     int     fft_lib;
     int     echo;
+    int     dagScheduler;   /* multicore task dispatch policy (DAG_SCHED_*) */
+    int     barrierSpin;    /* spins before a waiting thread parks */
+    int     adaptiveThreads; /* let the DAG size pick the worker count */
+    char    *threadCpus;    /* CPU list for performance threads, or NULL */
+    int     threadNuma;     /* NUMA node for threads and memory, -1: none */
+    int     threadSched;    /* CSP_SCHED_* policy for performance threads */
+    int     threadPriority; /* real-time priority, 0: lowest */
+    int     dagReport;      /* print the DAG critical path at the end */
+    int     profileInterval; /* time opcodes every Nth k-cycle, 0: off */
+    double  kcycleDeadline; /* fraction of ksmps/sr a k-cycle may take */
+    int     instancePrewarm; /* free instances made for each instrument */
+    int     auxStrict;      /* report AuxAlloc at init outside the arena */
+    int     memReport;      /* print memory use per owner at the end */
+    int     rtMemory;       /* lock, pre-fault and count page faults */
+    int     exprFusion;     /* 0: off, 1: fuse a-rate expressions,
+                               2: and regroup their k-rate factors */
+    int     treeOpt;        /* fold, share, hoist and remove dead code */
+    int     optReport;      /* print optimizer changes and instance sizes */
+    int     udoInline;      /* inline UDOs of up to this many statements */
   } OPARMS;
 
   typedef struct arglst {
@@ -345,6 +364,9 @@ typedef struct CORFIL {
     int     instcnt;                /* Count number of instances ever */
     int     isNew;                  /* is this a new definition */
     int     nocheckpcnt;            /* Control checks on pcnt */
+    struct instr_pool_t *pool;      /* slabs the instances are cut from */
+    struct aux_pool_t *auxpool;     /* AuxAlloc regions for its instances */
+    int     memowner;               /* memory accounting owner + 1 */
   } INSTRTXT;
 
   typedef struct namedInstr {
@@ -361,6 +383,8 @@ typedef struct CORFIL {
   typedef struct op {
     struct op *nxtop;
     TEXT    t;
+    int     prof;                   /* profile entry + 1, 0 until timed */
+    int     memowner;               /* memory accounting owner + 1 */
   } OPTXT;
 
   typedef struct fdch {
@@ -496,6 +520,15 @@ typedef struct CORFIL {
       MYFLT   p[2];
     } c;
   } EVTBLK;
+  /**
+   * A performance-time opcode of an instance and the function it runs,
+   * in chain order; see INSDS_PRIV.
+   */
+  typedef struct opdisp {
+    int     (*opadr)(CSOUND *, void *);
+    struct opds *op;
+  } OPDISP;
+
   /**
    * This struct holds the info for a concrete instrument event
    * instance in performance.
@@ -579,6 +612,34 @@ typedef struct CORFIL {
     CS_VAR_MEM  p3;
   } INSDS;
 
+#ifdef __BUILDING_LIBCSOUND
+  /**
+   * Engine state of an instance, kept in front of its INSDS by
+   * instance() so that neither INSDS nor the p-field offsets change for
+   * plugins.  Only instances made by instance() have it, not the
+   * actanchor list head.
+   */
+  typedef struct insds_priv {
+    size_t   blksiz;       /* size of its pool block, with this */
+    int      dag_slot;     /* task id in the multicore DAG */
+    int      dag_thread;   /* thread that last ran it */
+    double   dag_cost;     /* smoothed run time per k-cycle (seconds) */
+    char    *auxarena;     /* AuxAlloc region of this instance */
+    char    *auxnext, *auxend; /* uncut part of it */
+    size_t   auxreq;       /* bytes of its live AuxAlloc blocks */
+    /* The nxtp chain as an array, so the performance loop need not
+       follow the links; the functions are copied after an init pass,
+       which may change them, and disp_ready is cleared before one */
+    OPDISP  *disp;
+    int      ndisp;
+    int      disp_ready;
+  } INSDS_PRIV;
+
+  /* keeps the INSDS after it 16-aligned */
+#define INSDS_PRIV_SIZE ((sizeof(INSDS_PRIV) + 15) & ~((size_t) 15))
+#define INSDS_PRIV(ip)  ((INSDS_PRIV*) ((char*) (ip) - INSDS_PRIV_SIZE))
+#endif
+
 #define CS_KSMPS     (p->h.insdshead->ksmps)
 #define CS_KCNT      (p->h.insdshead->kcounter)
 #define CS_EKR       (p->h.insdshead->ekr)
@@ -926,6 +987,11 @@ typedef struct NAME__ {
     CS_VAR_POOL* in_arg_pool;
     INSTRTXT *ip;
     struct opcodinfo *prv;
+    /* inputs the body reads from the caller's argument instead of a
+       copy (NULL entries for those copied), and the number of opcode
+       arguments in the body reading them */
+    CS_VARIABLE **byref;
+    int     byref_slots;
   } OPCODINFO;
 
   /**
@@ -1745,7 +1811,7 @@ typedef struct _message_queue_t_ {
     volatile stateWithPadding    *dag_task_status;
     watchList     * volatile *dag_task_watch;
     watchList     *dag_wlmm;
-    char          **dag_task_dep;
+    uint64_t      *dag_task_dep;   /* dependency bit matrix, by task */
     int           dag_task_max_size;
     uint32_t      tempStatus;    /* keeps track of which files are temps */
     int           orcLineOffset; /* 1 less than 1st orch line in the CSD */
@@ -1795,6 +1861,58 @@ typedef struct _message_queue_t_ {
     volatile unsigned long message_string_queue_items;
     unsigned long message_string_queue_wp;
     message_string_queue_t *message_string_queue;
+    /* work-stealing dispatcher (cs_new_dispatch.c) */
+    dagDeque      *dag_deques;          /* one ready deque per thread */
+    int           dag_deque_size;       /* capacity of each deque */
+    volatile int  dag_num_remaining;    /* tasks not yet ended this k-cycle */
+    /* incremental DAG maintenance (cs_new_dispatch.c) */
+    int           dag_dep_words;        /* words in a dependency row */
+    int           dag_num_live;         /* occupied task slots */
+    struct instr_semantics_t **dag_task_sem;
+    int           *dag_task_rank;       /* position in the active chain */
+    uint32_t      *dag_task_epoch;      /* last dag_update that saw the task */
+    uint32_t      dag_epoch;
+    INSDS         **dag_pending;        /* instances new to the DAG */
+    /* numbering of globals for the semantic bitsets */
+    CS_HASH_TABLE *dag_global_ids;
+    int           dag_num_globals;
+    /* adaptive worker count (cs_new_dispatch.c) */
+    volatile int  dag_active_threads;   /* threads taking part this k-cycle */
+    int           dag_num_ready;        /* tasks ready at the cycle start */
+    double        dag_task_cost;        /* smoothed seconds per task */
+    void          **dag_idle_locks;     /* a mutex per worker thread, then
+                                           a condition variable per one */
+    volatile int  *dag_idle_parked;
+    /* cost-based placement and makespan counters (cs_new_dispatch.c) */
+    INSDS         **dag_ready;          /* ready tasks, sorted by cost */
+    int           *dag_ready_to;        /* thread chosen for each */
+    double        *dag_thread_stats;    /* work, longest task, load */
+    int           dag_timing;           /* time tasks this k-cycle */
+    int           dag_cycle_threads;    /* threads taking part */
+    int64_t       dag_stat_cycles;
+    double        dag_stat_makespan;    /* sum of parallel section times */
+    double        dag_stat_bound;       /* sum of lower bounds on them */
+    double        dag_stat_work;        /* sum of task times */
+    /* thread placement (cs_par_base.c) */
+    int           *thread_cpus;         /* parsed --thread-cpus/--thread-numa */
+    int           thread_ncpus;
+    int           perf_thread_placed;   /* performing thread has been placed */
+    /* accumulate-only buffers (cs_new_dispatch.c) */
+    DAG_ACCUM     * volatile dag_accums;
+    DAG_ACCUM     *dag_spout;           /* the one for spraw */
+    struct dag_report_t *dag_report;    /* --dag-report (cs_new_dispatch.c) */
+    /* opcode profiling (profile.c) */
+    int           prof_cycle;           /* this k-cycle is timed */
+    int           prof_countdown;       /* k-cycles to the next timed one */
+    struct cs_profile_t *profile;
+    struct cs_ktiming_t *ktiming;       /* k-cycle timing (profile.c) */
+    int           inst_prewarm;         /* instances being made ahead */
+    struct cs_memacct_t *memacct;       /* memory accounting (memalloc.c) */
+    int           mem_owner;            /* owner of new blocks */
+    struct cs_rtcheck_t *rtcheck;       /* CS_RT_CHECK violations (rtcheck.c) */
+    /* channels written by the orchestra since the host asked (bus.c) */
+    struct channelEntry_s * volatile chn_changed;
+    spin_lock_t   chn_changed_lock;     /* without atomic operations */
     /*struct CSOUND_ **self;*/
     /**@}*/
 #endif  /* __BUILDING_LIBCSOUND */
@@ -28,22 +28,32 @@
 extern "C" {
 #endif
 
-#define HASH_SIZE 4099
-
 typedef struct _cons {
     void* value; // should be car, but using value
     struct _cons* next; // should be cdr, but to follow csound
     // linked list conventions
 } CONS_CELL;
 
+/* The hash table uses open addressing with linear probing.  Each slot
+   holds the hash of its key, which is compared before the strings.
+   This replaced the HASH_SIZE chained buckets in API version 17; code
+   built against the old layout must be rebuilt, and should go through
+   the cs_hash_table_* functions rather than these members. */
 typedef struct _cs_hash_bucket_item {
-    char* key;
+    char* key;                  /* NULL for an empty slot */
     void* value;
-    struct _cs_hash_bucket_item* next;
+    unsigned int hash;
 } CS_HASH_TABLE_ITEM;
 
+typedef struct _cs_hash_slots {
+    unsigned int mask;          /* number of slots - 1, a power of two */
+    struct _cs_hash_slots* retired; /* the smaller slot arrays replaced */
+    CS_HASH_TABLE_ITEM items[1];
+} CS_HASH_SLOTS;
+
 typedef struct _cs_hash_table {
-    CS_HASH_TABLE_ITEM* buckets[HASH_SIZE];
+    CS_HASH_SLOTS* volatile slots;
+    unsigned int count;         /* keys held */
 } CS_HASH_TABLE;
 
 /* FUNCTIONS FOR CONS CELL */
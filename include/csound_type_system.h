@@ -59,6 +59,9 @@ extern "C" {
 #define CS_VAR_TYPE_OFFSET (sizeof(CS_VAR_MEM) - sizeof(MYFLT))
 #endif
 
+/* alignment of the a-rate variables of an instance, for SIMD loads */
+#define CS_VAR_ALIGN 32
+
     typedef struct csvariable {
         char* varName;
         CS_TYPE* varType;
@@ -116,6 +119,8 @@ extern "C" {
         struct csvarpool* parent;
         int varCount;
         int synthArgCount;
+        int blockSize; /* bytes of an instance's local variables, with
+                          type headers and alignment padding */
     } CS_VAR_POOL;
 
     PUBLIC CS_VAR_POOL* csoundCreateVarPool(CSOUND* csound);
@@ -38,6 +38,8 @@
 #define _CR (0x0020)
 #define _CW (0x0040)
 #define _CB (0x0060)
+/* only mixes into a channel (chnmix); such writes commute */
+#define _CA (0x0800)
 
 //Stack
 #define SK (0x0080)
@@ -50,6 +52,13 @@
 #define IW (0x0400)
 #define IB (0x0600)
 
+// Which input names the table or channel: _AN(n) for input n (0 to 5),
+// _AL for every input.  When that input is a constant the analysis
+// tracks the one table or channel; otherwise all of them.
+#define _AN(n) ((((n)+1)&7)<<12)
+#define _AL (0x7000)
+#define ANPOS(code) ((((code)>>12)&7)-1)
+
 //Deprecated
 #define _QQ (0x8000)
 
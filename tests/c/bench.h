@@ -0,0 +1,62 @@
+/*
+ * File:   bench.h
+ *
+ * Shared by the *_bench.c programs, which are built with the tests but
+ * not run by ctest.  None of them is a pass/fail test: each prints
+ * timings, to be compared between builds before and after a change.
+ */
+
+#ifndef CSOUND_TESTS_BENCH_H
+#define CSOUND_TESTS_BENCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "csound.h"
+
+static inline void bench_init(void)
+{
+    csoundInitialize(CSOUNDINIT_NO_SIGNAL_HANDLER | CSOUNDINIT_NO_ATEXIT);
+}
+
+/* a quiet instance with no audio output, running orc and the optional
+   score sco, with the options in the NULL-terminated list opts; the
+   first k-cycle, which runs the init pass of the instances, is done */
+static inline CSOUND *bench_start(const char *orc, const char *sco,
+                                  const char *const *opts)
+{
+    CSOUND  *csound = csoundCreate(NULL);
+
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-m0");
+    csoundSetOption(csound, "-d");
+    for ( ; opts != NULL && *opts != NULL; opts++)
+      csoundSetOption(csound, (char *) *opts);
+    if (csoundCompileOrc(csound, orc) != 0 ||
+        (sco != NULL && csoundReadScore(csound, sco) != 0) ||
+        csoundStart(csound) != 0) {
+      fprintf(stderr, "could not start csound\n");
+      exit(1);
+    }
+    csoundPerformKsmps(csound);
+    return csound;
+}
+
+/* wall time in seconds of kcycles k-cycles */
+static inline double bench_perform(CSOUND *csound, long kcycles)
+{
+    RTCLOCK  clk;
+    long     k;
+
+    csoundInitTimerStruct(&clk);
+    for (k = 0; k < kcycles; k++)
+      if (csoundPerformKsmps(csound) != 0) break;
+    return csoundGetRealTime(&clk);
+}
+
+static inline void bench_end(CSOUND *csound)
+{
+    csoundCleanup(csound);
+    csoundDestroy(csound);
+}
+
+#endif
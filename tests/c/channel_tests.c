@@ -233,6 +233,136 @@ void test_channel_opcodes(void)
     csoundDestroy(csound);
 }
 
+const char orc_handles[] = "chn_k \"gain\", 1\n"
+        "chn_k \"out\", 2\n"
+        "instr 1\n"
+        "kg chnget \"gain\"\n"
+        "chnset kg * 2, \"out\"\n"
+        "endin\n";
+
+void test_channel_handles(void)
+{
+    csoundSetGlobalEnv("OPCODE6DIR64", "../../");
+    CSOUND *csound = csoundCreate(0);
+    csoundCreateMessageBuffer(csound, 0);
+    csoundSetOption(csound, "--logfile=null");
+    csoundCompileOrc(csound, orc_handles);
+    int err = csoundStart(csound);
+    CU_ASSERT(err == CSOUND_SUCCESS);
+
+    CS_CHANNEL *gain = csoundGetChannelHandle(csound, "gain",
+                          CSOUND_CONTROL_CHANNEL | CSOUND_INPUT_CHANNEL);
+    CS_CHANNEL *out = csoundGetChannelHandle(csound, "out",
+                          CSOUND_CONTROL_CHANNEL | CSOUND_OUTPUT_CHANNEL);
+    CU_ASSERT_PTR_NOT_NULL(gain);
+    CU_ASSERT_PTR_NOT_NULL(out);
+    CU_ASSERT_PTR_EQUAL(gain, csoundGetChannelHandle(csound, "gain",
+                          CSOUND_CONTROL_CHANNEL));
+    CU_ASSERT_PTR_NULL(csoundGetChannelHandle(csound, "gain",
+                          CSOUND_AUDIO_CHANNEL));
+
+    csoundSetControlChannelByHandle(csound, gain, 3.0);
+    CU_ASSERT_EQUAL(3.0, csoundGetControlChannel(csound, "gain", NULL));
+    MYFLT pFields[] = {1.0, 0.0, 1.0};
+    csoundScoreEvent(csound, 'i', pFields, 3);
+    csoundPerformKsmps(csound);
+    CU_ASSERT_EQUAL(6.0, csoundGetControlChannelByHandle(csound, out));
+
+    /* batches, with a NULL handle in the middle */
+    CS_CHANNEL *chn[3];
+    MYFLT vals[3] = {1.0, 2.0, 4.0}, got[3];
+    chn[0] = gain;
+    chn[1] = NULL;
+    chn[2] = csoundGetChannelHandle(csound, "other",
+                          CSOUND_CONTROL_CHANNEL | CSOUND_INPUT_CHANNEL);
+    csoundSetControlChannelBatch(csound, chn, vals, 3);
+    csoundGetControlChannelBatch(csound, chn, got, 3);
+    CU_ASSERT_EQUAL(1.0, got[0]);
+    CU_ASSERT_EQUAL(0.0, got[1]);
+    CU_ASSERT_EQUAL(4.0, got[2]);
+    csoundPerformKsmps(csound);
+    CU_ASSERT_EQUAL(2.0, csoundGetControlChannel(csound, "out", NULL));
+
+    csoundCleanup(csound);
+    csoundDestroyMessageBuffer(csound);
+    csoundDestroy(csound);
+}
+
+const char orc_changes[] = "instr 1\n"
+        "kc init 0\n"
+        "kc += 1\n"
+        "chnset kc, \"counter\"\n"
+        "chnset 1, \"fixed\"\n"
+        "endin\n";
+
+static int changes_seen;
+
+static void change_callback(CSOUND *csound, CS_CHANNEL *const *chn, int n,
+                            void *userData)
+{
+    int i;
+    for (i = 0; i < n; i++)
+      if (chn[i] == (CS_CHANNEL *) userData) changes_seen++;
+}
+
+void test_channel_changes(void)
+{
+    csoundSetGlobalEnv("OPCODE6DIR64", "../../");
+    CSOUND *csound = csoundCreate(0);
+    csoundCreateMessageBuffer(csound, 0);
+    csoundSetOption(csound, "--logfile=null");
+    csoundCompileOrc(csound, orc_changes);
+    int i, n, err = csoundStart(csound);
+    CU_ASSERT(err == CSOUND_SUCCESS);
+
+    /* many channels, none written by the orchestra */
+    for (i = 0; i < 5000; i++) {
+      char name[32];
+      sprintf(name, "quiet%d", i);
+      csoundSetControlChannel(csound, name, 1.0);
+    }
+    CS_CHANNEL *counter = csoundGetChannelHandle(csound, "counter",
+                            CSOUND_CONTROL_CHANNEL | CSOUND_OUTPUT_CHANNEL);
+    CS_CHANNEL *fixed = csoundGetChannelHandle(csound, "fixed",
+                            CSOUND_CONTROL_CHANNEL | CSOUND_OUTPUT_CHANNEL);
+    CS_CHANNEL *chn[8];
+    CU_ASSERT_EQUAL(0, csoundGetChangedChannels(csound, chn, 8));
+
+    MYFLT pFields[] = {1.0, 0.0, -1.0};
+    csoundScoreEvent(csound, 'i', pFields, 3);
+    csoundPerformKsmps(csound);
+    n = csoundGetChangedChannels(csound, chn, 8);
+    CU_ASSERT_EQUAL(2, n);
+    CU_ASSERT((chn[0] == counter && chn[1] == fixed) ||
+              (chn[0] == fixed && chn[1] == counter));
+    CU_ASSERT_STRING_EQUAL("counter", csoundGetChannelHandleName(csound, counter));
+
+    /* only the counter changes from now on */
+    csoundPerformKsmps(csound);
+    n = csoundGetChangedChannels(csound, chn, 8);
+    CU_ASSERT_EQUAL(1, n);
+    CU_ASSERT_PTR_EQUAL(counter, chn[0]);
+    CU_ASSERT_EQUAL(0, csoundGetChangedChannels(csound, chn, 8));
+
+    /* what does not fit is kept for the next call */
+    csoundSetControlChannel(csound, "fixed", 0.0);
+    csoundScoreEvent(csound, 'i', pFields, 3);
+    csoundPerformKsmps(csound);
+    CU_ASSERT_EQUAL(1, csoundGetChangedChannels(csound, chn, 1));
+    CU_ASSERT_EQUAL(1, csoundGetChangedChannels(csound, chn, 8));
+    CU_ASSERT_EQUAL(0, csoundGetChangedChannels(csound, chn, 8));
+
+    csoundPerformKsmps(csound);
+    changes_seen = 0;
+    CU_ASSERT_EQUAL(1, csoundDispatchChangedChannels(csound, change_callback,
+                                                     counter));
+    CU_ASSERT_EQUAL(1, changes_seen);
+
+    csoundCleanup(csound);
+    csoundDestroyMessageBuffer(csound);
+    csoundDestroy(csound);
+}
+
 const char orc5[] = "chn_k \"winsize\", 3\n"
         "instr 1\n"
         "finput pvsin 1 \n"
@@ -358,6 +488,183 @@ void test_string_channel(void)
     csoundDestroy(csound);
 }
 
+/* host threads against performance threads: no audio frame or string
+   read from a channel may be torn by a writer on the other side */
+
+#define LONG_S "0123456789012345678901234567890123456789" \
+    "0123456789012345678901234567890123456789" \
+    "0123456789012345678901234567890123456789" \
+    "0123456789"
+
+const char orc_stress[] = "ksmps = 64\n"
+        "instr 1\n"
+        "kv chnget \"level\"\n"
+        "a1 = kv\n"
+        "chnset a1, \"aout\"\n"
+        "ain chnget \"ain\"\n"
+        "k0 vaget 0, ain\n"
+        "k1 vaget ksmps-1, ain\n"
+        "if k0 != k1 then\n"
+        "ktorn = 1\n"
+        "chnset ktorn, \"torn\"\n"
+        "endif\n"
+        "endin\n"
+        "instr 2\n"
+        "Sv chnget \"sin\"\n"
+        "chnset Sv, \"sout\"\n"
+        "kc init 0\n"
+        "kc += 1\n"
+        "if kc % 2 == 0 then\n"
+        "chnset \"alpha\", \"sorc\"\n"
+        "else\n"
+        "chnset \"" LONG_S "\", \"sorc\"\n"
+        "endif\n"
+        "endin\n"
+        "schedule 1, 0, -1\n"
+        "schedule 1, 0, -1\n"
+        "schedule 1, 0, -1\n"
+        "schedule 1, 0, -1\n"
+        "schedule 2, 0, -1\n"
+        "schedule 2, 0, -1\n";
+
+typedef struct {
+    CSOUND *csound;
+    volatile int done;
+    volatile int torn;
+} STRESS;
+
+static int stress_string_ok(const char *s)
+{
+    return (!strcmp(s, "") || !strcmp(s, "x") || !strcmp(s, "alpha") ||
+            !strcmp(s, LONG_S));
+}
+
+static uintptr_t stress_writer(void *arg)
+{
+    STRESS *st = (STRESS *) arg;
+    CSOUND *csound = st->csound;
+    CS_CHANNEL *level = csoundGetChannelHandle(csound, "level",
+                          CSOUND_CONTROL_CHANNEL | CSOUND_INPUT_CHANNEL);
+    MYFLT frame[64];
+    int i, n = 0;
+    while (!st->done) {
+      n++;
+      csoundSetControlChannelByHandle(csound, level, (MYFLT) n);
+      for (i = 0; i < 64; i++) frame[i] = (MYFLT) n;
+      csoundSetAudioChannel(csound, "ain", frame);
+      csoundSetStringChannel(csound, "sin", (n & 1) ? "x" : LONG_S);
+    }
+    return 0;
+}
+
+static uintptr_t stress_reader(void *arg)
+{
+    STRESS *st = (STRESS *) arg;
+    CSOUND *csound = st->csound;
+    MYFLT frame[64];
+    char s[1024];
+    int i;
+    while (!st->done) {
+      csoundGetAudioChannel(csound, "aout", frame);
+      for (i = 1; i < 64; i++)
+        if (frame[i] != frame[0]) st->torn++;
+      csoundGetStringChannel(csound, "sout", s);
+      if (!stress_string_ok(s)) st->torn++;
+      csoundGetStringChannel(csound, "sorc", s);
+      if (!stress_string_ok(s)) st->torn++;
+    }
+    return 0;
+}
+
+/* a host following the csoundGetChannelPtr() contract: it writes
+   through the channel pointers under the channel locks */
+typedef struct {            /* STRINGDAT in csoundCore.h */
+    char *data;
+    int size;
+} HOST_STRINGDAT;
+
+static uintptr_t stress_host_writer(void *arg)
+{
+    STRESS *st = (STRESS *) arg;
+    CSOUND *csound = st->csound;
+    MYFLT *ain, *sin;
+    spin_lock_t *alock, *slock;
+    HOST_STRINGDAT *sd;
+    const char *s;
+    int i, n = 0;
+    csoundGetChannelPtr(csound, &ain, "ain",
+                        CSOUND_AUDIO_CHANNEL | CSOUND_INPUT_CHANNEL);
+    csoundGetChannelPtr(csound, &sin, "sin",
+                        CSOUND_STRING_CHANNEL | CSOUND_INPUT_CHANNEL);
+    alock = (spin_lock_t *) csoundGetChannelLock(csound, "ain");
+    slock = (spin_lock_t *) csoundGetChannelLock(csound, "sin");
+    sd = (HOST_STRINGDAT *) sin;
+    while (!st->done) {
+      n++;
+      csoundSpinLock(alock);
+      for (i = 0; i < 64; i++) ain[i] = (MYFLT) n;
+      csoundSpinUnLock(alock);
+      s = (n & 1) ? "x" : LONG_S;
+      csoundSpinLock(slock);
+      if ((int) strlen(s) < sd->size)
+        strcpy(sd->data, s);
+      csoundSpinUnLock(slock);
+    }
+    return 0;
+}
+
+static void run_stress(uintptr_t (*writer)(void *))
+{
+    STRESS st;
+    void *thread[3];
+    int i, err;
+
+    csoundSetGlobalEnv("OPCODE6DIR64", "../../");
+    CSOUND *csound = csoundCreate(0);
+    csoundCreateMessageBuffer(csound, 0);
+    csoundSetOption(csound, "--logfile=null");
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-j4");
+    csoundCompileOrc(csound, orc_stress);
+    err = csoundStart(csound);
+    CU_ASSERT(err == CSOUND_SUCCESS);
+    /* create the channels the threads use before they start, the
+       string one large enough to take LONG_S in place */
+    csoundSetAudioChannel(csound, "ain", (MYFLT[64]) { 0 });
+    csoundSetStringChannel(csound, "sin", LONG_S);
+    csoundSetStringChannel(csound, "sin", "x");
+
+    st.csound = csound;
+    st.done = 0;
+    st.torn = 0;
+    thread[0] = csoundCreateThread(writer, &st);
+    thread[1] = csoundCreateThread(stress_reader, &st);
+    thread[2] = csoundCreateThread(stress_reader, &st);
+    for (i = 0; i < 5000; i++) {
+      err = csoundPerformKsmps(csound);
+      CU_ASSERT(err == 0);
+    }
+    st.done = 1;
+    for (i = 0; i < 3; i++)
+      csoundJoinThread(thread[i]);
+    CU_ASSERT_EQUAL(0, st.torn);
+    CU_ASSERT_EQUAL(0.0, csoundGetControlChannel(csound, "torn", NULL));
+
+    csoundCleanup(csound);
+    csoundDestroyMessageBuffer(csound);
+    csoundDestroy(csound);
+}
+
+void test_channel_stress(void)
+{
+    run_stress(stress_writer);
+}
+
+void test_channel_stress_host(void)
+{
+    run_stress(stress_host_writer);
+}
+
 int main(void)
 {
    CU_pSuite pSuite = NULL;
@@ -379,10 +686,15 @@ int main(void)
            || (NULL == CU_add_test(pSuite, "Control channel parameters", test_control_channel_params))
            || (NULL == CU_add_test(pSuite, "Callbacks", test_channel_callbacks))
            || (NULL == CU_add_test(pSuite, "Opcodes", test_channel_opcodes))
+           || (NULL == CU_add_test(pSuite, "Channel handles", test_channel_handles))
+           || (NULL == CU_add_test(pSuite, "Channel changes", test_channel_changes))
            || (NULL == CU_add_test(pSuite, "PVS Opcodes", test_pvs_opcodes))
            || (NULL == CU_add_test(pSuite, "Invalid channels", test_invalid_channel))
            || (NULL == CU_add_test(pSuite, "Channel hints", test_chn_hints))
            || (NULL == CU_add_test(pSuite, "String channel", test_string_channel))
+           || (NULL == CU_add_test(pSuite, "Channel stress", test_channel_stress))
+           || (NULL == CU_add_test(pSuite, "Channel stress, host locking",
+                                   test_channel_stress_host))
        )
    {
       CU_cleanup_registry();
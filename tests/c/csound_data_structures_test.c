@@ -147,6 +147,35 @@ void test_cs_hash_table_get_put_key(void) {
     csoundDestroy(csound);
 }
 
+void test_cs_hash_table_grow_remove(void) {
+    CSOUND* csound = csoundCreate(NULL);
+    char key[32];
+    int i, n;
+
+    CS_HASH_TABLE* hashTable = cs_hash_table_create(csound);
+    for (i = 0; i < 5000; i++) {
+        sprintf(key, "key%d", i);
+        cs_hash_table_put(csound, hashTable, key, (void*) (intptr_t) (i + 1));
+    }
+    /* remove every third key, the others must still be found */
+    for (i = 0; i < 5000; i += 3) {
+        sprintf(key, "key%d", i);
+        cs_hash_table_remove(csound, hashTable, key);
+    }
+    for (i = 0; i < 5000; i++) {
+        sprintf(key, "key%d", i);
+        if (i % 3 == 0) {
+            CU_ASSERT_PTR_NULL(cs_hash_table_get(csound, hashTable, key));
+        } else {
+            CU_ASSERT_EQUAL((intptr_t) cs_hash_table_get(csound, hashTable, key),
+                            i + 1);
+        }
+    }
+    n = cs_cons_length(cs_hash_table_keys(csound, hashTable));
+    CU_ASSERT_EQUAL(n, 5000 - 1667);
+
+    csoundDestroy(csound);
+}
 
 int main() {
     CU_pSuite pSuite = NULL;
@@ -167,7 +196,8 @@ int main() {
         (NULL == CU_add_test(pSuite, "Test cs_cons_append()", test_cs_cons_append)) ||
         (NULL == CU_add_test(pSuite, "Test cs_hash_table()", test_cs_hash_table)) ||
         (NULL == CU_add_test(pSuite, "Test cs_hash_table_merge()", test_cs_hash_table_merge)) ||
-        (NULL == CU_add_test(pSuite, "Test cs_hash_table_get_put_key()", test_cs_hash_table_get_put_key))) {
+        (NULL == CU_add_test(pSuite, "Test cs_hash_table_get_put_key()", test_cs_hash_table_get_put_key)) ||
+        (NULL == CU_add_test(pSuite, "Test cs_hash_table grow and remove", test_cs_hash_table_grow_remove))) {
         
         CU_cleanup_registry();
         return CU_get_error();
@@ -13,6 +13,9 @@
 #include "csoundCore.h"
 #include "CUnit/Basic.h"
 
+/* MYFLT may be float, so compare results relative to their size */
+#define REL_TOL(x)  (1.0e-5 * (FABS(x) + FL(1.0e-3)))
+
 extern int argsRequired(char* arrayName);
 extern char** splitArgs(CSOUND* csound, char* argString);
 
@@ -166,6 +169,422 @@ void test_linenum(void)
 }
 
 
+static const char *orc_fusion =
+    "sr = 44100\n"
+    "ksmps = 16\n"
+    "nchnls = 1\n"
+    "0dbfs = 1\n"
+    "instr 1\n"
+    "a1 oscili 0.5, 220\n"
+    "a2 oscili 0.3, 331\n"
+    "aenv linseg 0, 0.01, 1, 0.1, 0.5\n"
+    "kg = 0.7\n"
+    "kh line 0.2, 0.1, 1.3\n"
+    "aout = (a1*kg + a2*kh) * aenv\n"
+    "aout = abs(aout*kg*kh*0.5) + sqrt(abs(a1)) / 3\n"
+    "chnset aout, \"out\"\n"
+    "endin\n";
+
+#define FUSION_CYCLES 100
+#define FUSION_DEEP   70        /* unary operations, above FUSE_MAXINS */
+
+static int tree_has_opcode(TREE *t, const char *name)
+{
+    for (; t != NULL; t = t->next) {
+      if (t->value != NULL && t->value->lexeme != NULL &&
+          !strcmp(t->value->lexeme, name))
+        return 1;
+      if (tree_has_opcode(t->left, name) || tree_has_opcode(t->right, name))
+        return 1;
+    }
+    return 0;
+}
+
+static void run_fusion(const char *orc, const char *option, MYFLT *out)
+{
+    CSOUND  *csound = csoundCreate(NULL);
+    int     k;
+
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-m0");
+    csoundSetOption(csound, (char *) option);
+    CU_ASSERT(csoundCompileOrc(csound, orc) == 0);
+    CU_ASSERT(csoundReadScore(csound, "i1 0 1\n") == 0);
+    CU_ASSERT(csoundStart(csound) == 0);
+    for (k = 0; k < FUSION_CYCLES; k++) {
+      csoundPerformKsmps(csound);
+      csoundGetAudioChannel(csound, "out", out + k*16);
+    }
+    csoundDestroy(csound);
+}
+
+void test_expr_fusion(void)
+{
+    CSOUND  *csound;
+    TREE    *tree;
+    MYFLT   off[FUSION_CYCLES*16], exact[FUSION_CYCLES*16];
+    MYFLT   regroup[FUSION_CYCLES*16], dflt[FUSION_CYCLES*16];
+    char    deep[1024], *s = deep;
+    int     i;
+
+    csound = csoundCreate(NULL);
+    tree = csoundParseOrc(csound, orc_fusion);
+    CU_ASSERT_PTR_NOT_NULL(tree);
+    CU_ASSERT(tree_has_opcode(tree, "##fuse"));
+    csoundDeleteTree(csound, tree);
+    csoundSetOption(csound, "--expr-fusion=0");
+    tree = csoundParseOrc(csound, orc_fusion);
+    CU_ASSERT(!tree_has_opcode(tree, "##fuse"));
+    csoundDeleteTree(csound, tree);
+    /* out of range is rejected and leaves the setting alone */
+    CU_ASSERT(csoundSetOption(csound, "--expr-fusion=7") != 0);
+    CU_ASSERT(csoundSetOption(csound, "--expr-fusion=-1") != 0);
+    tree = csoundParseOrc(csound, orc_fusion);
+    CU_ASSERT(!tree_has_opcode(tree, "##fuse"));
+    csoundDeleteTree(csound, tree);
+    csoundDestroy(csound);
+
+    /* fused without reassociation gives the same samples */
+    run_fusion(orc_fusion, "--expr-fusion=0", off);
+    run_fusion(orc_fusion, "--expr-fusion=1", exact);
+    run_fusion(orc_fusion, "--expr-fusion=2", regroup);
+    run_fusion(orc_fusion, "-m0", dflt);
+    CU_ASSERT(memcmp(off, exact, sizeof(off)) == 0);
+    /* the default does not change the output of existing orchestras */
+    CU_ASSERT(memcmp(off, dflt, sizeof(off)) == 0);
+    for (i = 0; i < FUSION_CYCLES*16; i++)
+      CU_ASSERT_DOUBLE_EQUAL(off[i], regroup[i], REL_TOL(off[i]));
+
+    /* a tree longer than ##fuse runs is split, not fused whole */
+    s += sprintf(s, "sr = 44100\nksmps = 16\nnchnls = 1\n0dbfs = 1\n"
+                 "instr 1\na1 oscili 0.5, 220\naout = ");
+    for (i = 0; i < FUSION_DEEP; i++) s += sprintf(s, "abs(");
+    s += sprintf(s, "a1 - 0.25");
+    for (i = 0; i < FUSION_DEEP; i++) *s++ = ')';
+    sprintf(s, "\nchnset aout, \"out\"\nendin\n");
+    run_fusion(deep, "--expr-fusion=0", off);
+    run_fusion(deep, "--expr-fusion=1", exact);
+    CU_ASSERT(memcmp(off, exact, sizeof(off)) == 0);
+    CU_ASSERT(off[FUSION_CYCLES*16 - 1] != FL(0.0));
+}
+
+static const char *orc_temps =
+    "sr = 44100\n"
+    "ksmps = 10\n"
+    "nchnls = 1\n"
+    "0dbfs = 1\n"
+    "instr 1\n"
+    "a1 = p4\n"
+    "k1 = p5\n"
+    "a2 = (a1*k1 + 1) * (a1 - k1*2)\n"
+    "a3 = (a2 + a1) / (k1*k1 + 1)\n"
+    "a4 = sqrt(abs(a3*a2)) - (a1 + k1) * 0.5\n"
+    "chnset a4, \"out\"\n"
+    "endin\n";
+
+void test_var_layout(void)
+{
+    CSOUND  *csound = csoundCreate(NULL);
+    CS_VAR_POOL *pool;
+    CS_VARIABLE *var;
+    MYFLT   out[10], a1 = 0.25, k1 = 1.5, a2, a3, a4;
+    int     size = 0, i;
+
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-m0");
+    csoundSetOption(csound, "--expr-fusion=0");
+    CU_ASSERT(csoundCompileOrc(csound, orc_temps) == 0);
+    CU_ASSERT(csoundReadScore(csound, "i1 0 1 0.25 1.5\n") == 0);
+    CU_ASSERT(csoundStart(csound) == 0);
+
+    /* temporaries share slots, and audio buffers are aligned */
+    pool = csound->engineState.instrtxtp[1]->varPool;
+    for (var = pool->head; var != NULL; var = var->next) {
+      size += CS_FLOAT_ALIGN(CS_VAR_TYPE_OFFSET) + var->memBlockSize;
+      if (var->varType == &CS_VAR_TYPE_A)
+        CU_ASSERT((var->memBlockIndex * sizeof(MYFLT)) % CS_VAR_ALIGN == 0);
+    }
+    CU_ASSERT(pool->blockSize < size);
+
+    csoundPerformKsmps(csound);
+    csoundGetAudioChannel(csound, "out", out);
+    a2 = (a1*k1 + 1) * (a1 - k1*2);
+    a3 = (a2 + a1) / (k1*k1 + 1);
+    a4 = SQRT(FABS(a3*a2)) - (a1 + k1) * 0.5;
+    for (i = 0; i < 10; i++)
+      CU_ASSERT_DOUBLE_EQUAL(out[i], a4, REL_TOL(a4));
+    csoundDestroy(csound);
+}
+
+static const char *orc_opt =
+    "sr = 44100\n"
+    "ksmps = 16\n"
+    "nchnls = 1\n"
+    "0dbfs = 1\n"
+    "instr 1\n"
+    "a1 oscili 0.5, 220\n"
+    "ifreq = 110\n"
+    "kamp = p4\n"
+    "kdead = kamp * 3\n"
+    "a2 oscili kamp * sin(0.5), ifreq * 2\n"
+    "a3 = a1*kamp + a2\n"
+    "a4 = a1*kamp - a2\n"
+    "chnset a3 * a4, \"out\"\n"
+    "endin\n"
+    "instr 2\n"
+    "if p5 == 0 igoto skip\n"
+    "iamp = 0.5\n"
+    "skip:\n"
+    "if p5 == 0 kgoto kskip\n"
+    "kamp = p4\n"
+    "kskip:\n"
+    "kenv line 0, 1, 1\n"
+    "kx = kamp*2 + kenv\n"
+    "a1 oscili iamp, 440\n"
+    "chnset a1 + kx, \"jump\"\n"
+    "endin\n";
+
+static void run_opt(const char *option, MYFLT *out, MYFLT *jump)
+{
+    CSOUND  *csound = csoundCreate(NULL);
+    int     k;
+
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-m0");
+    csoundSetOption(csound, "--expr-fusion=0");
+    csoundSetOption(csound, (char *) option);
+    CU_ASSERT(csoundCompileOrc(csound, orc_opt) == 0);
+    CU_ASSERT(csoundReadScore(csound, "i1 0 1 0.8\ni2 0 1 0.8 0\n") == 0);
+    CU_ASSERT(csoundStart(csound) == 0);
+    for (k = 0; k < FUSION_CYCLES; k++) {
+      csoundPerformKsmps(csound);
+      csoundGetAudioChannel(csound, "out", out + k*16);
+      csoundGetAudioChannel(csound, "jump", jump + k*16);
+    }
+    csoundDestroy(csound);
+}
+
+void test_tree_opt(void)
+{
+    CSOUND  *csound;
+    TREE    *tree;
+    MYFLT   off[FUSION_CYCLES*16], on[FUSION_CYCLES*16];
+    MYFLT   joff[FUSION_CYCLES*16], jon[FUSION_CYCLES*16];
+    int     i, folded = 0, shared = 0, hoisted = 0;
+    int     counted = 0, reused = 0, to_itime = 0;
+
+    csound = csoundCreate(NULL);
+    csoundSetOption(csound, "--expr-fusion=0");
+    csoundSetOption(csound, "--tree-opt=0");
+    tree = csoundParseOrc(csound, orc_opt);
+    CU_ASSERT_PTR_NOT_NULL(tree);
+    CU_ASSERT(tree_has_opcode(tree, "kdead"));
+    CU_ASSERT(tree_has_opcode(tree, "sin"));
+    csoundDeleteTree(csound, tree);
+    /* the unread statement goes, and sin(0.5) is folded */
+    csoundSetOption(csound, "--tree-opt=1");
+    tree = csoundParseOrc(csound, orc_opt);
+    CU_ASSERT_PTR_NOT_NULL(tree);
+    CU_ASSERT(!tree_has_opcode(tree, "kdead"));
+    CU_ASSERT(!tree_has_opcode(tree, "sin"));
+    csoundDeleteTree(csound, tree);
+    csoundDestroy(csound);
+
+    /* --opt-report: a1*kamp is computed once, and kamp * sin(0.5) is
+       multiplied at i-time as kamp is only set from p4 */
+    csound = csoundCreate(NULL);
+    csoundCreateMessageBuffer(csound, 0);
+    csoundSetOption(csound, "--expr-fusion=0");
+    csoundSetOption(csound, "--tree-opt=1");
+    csoundSetOption(csound, "--opt-report");
+    tree = csoundParseOrc(csound, orc_opt);
+    CU_ASSERT_PTR_NOT_NULL(tree);
+    csoundDeleteTree(csound, tree);
+    while (csoundGetMessageCnt(csound) > 0) {
+      const char *msg = csoundGetFirstMessage(csound);
+      if (sscanf(msg, "instr 1: %d folded, %d shared, %d hoisted",
+                 &folded, &shared, &hoisted) == 3)
+        counted = 1;
+      if (!strncmp(msg, "instr 1, line ", 14)) {
+        if (strstr(msg, "reused earlier ##mul.ak") != NULL) reused = 1;
+        if (strstr(msg, "to i-time: ##mul.ii") != NULL) to_itime = 1;
+      }
+      csoundPopFirstMessage(csound);
+    }
+    csoundDestroyMessageBuffer(csound);
+    csoundDestroy(csound);
+    CU_ASSERT(counted);
+    CU_ASSERT(folded >= 1);
+    CU_ASSERT(shared >= 1);
+    CU_ASSERT(hoisted >= 1);
+    CU_ASSERT(reused);
+    CU_ASSERT(to_itime);
+
+    run_opt("--tree-opt=0", off, joff);
+    run_opt("--tree-opt=1", on, jon);
+    CU_ASSERT(memcmp(off, on, sizeof(off)) == 0);
+    /* both jumps are taken: iamp and kamp stay 0, leaving the ramp */
+    CU_ASSERT(memcmp(joff, jon, sizeof(joff)) == 0);
+    for (i = 0; i < FUSION_CYCLES*16; i++)
+      CU_ASSERT(jon[i] >= FL(0.0) && jon[i] < FL(0.05));
+}
+
+static const char *orc_udo =
+    "sr = 44100\n"
+    "ksmps = 16\n"
+    "nchnls = 1\n"
+    "0dbfs = 1\n"
+    "opcode gain, a, ak\n"
+    "ain, kg xin\n"
+    "xout ain * kg\n"
+    "endop\n"
+    "opcode half, a, a\n"
+    "ain xin\n"
+    "ain = ain * 0.5\n"
+    "xout ain\n"
+    "endop\n"
+    "opcode blocky, a, a\n"
+    "setksmps 4\n"
+    "ain xin\n"
+    "xout ain * 2\n"
+    "endop\n"
+    "opcode wrap, a, ak\n"
+    "ain, kg xin\n"
+    "a1 gain ain, kg\n"
+    "a2 half a1\n"
+    "xout a1 + a2\n"
+    "endop\n"
+    "gabus init 0\n"
+    "opcode bus, a, a\n"
+    "ain xin\n"
+    "gabus = gabus + ain\n"
+    "xout ain\n"
+    "endop\n"
+    "instr 1\n"
+    "a1 linseg 0, 0.1, 1\n"
+    "a2 wrap a1, 0.7\n"
+    "a3 blocky a2\n"
+    "a4 gain a3, 0.5, 8\n"
+    "gabus = a1\n"
+    "a5 bus gabus\n"
+    "chnset a1, \"in\"\n"
+    "chnset a4, \"out\"\n"
+    "chnset a5, \"bus\"\n"
+    "endin\n";
+
+/* whether the body of the instrument, the last definition, calls name */
+static int instr_calls(TREE *t, const char *name)
+{
+    while (t->next != NULL)
+      t = t->next;
+    return tree_has_opcode(t->right, name);
+}
+
+static void run_udo(const char *option, MYFLT *in, MYFLT *out, MYFLT *bus)
+{
+    CSOUND  *csound = csoundCreate(NULL);
+    int     k;
+
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-m0");
+    csoundSetOption(csound, (char *) option);
+    CU_ASSERT(csoundCompileOrc(csound, orc_udo) == 0);
+    CU_ASSERT(csoundReadScore(csound, "i1 0 1\n") == 0);
+    CU_ASSERT(csoundStart(csound) == 0);
+    for (k = 0; k < FUSION_CYCLES; k++) {
+      csoundPerformKsmps(csound);
+      csoundGetAudioChannel(csound, "in", in + k*16);
+      csoundGetAudioChannel(csound, "out", out + k*16);
+      csoundGetAudioChannel(csound, "bus", bus + k*16);
+    }
+    csoundDestroy(csound);
+}
+
+void test_udo_inline(void)
+{
+    CSOUND  *csound;
+    TREE    *tree;
+    MYFLT   in[FUSION_CYCLES*16], calls[FUSION_CYCLES*16];
+    MYFLT   inlined[FUSION_CYCLES*16], bus[FUSION_CYCLES*16];
+    int     i;
+
+    csound = csoundCreate(NULL);
+    csoundSetOption(csound, "--udo-inline=0");
+    tree = csoundParseOrc(csound, orc_udo);
+    CU_ASSERT_PTR_NOT_NULL(tree);
+    CU_ASSERT(instr_calls(tree, "wrap"));
+    csoundDeleteTree(csound, tree);
+    /* setksmps and a local ksmps keep their calls */
+    csoundSetOption(csound, "--udo-inline=16");
+    tree = csoundParseOrc(csound, orc_udo);
+    CU_ASSERT_PTR_NOT_NULL(tree);
+    CU_ASSERT(!instr_calls(tree, "wrap"));
+    CU_ASSERT(!instr_calls(tree, "half"));
+    CU_ASSERT(instr_calls(tree, "blocky"));
+    CU_ASSERT(instr_calls(tree, "gain"));
+    csoundDeleteTree(csound, tree);
+    csoundDestroy(csound);
+
+    /* inputs read in place, copied and copied in slices, or inlined;
+       bus sees its input as it was before it wrote the global passed */
+    run_udo("--udo-inline=0", in, calls, bus);
+    for (i = 0; i < FUSION_CYCLES*16; i++) {
+      CU_ASSERT_DOUBLE_EQUAL(calls[i], in[i] * 0.7 * 1.5,
+                             REL_TOL(in[i]));
+      CU_ASSERT_DOUBLE_EQUAL(bus[i], in[i], REL_TOL(in[i]));
+    }
+    run_udo("--udo-inline=16", in, inlined, bus);
+    CU_ASSERT(memcmp(calls, inlined, sizeof(calls)) == 0);
+    for (i = 0; i < FUSION_CYCLES*16; i++)
+      CU_ASSERT_DOUBLE_EQUAL(bus[i], in[i], REL_TOL(in[i]));
+}
+
+/* copyf2array fills the array it is given, which here is the UDO's
+   input: the caller's array must be left alone */
+static const char *orc_udo_array =
+    "sr = 44100\n"
+    "ksmps = 16\n"
+    "nchnls = 1\n"
+    "0dbfs = 1\n"
+    "gitab ftgen 1, 0, 4, -2, 1, 2, 3, 4\n"
+    "opcode fill, k, k[]\n"
+    "kArr[] xin\n"
+    "copyf2array kArr, 1\n"
+    "xout kArr[0]\n"
+    "endop\n"
+    "instr 1\n"
+    "kA[] fillarray 5, 6, 7, 8\n"
+    "kx fill kA\n"
+    "chnset kx, \"filled\"\n"
+    "chnset kA[0], \"kept\"\n"
+    "endin\n";
+
+static void run_udo_array(const char *option)
+{
+    CSOUND  *csound = csoundCreate(NULL);
+    int     k, err;
+
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-m0");
+    csoundSetOption(csound, (char *) option);
+    CU_ASSERT(csoundCompileOrc(csound, orc_udo_array) == 0);
+    CU_ASSERT(csoundReadScore(csound, "i1 0 1\n") == 0);
+    CU_ASSERT(csoundStart(csound) == 0);
+    for (k = 0; k < 4; k++) {
+      csoundPerformKsmps(csound);
+      CU_ASSERT_DOUBLE_EQUAL(csoundGetControlChannel(csound, "filled", &err),
+                             1.0, 1e-12);
+      CU_ASSERT_DOUBLE_EQUAL(csoundGetControlChannel(csound, "kept", &err),
+                             5.0, 1e-12);
+    }
+    csoundDestroy(csound);
+}
+
+void test_udo_array_input(void)
+{
+    run_udo_array("--udo-inline=0");
+    run_udo_array("--udo-inline=16");
+}
 
 int main() {
     CU_pSuite pSuite = NULL;
@@ -186,7 +605,17 @@ int main() {
             (NULL == CU_add_test(pSuite, "Test splitArgs", test_split_args)) ||
             (NULL == CU_add_test(pSuite, "Test Compilation", test_compile)) ||
             (NULL == CU_add_test(pSuite, "Test Reuse Instance", test_reuse)) ||
-        (NULL == CU_add_test(pSuite, "Test Line Numbers", test_linenum))) {
+        (NULL == CU_add_test(pSuite, "Test Line Numbers", test_linenum)) ||
+        (NULL == CU_add_test(pSuite, "Test Expression Fusion",
+                             test_expr_fusion)) ||
+        (NULL == CU_add_test(pSuite, "Test Variable Layout",
+                             test_var_layout)) ||
+        (NULL == CU_add_test(pSuite, "Test Tree Optimization",
+                             test_tree_opt)) ||
+        (NULL == CU_add_test(pSuite, "Test UDO Inlining",
+                             test_udo_inline)) ||
+        (NULL == CU_add_test(pSuite, "Test UDO Array Input",
+                             test_udo_array_input))) {
         CU_cleanup_registry();
         return CU_get_error();
     }
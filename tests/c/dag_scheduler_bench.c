@@ -0,0 +1,79 @@
+/*
+ * File:   dag_scheduler_bench.c
+ *
+ * Compares the multicore task dispatchers (--dag-scheduler=scan|steal|cost)
+ * over a range of thread and voice counts, printing the mean wall time
+ * of csoundPerformKsmps for each setting.  See bench.h.
+ *
+ * usage: benchDagScheduler [kcycles]
+ */
+
+#include <string.h>
+#include "bench.h"
+
+/* instr 1 voices are independent; instr 2 voices all mix into gasum,
+   which does not order them, and instr 3 reads it, so the DAG has both
+   wide and chained parts */
+static const char *orc =
+  "sr = 48000\n"
+  "ksmps = 16\n"
+  "nchnls = 2\n"
+  "0dbfs = 1\n"
+  "gasum init 0\n"
+  "instr 1\n"
+  "  a1 vco2 0.001, p4\n"
+  "  a2 moogladder a1, 2000, 0.3\n"
+  "  outs a2, a2\n"
+  "endin\n"
+  "instr 2\n"
+  "  a1 oscili 0.001, p4\n"
+  "  a2 butterlp a1, 1000\n"
+  "  gasum = gasum + a2\n"
+  "endin\n"
+  "instr 3\n"
+  "  a1, a2 reverbsc gasum, gasum, 0.8, 8000\n"
+  "  outs a1, a2\n"
+  "  gasum = 0\n"
+  "endin\n";
+
+static double run(const char *sched, int threads, int voices, int kcycles)
+{
+    CSOUND  *csound;
+    char    jopt[64], dopt[64], *sco, *p;
+    const char *opts[] = { jopt, dopt, NULL };
+    int     i;
+    double  t;
+
+    snprintf(jopt, 64, "-j%d", threads);
+    snprintf(dopt, 64, "--dag-scheduler=%s", sched);
+    p = sco = malloc(64 * (voices + 2));
+    for (i = 0; i < voices; i++)
+      p += sprintf(p, "i %d 0 3600 %d\n", (i % 4 == 3) ? 2 : 1, 100 + i);
+    p += sprintf(p, "i 3 0 3600\n");
+    csound = bench_start(orc, sco, opts);     /* the DAG is built */
+    free(sco);
+    t = bench_perform(csound, kcycles);
+    bench_end(csound);
+    return 1.0e6 * t / kcycles;
+}
+
+int main(int argc, char **argv)
+{
+    static const int threads[] = { 1, 2, 4, 8, 16 };
+    static const int voices[] = { 16, 64, 128, 320 };
+    int kcycles = argc > 1 ? atoi(argv[1]) : 3000;
+    unsigned int i, j;
+
+    bench_init();
+    printf("%8s %8s %14s %14s %14s\n", "threads", "voices",
+           "scan (us/k)", "steal (us/k)", "cost (us/k)");
+    for (i = 0; i < sizeof(threads)/sizeof(int); i++)
+      for (j = 0; j < sizeof(voices)/sizeof(int); j++) {
+        double scan = run("scan", threads[i], voices[j], kcycles);
+        double steal = run("steal", threads[i], voices[j], kcycles);
+        double cost = run("cost", threads[i], voices[j], kcycles);
+        printf("%8d %8d %14.2f %14.2f %14.2f\n",
+               threads[i], voices[j], scan, steal, cost);
+      }
+    return 0;
+}
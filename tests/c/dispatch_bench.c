@@ -0,0 +1,83 @@
+/*
+ * File:   dispatch_bench.c
+ *
+ * Times the opcode dispatch of the performance loop at ksmps = 1 and
+ * ksmps = 16, where the cost of calling an opcode rivals the work it
+ * does.  Each instance runs a chain of cheap k-rate and a-rate opcodes;
+ * a second instrument with a k-rate loop takes the jump path.  It
+ * prints the mean time per opcode call, counting the opcodes each
+ * instrument runs in a k-cycle.  The optimizer and expression fusion
+ * are off so that those counts hold.  See bench.h.
+ *
+ * usage: benchDispatch [instances] [seconds]
+ */
+
+#include <string.h>
+#include "bench.h"
+
+#define CHAIN   24      /* k-rate opcodes per instance */
+#define ACHAIN  4       /* a-rate opcodes per instance */
+#define LOOPS   2       /* passes of the loop of instr 2 */
+
+/* opcodes run per k-cycle: instr 1 sets k0, runs the chain, sets a0 and
+   runs the a-rate chain and out; instr 2 sets kn and k0, then runs its
+   loop body and loop_lt LOOPS times */
+#define OPS1    (CHAIN + ACHAIN + 1)
+#define OPS2    (2 + LOOPS * (CHAIN / 2))
+
+static char *make_orc(int ksmps, int instances, int jumps)
+{
+    size_t  size = 4096 + (size_t) instances * 64;
+    char    *orc = malloc(size), *p = orc;
+    int     i;
+
+    p += sprintf(p, "sr = 48000\nksmps = %d\nnchnls = 1\n0dbfs = 1\n", ksmps);
+    p += sprintf(p, "instr 1\nk0 = p4\n");
+    for (i = 1; i < CHAIN; i++)
+      p += sprintf(p, "k%d = k%d * 0.999 + 0.001\n", i, i - 1);
+    p += sprintf(p, "a0 = k%d\n", CHAIN - 1);
+    for (i = 1; i < ACHAIN; i++)
+      p += sprintf(p, "a%d = a%d * 0.5\n", i, i - 1);
+    p += sprintf(p, "out a%d * 0.001\nendin\n", ACHAIN - 1);
+    /* half the work, run LOOPS times behind a loop that jumps back */
+    p += sprintf(p, "instr 2\nkn = 0\nk0 = p4\nloop:\n");
+    for (i = 1; i < CHAIN / 2; i++)
+      p += sprintf(p, "k%d = k%d * 0.999 + 0.001\n", i, i - 1);
+    p += sprintf(p, "loop_lt kn, 1, %d, loop\nendin\n", LOOPS);
+    for (i = 0; i < instances; i++)
+      p += sprintf(p, "schedule %d, 0, -1, %d\n",
+                   (jumps && (i & 1)) ? 2 : 1, i);
+    return orc;
+}
+
+static double run(int ksmps, int instances, double seconds, int jumps)
+{
+    static const char *opts[] = { "--tree-opt=0", "--expr-fusion=0", NULL };
+    CSOUND   *csound;
+    char     *orc = make_orc(ksmps, instances, jumps);
+    long     cycles = (long) (seconds * 48000 / ksmps);
+    int      n2 = jumps ? instances / 2 : 0;     /* odd ones play instr 2 */
+    double   t, ops = (double) (instances - n2) * OPS1 + (double) n2 * OPS2;
+
+    csound = bench_start(orc, NULL, opts);
+    free(orc);
+    t = bench_perform(csound, cycles);
+    bench_end(csound);
+    return 1.0e9 * t / ((double) cycles * ops);
+}
+
+int main(int argc, char **argv)
+{
+    int     instances = argc > 1 ? atoi(argv[1]) : 64;
+    double  seconds = argc > 2 ? atof(argv[2]) : 10.0;
+    int     ksmps[2] = { 1, 16 }, i;
+
+    bench_init();
+    for (i = 0; i < 2; i++) {
+      printf("ksmps %2d, %d instances: %.2f ns/opcode straight, ",
+             ksmps[i], instances, run(ksmps[i], instances, seconds, 0));
+      printf("%.2f ns/opcode with jumps\n",
+             run(ksmps[i], instances, seconds, 1));
+    }
+    return 0;
+}
@@ -1,5 +1,7 @@
 #include "csound.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <CUnit/Basic.h>
 
 #include "time.h"
@@ -54,6 +56,601 @@ void test_compile_async(void)
     csoundDestroy(csound);
 }
 
+void test_opcode_profile(void)
+{
+    CSOUND  *csound;
+    CS_OPCODE_PROFILE *lst;
+    int i, n, found = 0;
+    csound = csoundCreate(NULL);
+    csoundSetOption(csound, "-n");
+    csoundSetOpcodeProfiling(csound, 2);
+    csoundCompileOrc(csound, "instr 1\n"
+                             "a1 oscili 0.1, 440\n"
+                             "a2 butterlp a1, 1000\n"
+                             "endin\n"
+                             "schedule 1,0,1\n");
+    csoundStart(csound);
+    for (i = 0; i < 100; i++)
+      csoundPerformKsmps(csound);
+    n = csoundGetOpcodeProfile(csound, &lst);
+    CU_ASSERT(n > 0);
+    for (i = 0; i < n; i++) {
+      if (!strncmp(lst[i].opname, "butterlp", 8)) {
+        found = 1;
+        CU_ASSERT_EQUAL(lst[i].insno, 1);
+        CU_ASSERT(lst[i].calls >= 49 && lst[i].calls <= 50);
+        CU_ASSERT(lst[i].seconds > 0.0);
+      }
+      if (i > 0) CU_ASSERT(lst[i].seconds <= lst[i-1].seconds);
+    }
+    CU_ASSERT(found);
+    csoundDeleteOpcodeProfile(csound, lst);
+    csoundDestroy(csound);
+}
+
+void test_kcycle_timing(void)
+{
+    CSOUND  *csound;
+    CS_KCYCLE_TIMING t;
+    int i;
+    csound = csoundCreate(NULL);
+    csoundSetOption(csound, "-n");
+    csoundCompileOrc(csound, "instr 1\n"
+                             "a1 oscili 0.1, 440\n"
+                             "endin\n"
+                             "schedule 1,0,1\n");
+    CU_ASSERT_EQUAL(csoundGetKcycleTiming(csound, CS_KCYCLE_TOTAL, &t),
+                    CSOUND_ERROR);
+    csoundStart(csound);
+    for (i = 0; i < 100; i++)
+      csoundPerformKsmps(csound);
+    CU_ASSERT_EQUAL(csoundGetKcycleTiming(csound, CS_KCYCLE_TOTAL, &t),
+                    CSOUND_SUCCESS);
+    CU_ASSERT_EQUAL(t.cycles, 100);
+    CU_ASSERT(t.p50 <= t.p99 && t.p99 <= t.p999 && t.p999 <= t.max);
+    CU_ASSERT(t.deadline > 0.0);
+    CU_ASSERT_EQUAL(csoundGetKcycleTiming(csound, CS_KCYCLE_CHAIN, &t),
+                    CSOUND_SUCCESS);
+    CU_ASSERT_EQUAL(t.cycles, 100);
+    csoundResetKcycleTiming(csound);
+    csoundPerformKsmps(csound);
+    csoundGetKcycleTiming(csound, CS_KCYCLE_TOTAL, &t);
+    CU_ASSERT_EQUAL(t.cycles, 1);
+    csoundDestroy(csound);
+}
+
+void test_memory_accounting(void)
+{
+    CSOUND  *csound;
+    CS_MEMORY_USAGE *lst;
+    int64_t cur, peak;
+    int i, n, found = 0;
+    csound = csoundCreate(NULL);
+    csoundSetOption(csound, "-n");
+    csoundSetMemoryAccounting(csound, 1);
+    csoundCompileOrc(csound, "instr 1\n"
+                             "a1 oscili 0.1, 440\n"
+                             "a2 delay a1, 1\n"
+                             "endin\n"
+                             "gi1 ftgen 1, 0, 65536, 10, 1\n"
+                             "schedule 1,0,1\n");
+    csoundStart(csound);
+    for (i = 0; i < 10; i++)
+      csoundPerformKsmps(csound);
+    CU_ASSERT_EQUAL(csoundGetMemoryTotal(csound, CS_MEM_FTABLES, &cur, &peak),
+                    CSOUND_SUCCESS);
+    CU_ASSERT(cur >= 65536*(int64_t) sizeof(MYFLT));
+    n = csoundGetMemoryUsage(csound, &lst);
+    CU_ASSERT(n > 0);
+    for (i = 0; i < n; i++) {
+      if (lst[i].kind == CS_MEM_OPCODE && lst[i].opname != NULL &&
+          !strcmp(lst[i].opname, "delay")) {
+        found = 1;
+        CU_ASSERT_EQUAL(lst[i].insno, 1);
+        CU_ASSERT(lst[i].peak >= 44100*(int64_t) sizeof(MYFLT));
+      }
+      if (i > 0) CU_ASSERT(lst[i].peak <= lst[i-1].peak);
+    }
+    CU_ASSERT(found);
+    csoundDeleteMemoryUsage(csound, lst);
+    csoundDestroy(csound);
+}
+
+/* instr 1 voices each write their own channel, and are chained in
+   instance order through gasum (not a plain ga = ga + x, which would be
+   summed per thread); instr 2 reads the result */
+#define DAG_VOICES  8
+#define DAG_CYCLES  200
+
+static const char *orc_dag =
+    "ksmps = 16\n"
+    "nchnls = 1\n"
+    "0dbfs = 1\n"
+    "gasum init 0\n"
+    "instr 1\n"
+    "a1 oscili 0.1, 110 * p4\n"
+    "a2 butterlp a1, 500 * p4\n"
+    "gasum = gasum * 0.5 + a2\n"
+    "Sname sprintf \"v%d\", p4\n"
+    "chnset a2, Sname\n"
+    "endin\n"
+    "instr 2\n"
+    "chnset gasum, \"sum\"\n"
+    "gasum = 0\n"
+    "endin\n";
+
+#define DAG_SAMPLES (DAG_CYCLES*(DAG_VOICES+1)*16)
+
+/* the messages printed so far, one string the caller frees */
+static char *take_messages(CSOUND *csound)
+{
+    size_t  len = 0, size = 4096;
+    char    *buf = malloc(size);
+
+    buf[0] = '\0';
+    while (csoundGetMessageCnt(csound) > 0) {
+      const char *msg = csoundGetFirstMessage(csound);
+      size_t  n = strlen(msg);
+      if (len + n + 1 > size) {
+        while (len + n + 1 > size) size *= 2;
+        buf = realloc(buf, size);
+      }
+      memcpy(buf + len, msg, n + 1);
+      len += n;
+      csoundPopFirstMessage(csound);
+    }
+    return buf;
+}
+
+/* every channel of orc_dag after each k-cycle, run with the options in
+   the NULL-terminated list opts; if msgs is not NULL, it gets what was
+   printed up to and including the end of the performance.  Returns the
+   number of threads taking part in the last k-cycle. */
+static int run_dag(const char *const *opts, const char *sco, MYFLT *out,
+                   char **msgs)
+{
+    CSOUND  *csound;
+    char    name[16];
+    int     i, k, threads;
+
+    csound = csoundCreate(NULL);
+    if (msgs != NULL) csoundCreateMessageBuffer(csound, 0);
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-m0");
+    for ( ; *opts != NULL; opts++)
+      csoundSetOption(csound, (char *) *opts);
+    CU_ASSERT(csoundCompileOrc(csound, orc_dag) == 0);
+    CU_ASSERT(csoundReadScore(csound, sco) == 0);
+    CU_ASSERT(csoundStart(csound) == 0);
+    for (k = 0; k < DAG_CYCLES; k++) {
+      csoundPerformKsmps(csound);
+      for (i = 1; i <= DAG_VOICES; i++, out += 16) {
+        sprintf(name, "v%d", i);
+        csoundGetAudioChannel(csound, name, out);
+      }
+      csoundGetAudioChannel(csound, "sum", out);
+      out += 16;
+    }
+    threads = csoundGetActiveThreads(csound);
+    if (msgs != NULL) {
+      csoundCleanup(csound);
+      *msgs = take_messages(csound);
+      csoundDestroyMessageBuffer(csound);
+    }
+    csoundDestroy(csound);
+    return threads;
+}
+
+/* all the voices, playing throughout */
+static void dag_score(char *sco)
+{
+    int     i;
+    for (i = 1; i <= DAG_VOICES; i++)
+      sco += sprintf(sco, "i1 0 10 %d\n", i);
+    sprintf(sco, "i2 0 10\n");
+}
+
+/* the work-stealing dispatchers run the same DAG as the scan one, so
+   give the same samples */
+void test_dag_schedulers(void)
+{
+    static const char *scan_opts[] = { "-j4", "--dag-scheduler=scan", NULL };
+    static const char *steal_opts[] = { "-j4", "--dag-scheduler=steal", NULL };
+    static const char *cost_opts[] = { "-j4", "--dag-scheduler=cost", NULL };
+    static MYFLT scan[DAG_SAMPLES], other[DAG_SAMPLES];
+    char    sco[64*(DAG_VOICES+1)];
+    int     i;
+
+    dag_score(sco);
+    run_dag(scan_opts, sco, scan, NULL);
+    for (i = 0; i < DAG_SAMPLES; i++)
+      if (scan[i] != 0.0) break;
+    CU_ASSERT(i < DAG_SAMPLES);
+    run_dag(steal_opts, sco, other, NULL);
+    CU_ASSERT(memcmp(scan, other, sizeof(scan)) == 0);
+    run_dag(cost_opts, sco, other, NULL);
+    CU_ASSERT(memcmp(scan, other, sizeof(scan)) == 0);
+}
+
+/* Voices start and end at different k-cycles, in the middle of the
+   chain, and come back later, so the DAG is brought up to date a
+   voice at a time rather than rebuilt.  Whatever the scheduler, the
+   result must match the sequential run, which the chain through gasum
+   makes sensitive to any edge or rank the update gets wrong. */
+void test_dag_update(void)
+{
+    static const char *seq_opts[] = { "-j1", NULL };
+    static const char *scan_opts[] = { "-j4", "--dag-scheduler=scan", NULL };
+    static const char *steal_opts[] = { "-j4", "--dag-scheduler=steal", NULL };
+    static MYFLT seq[DAG_SAMPLES], par[DAG_SAMPLES];
+    char    sco[64*(2*DAG_VOICES+1)], *p = sco;
+    int     i;
+
+    for (i = 1; i <= DAG_VOICES; i++)
+      p += sprintf(p, "i1 %.3f %.3f %d\n", 0.002*i, 0.01 + 0.004*(i%3), i);
+    for (i = DAG_VOICES; i >= 1; i--)
+      p += sprintf(p, "i1 %.3f 0.01 %d\n", 0.03 + 0.003*(i%4), i);
+    sprintf(p, "i2 0 10\n");
+    run_dag(seq_opts, sco, seq, NULL);
+    run_dag(scan_opts, sco, par, NULL);
+    CU_ASSERT(memcmp(seq, par, sizeof(seq)) == 0);
+    run_dag(steal_opts, sco, par, NULL);
+    CU_ASSERT(memcmp(seq, par, sizeof(seq)) == 0);
+}
+
+/* With --barrier-spin=0 a thread that finds the barrier closed parks
+   on its condition variable at once; with a large count it spins
+   first.  Both must give the samples of a sequential run, and the
+   barrier statistics (-m128) must count every thread at every
+   k-cycle. */
+void test_barrier_spin(void)
+{
+    static const char *seq_opts[] = { "-j1", NULL };
+    static const char *park_opts[] =
+      { "-j4", "--barrier-spin=0", "-m128", NULL };
+    static const char *spin_opts[] = { "-j4", "--barrier-spin=100000", NULL };
+    static MYFLT seq[DAG_SAMPLES], par[DAG_SAMPLES];
+    char    sco[64*(DAG_VOICES+1)], *msgs, *s;
+    long long waits = 0;
+    double  parked = -1.0;
+
+    dag_score(sco);
+    run_dag(seq_opts, sco, seq, NULL);
+    run_dag(park_opts, sco, par, &msgs);
+    CU_ASSERT(memcmp(seq, par, sizeof(seq)) == 0);
+    s = strstr(msgs, "barrier 1: ");
+    CU_ASSERT_PTR_NOT_NULL(s);
+    if (s != NULL)
+      sscanf(s, "barrier 1: %lld waits, %lf%% parked", &waits, &parked);
+    CU_ASSERT(waits >= 4*DAG_CYCLES);
+    CU_ASSERT(parked > 0.0);
+    free(msgs);
+    run_dag(spin_opts, sco, par, NULL);
+    CU_ASSERT(memcmp(seq, par, sizeof(seq)) == 0);
+}
+
+/* In orc_dag only one task is ready at the start of a k-cycle, so with
+   --adaptive-threads=1 the other workers are parked and one thread
+   does the work; without it all four take part.  Either way the
+   samples are those of a sequential run. */
+void test_adaptive_threads(void)
+{
+    static const char *seq_opts[] = { "-j1", NULL };
+    static const char *fixed_opts[] = { "-j4", "--adaptive-threads=0", NULL };
+    static const char *adapt_opts[] = { "-j4", "--adaptive-threads=1", NULL };
+    static MYFLT seq[DAG_SAMPLES], par[DAG_SAMPLES];
+    char    sco[64*(DAG_VOICES+1)];
+
+    dag_score(sco);
+    CU_ASSERT_EQUAL(run_dag(seq_opts, sco, seq, NULL), 1);
+    CU_ASSERT_EQUAL(run_dag(fixed_opts, sco, par, NULL), 4);
+    CU_ASSERT(memcmp(seq, par, sizeof(seq)) == 0);
+    CU_ASSERT_EQUAL(run_dag(adapt_opts, sco, par, NULL), 1);
+    CU_ASSERT(memcmp(seq, par, sizeof(seq)) == 0);
+}
+
+/* whether text is in the first n characters of s */
+static int line_has(const char *s, size_t n, const char *text)
+{
+    const char *t = strstr(s, text);
+    return t != NULL && t < s + n;
+}
+
+/* whether the line of msgs starting with what says the thread was
+   placed on cpu, or that the placement was refused or unsupported */
+static int placed_on(const char *msgs, const char *what, int cpu)
+{
+    const char *s = strstr(msgs, what), *end;
+    char    want[32];
+    size_t  n;
+
+    if (s == NULL) return 0;
+    end = strchr(s, '\n');
+    n = end != NULL ? (size_t) (end - s) : strlen(s);
+    sprintf(want, " CPU %d", cpu);
+    return line_has(s, n, want) || line_has(s, n, "refused") ||
+      line_has(s, n, "not supported");
+}
+
+/* --thread-cpus=1,0-1 is the list 1,0, so performance threads 0, 1 and
+   2 go to CPUs 1, 0 and 1 (or say that the system refused); a list
+   that does not parse is ignored with a warning.  Placement does not
+   change the samples. */
+void test_thread_placement(void)
+{
+    static const char *seq_opts[] = { "-j1", NULL };
+    static const char *list_opts[] = { "-j3", "--thread-cpus=1,0-1", NULL };
+    static const char *bad_opts[] = { "-j3", "-m4", "--thread-cpus=3-1", NULL };
+    static MYFLT seq[DAG_SAMPLES], par[DAG_SAMPLES];
+    char    sco[64*(DAG_VOICES+1)], *msgs;
+
+    dag_score(sco);
+    run_dag(seq_opts, sco, seq, NULL);
+    run_dag(list_opts, sco, par, &msgs);
+    CU_ASSERT(memcmp(seq, par, sizeof(seq)) == 0);
+    CU_ASSERT(placed_on(msgs, "performance thread 0:", 1));
+    CU_ASSERT(placed_on(msgs, "performance thread 1:", 0));
+    CU_ASSERT(placed_on(msgs, "performance thread 2:", 1));
+    free(msgs);
+    run_dag(bad_opts, sco, par, &msgs);
+    CU_ASSERT(memcmp(seq, par, sizeof(seq)) == 0);
+    CU_ASSERT_PTR_NOT_NULL(strstr(msgs, "invalid CPU list '3-1' ignored"));
+    CU_ASSERT_PTR_NULL(strstr(msgs, "performance thread"));
+    free(msgs);
+}
+
+/* the messages printed running orc and sco with the options in the
+   NULL-terminated list opts, for kcycles k-cycles or, if that is 0,
+   to the end of the score, one string the caller frees.  If chn is
+   not NULL, out gets that control channel after each k-cycle. */
+static char *run_orc(const char *orc, const char *sco,
+                     const char *const *opts, int kcycles,
+                     const char *chn, MYFLT *out)
+{
+    CSOUND  *csound;
+    char    *msgs;
+    int     k, err;
+
+    csound = csoundCreate(NULL);
+    csoundCreateMessageBuffer(csound, 0);
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-m0");
+    for ( ; *opts != NULL; opts++)
+      csoundSetOption(csound, (char *) *opts);
+    CU_ASSERT(csoundCompileOrc(csound, orc) == 0);
+    CU_ASSERT(csoundReadScore(csound, sco) == 0);
+    CU_ASSERT(csoundStart(csound) == 0);
+    for (k = 0; kcycles == 0 || k < kcycles; k++) {
+      if (csoundPerformKsmps(csound) != 0) break;
+      if (chn != NULL)
+        out[k] = csoundGetControlChannel(csound, chn, &err);
+    }
+    csoundCleanup(csound);
+    msgs = take_messages(csound);
+    csoundDestroyMessageBuffer(csound);
+    csoundDestroy(csound);
+    return msgs;
+}
+
+/* instr 1 to 3 are chained through the channel "left" and table 1;
+   instr 4 uses only the channel "right" and table 2, so it depends on
+   none of them once the names are told apart */
+#define RES_CYCLES  100
+
+static const char *orc_res =
+    "ksmps = 16\n"
+    "nchnls = 1\n"
+    "0dbfs = 1\n"
+    "gi1 ftgen 1, 0, 16, -2, 0\n"
+    "gi2 ftgen 2, 0, 16, -2, 0\n"
+    "instr 1\n"
+    "a1 oscili 0.1, 440\n"
+    "a2 butterlp a1, 1000\n"
+    "k1 = p4\n"
+    "chnset k1, \"left\"\n"
+    "endin\n"
+    "instr 2\n"
+    "a1 oscili 0.1, 440\n"
+    "a2 butterlp a1, 1000\n"
+    "k1 chnget \"left\"\n"
+    "tablew k1 * 2, 0, 1\n"
+    "endin\n"
+    "instr 3\n"
+    "a1 oscili 0.1, 440\n"
+    "a2 butterlp a1, 1000\n"
+    "k1 table 0, 1\n"
+    "chnset k1 + 1, \"out\"\n"
+    "endin\n"
+    "instr 4\n"
+    "k1 = p4\n"
+    "chnset k1, \"right\"\n"
+    "tablew k1, 0, 2\n"
+    "endin\n";
+
+/* --dag-report names the channel and the table serialising the chain
+   on its critical path, and nothing instr 4 uses; the chain runs in
+   order on any number of threads */
+void test_dag_resources(void)
+{
+    static const char *seq_opts[] = { "-j1", NULL };
+    static const char *par_opts[] = { "-j4", "--dag-report", NULL };
+    static const char *sco = "i1 0 10 3\ni2 0 10\ni3 0 10\ni4 0 10 5\n";
+    MYFLT   seq[RES_CYCLES], par[RES_CYCLES];
+    char    *msgs;
+    int     k;
+
+    free(run_orc(orc_res, sco, seq_opts, RES_CYCLES, "out", seq));
+    msgs = run_orc(orc_res, sco, par_opts, RES_CYCLES, "out", par);
+    for (k = 0; k < RES_CYCLES; k++) {
+      CU_ASSERT_DOUBLE_EQUAL(seq[k], 7.0, 0.0);
+      CU_ASSERT_DOUBLE_EQUAL(par[k], 7.0, 0.0);
+    }
+    CU_ASSERT_PTR_NOT_NULL(strstr(msgs, "DAG report: "));
+    CU_ASSERT_PTR_NOT_NULL(
+      strstr(msgs, "instr 1 -[##chn:left]-> instr 2 -[##tab:1]-> instr 3"));
+    CU_ASSERT_PTR_NULL(strstr(msgs, "##chn:right"));
+    CU_ASSERT_PTR_NULL(strstr(msgs, "##tab:2"));
+    CU_ASSERT_PTR_NULL(strstr(msgs, "-[##chn]->"));
+    CU_ASSERT_PTR_NULL(strstr(msgs, "-[##tab]->"));
+    free(msgs);
+}
+
+/* each note of instr 1 writes p4 to the channel named by p5 */
+static const char *orc_pool =
+    "ksmps = 16\n"
+    "nchnls = 1\n"
+    "0dbfs = 1\n"
+    "instr 1\n"
+    "k1 = p4\n"
+    "Sname sprintf \"n%d\", p5\n"
+    "chnset k1, Sname\n"
+    "endin\n";
+
+/* the same instrument with more variables, writing 10*p4 + 1 */
+static const char *orc_pool2 =
+    "instr 1\n"
+    "a1 oscili 0.1, 440\n"
+    "a2 butterlp a1, 1000\n"
+    "k1 = p4\n"
+    "k2 = k1 * 10\n"
+    "k3 = k2 + 1\n"
+    "Sname sprintf \"n%d\", p5\n"
+    "chnset k3, Sname\n"
+    "endin\n";
+
+/* Three notes at once cut two slabs, of one and two instances.  The
+   next section gets the instances orcompact freed from the pool, so
+   the report (-m128) still counts two allocations. */
+void test_instance_pool(void)
+{
+    static const char *opts[] = { "-m128", NULL };
+    static const char *sco =
+      "i1 0 0.01 1 1\ni1 0 0.01 2 2\ni1 0 0.01 3 3\ns\n"
+      "i1 0 0.01 1 1\ni1 0 0.01 2 2\ni1 0 0.01 3 3\ne\n";
+    char    *msgs;
+
+    msgs = run_orc(orc_pool, sco, opts, 0, NULL, NULL);
+    CU_ASSERT_PTR_NOT_NULL(strstr(msgs, "SECTION 2:"));
+    CU_ASSERT_PTR_NOT_NULL(strstr(msgs, "instances allocated while "
+                                  "performing"));
+    CU_ASSERT_PTR_NOT_NULL(strstr(msgs, "  instr 1: 2 allocations, "
+                                  "3 instances at most"));
+    free(msgs);
+}
+
+/* Instr 1 is redefined with more variables while two of its notes
+   play.  Those go on with the old code and the old instance pool,
+   new notes get the larger instances of the new one, and once the old
+   notes are gone and their instrument freed, further notes still
+   play. */
+void test_recompile_live(void)
+{
+    CSOUND  *csound;
+    int     k, err, ok = 1;
+
+    csound = csoundCreate(NULL);
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-m0");
+    CU_ASSERT(csoundCompileOrc(csound, orc_pool) == 0);
+    CU_ASSERT(csoundReadScore(csound, "f0 10\n"
+                              "i1 0 0.5 1 1\ni1 0 0.5 2 2\n") == 0);
+    CU_ASSERT(csoundStart(csound) == 0);
+    for (k = 0; k < 50; k++)
+      ok &= csoundPerformKsmps(csound) == 0;
+    CU_ASSERT(csoundCompileOrc(csound, orc_pool2) == 0);
+    csoundInputMessage(csound, "i1 0 0.1 3 3\ni1 0 0.1 4 4\n");
+    for (k = 0; k < 100; k++)
+      ok &= csoundPerformKsmps(csound) == 0;
+    CU_ASSERT_DOUBLE_EQUAL(csoundGetControlChannel(csound, "n1", &err),
+                           1.0, 0.0);
+    CU_ASSERT_DOUBLE_EQUAL(csoundGetControlChannel(csound, "n2", &err),
+                           2.0, 0.0);
+    CU_ASSERT_DOUBLE_EQUAL(csoundGetControlChannel(csound, "n3", &err),
+                           31.0, 0.0);
+    CU_ASSERT_DOUBLE_EQUAL(csoundGetControlChannel(csound, "n4", &err),
+                           41.0, 0.0);
+    /* all four notes end */
+    for (k = 0; k < 1500; k++)
+      ok &= csoundPerformKsmps(csound) == 0;
+    csoundInputMessage(csound, "i1 0 0.1 5 5\ni1 0 0.1 6 6\ni1 0 0.1 7 7\n");
+    for (k = 0; k < 10; k++)
+      ok &= csoundPerformKsmps(csound) == 0;
+    CU_ASSERT_DOUBLE_EQUAL(csoundGetControlChannel(csound, "n5", &err),
+                           51.0, 0.0);
+    CU_ASSERT_DOUBLE_EQUAL(csoundGetControlChannel(csound, "n7", &err),
+                           71.0, 0.0);
+    CU_ASSERT(ok);
+    csoundDestroy(csound);
+}
+
+/* occurrences of text in msgs between the lines "SECTION n:" and
+   "SECTION n+1:" */
+static int section_count(const char *msgs, int n, const char *text)
+{
+    char    head[32];
+    const char *s, *end;
+    int     cnt = 0;
+
+    sprintf(head, "SECTION %d:", n);
+    if ((s = strstr(msgs, head)) == NULL) return -1;
+    sprintf(head, "SECTION %d:", n+1);
+    end = strstr(s, head);
+    while ((s = strstr(s, text)) != NULL && (end == NULL || s < end)) {
+      cnt++;
+      s += strlen(text);
+    }
+    return cnt;
+}
+
+/* each note of instr 1 delays by p4 seconds, 480 or 960 samples */
+static const char *orc_aux =
+    "sr = 48000\n"
+    "ksmps = 16\n"
+    "nchnls = 1\n"
+    "0dbfs = 1\n"
+    "instr 1\n"
+    "a1 oscili 0.1, 440\n"
+    "a2 delay a1, p4\n"
+    "chnset a2, \"out\"\n"
+    "endin\n";
+
+/* With --aux-strict every AuxAlloc not served from a region is
+   reported.  The first note has no budget yet, so its delay line is
+   allocated outside, which sets the budget.  The second, longer one
+   takes a new region, does not fit it and raises the budget.  The
+   third takes a new region of the raised budget, since the old one was
+   too small to keep, and the fourth reuses that region: nothing is
+   reported.  Without --aux-strict nothing is ever reported. */
+void test_aux_arena(void)
+{
+    static const char *strict_opts[] = { "-m4", "--aux-strict", NULL };
+    static const char *quiet_opts[] = { "-m4", NULL };
+    static const char *sco =
+      "i1 0 0.01 0.01\ns\ni1 0 0.01 0.02\ns\n"
+      "i1 0 0.01 0.02\ns\ni1 0 0.01 0.02\ne\n";
+    static const char *outside = "outside the AuxAlloc arena";
+    char    small[64], large[64], *msgs;
+
+    sprintf(small, "delay allocated %d bytes",
+            (int) (480 * sizeof(MYFLT)));
+    sprintf(large, "delay allocated %d bytes",
+            (int) (960 * sizeof(MYFLT)));
+    msgs = run_orc(orc_aux, sco, strict_opts, 0, NULL, NULL);
+    CU_ASSERT_EQUAL(section_count(msgs, 1, outside), 1);
+    CU_ASSERT_EQUAL(section_count(msgs, 1, small), 1);
+    CU_ASSERT_EQUAL(section_count(msgs, 2, outside), 2);
+    CU_ASSERT_EQUAL(section_count(msgs, 2, small), 1);
+    CU_ASSERT_EQUAL(section_count(msgs, 2, large), 1);
+    CU_ASSERT_EQUAL(section_count(msgs, 3, outside), 1);
+    CU_ASSERT_EQUAL(section_count(msgs, 3, large), 1);
+    CU_ASSERT_EQUAL(section_count(msgs, 4, outside), 0);
+    free(msgs);
+    msgs = run_orc(orc_aux, sco, quiet_opts, 0, NULL, NULL);
+    CU_ASSERT_PTR_NOT_NULL(strstr(msgs, "SECTION 4:"));
+    CU_ASSERT_PTR_NULL(strstr(msgs, outside));
+    free(msgs);
+}
+
 int main()
 {
     CU_pSuite pSuite = NULL;
@@ -73,6 +670,30 @@ int main()
     if ((NULL == CU_add_test(pSuite, "Test daemon mode", test_daemon))
         || (NULL == CU_add_test(pSuite, "Test evalcode", test_eval_code))
 	|| (NULL == CU_add_test(pSuite, "Test compileAsync", test_compile_async)) 
+        || (NULL == CU_add_test(pSuite, "Test opcode profile",
+                                test_opcode_profile))
+        || (NULL == CU_add_test(pSuite, "Test k-cycle timing",
+                                test_kcycle_timing))
+        || (NULL == CU_add_test(pSuite, "Test memory accounting",
+                                test_memory_accounting))
+        || (NULL == CU_add_test(pSuite, "Test DAG schedulers",
+                                test_dag_schedulers))
+        || (NULL == CU_add_test(pSuite, "Test DAG update",
+                                test_dag_update))
+        || (NULL == CU_add_test(pSuite, "Test barrier spin",
+                                test_barrier_spin))
+        || (NULL == CU_add_test(pSuite, "Test adaptive threads",
+                                test_adaptive_threads))
+        || (NULL == CU_add_test(pSuite, "Test thread placement",
+                                test_thread_placement))
+        || (NULL == CU_add_test(pSuite, "Test DAG resources",
+                                test_dag_resources))
+        || (NULL == CU_add_test(pSuite, "Test instance pool",
+                                test_instance_pool))
+        || (NULL == CU_add_test(pSuite, "Test recompile with live notes",
+                                test_recompile_live))
+        || (NULL == CU_add_test(pSuite, "Test AuxAlloc arenas",
+                                test_aux_arena))
 	)
     {
         CU_cleanup_registry();
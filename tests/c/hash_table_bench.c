@@ -0,0 +1,136 @@
+/*
+ * File:   hash_table_bench.c
+ *
+ * Times the two uses of CS_HASH_TABLE that matter most: compiling a
+ * large orchestra (variable pools, the opcode table, named instruments
+ * and constants) and looking channels up by name, then the table on its
+ * own: lookups among CHANNELS keys, ROUNDS of a table of 2000 keys
+ * filled, read and freed, and 20000 tables of one key.  See bench.h.
+ *
+ * usage: benchHashTable [instruments] [lookups]
+ */
+
+#define __BUILDING_LIBCSOUND
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "csoundCore.h"
+#include "bench.h"
+
+#define CHANNELS 10000
+#define ROUNDS   100
+
+/* n instruments of 24 lines, each with its own locals, a named
+   instrument and a few channels */
+static void table_bench(CSOUND *csound, char (*names)[32], int lookups)
+{
+    CS_HASH_TABLE *table;
+    RTCLOCK  clk;
+    unsigned int seed = 1;
+    int      i, k;
+    void     *sum = NULL;
+
+    table = cs_hash_table_create(csound);
+    for (i = 0; i < CHANNELS; i++)
+      cs_hash_table_put(csound, table, names[i], names[i]);
+    csoundInitTimerStruct(&clk);
+    for (i = 0; i < lookups; i++) {
+      seed = seed * 1103515245u + 12345u;
+      sum = cs_hash_table_get(csound, table, names[(seed >> 8) % CHANNELS]);
+    }
+    printf("table: %d lookups among %d keys: %.1f ns/lookup\n", lookups,
+           CHANNELS, 1.0e9 * csoundGetRealTime(&clk) / lookups);
+    cs_hash_table_free(csound, table);
+
+    csoundInitTimerStruct(&clk);
+    for (k = 0; k < ROUNDS; k++) {
+      table = cs_hash_table_create(csound);
+      for (i = 0; i < 2000; i++)
+        cs_hash_table_put(csound, table, names[i], names[i]);
+      for (i = 0; i < 2000; i++)
+        sum = cs_hash_table_get(csound, table, names[i]);
+      cs_hash_table_free(csound, table);
+    }
+    printf("table: create, 2000 puts and gets, free: %.3f ms\n",
+           1.0e3 * csoundGetRealTime(&clk) / ROUNDS);
+
+    csoundInitTimerStruct(&clk);
+    for (i = 0; i < 20000; i++) {
+      table = cs_hash_table_create(csound);
+      cs_hash_table_put(csound, table, names[i % CHANNELS], names[i]);
+      cs_hash_table_free(csound, table);
+    }
+    printf("table: 20000 tables of one key: %.1f ms\n",
+           1.0e3 * csoundGetRealTime(&clk));
+    (void) sum;
+}
+
+static char *make_orc(int n)
+{
+    size_t  size = 1024 + (size_t) n * 2048;
+    char    *orc = malloc(size), *p = orc;
+    int     i, k;
+
+    p += sprintf(p, "sr = 44100\nksmps = 32\nnchnls = 2\n0dbfs = 1\n");
+    for (i = 0; i < n; i++) {
+      p += sprintf(p, "instr %d, voice%d\n", i + 1, i);
+      for (k = 0; k < 8; k++)
+        p += sprintf(p, "k%d_%d chnget \"ctl.%d.%d\"\n", k, i, i, k);
+      for (k = 0; k < 8; k++)
+        p += sprintf(p, "a%d_%d oscili k%d_%d * %d.%d, %d\n",
+                     k, i, k, i, k, i, 110 + 10*k + i);
+      p += sprintf(p, "aout = a0_%d + a1_%d + a2_%d + a3_%d + "
+                   "a4_%d + a5_%d + a6_%d + a7_%d\n",
+                   i, i, i, i, i, i, i, i);
+      p += sprintf(p, "chnmix aout, \"bus.%d\"\n", i % 16);
+      p += sprintf(p, "outs aout, aout\nendin\n");
+    }
+    return orc;
+}
+
+int main(int argc, char **argv)
+{
+    int      instrs = argc > 1 ? atoi(argv[1]) : 2000;
+    int      lookups = argc > 2 ? atoi(argv[2]) : 1000000;
+    CSOUND   *csound;
+    RTCLOCK  clk;
+    char     *orc, (*names)[32];
+    MYFLT    *p;
+    double   t;
+    unsigned int seed = 1;
+    int      i, err;
+
+    bench_init();
+    csound = csoundCreate(NULL);
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-m0");
+
+    orc = make_orc(instrs);
+    csoundInitTimerStruct(&clk);
+    err = csoundCompileOrc(csound, orc);
+    t = csoundGetRealTime(&clk);
+    printf("compile %d instruments: %s %.1f ms\n",
+           instrs, err ? "failed" : "", 1.0e3 * t);
+    free(orc);
+
+    names = malloc(CHANNELS * sizeof(*names));
+    for (i = 0; i < CHANNELS; i++) {
+      sprintf(names[i], "instr.%d.param%d", i / 16, i % 16);
+      csoundGetChannelPtr(csound, &p, names[i],
+                          CSOUND_CONTROL_CHANNEL | CSOUND_INPUT_CHANNEL);
+    }
+    csoundInitTimerStruct(&clk);
+    for (i = 0; i < lookups; i++) {
+      seed = seed * 1103515245u + 12345u;
+      csoundGetChannelPtr(csound, &p, names[(seed >> 8) % CHANNELS],
+                          CSOUND_CONTROL_CHANNEL | CSOUND_INPUT_CHANNEL);
+    }
+    t = csoundGetRealTime(&clk);
+    printf("%d lookups of %d channels: %.1f ns/lookup\n",
+           lookups, CHANNELS, 1.0e9 * t / lookups);
+    table_bench(csound, names, lookups);
+    free(names);
+    csoundDestroy(csound);
+    return 0;
+}
@@ -0,0 +1,130 @@
+/*
+ * File:   memalloc_bench.c
+ *
+ * Times csound->Malloc, Calloc, ReAlloc and Free from 1, 2, 4 and 8
+ * threads at once, with a mix of sizes like the engine's (mostly small
+ * instance and opcode blocks, some large tables), and a share of blocks
+ * freed by a thread other than the one that allocated them, and prints
+ * the mean time per operation.  Build csound with and without
+ * -DUSE_ARENA_ALLOC=ON to compare the two allocators.  See bench.h.
+ *
+ * usage: benchMemalloc [operations per thread]
+ */
+
+#define __BUILDING_LIBCSOUND
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "csoundCore.h"
+#include "bench.h"
+
+#define SLOTS   4096            /* live blocks per thread */
+
+typedef struct {
+    CSOUND      *csound;
+    int         index;
+    int         ops;
+    void        **slots;        /* own blocks */
+    void        **inbox;        /* blocks left by the previous thread */
+    void        **outbox;       /* the next thread's inbox */
+} BENCH;
+
+static BENCH bench[8];
+
+static size_t next_size(unsigned int *seed)
+{
+    unsigned int r;
+    *seed = *seed * 1103515245u + 12345u;
+    r = *seed >> 8;
+    if (r % 64 == 0) return 32768 + r % 65536;  /* tables and buffers */
+    if (r % 8 == 0) return 512 + r % 4096;      /* instances */
+    return 8 + r % 248;                         /* opcode data */
+}
+
+static uintptr_t worker(void *arg)
+{
+    BENCH    *b = (BENCH*) arg;
+    CSOUND   *csound = b->csound;
+    unsigned int seed = 17 + b->index;
+    int      i, k;
+
+    for (i = 0; i < b->ops; i++) {
+      void *p;
+      seed = seed * 1103515245u + 12345u;
+      k = (seed >> 8) % SLOTS;
+      /* free what the previous thread left here, in its arena */
+      if (b->inbox[k] != NULL &&
+          (p = __sync_lock_test_and_set(&b->inbox[k], NULL)) != NULL)
+        csound->Free(csound, p);
+      if (b->slots[k] == NULL) {
+        size_t n = next_size(&seed);
+        b->slots[k] = (i & 1) ? csound->Malloc(csound, n)
+                              : csound->Calloc(csound, n);
+      }
+      else if ((seed >> 20) % 16 == 0) {
+        b->slots[k] = csound->ReAlloc(csound, b->slots[k],
+                                      next_size(&seed));
+      }
+      else if ((seed >> 20) % 16 == 1) {
+        /* leave it for the next thread to free */
+        p = __sync_lock_test_and_set(&b->outbox[k], b->slots[k]);
+        b->slots[k] = NULL;
+        if (p != NULL) csound->Free(csound, p);
+      }
+      else {
+        csound->Free(csound, b->slots[k]);
+        b->slots[k] = NULL;
+      }
+    }
+    return 0;
+}
+
+static double run(CSOUND *csound, int threads, int ops)
+{
+    void    *thread[8];
+    RTCLOCK clk;
+    double  t;
+    int     i, k;
+
+    for (i = 0; i < threads; i++) {
+      bench[i].csound = csound;
+      bench[i].index = i;
+      bench[i].ops = ops;
+      bench[i].slots = calloc(SLOTS, sizeof(void*));
+      bench[i].inbox = calloc(SLOTS, sizeof(void*));
+    }
+    /* with one thread the blocks come back to the thread itself */
+    for (i = 0; i < threads; i++)
+      bench[i].outbox = bench[(i + 1) % threads].inbox;
+    csoundInitTimerStruct(&clk);
+    for (i = 0; i < threads; i++)
+      thread[i] = csoundCreateThread(worker, &bench[i]);
+    for (i = 0; i < threads; i++)
+      csoundJoinThread(thread[i]);
+    t = csoundGetRealTime(&clk);
+    for (i = 0; i < threads; i++) {
+      for (k = 0; k < SLOTS; k++) {
+        csound->Free(csound, bench[i].slots[k]);
+        csound->Free(csound, bench[i].inbox[k]);
+      }
+      free(bench[i].slots);
+      free(bench[i].inbox);
+    }
+    return 1.0e9 * t / ((double) ops * threads);
+}
+
+int main(int argc, char **argv)
+{
+    static const int threads[] = { 1, 2, 4, 8 };
+    int      ops = argc > 1 ? atoi(argv[1]) : 2000000;
+    CSOUND   *csound;
+    unsigned int i;
+
+    bench_init();
+    csound = csoundCreate(NULL);
+    printf("%8s %14s\n", "threads", "ns/op");
+    for (i = 0; i < sizeof(threads)/sizeof(int); i++)
+      printf("%8d %14.1f\n", threads[i], run(csound, threads[i], ops));
+    csoundDestroy(csound);
+    return 0;
+}
@@ -0,0 +1,196 @@
+/*
+ * File:   memalloc_test.c
+ *
+ * Checks csound->Malloc, Calloc, ReAlloc and Free: contents kept across
+ * ReAlloc as blocks grow and shrink between the small size classes and
+ * large blocks, zeroed Calloc blocks, and blocks freed by a thread other
+ * than the one that allocated them.  Run it in a build with
+ * -DUSE_ARENA_ALLOC=ON to cover the per-thread arenas.
+ */
+
+#define __BUILDING_LIBCSOUND
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "csoundCore.h"
+#include "CUnit/Basic.h"
+
+#define BLOCKS  1024            /* passed between the threads per round */
+#define ROUNDS  64
+
+int init_suite1(void)
+{
+    return 0;
+}
+
+int clean_suite1(void)
+{
+    return 0;
+}
+
+static void fill(unsigned char *p, size_t n, unsigned int seed)
+{
+    size_t i;
+    for (i = 0; i < n; i++) p[i] = (unsigned char) (seed + i*7);
+}
+
+static int check(const unsigned char *p, size_t n, unsigned int seed)
+{
+    size_t i;
+    for (i = 0; i < n; i++)
+      if (p[i] != (unsigned char) (seed + i*7)) return 0;
+    return 1;
+}
+
+static int zeroed(const unsigned char *p, size_t n)
+{
+    size_t i;
+    for (i = 0; i < n; i++)
+      if (p[i] != 0) return 0;
+    return 1;
+}
+
+void test_sizes(void)
+{
+    CSOUND  *csound = csoundCreate(NULL);
+    void    *p[64];
+    size_t  n;
+    int     i;
+
+    /* each small class, its edges, and large blocks */
+    for (n = 1, i = 0; n <= 262144; n += n/3 + 1, i++) {
+      p[i] = csound->Calloc(csound, n);
+      CU_ASSERT_PTR_NOT_NULL_FATAL(p[i]);
+      CU_ASSERT(((uintptr_t) p[i] & 7) == 0);
+      CU_ASSERT(zeroed(p[i], n));
+      fill(p[i], n, i);
+    }
+    for (n = 1, i = 0; n <= 262144; n += n/3 + 1, i++) {
+      CU_ASSERT(check(p[i], n, i));
+      csound->Free(csound, p[i]);
+    }
+    /* freed blocks come back zeroed from Calloc */
+    for (n = 1; n <= 262144; n += n/3 + 1) {
+      unsigned char *q = csound->Calloc(csound, n);
+      CU_ASSERT(zeroed(q, n));
+      csound->Free(csound, q);
+    }
+    csoundDestroy(csound);
+}
+
+void test_realloc(void)
+{
+    CSOUND  *csound = csoundCreate(NULL);
+    unsigned char *p = csound->Malloc(csound, 8);
+    size_t  n = 8, m;
+
+    /* grow through the classes into a large block, keeping the data */
+    fill(p, n, 3);
+    for (m = 12; m <= 200000; m += m/2) {
+      p = csound->ReAlloc(csound, p, m);
+      CU_ASSERT_PTR_NOT_NULL_FATAL(p);
+      CU_ASSERT(check(p, n, 3));
+      fill(p, m, 3);
+      n = m;
+    }
+    /* large to large, then back down to a small class */
+    p = csound->ReAlloc(csound, p, 400000);
+    CU_ASSERT(check(p, n, 3));
+    p = csound->ReAlloc(csound, p, 100000);
+    CU_ASSERT(check(p, 100000, 3));
+    p = csound->ReAlloc(csound, p, 100);
+    CU_ASSERT(check(p, 100, 3));
+    p = csound->ReAlloc(csound, p, 20);
+    CU_ASSERT(check(p, 20, 3));
+    CU_ASSERT_PTR_NULL(csound->ReAlloc(csound, p, 0));
+    csoundDestroy(csound);
+}
+
+typedef struct {
+    CSOUND          *csound;
+    void            **blocks;
+    volatile int    round;      /* last round handed over */
+    volatile int    freed;      /* last round freed */
+    int             errors;
+} XFREE;
+
+static size_t xsize(int round, int i)
+{
+    return (size_t) (16 + (round*31 + i*17) % 2000) *
+      ((i % 97) == 0 ? 64 : 1);
+}
+
+/* frees the blocks of each round, checking what the owner wrote */
+static uintptr_t xfree_thread(void *arg)
+{
+    XFREE   *x = (XFREE*) arg;
+    int     r, i;
+
+    for (r = 1; r <= ROUNDS; r++) {
+      while (ATOMIC_GET(x->round) < r) csoundSleep(0);
+      for (i = 0; i < BLOCKS; i++) {
+        if (!check(x->blocks[i], xsize(r, i), r + i)) x->errors++;
+        x->csound->Free(x->csound, x->blocks[i]);
+      }
+      ATOMIC_SET(x->freed, r);
+    }
+    return 0;
+}
+
+void test_cross_thread_free(void)
+{
+    XFREE   x;
+    void    *thread;
+    int     r, i;
+
+    x.csound = csoundCreate(NULL);
+    x.blocks = calloc(BLOCKS, sizeof(void*));
+    x.round = x.freed = x.errors = 0;
+    thread = csoundCreateThread(xfree_thread, &x);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(thread);
+    for (r = 1; r <= ROUNDS; r++) {
+      /* the blocks freed by the other thread are reused here */
+      for (i = 0; i < BLOCKS; i++) {
+        size_t n = xsize(r, i);
+        x.blocks[i] = (i & 1) ? x.csound->Calloc(x.csound, n)
+                              : x.csound->Malloc(x.csound, n);
+        if ((i & 1) && !zeroed(x.blocks[i], n)) x.errors++;
+        fill(x.blocks[i], n, r + i);
+      }
+      ATOMIC_SET(x.round, r);
+      while (ATOMIC_GET(x.freed) < r) csoundSleep(0);
+    }
+    csoundJoinThread(thread);
+    CU_ASSERT_EQUAL(x.errors, 0);
+    free(x.blocks);
+    /* everything is released by a reset, and allocation still works */
+    csoundReset(x.csound);
+    x.blocks = x.csound->Malloc(x.csound, 64);
+    CU_ASSERT_PTR_NOT_NULL(x.blocks);
+    x.csound->Free(x.csound, x.blocks);
+    csoundDestroy(x.csound);
+}
+
+int main()
+{
+    CU_pSuite pSuite = NULL;
+
+    if (CUE_SUCCESS != CU_initialize_registry())
+      return CU_get_error();
+    pSuite = CU_add_suite("memalloc tests", init_suite1, clean_suite1);
+    if (NULL == pSuite) {
+      CU_cleanup_registry();
+      return CU_get_error();
+    }
+    if ((NULL == CU_add_test(pSuite, "Test sizes", test_sizes)) ||
+        (NULL == CU_add_test(pSuite, "Test realloc", test_realloc)) ||
+        (NULL == CU_add_test(pSuite, "Test cross-thread free",
+                             test_cross_thread_free))) {
+      CU_cleanup_registry();
+      return CU_get_error();
+    }
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+}
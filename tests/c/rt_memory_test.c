@@ -0,0 +1,87 @@
+/*
+ * File:   rt_memory_test.c
+ *
+ * Tests --rt-memory, which locks the memory of the whole process with
+ * mlockall(MCL_FUTURE), so it runs in an executable of its own rather
+ * than with the other engine tests.
+ */
+
+#include "csound.h"
+#include <stdio.h>
+#include <string.h>
+#include <CUnit/Basic.h>
+
+int init_suite1(void)
+{
+    return 0;
+}
+
+int clean_suite1(void)
+{
+    return 0;
+}
+
+void test_rt_memory(void)
+{
+    CSOUND  *csound;
+    CS_KCYCLE_TIMING t;
+    int i;
+    csound = csoundCreate(NULL);
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "--rt-memory");
+    csoundCompileOrc(csound, "instr 1\n"
+                             "a1 oscili 0.1, 440\n"
+                             "a2 delay a1, 0.5\n"
+                             "endin\n"
+                             "gi1 ftgen 1, 0, 1048576, 10, 1\n"
+                             "schedule 1,0,10\n");
+    csoundStart(csound);
+    /* the note starts and its delay line is allocated */
+    for (i = 0; i < 10; i++)
+      csoundPerformKsmps(csound);
+    CU_ASSERT_EQUAL(csoundGetKcycleTiming(csound, CS_KCYCLE_TOTAL, &t),
+                    CSOUND_SUCCESS);
+    CU_ASSERT_EQUAL(t.cycles, 10);
+    CU_ASSERT(t.fault_cycles <= t.cycles);
+    CU_ASSERT(t.fault_cycles == 0 || t.minor_faults + t.major_faults > 0);
+    /* then it plays in memory that is locked and already touched */
+    csoundResetKcycleTiming(csound);
+    for (i = 0; i < 200; i++)
+      csoundPerformKsmps(csound);
+    CU_ASSERT_EQUAL(csoundGetKcycleTiming(csound, CS_KCYCLE_TOTAL, &t),
+                    CSOUND_SUCCESS);
+    CU_ASSERT_EQUAL(t.cycles, 200);
+    CU_ASSERT_EQUAL(t.major_faults, 0);
+    CU_ASSERT_EQUAL(t.minor_faults, 0);
+    CU_ASSERT_EQUAL(t.fault_cycles, 0);
+    csoundDestroy(csound);
+}
+
+int main()
+{
+    CU_pSuite pSuite = NULL;
+
+    /* initialize the CUnit test registry */
+    if (CUE_SUCCESS != CU_initialize_registry())
+        return CU_get_error();
+
+    /* add a suite to the registry */
+    pSuite = CU_add_suite("real-time memory tests", init_suite1, clean_suite1);
+    if (NULL == pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    /* add the tests to the suite */
+    if (NULL == CU_add_test(pSuite, "Test real-time memory", test_rt_memory))
+    {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    /* Run all tests using the CUnit Basic interface */
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+}
@@ -0,0 +1,93 @@
+/*
+ * File:   udo_bench.c
+ *
+ * Times a library of nested user-defined opcodes: a voice UDO built
+ * from three small ones, called VOICES times from a chain UDO in each
+ * instance.  Every call passes a-rate arguments, so without inlining
+ * the cost is dominated by moving arguments in and out of the UDO
+ * instances.  Runs with --udo-inline=0 (calls, inputs read in place)
+ * and with inlining, and prints the mean time per UDO call of the
+ * source.  See bench.h.
+ *
+ * usage: benchUDO [instances] [seconds]
+ */
+
+#include <string.h>
+#include "bench.h"
+
+#define VOICES  8       /* voice calls per instance */
+#define CALLS   (1 + VOICES * 4)
+
+static const char *udos =
+    "opcode gain, a, ak\n"
+    "ain, kg xin\n"
+    "xout ain * kg\n"
+    "endop\n"
+    "opcode smooth, a, ak\n"
+    "ain, kcf xin\n"
+    "aout tone ain, kcf\n"
+    "xout aout\n"
+    "endop\n"
+    "opcode mix, a, aa\n"
+    "a1, a2 xin\n"
+    "xout (a1 + a2) * 0.5\n"
+    "endop\n"
+    "opcode voice, a, akk\n"
+    "ain, kg, kcf xin\n"
+    "a1 gain ain, kg\n"
+    "a2 smooth a1, kcf\n"
+    "a3 mix a1, a2\n"
+    "xout a3\n"
+    "endop\n";
+
+static char *make_orc(int ksmps, int instances)
+{
+    size_t  size = 4096 + (size_t) instances * 64;
+    char    *orc = malloc(size), *p = orc;
+    int     i;
+
+    p += sprintf(p, "sr = 48000\nksmps = %d\nnchnls = 1\n0dbfs = 1\n%s",
+                 ksmps, udos);
+    p += sprintf(p, "opcode chain, a, a\nain xin\na0 = ain\n");
+    for (i = 1; i <= VOICES; i++)
+      p += sprintf(p, "a%d voice a%d, 0.9, %d\n", i, i - 1, 1000 + i * 100);
+    p += sprintf(p, "xout a%d\nendop\n", VOICES);
+    p += sprintf(p, "instr 1\nasig oscili 0.1, 100 + p4\n"
+                 "aout chain asig\nout aout\nendin\n");
+    for (i = 0; i < instances; i++)
+      p += sprintf(p, "schedule 1, 0, -1, %d\n", i);
+    return orc;
+}
+
+static double run(int ksmps, int instances, double seconds,
+                  const char *option)
+{
+    const char *opts[] = { option, NULL };
+    CSOUND   *csound;
+    char     *orc = make_orc(ksmps, instances);
+    long     cycles = (long) (seconds * 48000 / ksmps);
+    double   t;
+
+    csound = bench_start(orc, NULL, opts);
+    free(orc);
+    t = bench_perform(csound, cycles);
+    bench_end(csound);
+    return 1.0e9 * t / ((double) cycles * instances * CALLS);
+}
+
+int main(int argc, char **argv)
+{
+    int     instances = argc > 1 ? atoi(argv[1]) : 32;
+    double  seconds = argc > 2 ? atof(argv[2]) : 10.0;
+    int     ksmps[2] = { 16, 64 }, i;
+
+    bench_init();
+    for (i = 0; i < 2; i++) {
+      printf("ksmps %2d, %d instances: %.2f ns/call as calls, ",
+             ksmps[i], instances,
+             run(ksmps[i], instances, seconds, "--udo-inline=0"));
+      printf("%.2f ns/call inlined\n",
+             run(ksmps[i], instances, seconds, "--udo-inline=16"));
+    }
+    return 0;
+}
@@ -1049,6 +1049,11 @@ try:
 except OSError:
     pass
 
+try:
+    os.remove("RTViolations")
+except OSError:
+    pass
+
 for filename in testFiles:
 
     replaceText = (csound, flags, filename, filename)
@@ -1057,9 +1062,25 @@ for filename in testFiles:
     md5sumCommand = "md5sum -b %s.wav >> CheckSums"%filename
 
     print csCommand
+    try:
+        start = os.path.getsize("Output")
+    except OSError:
+        start = 0
     os.system(csCommand)
     os.system(md5sumCommand)
 
+    # a csound built with -DUSE_RT_CHECK=ON lists the calls that may
+    # block or allocate made while performing; keep them by test
+    out = open("Output")
+    out.seek(start)
+    text = out.read()
+    out.close()
+    at = text.find("real-time violations:")
+    if at >= 0:
+        rt = open("RTViolations", "a")
+        rt.write("%s: %s\n" % (filename, text[at:].strip()))
+        rt.close()
+
     try:
         os.remove(filename + ".wav")
     except OSError:
@@ -1069,3 +1090,5 @@ print "********Comparing checksums"
 os.system("diff CheckSums SAFESums")
 print "********Comparing output"
 os.system("diff Output Old_Output")
+if os.path.exists("RTViolations"):
+    print "********Real-time violations in RTViolations"